@@ -0,0 +1,187 @@
+/*******************************************************************************
+* Title                 :   SPI Baud Rate Calibration
+* Filename              :   spi_calibrate.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_calibrate.c
+ *  @brief Steps a device through the prescalers from fastest to slowest and keeps
+ *  	the fastest one which passes a verified exchange.
+ */
+#include "spi_calibrate.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+static uint8_t spi_calibrate_exchange(spi_calibration_t *calibration, uint32_t clock_hz);
+
+/******************************************************************************
+* Function: spi_calibrate()
+*//**
+* \b Description:
+*
+* 	Runs the calibration exchange at every prescaler from PCLK_DIV_2 down to
+* 	PCLK_DIV_256. The first prescaler for which repetitions consecutive exchanges
+* 	return the expected reply (and, if requested, a matching CRC) is taken as the
+* 	fastest reliable one; margin_steps slower prescalers are then added on top and
+* 	the resulting SCK is written to the device's max_clock_hz.
+*
+* PRE-CONDITION: spi_init() has configured the channel as a full duplex master
+* PRE-CONDITION: command_length + expected_length <= SPI_CALIBRATE_MAX_FRAMES
+* PRE-CONDITION: For a loopback, MOSI is tied to MISO (or the slave echoes)
+*
+* POST-CONDITION: On success the device's max_clock_hz holds the calibrated SCK
+* POST-CONDITION: On failure the device is left untouched
+*
+* @param		calibration a pointer to the calibration description
+* @return 		uint32_t the calibrated SCK in Hz, 0 if no prescaler passed
+*
+* \b Example:
+* @code
+*	uint16_t read_id = 0x9F;
+*	uint16_t jedec_id[3] = {0xEF, 0x40, 0x18};
+*	spi_calibration_t flash_cal = {0};
+*	flash_cal.device = &flash_transfer;
+*	flash_cal.command = &read_id;
+*	flash_cal.command_length = 1;
+*	flash_cal.expected = jedec_id;
+*	flash_cal.expected_length = 3;
+*	flash_cal.crc_enable = CRC_DISABLE;
+*	flash_cal.repetitions = 16;
+*	flash_cal.margin_steps = 1;
+*	spi_calibrate(&flash_cal);
+* @endcode
+*
+* @see spi_clock_get
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_calibrate(spi_calibration_t *calibration)
+{
+	assert(calibration != NULL && calibration->device != NULL);
+	assert(calibration->expected != NULL && calibration->expected_length != 0);
+	assert(calibration->command_length + calibration->expected_length <= SPI_CALIBRATE_MAX_FRAMES);
+	assert(calibration->command != NULL || calibration->command_length == 0);
+	spi_channel_t channel = calibration->device->channel;
+	uint8_t required = (calibration->repetitions != 0) ? calibration->repetitions : 1;
+
+	for (uint32_t baud_rate = PCLK_DIV_2; baud_rate <= PCLK_DIV_256; baud_rate++)
+	{
+		uint32_t clock_hz = spi_clock_get(channel, (spi_baud_rate_t)baud_rate);
+		uint8_t passes = 0;
+
+		while (passes < required && spi_calibrate_exchange(calibration, clock_hz))
+		{
+			passes++;
+		}
+
+		if (passes == required)
+		{
+			baud_rate += calibration->margin_steps;
+			if (baud_rate > PCLK_DIV_256)
+			{
+				baud_rate = PCLK_DIV_256;
+			}
+			calibration->device->max_clock_hz = spi_clock_get(channel, (spi_baud_rate_t)baud_rate);
+			return (calibration->device->max_clock_hz);
+		}
+	}
+	return (0);
+}
+
+/******************************************************************************
+* Function: spi_calibrate_exchange()
+*//**
+* \b Description:
+*
+* 	Static function which runs one calibration exchange at the given SCK and
+* 	checks the reply, and the CRC and overrun flags, against expectations. The
+* 	device's rate monitor is left out, so that it neither derates the exchange
+* 	nor counts the failures the search provokes.
+*
+* PRE-CONDITION: The calibration has been checked by spi_calibrate
+*
+* POST-CONDITION: The device itself is not modified
+*
+* @param		calibration a pointer to the calibration description
+* @param		clock_hz the SCK to run the exchange at
+* @return 		uint8_t 1 if the exchange was clean, 0 otherwise
+*
+* \b Example:
+*	Called by spi_calibrate for every repetition at every prescaler
+*
+* @see spi_calibrate
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_calibrate_exchange(spi_calibration_t *calibration, uint32_t clock_hz)
+{
+	uint16_t rx_frames[SPI_CALIBRATE_MAX_FRAMES];
+	spi_transfer_t transfer = *calibration->device;
+
+	transfer.max_clock_hz = clock_hz;
+	transfer.rate_monitor = NULL;
+	transfer.crc_enable = calibration->crc_enable;
+	transfer.rx_buffer = rx_frames;
+	transfer.rx_length = calibration->command_length + calibration->expected_length;
+	if (calibration->command != NULL)
+	{
+		transfer.tx_buffer = calibration->command;
+		transfer.tx_length = calibration->command_length;
+	}
+	else
+	{
+		transfer.tx_buffer = calibration->expected;
+		transfer.tx_length = calibration->expected_length;
+	}
+	spi_transfer(&transfer);
+
+	if (spi_error_get(transfer.channel) != SPI_ERROR_NONE)
+	{
+		return (0);
+	}
+	for (uint32_t i = 0; i < calibration->expected_length; i++)
+	{
+		if (rx_frames[calibration->command_length + i] != calibration->expected[i])
+		{
+			return (0);
+		}
+	}
+	return (1);
+}
@@ -0,0 +1,64 @@
+/*******************************************************************************
+* Title                 :   SPI Baud Rate Calibration
+* Filename              :   spi_calibrate.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_calibrate.h
+ *  @brief Startup search for the fastest prescaler a device can be driven at
+ *  	reliably on the current board.
+ */
+#ifndef _SPI_CALIBRATE_H
+#define _SPI_CALIBRATE_H
+
+#include "spi_interface.h"
+#include <stdint.h>
+
+/**
+ * Largest command + expected reply handled by a calibration exchange, in frames
+ */
+#ifndef SPI_CALIBRATE_MAX_FRAMES
+#define SPI_CALIBRATE_MAX_FRAMES 32U
+#endif
+
+/**
+ * Struct describing the exchange used to qualify a device at each prescaler
+ */
+typedef struct
+{
+	spi_transfer_t *device;			/**<The device to tune. Its max_clock_hz is set to the result */
+	uint16_t *command;				/**<Frames sent ahead of the reply (e.g. read ID), NULL for a MOSI-MISO loopback */
+	uint32_t command_length;		/**<Number of command frames */
+	uint16_t *expected;				/**<Reply expected after the command, or the pattern echoed by a loopback */
+	uint32_t expected_length;		/**<Number of expected frames */
+	spi_crc_en_t crc_enable;		/**<Also require the hardware CRC to match (loopback or CRC capable slaves) */
+	uint8_t repetitions;			/**<Consecutive clean exchanges needed for a prescaler to pass */
+	uint8_t margin_steps;			/**<Prescaler steps backed off from the fastest passing one */
+}spi_calibration_t;
+
+uint32_t spi_calibrate(spi_calibration_t *calibration);
+
+#endif
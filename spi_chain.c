@@ -0,0 +1,366 @@
+/*******************************************************************************
+* Title                 :   SPI Shift Register Chain
+* Filename              :   spi_chain.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_chain.c
+ *  @brief Bit field access to the image of a shift register chain and single
+ *  	burst updates of the whole chain.
+ */
+#include "spi_chain.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+static uint8_t spi_chain_insert(uint16_t *frames, uint32_t last, uint32_t offset, uint8_t width, uint32_t value);
+static uint32_t spi_chain_extract(uint16_t *frames, uint32_t last, uint32_t offset, uint8_t width);
+
+/******************************************************************************
+* Function: spi_chain_init()
+*//**
+* \b Description:
+*
+* 	Checks the description of a chain and clears its image. The chain is sent
+* 	as a whole number of 16 bit frames; when its length is not a multiple of 16
+* 	the spare bits are clocked out first and fall off the far end of the chain.
+*
+* PRE-CONDITION: spi_init() has configured the bus's channel as a master
+* PRE-CONDITION: The frame buffers hold SPI_CHAIN_FRAMES(num_bits) frames
+* PRE-CONDITION: The chain latches its outputs on the rising edge of its select
+*
+* POST-CONDITION: All outputs are 0 and the next update sends them
+*
+* @param		chain a pointer to the chain description
+* @return 		void
+*
+* \b Example:
+* @code
+*	static uint16_t leds_image[SPI_CHAIN_FRAMES(24 * 8)];
+*	leds.bus = led_bus;
+*	leds.num_bits = 24 * 8;
+*	leds.frames = leds_image;
+*	leds.rx_frames = NULL;
+*	spi_chain_init(&leds);
+* @endcode
+*
+* @see spi_chain_update
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_chain_init(spi_chain_t *chain)
+{
+	assert(chain != NULL && chain->frames != NULL && chain->num_bits != 0);
+	assert(chain->bus.bit_format == MSB_FIRST);
+	for (uint32_t i = 0; i < SPI_CHAIN_FRAMES(chain->num_bits); i++)
+	{
+		chain->frames[i] = 0;
+	}
+	chain->dirty = 1;
+}
+
+/******************************************************************************
+* Function: spi_chain_write()
+*//**
+* \b Description:
+*
+* 	Writes a bit field of the chain's outputs in the image. Only the bits of the
+* 	field are touched, and the chain is only marked for an update if one of
+* 	them actually changed.
+*
+* PRE-CONDITION: spi_chain_init() has been called on the chain
+* PRE-CONDITION: 1 <= width <= 32 and offset + width <= num_bits
+*
+* POST-CONDITION: The field holds the low width bits of value
+*
+* @param		chain a pointer to the chain
+* @param		offset the chain offset of the field's least significant bit
+* @param		width the number of bits in the field
+* @param		value the new value of the field
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_chain_write(&leds, 5 * 8 + 3, 1, 1);	//Output 3 of the sixth part
+*	spi_chain_write(&leds, 16, 8, 0xA5);		//All outputs of the third part
+* @endcode
+*
+* @see spi_chain_update
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_chain_write(spi_chain_t *chain, uint32_t offset, uint8_t width, uint32_t value)
+{
+	assert(chain != NULL && width != 0 && width <= 32);
+	assert(offset + width <= chain->num_bits);
+	uint32_t last = SPI_CHAIN_FRAMES(chain->num_bits) * 16U - 1U;
+	if (spi_chain_insert(chain->frames, last, offset, width, value))
+	{
+		chain->dirty = 1;
+	}
+}
+
+/******************************************************************************
+* Function: spi_chain_get()
+*//**
+* \b Description:
+*
+* 	Reads a bit field of the chain's outputs back from the image.
+*
+* PRE-CONDITION: spi_chain_init() has been called on the chain
+* PRE-CONDITION: 1 <= width <= 32 and offset + width <= num_bits
+*
+* POST-CONDITION: None
+*
+* @param		chain a pointer to the chain
+* @param		offset the chain offset of the field's least significant bit
+* @param		width the number of bits in the field
+* @return 		uint32_t the value of the field
+*
+* \b Example:
+* @code
+*	spi_chain_write(&leds, 7, 1, !spi_chain_get(&leds, 7, 1));
+* @endcode
+*
+* @see spi_chain_write
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_chain_get(spi_chain_t *chain, uint32_t offset, uint8_t width)
+{
+	assert(chain != NULL && width != 0 && width <= 32);
+	assert(offset + width <= chain->num_bits);
+	uint32_t last = SPI_CHAIN_FRAMES(chain->num_bits) * 16U - 1U;
+	return (spi_chain_extract(chain->frames, last, offset, width));
+}
+
+/******************************************************************************
+* Function: spi_chain_read()
+*//**
+* \b Description:
+*
+* 	Reads a bit field of what the chain shifted out during the latest update,
+* 	e.g. a conversion result of one ADC in a chain. Offsets are counted the
+* 	same way as for the outputs.
+*
+* PRE-CONDITION: spi_chain_update() has been called on a chain with rx_frames
+* PRE-CONDITION: 1 <= width <= 32 and offset + width <= num_bits
+*
+* POST-CONDITION: None
+*
+* @param		chain a pointer to the chain
+* @param		offset the chain offset of the field's least significant bit
+* @param		width the number of bits in the field
+* @return 		uint32_t the value of the field
+*
+* \b Example:
+* @code
+*	spi_chain_update(&adcs);
+*	uint32_t channel_2 = spi_chain_read(&adcs, 2 * 24, 24);
+* @endcode
+*
+* @see spi_chain_update
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_chain_read(spi_chain_t *chain, uint32_t offset, uint8_t width)
+{
+	assert(chain != NULL && chain->rx_frames != NULL && width != 0 && width <= 32);
+	assert(offset + width <= chain->num_bits);
+	return (spi_chain_extract(chain->rx_frames, chain->num_bits - 1U, offset, width));
+}
+
+/******************************************************************************
+* Function: spi_chain_update()
+*//**
+* \b Description:
+*
+* 	Clocks the image into the chain in one burst of 16 bit frames, under a single
+* 	select. A chain without rx_frames is sent transmit only, and only if one of
+* 	its outputs has changed; a chain with rx_frames is always clocked, as its
+* 	inputs need sampling.
+*
+* PRE-CONDITION: spi_chain_init() has been called on the chain
+*
+* POST-CONDITION: The chain's outputs match the image
+*
+* @param		chain a pointer to the chain
+* @return 		uint8_t 1 if the chain was clocked, 0 if there was nothing to send
+*
+* \b Example:
+* @code
+*	spi_chain_write(&leds, 12, 4, pattern);
+*	spi_chain_update(&leds);
+* @endcode
+*
+* @see spi_chain_write
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_chain_update(spi_chain_t *chain)
+{
+	assert(chain != NULL);
+	if (!chain->dirty && chain->rx_frames == NULL)
+	{
+		return (0);
+	}
+
+	spi_transfer_t transfer = chain->bus;
+	transfer.data_format = SPI_DATA_16BIT;
+	transfer.tx_buffer = chain->frames;
+	transfer.tx_length = SPI_CHAIN_FRAMES(chain->num_bits);
+	transfer.rx_buffer = chain->rx_frames;
+	transfer.rx_length = (chain->rx_frames != NULL) ? transfer.tx_length : 0;
+	transfer.crc_enable = CRC_DISABLE;
+	spi_transfer(&transfer);
+
+	chain->dirty = 0;
+	return (1);
+}
+
+/******************************************************************************
+* Function: spi_chain_insert()
+*//**
+* \b Description:
+*
+*	Static function which writes a field into a frame image, a frame at a time.
+*	Frames are sent MSB first, so the bit clocked at position p sits in frame
+*	p / 16 at bit 15 - p % 16, and offset 0 is the bit clocked at position last.
+*
+* PRE-CONDITION: The field lies within the image
+*
+* POST-CONDITION: The field holds the low width bits of value
+*
+* @param		frames the frame image
+* @param		last the clock position of offset 0
+* @param		offset the offset of the field's least significant bit
+* @param		width the number of bits in the field
+* @param		value the new value of the field
+* @return 		uint8_t 1 if any bit changed, 0 otherwise
+*
+* \b Example:
+*	Called by spi_chain_write
+*
+* @see spi_chain_extract
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_chain_insert(uint16_t *frames, uint32_t last, uint32_t offset, uint8_t width, uint32_t value)
+{
+	uint16_t changed = 0;
+	while (width > 0)
+	{
+		uint32_t position = last - offset;
+		uint8_t bit = 15U - (position & 15U);
+		uint8_t count = (16U - bit < width) ? (uint8_t)(16U - bit) : width;
+		uint16_t mask = (uint16_t)(((1UL << count) - 1U) << bit);
+		uint16_t frame = frames[position >> 4];
+		uint16_t updated = (frame & ~mask) | ((uint16_t)(value << bit) & mask);
+
+		changed |= frame ^ updated;
+		frames[position >> 4] = updated;
+		value >>= count;
+		offset += count;
+		width -= count;
+	}
+	return (changed != 0);
+}
+
+/******************************************************************************
+* Function: spi_chain_extract()
+*//**
+* \b Description:
+*
+*	Static function which reads a field out of a frame image, a frame at a time,
+*	with the layout described for spi_chain_insert.
+*
+* PRE-CONDITION: The field lies within the image
+*
+* POST-CONDITION: None
+*
+* @param		frames the frame image
+* @param		last the clock position of offset 0
+* @param		offset the offset of the field's least significant bit
+* @param		width the number of bits in the field
+* @return 		uint32_t the value of the field
+*
+* \b Example:
+*	Called by spi_chain_get and spi_chain_read
+*
+* @see spi_chain_insert
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t spi_chain_extract(uint16_t *frames, uint32_t last, uint32_t offset, uint8_t width)
+{
+	uint32_t value = 0;
+	uint8_t shift = 0;
+	while (width > 0)
+	{
+		uint32_t position = last - offset;
+		uint8_t bit = 15U - (position & 15U);
+		uint8_t count = (16U - bit < width) ? (uint8_t)(16U - bit) : width;
+
+		value |= (((uint32_t)frames[position >> 4] >> bit) & ((1UL << count) - 1U)) << shift;
+		shift += count;
+		offset += count;
+		width -= count;
+	}
+	return (value);
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+* Title                 :   SPI Shift Register Chain
+* Filename              :   spi_chain.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_chain.h
+ *  @brief Keeps the image of a daisy chain of shift registers (74HC595s, LED
+ *  	drivers, chained ADCs) on one select and clocks the whole chain out in a
+ *  	single burst of 16 bit frames.
+ */
+#ifndef _SPI_CHAIN_H
+#define _SPI_CHAIN_H
+
+#include "spi_interface.h"
+#include <stdint.h>
+
+/**
+ * Number of 16 bit frames needed for a chain of num_bits bits
+ */
+#define SPI_CHAIN_FRAMES(num_bits)	(((num_bits) + 15U) / 16U)
+
+/**
+ * Struct describing a chain and holding its image. Bit offsets count from the
+ * device nearest the spi: with 8 bit parts, outputs 0..7 of the first part are
+ * offsets 0..7, those of the second part 8..15, and so on
+ */
+typedef struct
+{
+	spi_transfer_t bus;			/**<Channel, slave pin and clock settings of the chain (MSB first). Buffers are ignored */
+	uint32_t num_bits;			/**<Length of the whole chain in bits */
+	uint16_t *frames;			/**<SPI_CHAIN_FRAMES(num_bits) frames holding the outputs to shift in */
+	uint16_t *rx_frames;		/**<SPI_CHAIN_FRAMES(num_bits) frames receiving what the chain shifts out, NULL if nothing is read */
+	uint8_t dirty;				/**<The outputs have changed since the last update (set by the driver) */
+}spi_chain_t;
+
+void spi_chain_init(spi_chain_t *chain);
+void spi_chain_write(spi_chain_t *chain, uint32_t offset, uint8_t width, uint32_t value);
+uint32_t spi_chain_get(spi_chain_t *chain, uint32_t offset, uint8_t width);
+uint32_t spi_chain_read(spi_chain_t *chain, uint32_t offset, uint8_t width);
+uint8_t spi_chain_update(spi_chain_t *chain);
+
+#endif
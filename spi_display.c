@@ -0,0 +1,618 @@
+/*******************************************************************************
+* Title                 :   SPI Display Framebuffer
+* Filename              :   spi_display.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   Written for ILI9341/ST7789 class controllers
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_display.c
+ *  @brief Dirty rectangle tracking and partial framebuffer pushes for spi tfts.
+ */
+#include "spi_display.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+/**
+ * Column address set command
+ */
+#define DISPLAY_CMD_CASET	0x2AU
+
+/**
+ * Row (page) address set command
+ */
+#define DISPLAY_CMD_RASET	0x2BU
+
+/**
+ * Memory write command, followed by the pixels of the current window
+ */
+#define DISPLAY_CMD_RAMWR	0x2CU
+
+static void spi_display_select(spi_display_t *display);
+static void spi_display_release(spi_display_t *display);
+static void spi_display_send(spi_display_t *display, spi_data_format_t data_format,
+								uint16_t *buffer, uint32_t length);
+static void spi_display_set_window(spi_display_t *display, spi_display_rect_t *rect);
+static void spi_display_push_rect(spi_display_t *display, spi_display_rect_t *rect);
+static uint32_t spi_display_rect_area(spi_display_rect_t *rect);
+static spi_display_rect_t spi_display_rect_union(spi_display_rect_t *a, spi_display_rect_t *b);
+static void spi_display_remove_rect(spi_display_t *display, uint8_t index);
+
+/******************************************************************************
+* Function: spi_display_init()
+*//**
+* \b Description:
+*
+* 	Resets the dirty region list and marks the whole panel as dirty so the
+* 	first flush pushes the complete framebuffer.
+*
+* PRE-CONDITION: The bus, dc_pin, width, height and framebuffer members are filled out
+* PRE-CONDITION: gpio_init() has configured the slave and dc pins as outputs, the slave released
+* PRE-CONDITION: The panel has been brought out of reset and set to RGB565
+*
+* POST-CONDITION: The whole panel is queued for the next spi_display_flush
+*
+* @param		display a pointer to the display to initialise
+* @return 		void
+*
+* \b Example:
+* @code
+*	static uint16_t pixels[240 * 320];
+*	spi_display_t tft = {0};
+*	tft.bus.channel = SPI_2;
+*	tft.bus.slave_pin = GPIO_B_12;
+*	tft.bus.ss_polarity = SS_ACTIVE_LOW;
+*	tft.bus.bit_format = MSB_FIRST;
+*	tft.bus.clock_polarity = ACTIVE_HIGH;
+*	tft.bus.clock_phase = FIRST_EDGE;
+*	tft.dc_pin = GPIO_B_1;
+*	tft.width = 240;
+*	tft.height = 320;
+*	tft.framebuffer = pixels;
+*	spi_display_init(&tft);
+* @endcode
+*
+* @see spi_display_flush
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_display_init(spi_display_t *display)
+{
+	assert(display != NULL);
+	assert(display->framebuffer != NULL);
+	assert(display->width != 0 && display->height != 0);
+
+	display->dirty_count = 0;
+	spi_display_invalidate(display, 0, 0, display->width, display->height);
+}
+
+/******************************************************************************
+* Function: spi_display_write_command()
+*//**
+* \b Description:
+*
+* 	Sends a single command byte followed by its (8 bit) parameters within one
+* 	slave selection, or with a hardware NSS dropped between the two. Used
+* 	internally for the address window and available for the panel's own init
+* 	sequence.
+*
+* PRE-CONDITION: The display pointer is non-NULL
+* PRE-CONDITION: params is non-NULL whenever length is non-zero
+*
+* POST-CONDITION: The command and its parameters have been sent to the panel
+*
+* @param		display a pointer to the target display
+* @param		command the command byte
+* @param		params the parameter bytes, one per element
+* @param		length the number of parameters
+* @return 		void
+*
+* \b Example:
+* @code
+*	uint16_t madctl = 0x48;
+*	spi_display_write_command(&tft, 0x36, &madctl, 1);
+* @endcode
+*
+* @see spi_display_flush
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_display_write_command(spi_display_t *display, uint8_t command, uint16_t *params, uint32_t length)
+{
+	assert(display != NULL);
+	assert(params != NULL || length == 0);
+	uint16_t command_frame = command;
+
+	spi_display_select(display);
+	gpio_pin_write(display->dc_pin, GPIO_PIN_LOW);
+	spi_display_send(display, SPI_DATA_8BIT, &command_frame, 1);
+	if (length != 0)
+	{
+		gpio_pin_write(display->dc_pin, GPIO_PIN_HIGH);
+		spi_display_send(display, SPI_DATA_8BIT, params, length);
+	}
+	spi_display_release(display);
+}
+
+/******************************************************************************
+* Function: spi_display_invalidate()
+*//**
+* \b Description:
+*
+* 	Marks a region of the framebuffer as changed. The region is clipped to the
+* 	panel and merged with any queued region where sending the union costs no
+* 	more than sending both separately (within SPI_DISPLAY_MERGE_SLACK pixels).
+* 	When the list is full the region is folded into whichever queued region
+* 	grows the least.
+*
+* PRE-CONDITION: spi_display_init() has been called on the display
+*
+* POST-CONDITION: The region will be pushed by the next spi_display_flush
+*
+* @param		display a pointer to the target display
+* @param		x leftmost changed column
+* @param		y topmost changed row
+* @param		width number of changed columns
+* @param		height number of changed rows
+* @return 		void
+*
+* \b Example:
+* @code
+*	draw_battery_icon(pixels, 200, 4);
+*	spi_display_invalidate(&tft, 200, 4, 32, 16);
+* @endcode
+*
+* @see spi_display_flush
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_display_invalidate(spi_display_t *display, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+	assert(display != NULL);
+	if (width == 0 || height == 0 || x >= display->width || y >= display->height)
+	{
+		return;
+	}
+
+	spi_display_rect_t rect;
+	rect.x0 = x;
+	rect.y0 = y;
+	rect.x1 = (width > display->width - x) ? display->width - 1 : x + width - 1;
+	rect.y1 = (height > display->height - y) ? display->height - 1 : y + height - 1;
+
+	uint8_t merged;
+	do
+	{
+		merged = 0;
+		for (uint8_t i = 0; i < display->dirty_count; i++)
+		{
+			spi_display_rect_t joined = spi_display_rect_union(&display->dirty[i], &rect);
+			if (spi_display_rect_area(&joined) <= spi_display_rect_area(&display->dirty[i])
+					+ spi_display_rect_area(&rect) + SPI_DISPLAY_MERGE_SLACK)
+			{
+				rect = joined;
+				spi_display_remove_rect(display, i);
+				merged = 1;
+				break;
+			}
+		}
+
+		if (!merged && display->dirty_count == SPI_DISPLAY_MAX_DIRTY_RECTS)
+		{
+			uint8_t best = 0;
+			uint32_t best_growth = UINT32_MAX;
+			for (uint8_t i = 0; i < display->dirty_count; i++)
+			{
+				spi_display_rect_t joined = spi_display_rect_union(&display->dirty[i], &rect);
+				uint32_t growth = spi_display_rect_area(&joined) - spi_display_rect_area(&display->dirty[i]);
+				if (growth < best_growth)
+				{
+					best_growth = growth;
+					best = i;
+				}
+			}
+			rect = spi_display_rect_union(&display->dirty[best], &rect);
+			spi_display_remove_rect(display, best);
+			merged = 1;
+		}
+	} while (merged);
+
+	display->dirty[display->dirty_count] = rect;
+	display->dirty_count++;
+}
+
+/******************************************************************************
+* Function: spi_display_flush()
+*//**
+* \b Description:
+*
+* 	Pushes every queued dirty region to the panel and empties the queue. Each
+* 	region costs one address window and one memory write; its pixels are sent
+* 	as transmit-only 16 bit frames.
+*
+* PRE-CONDITION: spi_display_init() has been called on the display
+* PRE-CONDITION: The spi channel is initialised as a full duplex or bidirectional master
+*
+* POST-CONDITION: The panel matches the framebuffer in every region that was dirty
+* POST-CONDITION: The dirty list is empty
+*
+* @param		display a pointer to the target display
+* @return 		void
+*
+* \b Example:
+* @code
+*	while (1)
+*	{
+*		ui_update(pixels, &tft);
+*		spi_display_flush(&tft);
+*	}
+* @endcode
+*
+* @see spi_display_invalidate
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_display_flush(spi_display_t *display)
+{
+	assert(display != NULL);
+	for (uint8_t i = 0; i < display->dirty_count; i++)
+	{
+		spi_display_set_window(display, &display->dirty[i]);
+		spi_display_push_rect(display, &display->dirty[i]);
+	}
+	display->dirty_count = 0;
+}
+
+/******************************************************************************
+* Function: spi_display_select()
+*//**
+* \b Description:
+*
+* 	Static function which selects the panel through spi_bus_acquire, so that the
+* 	select is held across the command and pixel phases and the channel is locked
+* 	to the caller meanwhile. A hardware NSS cannot be held; it is left to each
+* 	transfer to drive, which drops it between the phases.
+*
+* PRE-CONDITION: The slave pin has been configured as an output, unless it is SS_HARDWARE
+*
+* POST-CONDITION: The panel is selected and its channel locked, unless it uses SS_HARDWARE
+*
+* @param		display a pointer to the target display
+* @return 		void
+*
+* \b Example:
+*	Called by spi_display_write_command and spi_display_push_rect
+*
+* @see spi_display_release
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_display_select(spi_display_t *display)
+{
+	if (display->bus.ss_polarity != SS_HARDWARE)
+	{
+		spi_bus_acquire(&display->bus);
+	}
+}
+
+/******************************************************************************
+* Function: spi_display_release()
+*//**
+* \b Description:
+*
+* 	Static function which releases the panel and its channel through
+* 	spi_bus_release.
+*
+* PRE-CONDITION: spi_display_select has been called
+*
+* POST-CONDITION: The panel is released and its channel unlocked
+*
+* @param		display a pointer to the target display
+* @return 		void
+*
+* \b Example:
+*	Called by spi_display_write_command and spi_display_push_rect
+*
+* @see spi_display_select
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_display_release(spi_display_t *display)
+{
+	if (display->bus.ss_polarity != SS_HARDWARE)
+	{
+		spi_bus_release(&display->bus);
+	}
+}
+
+/******************************************************************************
+* Function: spi_display_send()
+*//**
+* \b Description:
+*
+* 	Static function which clocks a buffer out to the panel as a transmit-only
+* 	transfer. The select held by spi_display_select is left alone by the driver;
+* 	a hardware NSS is driven for the transfer.
+*
+* PRE-CONDITION: The panel has been selected
+* PRE-CONDITION: buffer is non-NULL and length is non-zero
+*
+* POST-CONDITION: The buffer has been sent in frames of data_format
+*
+* @param		display a pointer to the target display
+* @param		data_format the frame size to send the buffer with
+* @param		buffer the frames to send
+* @param		length the number of frames
+* @return 		void
+*
+* \b Example:
+*	Called by spi_display_write_command and spi_display_push_rect
+*
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_display_send(spi_display_t *display, spi_data_format_t data_format,
+								uint16_t *buffer, uint32_t length)
+{
+	spi_transfer_t transfer = display->bus;
+	transfer.data_format = data_format;
+	transfer.tx_buffer = buffer;
+	transfer.tx_length = length;
+	transfer.rx_buffer = NULL;
+	transfer.rx_length = 0;
+	transfer.bidir_direction = BIDIR_TRANSMIT;
+	spi_transfer(&transfer);
+}
+
+/******************************************************************************
+* Function: spi_display_set_window()
+*//**
+* \b Description:
+*
+* 	Static function which sets the panel's column and row address window to
+* 	the given rectangle.
+*
+* PRE-CONDITION: rect lies within the panel
+*
+* POST-CONDITION: The next memory write fills rect
+*
+* @param		display a pointer to the target display
+* @param		rect the window to set
+* @return 		void
+*
+* \b Example:
+*	Called by spi_display_flush for every dirty region
+*
+* @see spi_display_push_rect
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_display_set_window(spi_display_t *display, spi_display_rect_t *rect)
+{
+	uint16_t params[4];
+
+	params[0] = rect->x0 >> 8;
+	params[1] = rect->x0 & 0xFFU;
+	params[2] = rect->x1 >> 8;
+	params[3] = rect->x1 & 0xFFU;
+	spi_display_write_command(display, DISPLAY_CMD_CASET, params, 4);
+
+	params[0] = rect->y0 >> 8;
+	params[1] = rect->y0 & 0xFFU;
+	params[2] = rect->y1 >> 8;
+	params[3] = rect->y1 & 0xFFU;
+	spi_display_write_command(display, DISPLAY_CMD_RASET, params, 4);
+}
+
+/******************************************************************************
+* Function: spi_display_push_rect()
+*//**
+* \b Description:
+*
+* 	Static function which issues a memory write and streams the pixels of rect
+* 	out of the framebuffer. Full width regions are contiguous and go out in a
+* 	single burst, narrower ones are sent a row at a time under one selection.
+*
+* PRE-CONDITION: The address window has been set to rect
+*
+* POST-CONDITION: The panel holds the framebuffer's contents for rect
+*
+* @param		display a pointer to the target display
+* @param		rect the region to push
+* @return 		void
+*
+* \b Example:
+*	Called by spi_display_flush for every dirty region
+*
+* @see spi_display_set_window
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_display_push_rect(spi_display_t *display, spi_display_rect_t *rect)
+{
+	uint16_t command_frame = DISPLAY_CMD_RAMWR;
+	uint32_t columns = (uint32_t)(rect->x1 - rect->x0) + 1;
+	uint16_t *row = display->framebuffer + (uint32_t)rect->y0 * display->width + rect->x0;
+
+	spi_display_select(display);
+	gpio_pin_write(display->dc_pin, GPIO_PIN_LOW);
+	spi_display_send(display, SPI_DATA_8BIT, &command_frame, 1);
+	gpio_pin_write(display->dc_pin, GPIO_PIN_HIGH);
+
+	if (columns == display->width)
+	{
+		spi_display_send(display, SPI_DATA_16BIT, row, columns * ((uint32_t)(rect->y1 - rect->y0) + 1));
+	}
+	else
+	{
+		for (uint16_t y = rect->y0; y <= rect->y1; y++)
+		{
+			spi_display_send(display, SPI_DATA_16BIT, row, columns);
+			row += display->width;
+		}
+	}
+	spi_display_release(display);
+}
+
+/******************************************************************************
+* Function: spi_display_rect_area()
+*//**
+* \b Description:
+*
+* 	Static function returning the number of pixels in a rectangle.
+*
+* PRE-CONDITION: rect is well formed (x0 <= x1, y0 <= y1)
+*
+* POST-CONDITION: None
+*
+* @param		rect the rectangle to measure
+* @return 		uint32_t the area of rect in pixels
+*
+* \b Example:
+*	Called by spi_display_invalidate when weighing a merge
+*
+* @see spi_display_rect_union
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t spi_display_rect_area(spi_display_rect_t *rect)
+{
+	return (((uint32_t)(rect->x1 - rect->x0) + 1) * ((uint32_t)(rect->y1 - rect->y0) + 1));
+}
+
+/******************************************************************************
+* Function: spi_display_rect_union()
+*//**
+* \b Description:
+*
+* 	Static function returning the bounding box of two rectangles.
+*
+* PRE-CONDITION: a and b are well formed
+*
+* POST-CONDITION: None
+*
+* @param		a the first rectangle
+* @param		b the second rectangle
+* @return 		spi_display_rect_t the smallest rectangle containing a and b
+*
+* \b Example:
+*	Called by spi_display_invalidate when weighing a merge
+*
+* @see spi_display_rect_area
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static spi_display_rect_t spi_display_rect_union(spi_display_rect_t *a, spi_display_rect_t *b)
+{
+	spi_display_rect_t joined;
+	joined.x0 = (a->x0 < b->x0) ? a->x0 : b->x0;
+	joined.y0 = (a->y0 < b->y0) ? a->y0 : b->y0;
+	joined.x1 = (a->x1 > b->x1) ? a->x1 : b->x1;
+	joined.y1 = (a->y1 > b->y1) ? a->y1 : b->y1;
+	return (joined);
+}
+
+/******************************************************************************
+* Function: spi_display_remove_rect()
+*//**
+* \b Description:
+*
+* 	Static function which drops an entry from the dirty list by moving the
+* 	last entry into its place.
+*
+* PRE-CONDITION: index < dirty_count
+*
+* POST-CONDITION: The dirty list is one entry shorter
+*
+* @param		display a pointer to the target display
+* @param		index the entry to remove
+* @return 		void
+*
+* \b Example:
+*	Called by spi_display_invalidate after a merge
+*
+* @see spi_display_invalidate
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_display_remove_rect(spi_display_t *display, uint8_t index)
+{
+	display->dirty_count--;
+	display->dirty[index] = display->dirty[display->dirty_count];
+}
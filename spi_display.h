@@ -0,0 +1,85 @@
+/*******************************************************************************
+* Title                 :   SPI Display Framebuffer
+* Filename              :   spi_display.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   Written for ILI9341/ST7789 class controllers
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_display.h
+ *  @brief Pushes a RGB565 framebuffer to an spi tft, only resending the regions
+ *  	which have been marked dirty since the last flush.
+ */
+#ifndef _SPI_DISPLAY_H
+#define _SPI_DISPLAY_H
+
+#include "spi_interface.h"
+#include <stdint.h>
+
+/**
+ * Maximum number of separate dirty regions tracked before they are forced together
+ */
+#ifndef SPI_DISPLAY_MAX_DIRTY_RECTS
+#define SPI_DISPLAY_MAX_DIRTY_RECTS 8U
+#endif
+
+/**
+ * Number of extra (clean) pixels two regions may drag in when merged. Roughly the
+ * cost of the address window commands which the merge saves.
+ */
+#ifndef SPI_DISPLAY_MERGE_SLACK
+#define SPI_DISPLAY_MERGE_SLACK 64UL
+#endif
+
+/**
+ * An inclusive rectangle of pixels on the display
+ */
+typedef struct
+{
+	uint16_t x0;	/**<Leftmost column */
+	uint16_t y0;	/**<Topmost row */
+	uint16_t x1;	/**<Rightmost column */
+	uint16_t y1;	/**<Bottommost row */
+}spi_display_rect_t;
+
+/**
+ * Struct containing a display, its framebuffer and the regions yet to be pushed
+ */
+typedef struct
+{
+	spi_transfer_t bus;				/**<Channel, slave pin and clock settings of the panel. Buffers are ignored */
+	gpio_pin_t dc_pin;				/**<Data/command select pin, low for commands */
+	uint16_t width;					/**<Number of columns on the panel */
+	uint16_t height;				/**<Number of rows on the panel */
+	uint16_t *framebuffer;			/**<width * height RGB565 pixels, row major */
+	spi_display_rect_t dirty[SPI_DISPLAY_MAX_DIRTY_RECTS];	/**<Regions changed since the last flush */
+	uint8_t dirty_count;			/**<Number of valid entries in dirty */
+}spi_display_t;
+
+void spi_display_init(spi_display_t *display);
+void spi_display_write_command(spi_display_t *display, uint8_t command, uint16_t *params, uint32_t length);
+void spi_display_invalidate(spi_display_t *display, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+void spi_display_flush(spi_display_t *display);
+
+#endif
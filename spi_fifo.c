@@ -0,0 +1,338 @@
+/*******************************************************************************
+* Title                 :   SPI Sensor FIFO Drain
+* Filename              :   spi_fifo.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_fifo.c
+ *  @brief Single transaction FIFO drains for spi sensors.
+ */
+#include "spi_fifo.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+static uint32_t spi_fifo_level(spi_fifo_t *fifo);
+static uint32_t spi_fifo_decode(spi_fifo_t *fifo, uint32_t num_samples);
+
+/******************************************************************************
+* Function: spi_fifo_init()
+*//**
+* \b Description:
+*
+* 	Checks the description of a FIFO and clears any pending data ready event.
+*
+* PRE-CONDITION: The map has been initialised with spi_regmap_init()
+* PRE-CONDITION: The level and data registers are flagged SPI_REGMAP_VOLATILE
+* PRE-CONDITION: The buffer holds at least one entry plus SPI_REGMAP_ADDRESS_FRAMES
+*
+* POST-CONDITION: The FIFO is ready to be drained
+*
+* @param		fifo a pointer to the FIFO description
+* @return 		void
+*
+* \b Example:
+* @code
+*	static uint16_t imu_frames[1024 + SPI_REGMAP_ADDRESS_FRAMES];
+*	imu_fifo.map = &imu;
+*	imu_fifo.level_register = 0x3A;
+*	imu_fifo.level_bytes = 2;
+*	imu_fifo.level_order = FIFO_LITTLE_ENDIAN;
+*	imu_fifo.level_mask = 0x03FF;
+*	imu_fifo.level_unit = 7;
+*	imu_fifo.data_register = 0x78;
+*	imu_fifo.sample_bytes = 7;
+*	imu_fifo.header_bytes = 1;
+*	imu_fifo.sample_order = FIFO_LITTLE_ENDIAN;
+*	imu_fifo.buffer = imu_frames;
+*	imu_fifo.buffer_length = sizeof(imu_frames) / sizeof(imu_frames[0]);
+*	imu_fifo.callback = imu_samples_ready;
+*	spi_fifo_init(&imu_fifo);
+* @endcode
+*
+* @see spi_fifo_drain
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_fifo_init(spi_fifo_t *fifo)
+{
+	assert(fifo != NULL && fifo->map != NULL && fifo->buffer != NULL);
+	assert(fifo->level_bytes == 1 || fifo->level_bytes == 2);
+	assert(fifo->level_unit != 0);
+	assert(fifo->sample_bytes > fifo->header_bytes);
+	assert(fifo->buffer_length >= (uint32_t)fifo->sample_bytes + SPI_REGMAP_ADDRESS_FRAMES);
+	fifo->data_ready = 0;
+}
+
+/******************************************************************************
+* Function: spi_fifo_drain()
+*//**
+* \b Description:
+*
+* 	Reads the fill level and then pulls every complete entry that fits in the
+* 	buffer out of the device in one burst read of the data register, with the
+* 	increment bits clear so that the address stays on it. The entries are
+* 	decoded in place into the 16 bit words they contain (headers stripped, byte
+* 	order applied) and handed to the callback.
+*
+* PRE-CONDITION: spi_fifo_init() has been called on the FIFO
+*
+* POST-CONDITION: The buffer, viewed as int16_t, holds the decoded words
+*
+* @param		fifo a pointer to the FIFO description
+* @return 		uint32_t the number of decoded words, 0 if the FIFO was empty
+*
+* \b Example:
+* @code
+*	uint32_t words = spi_fifo_drain(&imu_fifo);
+* @endcode
+*
+* @see spi_fifo_poll
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_fifo_drain(spi_fifo_t *fifo)
+{
+	assert(fifo != NULL);
+	uint32_t capacity = (fifo->buffer_length - SPI_REGMAP_ADDRESS_FRAMES) / fifo->sample_bytes;
+	uint32_t num_samples = spi_fifo_level(fifo) / fifo->sample_bytes;
+
+	if (num_samples > capacity)
+	{
+		num_samples = capacity;
+	}
+	if (num_samples == 0)
+	{
+		return (0);
+	}
+
+	spi_regmap_read_raw(fifo->map, fifo->data_register, fifo->buffer, num_samples * fifo->sample_bytes,
+			REGMAP_BURST_FIXED);
+	uint32_t num_words = spi_fifo_decode(fifo, num_samples);
+
+	if (fifo->callback != NULL)
+	{
+		fifo->callback((int16_t *)fifo->buffer, num_words);
+	}
+	return (num_words);
+}
+
+/******************************************************************************
+* Function: spi_fifo_data_ready_isr()
+*//**
+* \b Description:
+*
+* 	Records a data ready (or FIFO watermark) event. Meant to be called from the
+* 	external interrupt handler of the device's interrupt pin; the drain itself
+* 	is left to spi_fifo_poll so that no transfer runs inside the interrupt.
+*
+* PRE-CONDITION: spi_fifo_init() has been called on the FIFO
+*
+* POST-CONDITION: The next spi_fifo_poll drains the FIFO
+*
+* @param		fifo a pointer to the FIFO description
+* @return 		void
+*
+* \b Example:
+* @code
+* EXTI4_IRQHandler()
+* {
+* 	EXTI->PR = EXTI_PR_PR4;
+* 	spi_fifo_data_ready_isr(&imu_fifo);
+* }
+* @endcode
+*
+* @see spi_fifo_poll
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_fifo_data_ready_isr(spi_fifo_t *fifo)
+{
+	fifo->data_ready = 1;
+}
+
+/******************************************************************************
+* Function: spi_fifo_poll()
+*//**
+* \b Description:
+*
+* 	Drains the FIFO if a data ready event has been recorded since the last call.
+*
+* PRE-CONDITION: spi_fifo_init() has been called on the FIFO
+*
+* POST-CONDITION: Any recorded data ready event has been consumed
+*
+* @param		fifo a pointer to the FIFO description
+* @return 		uint32_t the number of decoded words, 0 if nothing was drained
+*
+* \b Example:
+* @code
+*	while (1)
+*	{
+*		spi_fifo_poll(&imu_fifo);
+*		other_work();
+*	}
+* @endcode
+*
+* @see spi_fifo_data_ready_isr
+* @see spi_fifo_drain
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_fifo_poll(spi_fifo_t *fifo)
+{
+	assert(fifo != NULL);
+	if (fifo->data_ready == 0)
+	{
+		return (0);
+	}
+	fifo->data_ready = 0;
+	return (spi_fifo_drain(fifo));
+}
+
+/******************************************************************************
+* Function: spi_fifo_level()
+*//**
+* \b Description:
+*
+* 	Static function which reads the level registers and converts the count they
+* 	hold into bytes.
+*
+* PRE-CONDITION: spi_fifo_init() has been called on the FIFO
+*
+* POST-CONDITION: None
+*
+* @param		fifo a pointer to the FIFO description
+* @return 		uint32_t the number of bytes waiting in the FIFO
+*
+* \b Example:
+*	Called by spi_fifo_drain
+*
+* @see spi_fifo_drain
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t spi_fifo_level(spi_fifo_t *fifo)
+{
+	uint8_t raw[2];
+	uint16_t level;
+
+	spi_regmap_read_block(fifo->map, fifo->level_register, raw, fifo->level_bytes);
+	if (fifo->level_bytes == 1)
+	{
+		level = raw[0];
+	}
+	else if (fifo->level_order == FIFO_LITTLE_ENDIAN)
+	{
+		level = (uint16_t)(raw[1] << 8) | raw[0];
+	}
+	else
+	{
+		level = (uint16_t)(raw[0] << 8) | raw[1];
+	}
+	return ((uint32_t)(level & fifo->level_mask) * fifo->level_unit);
+}
+
+/******************************************************************************
+* Function: spi_fifo_decode()
+*//**
+* \b Description:
+*
+* 	Static function which turns the received frames (one byte each) into the
+* 	16 bit words of each entry, writing them from the start of the same buffer.
+* 	Every word is written at a lower index than the frames it is built from, so
+* 	no second buffer is required.
+*
+* PRE-CONDITION: The buffer holds num_samples entries, one byte per frame
+*
+* POST-CONDITION: The buffer, viewed as int16_t, holds the decoded words
+*
+* @param		fifo a pointer to the FIFO description
+* @param		num_samples the number of entries in the buffer
+* @return 		uint32_t the number of decoded words
+*
+* \b Example:
+*	Called by spi_fifo_drain
+*
+* @see spi_fifo_drain
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t spi_fifo_decode(spi_fifo_t *fifo, uint32_t num_samples)
+{
+	uint32_t words_per_sample = (uint32_t)(fifo->sample_bytes - fifo->header_bytes) / 2;
+	uint16_t *in = fifo->buffer;
+	uint16_t *out = fifo->buffer;
+
+	for (uint32_t sample = 0; sample < num_samples; sample++)
+	{
+		uint16_t *word = in + fifo->header_bytes;
+		for (uint32_t i = 0; i < words_per_sample; i++)
+		{
+			if (fifo->sample_order == FIFO_LITTLE_ENDIAN)
+			{
+				*out = (uint16_t)((word[1] & 0xFFU) << 8) | (word[0] & 0xFFU);
+			}
+			else
+			{
+				*out = (uint16_t)((word[0] & 0xFFU) << 8) | (word[1] & 0xFFU);
+			}
+			out++;
+			word += 2;
+		}
+		in += fifo->sample_bytes;
+	}
+	return (num_samples * words_per_sample);
+}
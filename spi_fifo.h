@@ -0,0 +1,80 @@
+/*******************************************************************************
+* Title                 :   SPI Sensor FIFO Drain
+* Filename              :   spi_fifo.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_fifo.h
+ *  @brief Drains the hardware FIFO of an imu/accelerometer with a single burst
+ *  	read and decodes the samples into 16 bit words in place.
+ */
+#ifndef _SPI_FIFO_H
+#define _SPI_FIFO_H
+
+#include "spi_regmap.h"
+#include <stdint.h>
+
+/**
+ * Contains the byte orders of multi-byte values read out of the device
+ */
+typedef enum
+{
+	FIFO_LITTLE_ENDIAN,	/**<The least significant byte is read first */
+	FIFO_BIG_ENDIAN		/**<The most significant byte is read first */
+}spi_fifo_byte_order_t;
+
+/**
+ * Callback typedef handed the decoded words of a drain
+ */
+typedef void (*spi_fifo_callback_t)(int16_t *words, uint32_t num_words);
+
+/**
+ * Struct describing a device FIFO and the buffer it is drained into
+ */
+typedef struct
+{
+	spi_regmap_t *map;						/**<Register map of the device, the FIFO registers must be volatile */
+	uint16_t level_register;				/**<First register holding the FIFO fill level */
+	uint8_t level_bytes;					/**<Number of consecutive level registers (1 or 2) */
+	spi_fifo_byte_order_t level_order;		/**<Byte order of a two register level */
+	uint16_t level_mask;					/**<Bits of the level registers holding the count */
+	uint8_t level_unit;						/**<Bytes per level count, 1 for byte counts or sample_bytes for sample counts */
+	uint16_t data_register;					/**<FIFO output register */
+	uint8_t sample_bytes;					/**<Bytes per FIFO entry, including any header */
+	uint8_t header_bytes;					/**<Leading bytes of each entry (tags) skipped by the decoder */
+	spi_fifo_byte_order_t sample_order;		/**<Byte order of the 16 bit words in an entry */
+	uint16_t *buffer;						/**<Frame buffer the FIFO is read and decoded into */
+	uint32_t buffer_length;					/**<Number of frames in buffer */
+	spi_fifo_callback_t callback;			/**<Called with the decoded words of every drain, may be NULL */
+	volatile uint8_t data_ready;			/**<Set by spi_fifo_data_ready_isr, cleared by spi_fifo_poll */
+}spi_fifo_t;
+
+void spi_fifo_init(spi_fifo_t *fifo);
+uint32_t spi_fifo_drain(spi_fifo_t *fifo);
+void spi_fifo_data_ready_isr(spi_fifo_t *fifo);
+uint32_t spi_fifo_poll(spi_fifo_t *fifo);
+
+#endif
@@ -44,7 +44,9 @@
 typedef enum
 {
 	SS_ACTIVE_LOW, /**<A slave is selected by pulling its select pin low */
-	SS_ACTIVE_HIGH /**<A slave is selected by pulling its select pin high */
+	SS_ACTIVE_HIGH, /**<A slave is selected by pulling its select pin high */
+	SS_MANUAL,		/**<The select pin is left alone and driven by the caller around the transfer */
+	SS_HARDWARE		/**<NSS is driven low by the spi for the transfer (SSOE), slave_pin is ignored */
 }spi_ss_polarity_t;
 
 /**
@@ -79,8 +81,10 @@ typedef enum
  */
 typedef enum
 {
-	SPI_DATA_8BIT,	/**<The data is in 8 bit frames */
-	SPI_DATA_16BIT	/**<The data is in 16 bit frames */
+	SPI_DATA_8BIT,			/**<The data is in 8 bit frames */
+	SPI_DATA_16BIT,			/**<The data is in 16 bit frames */
+	SPI_DATA_8BIT_PACKED	/**<Byte stream sent two bytes per 16 bit frame. The buffers are byte arrays aligned
+								to two bytes, passed as uint16_t *, and the lengths count bytes (full duplex master only) */
 }spi_data_format_t;
 
 /**
@@ -93,7 +97,44 @@ typedef enum
 }spi_bidir_dir_t;
 
 /**
- * Struct containing implementation agnostic transfer information.
+ * Contains the options for letting an urgent transfer cut into an interrupt transfer
+ */
+typedef enum
+{
+	PREEMPT_DISABLE,	/**<The transfer runs to the end before an urgent transfer starts */
+	PREEMPT_ENABLE		/**<The transfer may be paused between frames, its slave released, and resumed later */
+}spi_preempt_t;
+
+/**
+ * Contains the error flags reported for a transfer, combined as a bit mask
+ */
+typedef enum
+{
+	SPI_ERROR_NONE = 0x00,			/**<The transfer completed cleanly */
+	SPI_ERROR_CRC = 0x01,			/**<The received CRC did not match the calculated one */
+	SPI_ERROR_OVERRUN = 0x02,		/**<A received frame was overwritten before it was read */
+	SPI_ERROR_MODE_FAULT = 0x04		/**<Another master pulled the slave select of a master low */
+}spi_error_t;
+
+/**
+ * Tracks the error rate of a device and the prescaler steps currently taken off its
+ * clock because of it. Shared by every transfer to the device through a pointer.
+ */
+typedef struct
+{
+	uint8_t window;				/**<Number of most recent transfers considered (1 to 32) */
+	uint8_t error_threshold;	/**<Errored transfers within the window that step the clock down */
+	uint16_t probe_after;		/**<Consecutive clean transfers before a step back up is tried */
+	uint32_t history;			/**<One bit per recent transfer, set if it had an error */
+	uint16_t clean_run;			/**<Clean transfers since the last error or step */
+	uint8_t derate;				/**<Prescaler steps currently applied on top of the requested clock */
+	uint32_t error_count;		/**<Errored transfers since init, for diagnostics */
+}spi_rate_monitor_t;
+
+/**
+ * Struct containing implementation agnostic transfer information. Fields added over
+ * time default to off when zero, so declare transfers zero-initialised ({0}) or
+ * with designated initialisers and fill in what is needed.
  */
 typedef struct
 {
@@ -101,20 +142,85 @@ typedef struct
 	gpio_pin_t slave_pin;					/**<The slave's ss pin */
 	spi_ss_polarity_t ss_polarity;			/**<The polarity of slave_pin */
 	uint16_t *tx_buffer;					/**<Pointer to the data buffer for transfers*/
-	uint32_t tx_length;						/**<Length of the transfer buffer*/
-	uint16_t *rx_buffer;					/**<Pointer to the data buffer for reception */
+	uint32_t tx_length;						/**<Length of the transfer buffer (padded with dummy frames on a master if shorter than rx_length)*/
+	uint16_t *rx_buffer;					/**<Pointer to the data buffer for reception (NULL discards it on a full duplex master) */
 	uint32_t rx_length;						/**<Length of the reception buffer */
 	spi_data_format_t data_format;			/**<Data size of the transfer elements*/
 	spi_bit_format_t bit_format;			/**<MSB or LSB first*/
 	spi_clock_polarity_t clock_polarity;	/**<Selection of the clock's active and idle states */
 	spi_clock_phase_t clock_phase;			/**<Edge sensitivity on sampling and shifts */
 	spi_bidir_dir_t bidir_direction;		/**<Direction of the single data line transfer*/
+	uint32_t max_clock_hz;					/**<Fastest SCK the slave accepts, 0 uses the channel's configured baud_rate*/
+	spi_crc_en_t crc_enable;				/**<Appends and checks a hardware CRC frame (full duplex master)*/
+	spi_rate_monitor_t *rate_monitor;		/**<Optional error tracking which slows the clock on a noisy bus, NULL if unused (zero-initialise transfers)*/
+	uint16_t cs_setup_cycles;				/**<Core clock cycles from a GPIO select to the first clock edge, 0 for none*/
+	uint16_t cs_hold_cycles;				/**<Core clock cycles from the end of the last frame to a GPIO release, 0 for none*/
+	spi_preempt_t preemptible;				/**<Lets an urgent transfer pause this one (full duplex interrupt master only)*/
+	uint32_t sleep_threshold;				/**<Frames above which spi_transfer sleeps on an interrupt transfer instead of polling, 0 always polls*/
 }spi_transfer_t;
 
-void spi_init(spi_config_t *config_table);
-void spi_transfer(spi_transfer_t *transfer);
-void spi_transfer_it(spi_transfer_t *transfer);
+/**
+ * Struct holding a transfer together with everything spi_transfer_prepare worked
+ * out for it, so that it can be started repeatedly at minimum cost
+ */
+typedef struct
+{
+	spi_transfer_t transfer;			/**<Copy of the transfer, replayed unchanged by every start */
+	uint16_t CR1_image;					/**<CR1 for the transfer without SPE (set by the driver) */
+	void (*kernel)(spi_transfer_t *);	/**<Polling routine for the transfer, NULL if there is nothing to do (set by the driver) */
+}spi_prepared_t;
+
+/**
+ * Filled in by the driver as it begins a transfer queued from an interrupt handler
+ */
+typedef struct
+{
+	volatile uint32_t cycles;	/**<DWT cycle count when the transfer began */
+	volatile uint8_t started;	/**<Set once the transfer has begun, cleared as it is queued */
+}spi_start_stamp_t;
+
+/**
+ * Handle of a transfer descriptor from the driver's pool
+ */
+typedef uint8_t spi_desc_t;
+
+/**
+ * Handle returned when the descriptor pool is empty
+ */
+#define SPI_DESC_NONE	0xFFU
+
+/**
+ * Contains the states of a transfer descriptor
+ */
+typedef enum
+{
+	SPI_DESC_IDLE,		/**<Not submitted since it was created */
+	SPI_DESC_QUEUED,	/**<Waiting in its channel's queue or in progress */
+	SPI_DESC_DONE		/**<The latest submission has completed */
+}spi_desc_status_t;
+
+void spi_init(const spi_config_t *config_table);
+void spi_deinit(const spi_config_t *config_table);
+void spi_transfer(const spi_transfer_t *transfer);
+void spi_transfer_multi(spi_transfer_t **transfers, uint8_t count);
+void spi_bus_acquire(const spi_transfer_t *device);
+void spi_bus_release(const spi_transfer_t *device);
+void spi_transfer_prepare(spi_prepared_t *prepared, const spi_transfer_t *transfer);
+void spi_transfer_start_prepared(spi_prepared_t *prepared);
+void spi_transfer_it(const spi_transfer_t *transfer);
+uint8_t spi_transfer_it_from_isr(const spi_transfer_t *transfer, spi_start_stamp_t *stamp);
+uint8_t spi_transfer_submit(const spi_transfer_t *transfer);
+uint8_t spi_transfer_reap(spi_channel_t channel, spi_transfer_t *completed);
+void spi_transfer_it_wait(const spi_transfer_t *transfer, spi_transfer_t *completed);
+spi_desc_t spi_desc_create(const spi_transfer_t *request);
+uint8_t spi_desc_submit(spi_desc_t desc);
+spi_desc_status_t spi_desc_status(spi_desc_t desc);
+void spi_desc_destroy(spi_desc_t desc);
+uint8_t spi_desc_submit_urgent(spi_desc_t desc);
 void spi_irq_handler(spi_channel_t channel);
+uint8_t spi_error_get(spi_channel_t channel);
+uint32_t spi_clock_get(spi_channel_t channel, spi_baud_rate_t baud_rate);
+void spi_rate_monitor_init(spi_rate_monitor_t *monitor, uint8_t window, uint8_t error_threshold, uint16_t probe_after);
 void spi_register_write(uint32_t spi_register, uint16_t value);
 uint16_t spi_register_read(uint32_t spi_register);
 
@@ -0,0 +1,1021 @@
+/*******************************************************************************
+* Title                 :   SPI Slave Device Models
+* Filename              :   spi_model.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_model.c
+ *  @brief Byte level state machines of the modelled slaves. Nothing here touches
+ *  	the hardware, so the file builds for the target and for a host alike.
+ */
+#include "spi_model.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+/**
+ * NOR flash opcodes and status bits
+ */
+#define SPI_MODEL_FLASH_NONE	0x00U
+#define SPI_MODEL_FLASH_WRSR	0x01U
+#define SPI_MODEL_FLASH_PP		0x02U
+#define SPI_MODEL_FLASH_READ	0x03U
+#define SPI_MODEL_FLASH_WRDI	0x04U
+#define SPI_MODEL_FLASH_RDSR	0x05U
+#define SPI_MODEL_FLASH_WREN	0x06U
+#define SPI_MODEL_FLASH_SE		0x20U
+#define SPI_MODEL_FLASH_CE		0x60U
+#define SPI_MODEL_FLASH_RDID	0x9FU
+#define SPI_MODEL_FLASH_CE_ALT	0xC7U
+#define SPI_MODEL_FLASH_BE		0xD8U
+#define SPI_MODEL_FLASH_WIP		0x01U
+#define SPI_MODEL_FLASH_WEL		0x02U
+
+/**
+ * SD card R1 bits and data tokens
+ */
+#define SPI_MODEL_SD_R1_IDLE		0x01U
+#define SPI_MODEL_SD_R1_ILLEGAL		0x04U
+#define SPI_MODEL_SD_R1_PARAMETER	0x40U
+#define SPI_MODEL_SD_TOKEN			0xFEU
+#define SPI_MODEL_SD_DATA_ACCEPTED	0x05U
+
+/**
+ * Phases of a sensor transaction
+ */
+#define SPI_MODEL_SENSOR_ADDRESS	0U
+#define SPI_MODEL_SENSOR_READ		1U
+#define SPI_MODEL_SENSOR_WRITE		2U
+
+static uint8_t spi_model_byte(spi_model_t *model, uint8_t mosi);
+static uint8_t spi_model_flash_byte(spi_model_flash_t *flash, uint8_t mosi);
+static void spi_model_flash_end(spi_model_flash_t *flash);
+static void spi_model_flash_erase(spi_model_flash_t *flash, uint32_t address, uint32_t length);
+static uint8_t spi_model_sd_byte(spi_model_sd_t *sd, uint8_t mosi);
+static void spi_model_sd_command(spi_model_sd_t *sd);
+static uint8_t spi_model_sensor_byte(spi_model_sensor_t *sensor, uint8_t mosi);
+static uint8_t spi_model_sensor_read(spi_model_sensor_t *sensor, uint8_t reg);
+static uint8_t spi_model_chain_byte(spi_model_chain_t *chain, uint8_t mosi);
+
+/******************************************************************************
+* Function: spi_model_init()
+*//**
+* \b Description:
+*
+* 	Checks the configuration of a model and puts it in its power on state: the
+* 	flash idle and write protected, the SD card in the idle state, the sensor's
+* 	FIFO empty and the chain cleared. The counters are cleared.
+*
+* PRE-CONDITION: kind and the configuration fields of the matching device are filled in
+*
+* POST-CONDITION: The model is deselected and ready to be exchanged with
+*
+* @param		model a pointer to the model
+* @return 		void
+*
+* \b Example:
+* @code
+*	static uint8_t flash_memory[0x100000];
+*	static spi_model_t flash;
+*	flash.kind = MODEL_NOR_FLASH;
+*	flash.device.flash.memory = flash_memory;
+*	flash.device.flash.size = sizeof(flash_memory);
+*	flash.device.flash.jedec_id[0] = 0xEF;
+*	flash.device.flash.jedec_id[1] = 0x40;
+*	flash.device.flash.jedec_id[2] = 0x14;
+*	flash.device.flash.busy_polls = 4;
+*	spi_model_init(&flash);
+* @endcode
+*
+* @see spi_model_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_model_init(spi_model_t *model)
+{
+	assert(model != NULL);
+	model->selected = 0;
+	model->selections = 0;
+	model->frames = 0;
+
+	if (model->kind == MODEL_NOR_FLASH)
+	{
+		spi_model_flash_t *flash = &model->device.flash;
+		assert(flash->memory != NULL && flash->size != 0 && (flash->size & 0xFFFFUL) == 0);
+		flash->command = SPI_MODEL_FLASH_NONE;
+		flash->address = 0;
+		flash->position = 0;
+		flash->write_enable = 0;
+		flash->busy = 0;
+	}
+	else if (model->kind == MODEL_SD_CARD)
+	{
+		spi_model_sd_t *sd = &model->device.sd;
+		assert(sd->blocks != NULL && sd->num_blocks != 0);
+		sd->state = SD_MODEL_COMMAND;
+		sd->idle = 1;
+		sd->app_command = 0;
+		sd->polls_left = sd->init_polls;
+		sd->command_count = 0;
+		sd->response_length = 0;
+		sd->response_index = 0;
+	}
+	else if (model->kind == MODEL_SENSOR)
+	{
+		spi_model_sensor_t *sensor = &model->device.sensor;
+		assert(sensor->registers != NULL && sensor->fifo != NULL && sensor->fifo_size != 0);
+		sensor->fifo_head = 0;
+		sensor->fifo_count = 0;
+		sensor->phase = SPI_MODEL_SENSOR_ADDRESS;
+	}
+	else
+	{
+		spi_model_chain_t *chain = &model->device.chain;
+		assert(chain->num_bytes != 0 && chain->num_bytes <= SPI_MODEL_CHAIN_BYTES);
+		for (uint8_t i = 0; i < chain->num_bytes; i++)
+		{
+			chain->shift[i] = 0;
+			chain->outputs[i] = 0;
+		}
+	}
+}
+
+/******************************************************************************
+* Function: spi_model_select()
+*//**
+* \b Description:
+*
+* 	Asserts the model's slave select, starting a new transaction. The chain
+* 	loads its parallel inputs into the shift registers.
+*
+* PRE-CONDITION: spi_model_init() has been called on the model
+*
+* POST-CONDITION: The model answers spi_model_exchange
+*
+* @param		model a pointer to the model
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_model_select(&flash);
+*	spi_model_exchange(&flash, 0x06, 8);
+*	spi_model_deselect(&flash);
+* @endcode
+*
+* @see spi_model_deselect
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_model_select(spi_model_t *model)
+{
+	assert(model != NULL);
+	model->selected = 1;
+	model->selections++;
+
+	if (model->kind == MODEL_NOR_FLASH)
+	{
+		model->device.flash.position = 0;
+	}
+	else if (model->kind == MODEL_SENSOR)
+	{
+		model->device.sensor.phase = SPI_MODEL_SENSOR_ADDRESS;
+	}
+	else if (model->kind == MODEL_SHIFT_CHAIN)
+	{
+		spi_model_chain_t *chain = &model->device.chain;
+		for (uint8_t i = 0; i < chain->num_bytes; i++)
+		{
+			chain->shift[i] = chain->inputs[i];
+		}
+	}
+}
+
+/******************************************************************************
+* Function: spi_model_deselect()
+*//**
+* \b Description:
+*
+* 	Releases the model's slave select, ending the transaction. The flash carries
+* 	out a program or erase which was fully clocked in, and the chain latches its
+* 	shift registers onto its outputs.
+*
+* PRE-CONDITION: spi_model_init() has been called on the model
+*
+* POST-CONDITION: The model ignores spi_model_exchange until selected again
+*
+* @param		model a pointer to the model
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_model_deselect(&flash);
+* @endcode
+*
+* @see spi_model_select
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_model_deselect(spi_model_t *model)
+{
+	assert(model != NULL);
+	if (model->selected == 0)
+	{
+		return;
+	}
+	model->selected = 0;
+
+	if (model->kind == MODEL_NOR_FLASH)
+	{
+		spi_model_flash_end(&model->device.flash);
+	}
+	else if (model->kind == MODEL_SHIFT_CHAIN)
+	{
+		spi_model_chain_t *chain = &model->device.chain;
+		for (uint8_t i = 0; i < chain->num_bytes; i++)
+		{
+			chain->outputs[i] = chain->shift[i];
+		}
+	}
+}
+
+/******************************************************************************
+* Function: spi_model_exchange()
+*//**
+* \b Description:
+*
+* 	Clocks one frame through the model: the frame on MOSI goes in and the frame
+* 	the model drives on MISO comes back. 16 bit frames are handled as two bytes,
+* 	most significant first. An unselected model leaves MISO to its pull up.
+*
+* PRE-CONDITION: spi_model_init() has been called on the model
+* PRE-CONDITION: bits is 8 or 16
+*
+* POST-CONDITION: The model has advanced by one frame
+*
+* @param		model a pointer to the model
+* @param		mosi the frame sent by the master
+* @param		bits the frame size
+* @return 		uint16_t the frame sent back by the model
+*
+* \b Example:
+* @code
+*	spi_model_select(&flash);
+*	spi_model_exchange(&flash, 0x9F, 8);
+*	uint8_t manufacturer = (uint8_t)spi_model_exchange(&flash, 0x00, 8);
+*	spi_model_deselect(&flash);
+* @endcode
+*
+* @see spi_model_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint16_t spi_model_exchange(spi_model_t *model, uint16_t mosi, uint8_t bits)
+{
+	assert(model != NULL && (bits == 8 || bits == 16));
+	if (model->selected == 0)
+	{
+		return ((bits == 16) ? 0xFFFFU : 0xFFU);
+	}
+	model->frames++;
+
+	if (bits == 16)
+	{
+		uint16_t high = spi_model_byte(model, (uint8_t)(mosi >> 8));
+		return ((uint16_t)(high << 8) | spi_model_byte(model, (uint8_t)mosi));
+	}
+	return (spi_model_byte(model, (uint8_t)mosi));
+}
+
+/******************************************************************************
+* Function: spi_model_transfer()
+*//**
+* \b Description:
+*
+* 	Carries out a full duplex master transfer against the model the way the
+* 	driver would on the bus: the model is selected, max(tx_length, rx_length)
+* 	frames are exchanged, with SPI_MODEL_DUMMY_FRAME once the transmit buffer
+* 	runs out, and the model is released. The transfer description is the one a
+* 	device stack hands to spi_transfer, so the stack can be exercised unchanged.
+*
+* PRE-CONDITION: spi_model_init() has been called on the model
+* PRE-CONDITION: The transfer is in 8 or 16 bit frames (not SPI_DATA_8BIT_PACKED)
+*
+* POST-CONDITION: rx_buffer, if any, holds the frames sent back by the model
+* POST-CONDITION: The transfer structure itself is left untouched
+*
+* @param		model a pointer to the model
+* @param		transfer a pointer to the transfer to carry out
+* @return 		void
+*
+* \b Example:
+* @code
+*	uint16_t read_id[4] = {0x9F};
+*	uint16_t id[4];
+*	spi_transfer_t flash_read_id = {SPI_1, GPIO_A_4, SS_ACTIVE_LOW, read_id, 1, id, 4, SPI_DATA_8BIT};
+*	spi_model_transfer(&flash, &flash_read_id);
+* @endcode
+*
+* @see spi_model_exchange
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_model_transfer(spi_model_t *model, const spi_transfer_t *transfer)
+{
+	assert(model != NULL && transfer != NULL);
+	assert(transfer->data_format != SPI_DATA_8BIT_PACKED);
+	uint8_t bits = (transfer->data_format == SPI_DATA_16BIT) ? 16U : 8U;
+	uint32_t length = (transfer->tx_length > transfer->rx_length) ? transfer->tx_length : transfer->rx_length;
+
+	spi_model_select(model);
+	for (uint32_t i = 0; i < length; i++)
+	{
+		uint16_t mosi = (i < transfer->tx_length) ? transfer->tx_buffer[i] : SPI_MODEL_DUMMY_FRAME;
+		uint16_t miso = spi_model_exchange(model, mosi, bits);
+		if (transfer->rx_buffer != NULL && i < transfer->rx_length)
+		{
+			transfer->rx_buffer[i] = miso;
+		}
+	}
+	spi_model_deselect(model);
+}
+
+/******************************************************************************
+* Function: spi_model_sensor_push()
+*//**
+* \b Description:
+*
+* 	Appends samples to a sensor model's FIFO, as the sensor would on every
+* 	conversion. Bytes which do not fit are dropped, as on an overflowing
+* 	sensor configured to stop when full.
+*
+* PRE-CONDITION: spi_model_init() has been called on the model, a MODEL_SENSOR
+*
+* POST-CONDITION: The FIFO level registers report the new level
+*
+* @param		model a pointer to the sensor model
+* @param		data the bytes to append, in the order they are to be read out
+* @param		count the number of bytes to append
+* @return 		uint16_t the number of bytes appended
+*
+* \b Example:
+* @code
+*	uint8_t sample[7] = {0x08, 0x10, 0x00, 0xF0, 0xFF, 0x00, 0x40};
+*	spi_model_sensor_push(&imu, sample, sizeof(sample));
+* @endcode
+*
+* @see spi_fifo_drain
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint16_t spi_model_sensor_push(spi_model_t *model, const uint8_t *data, uint16_t count)
+{
+	assert(model != NULL && model->kind == MODEL_SENSOR && data != NULL);
+	spi_model_sensor_t *sensor = &model->device.sensor;
+	uint16_t pushed = 0;
+
+	while (pushed < count && sensor->fifo_count < sensor->fifo_size)
+	{
+		uint16_t tail = (uint16_t)((sensor->fifo_head + sensor->fifo_count) % sensor->fifo_size);
+		sensor->fifo[tail] = data[pushed];
+		sensor->fifo_count++;
+		pushed++;
+	}
+	return (pushed);
+}
+
+/******************************************************************************
+* Function: spi_model_byte()
+*//**
+* \b Description:
+*
+* 	Static function which hands a byte to the state machine of the model's kind.
+*
+* PRE-CONDITION: The model is selected
+*
+* POST-CONDITION: The model has advanced by one byte
+*
+* @param		model a pointer to the model
+* @param		mosi the byte sent by the master
+* @return 		uint8_t the byte sent back by the model
+*
+* \b Example:
+*	Called by spi_model_exchange once per byte
+*
+* @see spi_model_exchange
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_model_byte(spi_model_t *model, uint8_t mosi)
+{
+	if (model->kind == MODEL_NOR_FLASH)
+	{
+		return (spi_model_flash_byte(&model->device.flash, mosi));
+	}
+	else if (model->kind == MODEL_SD_CARD)
+	{
+		return (spi_model_sd_byte(&model->device.sd, mosi));
+	}
+	else if (model->kind == MODEL_SENSOR)
+	{
+		return (spi_model_sensor_byte(&model->device.sensor, mosi));
+	}
+	return (spi_model_chain_byte(&model->device.chain, mosi));
+}
+
+/******************************************************************************
+* Function: spi_model_flash_byte()
+*//**
+* \b Description:
+*
+* 	Static function which advances the flash by one byte. The first byte of a
+* 	transaction is the opcode; while a program or erase is in progress only
+* 	RDSR is accepted and each status read counts the operation down. Page
+* 	programs wrap within their 256 byte page and can only clear bits.
+*
+* PRE-CONDITION: The model is selected
+*
+* POST-CONDITION: The flash has advanced by one byte
+*
+* @param		flash a pointer to the flash model
+* @param		mosi the byte sent by the master
+* @return 		uint8_t the byte sent back by the flash
+*
+* \b Example:
+*	Called by spi_model_byte
+*
+* @see spi_model_flash_end
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_model_flash_byte(spi_model_flash_t *flash, uint8_t mosi)
+{
+	uint32_t position = flash->position++;
+	uint8_t command = flash->command;
+	uint8_t miso = 0xFFU;
+
+	if (position == 0)
+	{
+		flash->command = (flash->busy != 0 && mosi != SPI_MODEL_FLASH_RDSR) ? SPI_MODEL_FLASH_NONE : mosi;
+		flash->address = 0;
+		if (flash->command == SPI_MODEL_FLASH_WREN)
+		{
+			flash->write_enable = 1;
+		}
+		else if (flash->command == SPI_MODEL_FLASH_WRDI)
+		{
+			flash->write_enable = 0;
+		}
+	}
+	else if (command == SPI_MODEL_FLASH_RDID)
+	{
+		miso = (position <= 3) ? flash->jedec_id[position - 1] : 0xFFU;
+	}
+	else if (command == SPI_MODEL_FLASH_RDSR)
+	{
+		miso = (flash->write_enable ? SPI_MODEL_FLASH_WEL : 0) | ((flash->busy != 0) ? SPI_MODEL_FLASH_WIP : 0);
+		if (flash->busy != 0)
+		{
+			flash->busy--;
+		}
+	}
+	else if (position <= 3)
+	{
+		flash->address = (flash->address << 8) | mosi;
+	}
+	else if (command == SPI_MODEL_FLASH_READ)
+	{
+		miso = flash->memory[flash->address % flash->size];
+		flash->address++;
+	}
+	else if (command == SPI_MODEL_FLASH_PP && flash->write_enable)
+	{
+		flash->memory[flash->address % flash->size] &= mosi;
+		flash->address = (flash->address & ~(uint32_t)0xFFU) | ((flash->address + 1) & 0xFFUL);
+	}
+	return (miso);
+}
+
+/******************************************************************************
+* Function: spi_model_flash_end()
+*//**
+* \b Description:
+*
+* 	Static function which completes the command of a transaction when the
+* 	select is released. An erase is carried out only if exactly its opcode and
+* 	address were sent, and a program or erase clears WEL and leaves the flash
+* 	busy for busy_polls status reads.
+*
+* PRE-CONDITION: The model has just been deselected
+*
+* POST-CONDITION: Any program or erase has been carried out
+*
+* @param		flash a pointer to the flash model
+* @return 		void
+*
+* \b Example:
+*	Called by spi_model_deselect
+*
+* @see spi_model_flash_byte
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_model_flash_end(spi_model_flash_t *flash)
+{
+	uint8_t command = flash->command;
+	uint32_t position = flash->position;
+	uint8_t done = 0;
+
+	if (flash->write_enable == 0 || position == 0)
+	{
+		return;
+	}
+	if (command == SPI_MODEL_FLASH_PP && position > 4)
+	{
+		done = 1;
+	}
+	else if (command == SPI_MODEL_FLASH_SE && position == 4)
+	{
+		spi_model_flash_erase(flash, flash->address & ~(uint32_t)0xFFFU, 0x1000UL);
+		done = 1;
+	}
+	else if (command == SPI_MODEL_FLASH_BE && position == 4)
+	{
+		spi_model_flash_erase(flash, flash->address & ~(uint32_t)0xFFFFU, 0x10000UL);
+		done = 1;
+	}
+	else if ((command == SPI_MODEL_FLASH_CE || command == SPI_MODEL_FLASH_CE_ALT) && position == 1)
+	{
+		spi_model_flash_erase(flash, 0, flash->size);
+		done = 1;
+	}
+	else if (command == SPI_MODEL_FLASH_WRSR && position == 2)
+	{
+		done = 1;
+	}
+
+	if (done)
+	{
+		flash->write_enable = 0;
+		flash->busy = flash->busy_polls;
+	}
+}
+
+/******************************************************************************
+* Function: spi_model_flash_erase()
+*//**
+* \b Description:
+*
+* 	Static function which sets a range of the flash to 0xFF.
+*
+* PRE-CONDITION: The range is aligned to its own size
+*
+* POST-CONDITION: The range reads back as 0xFF
+*
+* @param		flash a pointer to the flash model
+* @param		address the first byte to erase
+* @param		length the number of bytes to erase
+* @return 		void
+*
+* \b Example:
+*	Called by spi_model_flash_end
+*
+* @see spi_model_flash_end
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_model_flash_erase(spi_model_flash_t *flash, uint32_t address, uint32_t length)
+{
+	for (uint32_t i = 0; i < length; i++)
+	{
+		flash->memory[(address + i) % flash->size] = 0xFFU;
+	}
+}
+
+/******************************************************************************
+* Function: spi_model_sd_byte()
+*//**
+* \b Description:
+*
+* 	Static function which advances the SD card by one byte. Queued response
+* 	bytes go out first, then the data phase of a read (start token, block, two
+* 	CRC bytes) or the busy frames after a write. Incoming bytes are collected
+* 	into command frames, which start with the bit pattern 01, or into the block
+* 	of a write once its start token has been seen. CRCs are not checked, as in
+* 	spi mode after CMD0 and CMD8.
+*
+* PRE-CONDITION: The model is selected
+*
+* POST-CONDITION: The card has advanced by one byte
+*
+* @param		sd a pointer to the SD card model
+* @param		mosi the byte sent by the master
+* @return 		uint8_t the byte sent back by the card
+*
+* \b Example:
+*	Called by spi_model_byte
+*
+* @see spi_model_sd_command
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_model_sd_byte(spi_model_sd_t *sd, uint8_t mosi)
+{
+	uint8_t *block = &sd->blocks[sd->block * SPI_MODEL_SD_BLOCK];
+	uint8_t miso = 0xFFU;
+
+	if (sd->response_index < sd->response_length)
+	{
+		miso = sd->response[sd->response_index++];
+	}
+	else if (sd->state == SD_MODEL_READ_DATA)
+	{
+		if (sd->position == 0)
+		{
+			miso = SPI_MODEL_SD_TOKEN;
+		}
+		else if (sd->position <= SPI_MODEL_SD_BLOCK)
+		{
+			miso = block[sd->position - 1];
+		}
+		sd->position++;
+		if (sd->position == SPI_MODEL_SD_BLOCK + 3)
+		{
+			sd->state = SD_MODEL_COMMAND;
+		}
+		return (miso);
+	}
+	else if (sd->state == SD_MODEL_WRITE_BUSY)
+	{
+		miso = 0x00;
+		sd->position--;
+		if (sd->position == 0)
+		{
+			sd->state = SD_MODEL_COMMAND;
+		}
+		return (miso);
+	}
+
+	if (sd->state == SD_MODEL_COMMAND)
+	{
+		if (sd->command_count != 0 || (mosi & 0xC0U) == 0x40U)
+		{
+			sd->command[sd->command_count++] = mosi;
+			if (sd->command_count == sizeof(sd->command))
+			{
+				sd->command_count = 0;
+				spi_model_sd_command(sd);
+			}
+		}
+	}
+	else if (sd->state == SD_MODEL_WRITE_TOKEN)
+	{
+		if (mosi == SPI_MODEL_SD_TOKEN)
+		{
+			sd->state = SD_MODEL_WRITE_DATA;
+			sd->position = 0;
+		}
+	}
+	else if (sd->state == SD_MODEL_WRITE_DATA)
+	{
+		if (sd->position < SPI_MODEL_SD_BLOCK)
+		{
+			block[sd->position] = mosi;
+		}
+		sd->position++;
+		if (sd->position == SPI_MODEL_SD_BLOCK + 2)
+		{
+			sd->response[0] = SPI_MODEL_SD_DATA_ACCEPTED;
+			sd->response_length = 1;
+			sd->response_index = 0;
+			sd->position = sd->busy_frames;
+			sd->state = (sd->busy_frames != 0) ? SD_MODEL_WRITE_BUSY : SD_MODEL_COMMAND;
+		}
+	}
+	return (miso);
+}
+
+/******************************************************************************
+* Function: spi_model_sd_command()
+*//**
+* \b Description:
+*
+* 	Static function which carries out a complete command frame and queues its
+* 	response behind one NCR byte. The card leaves the idle state after
+* 	init_polls + 1 ACMD41s; block commands are refused while it is idle, and
+* 	take block addresses as on a high capacity card.
+*
+* PRE-CONDITION: A whole command frame has been collected
+*
+* POST-CONDITION: The response is queued and the data phase, if any, set up
+*
+* @param		sd a pointer to the SD card model
+* @return 		void
+*
+* \b Example:
+*	Called by spi_model_sd_byte
+*
+* @see spi_model_sd_byte
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_model_sd_command(spi_model_sd_t *sd)
+{
+	uint8_t index = sd->command[0] & 0x3FU;
+	uint32_t argument = ((uint32_t)sd->command[1] << 24) | ((uint32_t)sd->command[2] << 16)
+			| ((uint32_t)sd->command[3] << 8) | sd->command[4];
+	uint8_t app_command = sd->app_command;
+	uint8_t errors = 0;
+
+	sd->app_command = 0;
+	sd->response[0] = 0xFFU;
+	sd->response_length = 2;
+	sd->response_index = 0;
+
+	if (index == 0)
+	{
+		sd->idle = 1;
+		sd->polls_left = sd->init_polls;
+	}
+	else if (index == 8)
+	{
+		sd->response[2] = 0x00;
+		sd->response[3] = 0x00;
+		sd->response[4] = (uint8_t)((argument >> 8) & 0x0FU);
+		sd->response[5] = (uint8_t)argument;
+		sd->response_length = 6;
+	}
+	else if (index == 55)
+	{
+		sd->app_command = 1;
+	}
+	else if (index == 41 && app_command)
+	{
+		if (sd->polls_left != 0)
+		{
+			sd->polls_left--;
+		}
+		else
+		{
+			sd->idle = 0;
+		}
+	}
+	else if (index == 58)
+	{
+		sd->response[2] = sd->idle ? 0x40U : 0xC0U;
+		sd->response[3] = 0xFFU;
+		sd->response[4] = 0x80U;
+		sd->response[5] = 0x00;
+		sd->response_length = 6;
+	}
+	else if (index == 16)
+	{
+		errors = (argument != SPI_MODEL_SD_BLOCK) ? SPI_MODEL_SD_R1_PARAMETER : 0;
+	}
+	else if ((index == 17 || index == 24) && !sd->idle)
+	{
+		if (argument >= sd->num_blocks)
+		{
+			errors = SPI_MODEL_SD_R1_PARAMETER;
+		}
+		else
+		{
+			sd->block = argument;
+			sd->position = 0;
+			sd->state = (index == 17) ? SD_MODEL_READ_DATA : SD_MODEL_WRITE_TOKEN;
+		}
+	}
+	else
+	{
+		errors = SPI_MODEL_SD_R1_ILLEGAL;
+	}
+	sd->response[1] = (sd->idle ? SPI_MODEL_SD_R1_IDLE : 0) | errors;
+}
+
+/******************************************************************************
+* Function: spi_model_sensor_byte()
+*//**
+* \b Description:
+*
+* 	Static function which advances the sensor by one byte. The first byte of a
+* 	transaction is the address, with the read and increment bits; the bytes
+* 	after it read or write consecutive registers. Bursts stop advancing at the
+* 	FIFO data register, so a long read drains the FIFO. The level and data
+* 	registers ignore writes.
+*
+* PRE-CONDITION: The model is selected
+*
+* POST-CONDITION: The sensor has advanced by one byte
+*
+* @param		sensor a pointer to the sensor model
+* @param		mosi the byte sent by the master
+* @return 		uint8_t the byte sent back by the sensor
+*
+* \b Example:
+*	Called by spi_model_byte
+*
+* @see spi_model_sensor_read
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_model_sensor_byte(spi_model_sensor_t *sensor, uint8_t mosi)
+{
+	uint8_t address = sensor->address;
+	uint8_t miso = 0xFFU;
+
+	if (sensor->phase == SPI_MODEL_SENSOR_ADDRESS)
+	{
+		sensor->address = mosi & (uint8_t)~(sensor->read_mask | sensor->increment_mask);
+		sensor->increment = (sensor->increment_mask == 0) || (mosi & sensor->increment_mask);
+		sensor->phase = (mosi & sensor->read_mask) ? SPI_MODEL_SENSOR_READ : SPI_MODEL_SENSOR_WRITE;
+		return (miso);
+	}
+
+	if (sensor->phase == SPI_MODEL_SENSOR_READ)
+	{
+		miso = spi_model_sensor_read(sensor, address);
+	}
+	else if (address < sensor->num_registers && address != sensor->data_register
+			&& address != sensor->level_register && address != sensor->level_register + 1)
+	{
+		sensor->registers[address] = mosi;
+	}
+
+	if (sensor->increment && address != sensor->data_register)
+	{
+		sensor->address++;
+	}
+	return (miso);
+}
+
+/******************************************************************************
+* Function: spi_model_sensor_read()
+*//**
+* \b Description:
+*
+* 	Static function which reads a register of the sensor. The level registers
+* 	report the FIFO level in bytes, little endian, and the data register pops
+* 	the oldest byte of the FIFO (0 once it is empty).
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: A read of the data register has removed a byte from the FIFO
+*
+* @param		sensor a pointer to the sensor model
+* @param		reg the register to read
+* @return 		uint8_t the value of the register, 0 beyond the map
+*
+* \b Example:
+*	Called by spi_model_sensor_byte
+*
+* @see spi_model_sensor_byte
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_model_sensor_read(spi_model_sensor_t *sensor, uint8_t reg)
+{
+	if (reg == sensor->data_register)
+	{
+		uint8_t value = 0;
+		if (sensor->fifo_count != 0)
+		{
+			value = sensor->fifo[sensor->fifo_head];
+			sensor->fifo_head = (uint16_t)((sensor->fifo_head + 1) % sensor->fifo_size);
+			sensor->fifo_count--;
+		}
+		return (value);
+	}
+	else if (reg == sensor->level_register)
+	{
+		return ((uint8_t)sensor->fifo_count);
+	}
+	else if (reg == sensor->level_register + 1)
+	{
+		return ((uint8_t)(sensor->fifo_count >> 8));
+	}
+	return ((reg < sensor->num_registers) ? sensor->registers[reg] : 0);
+}
+
+/******************************************************************************
+* Function: spi_model_chain_byte()
+*//**
+* \b Description:
+*
+* 	Static function which shifts a byte into the part nearest MOSI, moving every
+* 	byte one part along; the byte leaving the last part goes out on MISO.
+*
+* PRE-CONDITION: The model is selected
+*
+* POST-CONDITION: The chain has shifted by one byte
+*
+* @param		chain a pointer to the chain model
+* @param		mosi the byte sent by the master
+* @return 		uint8_t the byte shifted out of the chain
+*
+* \b Example:
+*	Called by spi_model_byte
+*
+* @see spi_chain_update
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_model_chain_byte(spi_model_chain_t *chain, uint8_t mosi)
+{
+	uint8_t last = (uint8_t)(chain->num_bytes - 1U);
+	uint8_t miso = chain->shift[last];
+
+	for (uint8_t i = last; i > 0; i--)
+	{
+		chain->shift[i] = chain->shift[i - 1U];
+	}
+	chain->shift[0] = mosi;
+	return (miso);
+}
@@ -0,0 +1,180 @@
+/*******************************************************************************
+* Title                 :   SPI Slave Device Models
+* Filename              :   spi_model.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_model.h
+ *  @brief Behavioural models of spi slaves (NOR flash, SD card in spi mode,
+ *  	register map sensor with a FIFO, shift register chain) which answer frame
+ *  	by frame, so that device stacks can be exercised and timed off target.
+ *  	tests/spi_sim.c attaches them to select pins behind the simulated channels.
+ */
+#ifndef _SPI_MODEL_H
+#define _SPI_MODEL_H
+
+#include "spi_interface.h"
+#include <stdint.h>
+
+/**
+ * Frame sent by spi_model_transfer once the transmit buffer has run out. Matches
+ * the driver's SPI_DUMMY_FRAME
+ */
+#ifndef SPI_MODEL_DUMMY_FRAME
+#define SPI_MODEL_DUMMY_FRAME 0x0000U
+#endif
+
+/**
+ * Largest shift register chain modelled, in bytes
+ */
+#ifndef SPI_MODEL_CHAIN_BYTES
+#define SPI_MODEL_CHAIN_BYTES 16U
+#endif
+
+/**
+ * Size of an SD card block in bytes
+ */
+#define SPI_MODEL_SD_BLOCK	512U
+
+/**
+ * Contains the slaves which can be modelled
+ */
+typedef enum
+{
+	MODEL_NOR_FLASH,	/**<JEDEC serial NOR flash (RDID, READ, PP, SE, BE, CE, RDSR, WREN, WRDI) */
+	MODEL_SD_CARD,		/**<Block addressed SD card in spi mode (CMD0, 8, 16, 17, 24, 55, 58, ACMD41) */
+	MODEL_SENSOR,		/**<8 bit register map with a FIFO drained through a single data register */
+	MODEL_SHIFT_CHAIN	/**<Daisy chain of shift registers latched when the select is released */
+}spi_model_kind_t;
+
+/**
+ * Contains the states of the SD card model between frames
+ */
+typedef enum
+{
+	SD_MODEL_COMMAND,		/**<Collecting a command frame */
+	SD_MODEL_READ_DATA,		/**<Sending a start token, a block and its CRC */
+	SD_MODEL_WRITE_TOKEN,	/**<Waiting for the start token of a block to write */
+	SD_MODEL_WRITE_DATA,	/**<Receiving a block and its CRC */
+	SD_MODEL_WRITE_BUSY		/**<Holding MISO low while the block is "programmed" */
+}spi_model_sd_state_t;
+
+/**
+ * Struct describing a NOR flash model and holding its state
+ */
+typedef struct
+{
+	uint8_t *memory;			/**<Contents of the flash, size bytes */
+	uint32_t size;				/**<Size of the flash in bytes, a multiple of 64k */
+	uint8_t jedec_id[3];		/**<Manufacturer, memory type and capacity returned by RDID */
+	uint16_t busy_polls;		/**<Status reads reporting WIP after a program or erase */
+	uint8_t command;			/**<Opcode of the current command (set by the model) */
+	uint32_t address;			/**<Address of the current command (set by the model) */
+	uint32_t position;			/**<Bytes received since the select (set by the model) */
+	uint8_t write_enable;		/**<WEL bit (set by the model) */
+	uint16_t busy;				/**<Status reads left before WIP clears (set by the model) */
+}spi_model_flash_t;
+
+/**
+ * Struct describing an SD card model and holding its state
+ */
+typedef struct
+{
+	uint8_t *blocks;				/**<Contents of the card, num_blocks blocks of SPI_MODEL_SD_BLOCK bytes */
+	uint32_t num_blocks;			/**<Number of blocks on the card */
+	uint8_t init_polls;				/**<ACMD41s answered "idle" before the card reports ready */
+	uint8_t busy_frames;			/**<Frames MISO is held low after a block write */
+	spi_model_sd_state_t state;		/**<Current state (set by the model) */
+	uint8_t idle;					/**<Card is in the idle state (set by the model) */
+	uint8_t app_command;			/**<The previous command was CMD55 (set by the model) */
+	uint8_t polls_left;				/**<ACMD41s left before the card is ready (set by the model) */
+	uint8_t command[6];				/**<Command frame being collected (set by the model) */
+	uint8_t command_count;			/**<Bytes of the command collected (set by the model) */
+	uint8_t response[8];			/**<Response bytes waiting to be sent (set by the model) */
+	uint8_t response_length;		/**<Number of response bytes (set by the model) */
+	uint8_t response_index;			/**<Next response byte to send (set by the model) */
+	uint32_t block;					/**<Block being read or written (set by the model) */
+	uint32_t position;				/**<Byte of the data phase reached (set by the model) */
+}spi_model_sd_t;
+
+/**
+ * Struct describing a register map sensor model and holding its state
+ */
+typedef struct
+{
+	uint8_t *registers;			/**<Register contents, num_registers bytes */
+	uint16_t num_registers;		/**<Number of registers, addresses run from 0 to num_registers - 1 */
+	uint8_t read_mask;			/**<Address bits flagging a read (e.g. 0x80) */
+	uint8_t increment_mask;		/**<Address bits enabling auto increment, 0 if it is always enabled */
+	uint8_t level_register;		/**<Register holding the low byte of the FIFO level in bytes, the high byte follows */
+	uint8_t data_register;		/**<FIFO output register. Reads of it pop the FIFO and do not increment */
+	uint8_t *fifo;				/**<Storage of the FIFO, fifo_size bytes */
+	uint16_t fifo_size;			/**<Capacity of the FIFO in bytes */
+	uint16_t fifo_head;			/**<Oldest byte in the FIFO (set by the model) */
+	uint16_t fifo_count;		/**<Bytes in the FIFO (set by the model) */
+	uint8_t address;			/**<Register addressed by the next data frame (set by the model) */
+	uint8_t increment;			/**<The address advances after each data frame (set by the model) */
+	uint8_t phase;				/**<0 while the address frame is expected, 1 for reads, 2 for writes (set by the model) */
+}spi_model_sensor_t;
+
+/**
+ * Struct describing a shift register chain model and holding its state. Byte 0
+ * is the part nearest MOSI, the last byte the part driving MISO
+ */
+typedef struct
+{
+	uint8_t num_bytes;						/**<Length of the chain in bytes */
+	uint8_t inputs[SPI_MODEL_CHAIN_BYTES];	/**<Parallel inputs loaded into the chain on select (74HC165 style) */
+	uint8_t outputs[SPI_MODEL_CHAIN_BYTES];	/**<Outputs latched when the select is released (74HC595 style) */
+	uint8_t shift[SPI_MODEL_CHAIN_BYTES];	/**<Contents of the shift registers (set by the model) */
+}spi_model_chain_t;
+
+/**
+ * Struct holding a slave model, its bus state and its counters
+ */
+typedef struct
+{
+	spi_model_kind_t kind;				/**<Which of the models in device is in use */
+	uint8_t selected;					/**<The slave select is asserted (set by the model) */
+	uint32_t selections;				/**<Times the slave has been selected since init */
+	uint32_t frames;					/**<Frames exchanged since init */
+	union
+	{
+		spi_model_flash_t flash;
+		spi_model_sd_t sd;
+		spi_model_sensor_t sensor;
+		spi_model_chain_t chain;
+	}device;							/**<Configuration and state of the model */
+}spi_model_t;
+
+void spi_model_init(spi_model_t *model);
+void spi_model_select(spi_model_t *model);
+void spi_model_deselect(spi_model_t *model);
+uint16_t spi_model_exchange(spi_model_t *model, uint16_t mosi, uint8_t bits);
+void spi_model_transfer(spi_model_t *model, const spi_transfer_t *transfer);
+uint16_t spi_model_sensor_push(spi_model_t *model, const uint8_t *data, uint16_t count);
+
+#endif
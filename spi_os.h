@@ -0,0 +1,68 @@
+/*******************************************************************************
+* Title                 :   SPI OS Abstraction
+* Filename              :   spi_os.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_os.h
+ *  @brief Hooks through which the spi driver serialises tasks sharing a channel
+ *  	and puts a task to sleep while its interrupt transfer completes. A port
+ *  	(e.g. spi_os_posix.c) implements them for the operating system in use.
+ */
+#ifndef _SPI_OS_H
+#define _SPI_OS_H
+
+#include "spi_stm32f411_config.h"
+#include <stdint.h>
+
+/**
+ * Set to 1 to build the driver against an os port. When 0 the hooks compile away
+ * and waits for interrupt transfers sleep with WFE
+ */
+#ifndef SPI_OS_ENABLE
+#define SPI_OS_ENABLE 0
+#endif
+
+/**
+ * Set to 1 for the channel locks to lend the priority of a blocked task to the
+ * task holding the lock, where the os supports it
+ */
+#ifndef SPI_OS_PRIORITY_INHERITANCE
+#define SPI_OS_PRIORITY_INHERITANCE 1
+#endif
+
+/*
+ * The channel locks must be recursive: a task which has locked a channel with
+ * spi_bus_acquire goes on to transfer on it, locking it again.
+ */
+void spi_os_init(spi_channel_t channel);
+void spi_os_deinit(spi_channel_t channel);
+void spi_os_lock(spi_channel_t channel);
+void spi_os_unlock(spi_channel_t channel);
+void spi_os_wait(spi_channel_t channel);
+void spi_os_signal(spi_channel_t channel);
+
+#endif
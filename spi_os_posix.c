@@ -0,0 +1,266 @@
+/*******************************************************************************
+* Title                 :   SPI OS Port for POSIX Threads
+* Filename              :   spi_os_posix.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   GCC
+* Target                :   Linux/POSIX host
+* Notes                 :   Link with -pthread
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_os_posix.c
+ *  @brief Implements the spi os hooks with POSIX threads, so that contention
+ *  	between tasks sharing a channel can be exercised and measured on a host.
+ */
+#define _XOPEN_SOURCE 700
+
+#include "spi_os.h"
+#include <pthread.h>
+#include <assert.h>
+
+/**
+ * Binary semaphore built from a mutex, a condition variable and a flag
+ */
+typedef struct
+{
+	pthread_mutex_t lock;	/**<Protects given */
+	pthread_cond_t cond;	/**<Signalled when given is set */
+	uint8_t given;			/**<1 when the semaphore is available */
+}spi_os_semaphore_t;
+
+/**
+ * Static array of the locks serialising the tasks on each spi device
+ */
+static pthread_mutex_t spi_os_locks[NUM_SPI];
+
+/**
+ * Static array of the completion semaphores of each spi device
+ */
+static spi_os_semaphore_t spi_os_semaphores[NUM_SPI];
+
+/******************************************************************************
+* Function: spi_os_init()
+*//**
+* \b Description:
+*
+* 	Creates the channel's recursive lock, with priority inheritance when
+* 	SPI_OS_PRIORITY_INHERITANCE is set, and its empty completion semaphore.
+*
+* PRE-CONDITION: The channel's objects have not been created yet
+*
+* POST-CONDITION: The channel can be locked, waited on and signalled
+*
+* @param		channel the spi device of interest
+* @return 		void
+*
+* \b Example:
+*	Called by spi_init for every enabled channel
+*
+* @see spi_os_deinit
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_os_init(spi_channel_t channel)
+{
+	assert(channel < NUM_SPI);
+	pthread_mutexattr_t attributes;
+	pthread_mutexattr_init(&attributes);
+	pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+#if SPI_OS_PRIORITY_INHERITANCE
+	pthread_mutexattr_setprotocol(&attributes, PTHREAD_PRIO_INHERIT);
+#endif
+	pthread_mutex_init(&spi_os_locks[channel], &attributes);
+	pthread_mutexattr_destroy(&attributes);
+
+	pthread_mutex_init(&spi_os_semaphores[channel].lock, NULL);
+	pthread_cond_init(&spi_os_semaphores[channel].cond, NULL);
+	spi_os_semaphores[channel].given = 0;
+}
+
+/******************************************************************************
+* Function: spi_os_deinit()
+*//**
+* \b Description:
+*
+* 	Destroys the channel's lock and completion semaphore.
+*
+* PRE-CONDITION: No task holds or waits on the channel
+*
+* POST-CONDITION: spi_os_init must be called again before the channel is used
+*
+* @param		channel the spi device of interest
+* @return 		void
+*
+* \b Example:
+*	Called by spi_deinit for every enabled channel
+*
+* @see spi_os_init
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_os_deinit(spi_channel_t channel)
+{
+	assert(channel < NUM_SPI);
+	pthread_mutex_destroy(&spi_os_locks[channel]);
+	pthread_cond_destroy(&spi_os_semaphores[channel].cond);
+	pthread_mutex_destroy(&spi_os_semaphores[channel].lock);
+}
+
+/******************************************************************************
+* Function: spi_os_lock()
+*//**
+* \b Description:
+*
+* 	Takes ownership of the channel, sleeping while another task holds it.
+*
+* PRE-CONDITION: spi_os_init has been called for the channel
+*
+* POST-CONDITION: The calling task owns the channel
+*
+* @param		channel the spi device of interest
+* @return 		void
+*
+* \b Example:
+*	Called by the driver around every transfer made from task context
+*
+* @see spi_os_unlock
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_os_lock(spi_channel_t channel)
+{
+	pthread_mutex_lock(&spi_os_locks[channel]);
+}
+
+/******************************************************************************
+* Function: spi_os_unlock()
+*//**
+* \b Description:
+*
+* 	Hands the channel back, waking the next task waiting for it.
+*
+* PRE-CONDITION: The calling task owns the channel
+*
+* POST-CONDITION: The channel is free
+*
+* @param		channel the spi device of interest
+* @return 		void
+*
+* \b Example:
+*	Called by the driver at the end of every transfer made from task context
+*
+* @see spi_os_lock
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_os_unlock(spi_channel_t channel)
+{
+	pthread_mutex_unlock(&spi_os_locks[channel]);
+}
+
+/******************************************************************************
+* Function: spi_os_wait()
+*//**
+* \b Description:
+*
+* 	Sleeps until the channel's completion semaphore is given, then takes it.
+*
+* PRE-CONDITION: spi_os_init has been called for the channel
+*
+* POST-CONDITION: The semaphore is empty
+*
+* @param		channel the spi device of interest
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer_it_wait while its transfer is in progress
+*
+* @see spi_os_signal
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_os_wait(spi_channel_t channel)
+{
+	spi_os_semaphore_t *semaphore = &spi_os_semaphores[channel];
+	pthread_mutex_lock(&semaphore->lock);
+	while (semaphore->given == 0)
+	{
+		pthread_cond_wait(&semaphore->cond, &semaphore->lock);
+	}
+	semaphore->given = 0;
+	pthread_mutex_unlock(&semaphore->lock);
+}
+
+/******************************************************************************
+* Function: spi_os_signal()
+*//**
+* \b Description:
+*
+* 	Gives the channel's completion semaphore. Giving an already available
+* 	semaphore has no further effect.
+*
+* PRE-CONDITION: spi_os_init has been called for the channel
+*
+* POST-CONDITION: The semaphore is available and any waiting task has been woken
+*
+* @param		channel the spi device of interest
+* @return 		void
+*
+* \b Example:
+*	Called from the channel's interrupt whenever a queued transfer completes
+*
+* @see spi_os_wait
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_os_signal(spi_channel_t channel)
+{
+	spi_os_semaphore_t *semaphore = &spi_os_semaphores[channel];
+	pthread_mutex_lock(&semaphore->lock);
+	semaphore->given = 1;
+	pthread_cond_signal(&semaphore->cond);
+	pthread_mutex_unlock(&semaphore->lock);
+}
@@ -0,0 +1,594 @@
+/*******************************************************************************
+* Title                 :   SPI Register Map
+* Filename              :   spi_regmap.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_regmap.c
+ *  @brief Register cache, write skipping and burst coalescing for spi devices.
+ */
+#include "spi_regmap.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+static uint8_t spi_regmap_address(spi_regmap_t *map, uint16_t reg, uint16_t mask, uint16_t *frames);
+static void spi_regmap_burst_write(spi_regmap_t *map, uint16_t reg, uint16_t count);
+static void spi_regmap_burst_read(spi_regmap_t *map, uint16_t reg, uint8_t *data, uint16_t count);
+
+/******************************************************************************
+* Function: spi_regmap_init()
+*//**
+* \b Description:
+*
+* 	Prepares the cache of a register map. Every register starts out uncached and
+* 	clean; only the SPI_REGMAP_VOLATILE flags supplied by the user are kept.
+*
+* PRE-CONDITION: The bus, masks, num_registers, cache and flags members are filled out
+* PRE-CONDITION: spi_init() has configured the channel as a full duplex master
+*
+* POST-CONDITION: The map is ready for use and holds no cached values
+*
+* @param		map a pointer to the register map to initialise
+* @return 		void
+*
+* \b Example:
+* @code
+*	static uint8_t imu_cache[0x80];
+*	static uint8_t imu_flags[0x80];
+*	imu_flags[0x1E] = SPI_REGMAP_VOLATILE;		//STATUS
+*	imu.bus = imu_bus;
+*	imu.address_width = REGMAP_ADDR_8BIT;
+*	imu.read_mask = 0x80;
+*	imu.write_mask = 0x00;
+*	imu.increment_mask = 0x00;
+*	imu.num_registers = 0x80;
+*	imu.cache = imu_cache;
+*	imu.flags = imu_flags;
+*	spi_regmap_init(&imu);
+* @endcode
+*
+* @see spi_regmap_invalidate
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_regmap_init(spi_regmap_t *map)
+{
+	assert(map != NULL);
+	assert(map->cache != NULL && map->flags != NULL);
+	assert(map->num_registers != 0);
+	spi_regmap_invalidate(map);
+}
+
+/******************************************************************************
+* Function: spi_regmap_read()
+*//**
+* \b Description:
+*
+* 	Returns the value of a single register. Cached registers are served from RAM
+* 	without touching the bus; volatile and not yet cached registers are read from
+* 	the device, the latter then being cached.
+*
+* PRE-CONDITION: spi_regmap_init() has been called on the map
+* PRE-CONDITION: reg < num_registers
+*
+* POST-CONDITION: A non-volatile register is cached after the call
+*
+* @param		map a pointer to the register map
+* @param		reg the register address
+* @return 		uint8_t the register's value
+*
+* \b Example:
+* @code
+*	uint8_t whoami = spi_regmap_read(&imu, 0x0F);
+* @endcode
+*
+* @see spi_regmap_read_block
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_regmap_read(spi_regmap_t *map, uint16_t reg)
+{
+	assert(map != NULL && reg < map->num_registers);
+	uint8_t value;
+
+	if ((map->flags[reg] & (SPI_REGMAP_VOLATILE | SPI_REGMAP_VALID)) == SPI_REGMAP_VALID)
+	{
+		return (map->cache[reg]);
+	}
+	spi_regmap_burst_read(map, reg, &value, 1);
+	return (value);
+}
+
+/******************************************************************************
+* Function: spi_regmap_read_block()
+*//**
+* \b Description:
+*
+* 	Reads count consecutive registers from the device using auto-increment
+* 	bursts of up to SPI_REGMAP_MAX_BURST registers. Non-volatile registers
+* 	which are not awaiting a write are refreshed in the cache; registers with a
+* 	pending write report the pending value.
+*
+* PRE-CONDITION: spi_regmap_init() has been called on the map
+* PRE-CONDITION: reg + count <= num_registers
+* PRE-CONDITION: data is non-NULL
+*
+* POST-CONDITION: data holds the values of the count registers starting at reg
+*
+* @param		map a pointer to the register map
+* @param		reg the first register address
+* @param		data the destination for the register values
+* @param		count the number of registers to read
+* @return 		void
+*
+* \b Example:
+* @code
+*	uint8_t raw_accel[6];
+*	spi_regmap_read_block(&imu, 0x28, raw_accel, sizeof(raw_accel));
+* @endcode
+*
+* @see spi_regmap_read
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_regmap_read_block(spi_regmap_t *map, uint16_t reg, uint8_t *data, uint16_t count)
+{
+	assert(map != NULL && data != NULL);
+	assert((uint32_t)reg + count <= map->num_registers);
+
+	while (count > 0)
+	{
+		uint16_t burst = (count > SPI_REGMAP_MAX_BURST) ? SPI_REGMAP_MAX_BURST : count;
+		spi_regmap_burst_read(map, reg, data, burst);
+		reg += burst;
+		data += burst;
+		count -= burst;
+	}
+}
+
+/******************************************************************************
+* Function: spi_regmap_write()
+*//**
+* \b Description:
+*
+* 	Writes a register through the cache. A write of the value already held by a
+* 	cached register is dropped; any other write is held until spi_regmap_sync.
+* 	Volatile registers are written straight away, after any pending writes, so
+* 	that the order the device sees matches the order of the calls.
+*
+* PRE-CONDITION: spi_regmap_init() has been called on the map
+* PRE-CONDITION: reg < num_registers
+*
+* POST-CONDITION: The cache holds value and the register is dirty if it changed
+*
+* @param		map a pointer to the register map
+* @param		reg the register address
+* @param		value the new value of the register
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_regmap_write(&imu, 0x20, 0x57);
+*	spi_regmap_write(&imu, 0x21, 0x00);
+*	spi_regmap_write(&imu, 0x23, 0x88);
+*	spi_regmap_sync(&imu);
+* @endcode
+*
+* @see spi_regmap_sync
+* @see spi_regmap_update_bits
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_regmap_write(spi_regmap_t *map, uint16_t reg, uint8_t value)
+{
+	assert(map != NULL && reg < map->num_registers);
+
+	if ((map->flags[reg] & SPI_REGMAP_VOLATILE) != 0)
+	{
+		spi_regmap_sync(map);
+		map->cache[reg] = value;
+		spi_regmap_burst_write(map, reg, 1);
+		return;
+	}
+
+	if ((map->flags[reg] & SPI_REGMAP_VALID) != 0 && map->cache[reg] == value)
+	{
+		return;
+	}
+	map->cache[reg] = value;
+	map->flags[reg] |= SPI_REGMAP_VALID | SPI_REGMAP_DIRTY;
+}
+
+/******************************************************************************
+* Function: spi_regmap_update_bits()
+*//**
+* \b Description:
+*
+* 	Read-modify-write of the bits selected by mask. The read is served from the
+* 	cache whenever possible, and the write is skipped if nothing changes.
+*
+* PRE-CONDITION: spi_regmap_init() has been called on the map
+* PRE-CONDITION: reg < num_registers
+*
+* POST-CONDITION: The bits of mask in the register equal those of value
+*
+* @param		map a pointer to the register map
+* @param		reg the register address
+* @param		mask the bits to change
+* @param		value the new state of the masked bits
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_regmap_update_bits(&imu, 0x23, 0x30, 0x10);		//+-4g full scale
+*	spi_regmap_sync(&imu);
+* @endcode
+*
+* @see spi_regmap_write
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_regmap_update_bits(spi_regmap_t *map, uint16_t reg, uint8_t mask, uint8_t value)
+{
+	uint8_t current = spi_regmap_read(map, reg);
+	spi_regmap_write(map, reg, (current & ~mask) | (value & mask));
+}
+
+/******************************************************************************
+* Function: spi_regmap_sync()
+*//**
+* \b Description:
+*
+* 	Sends every pending write to the device. Runs of consecutive dirty registers
+* 	are coalesced into a single auto-increment burst per run (split every
+* 	SPI_REGMAP_MAX_BURST registers).
+*
+* PRE-CONDITION: spi_regmap_init() has been called on the map
+*
+* POST-CONDITION: No register is dirty and the device matches the cache
+*
+* @param		map a pointer to the register map
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_regmap_sync(&imu);
+* @endcode
+*
+* @see spi_regmap_write
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_regmap_sync(spi_regmap_t *map)
+{
+	assert(map != NULL);
+	uint16_t reg = 0;
+
+	while (reg < map->num_registers)
+	{
+		if ((map->flags[reg] & SPI_REGMAP_DIRTY) == 0)
+		{
+			reg++;
+			continue;
+		}
+
+		uint16_t count = 1;
+		while ((uint32_t)reg + count < map->num_registers
+				&& count < SPI_REGMAP_MAX_BURST
+				&& (map->flags[reg + count] & SPI_REGMAP_DIRTY) != 0)
+		{
+			count++;
+		}
+		spi_regmap_burst_write(map, reg, count);
+		for (uint16_t i = 0; i < count; i++)
+		{
+			map->flags[reg + i] &= ~SPI_REGMAP_DIRTY;
+		}
+		reg += count;
+	}
+}
+
+/******************************************************************************
+* Function: spi_regmap_invalidate()
+*//**
+* \b Description:
+*
+* 	Forgets every cached value and drops pending writes, e.g. after the device
+* 	has been reset.
+*
+* PRE-CONDITION: The map's cache and flags are non-NULL
+*
+* POST-CONDITION: No register is cached or dirty
+*
+* @param		map a pointer to the register map
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_regmap_write(&imu, 0x24, 0x80);		//BOOT
+*	spi_regmap_sync(&imu);
+*	spi_regmap_invalidate(&imu);
+* @endcode
+*
+* @see spi_regmap_init
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_regmap_invalidate(spi_regmap_t *map)
+{
+	assert(map != NULL);
+	for (uint16_t reg = 0; reg < map->num_registers; reg++)
+	{
+		map->flags[reg] &= SPI_REGMAP_VOLATILE;
+	}
+}
+
+/******************************************************************************
+* Function: spi_regmap_read_raw()
+*//**
+* \b Description:
+*
+* 	Reads count frames starting at a register address in one transfer, bypassing
+* 	the cache. With REGMAP_BURST_INCREMENT the increment bits are applied for
+* 	counts above one, exactly as for a block read, and consecutive registers are
+* 	read. With REGMAP_BURST_FIXED they are left clear, so that every frame comes
+* 	from the same register: this is the burst for FIFO output registers and other
+* 	streams which are longer than the register map itself. A device which always
+* 	increments (increment_mask of 0) decides for itself.
+*
+* PRE-CONDITION: spi_regmap_init() has been called on the map
+* PRE-CONDITION: frames has room for count + SPI_REGMAP_ADDRESS_FRAMES entries
+*
+* POST-CONDITION: The first count entries of frames hold the received data
+*
+* @param		map a pointer to the register map
+* @param		reg the register address to stream from
+* @param		frames the destination, which is also used for the address phase
+* @param		count the number of data frames to read
+* @param		burst whether the address advances during the burst
+* @return 		void
+*
+* \b Example:
+* @code
+*	uint16_t fifo_frames[192 + SPI_REGMAP_ADDRESS_FRAMES];
+*	spi_regmap_read_raw(&imu, 0x74, fifo_frames, 192, REGMAP_BURST_FIXED);
+* @endcode
+*
+* @see spi_regmap_read_block
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_regmap_read_raw(spi_regmap_t *map, uint16_t reg, uint16_t *frames, uint32_t count, spi_regmap_burst_t burst)
+{
+	assert(map != NULL && frames != NULL && count != 0);
+	uint16_t address[SPI_REGMAP_ADDRESS_FRAMES];
+	uint16_t mask = map->read_mask | ((count > 1 && burst == REGMAP_BURST_INCREMENT) ? map->increment_mask : 0);
+	uint8_t address_frames = spi_regmap_address(map, reg, mask, address);
+
+	spi_transfer_t transfer = map->bus;
+	transfer.data_format = SPI_DATA_8BIT;
+	transfer.tx_buffer = address;
+	transfer.tx_length = address_frames;
+	transfer.rx_buffer = frames;
+	transfer.rx_length = address_frames + count;
+	spi_transfer(&transfer);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		frames[i] = frames[address_frames + i];
+	}
+}
+
+/******************************************************************************
+* Function: spi_regmap_address()
+*//**
+* \b Description:
+*
+* 	Static function which writes the address phase of a transaction into the
+* 	start of a frame buffer.
+*
+* PRE-CONDITION: frames has room for SPI_REGMAP_ADDRESS_FRAMES entries
+*
+* POST-CONDITION: The address phase has been placed in frames
+*
+* @param		map a pointer to the register map
+* @param		reg the register address
+* @param		mask the read/write/increment bits of the transaction
+* @param		frames the frame buffer to fill
+* @return 		uint8_t the number of address frames written
+*
+* \b Example:
+*	Called by spi_regmap_burst_write and spi_regmap_burst_read
+*
+* @see spi_regmap_burst_write
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_regmap_address(spi_regmap_t *map, uint16_t reg, uint16_t mask, uint16_t *frames)
+{
+	uint16_t address = reg | mask;
+	if (map->address_width == REGMAP_ADDR_16BIT)
+	{
+		frames[0] = address >> 8;
+		frames[1] = address & 0xFFU;
+		return (2);
+	}
+	frames[0] = address & 0xFFU;
+	return (1);
+}
+
+/******************************************************************************
+* Function: spi_regmap_burst_write()
+*//**
+* \b Description:
+*
+* 	Static function which writes count cached registers starting at reg to the
+* 	device in one transmit-only transfer.
+*
+* PRE-CONDITION: 0 < count <= SPI_REGMAP_MAX_BURST
+*
+* POST-CONDITION: The device registers hold the cached values
+*
+* @param		map a pointer to the register map
+* @param		reg the first register address
+* @param		count the number of registers to write
+* @return 		void
+*
+* \b Example:
+*	Called by spi_regmap_sync and spi_regmap_write
+*
+* @see spi_regmap_sync
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_regmap_burst_write(spi_regmap_t *map, uint16_t reg, uint16_t count)
+{
+	uint16_t frames[SPI_REGMAP_ADDRESS_FRAMES + SPI_REGMAP_MAX_BURST];
+	uint16_t mask = map->write_mask | ((count > 1) ? map->increment_mask : 0);
+	uint8_t address_frames = spi_regmap_address(map, reg, mask, frames);
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		frames[address_frames + i] = map->cache[reg + i];
+	}
+
+	spi_transfer_t transfer = map->bus;
+	transfer.data_format = SPI_DATA_8BIT;
+	transfer.tx_buffer = frames;
+	transfer.tx_length = address_frames + count;
+	transfer.rx_buffer = NULL;
+	transfer.rx_length = 0;
+	spi_transfer(&transfer);
+}
+
+/******************************************************************************
+* Function: spi_regmap_burst_read()
+*//**
+* \b Description:
+*
+* 	Static function which reads count registers starting at reg in one transfer
+* 	and refreshes the cache for the non-volatile, clean ones.
+*
+* PRE-CONDITION: 0 < count <= SPI_REGMAP_MAX_BURST
+*
+* POST-CONDITION: data holds the register values (pending values for dirty ones)
+*
+* @param		map a pointer to the register map
+* @param		reg the first register address
+* @param		data the destination for the register values
+* @param		count the number of registers to read
+* @return 		void
+*
+* \b Example:
+*	Called by spi_regmap_read and spi_regmap_read_block
+*
+* @see spi_regmap_read_block
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_regmap_burst_read(spi_regmap_t *map, uint16_t reg, uint8_t *data, uint16_t count)
+{
+	uint16_t tx_frames[SPI_REGMAP_ADDRESS_FRAMES];
+	uint16_t rx_frames[SPI_REGMAP_ADDRESS_FRAMES + SPI_REGMAP_MAX_BURST];
+	uint16_t mask = map->read_mask | ((count > 1) ? map->increment_mask : 0);
+	uint8_t address_frames = spi_regmap_address(map, reg, mask, tx_frames);
+
+	spi_transfer_t transfer = map->bus;
+	transfer.data_format = SPI_DATA_8BIT;
+	transfer.tx_buffer = tx_frames;
+	transfer.tx_length = address_frames;
+	transfer.rx_buffer = rx_frames;
+	transfer.rx_length = address_frames + count;
+	spi_transfer(&transfer);
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		uint8_t flags = map->flags[reg + i];
+		if ((flags & SPI_REGMAP_DIRTY) != 0)
+		{
+			data[i] = map->cache[reg + i];
+		}
+		else
+		{
+			data[i] = rx_frames[address_frames + i] & 0xFFU;
+			if ((flags & SPI_REGMAP_VOLATILE) == 0)
+			{
+				map->cache[reg + i] = data[i];
+				map->flags[reg + i] |= SPI_REGMAP_VALID;
+			}
+		}
+	}
+}
@@ -0,0 +1,109 @@
+/*******************************************************************************
+* Title                 :   SPI Register Map
+* Filename              :   spi_regmap.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_regmap.h
+ *  @brief Cached register access for spi devices with 8 bit registers. Writes are
+ *  	held in the cache and sent in auto-increment bursts by spi_regmap_sync.
+ */
+#ifndef _SPI_REGMAP_H
+#define _SPI_REGMAP_H
+
+#include "spi_interface.h"
+#include <stdint.h>
+
+/**
+ * Largest number of registers sent or received in a single burst
+ */
+#ifndef SPI_REGMAP_MAX_BURST
+#define SPI_REGMAP_MAX_BURST 32U
+#endif
+
+/**
+ * Longest address phase in frames
+ */
+#define SPI_REGMAP_ADDRESS_FRAMES	2U
+
+/**
+ * The register changes on its own (status, data, FIFO) and is never cached
+ */
+#define SPI_REGMAP_VOLATILE	0x01U
+
+/**
+ * The cached value matches the device (set by the driver)
+ */
+#define SPI_REGMAP_VALID	0x02U
+
+/**
+ * The cached value has yet to be written to the device (set by the driver)
+ */
+#define SPI_REGMAP_DIRTY	0x04U
+
+/**
+ * Contains the options for the width of the address phase
+ */
+typedef enum
+{
+	REGMAP_ADDR_8BIT,	/**<The address (and read/write/increment bits) fit in one byte */
+	REGMAP_ADDR_16BIT	/**<The address is sent as two bytes, most significant first */
+}spi_regmap_addr_width_t;
+
+/**
+ * Contains the options for the addressing of a raw burst read
+ */
+typedef enum
+{
+	REGMAP_BURST_INCREMENT,	/**<The increment bits are sent and the burst walks consecutive registers */
+	REGMAP_BURST_FIXED		/**<The increment bits are left clear and every frame comes from the same register */
+}spi_regmap_burst_t;
+
+/**
+ * Struct describing a device's register map and holding its cache
+ */
+typedef struct
+{
+	spi_transfer_t bus;						/**<Channel, slave pin and clock settings of the device. Buffers are ignored */
+	spi_regmap_addr_width_t address_width;	/**<Size of the address phase */
+	uint16_t read_mask;						/**<Bits OR-ed into the address for reads (e.g. 0x80) */
+	uint16_t write_mask;					/**<Bits OR-ed into the address for writes (usually 0) */
+	uint16_t increment_mask;				/**<Bits OR-ed into the address for multi register bursts (e.g. 0x40, or 0) */
+	uint16_t num_registers;					/**<Number of registers, addresses run from 0 to num_registers - 1 */
+	uint8_t *cache;							/**<num_registers bytes holding the cached values */
+	uint8_t *flags;							/**<num_registers bytes, SPI_REGMAP_VOLATILE set by the user where needed */
+}spi_regmap_t;
+
+void spi_regmap_init(spi_regmap_t *map);
+uint8_t spi_regmap_read(spi_regmap_t *map, uint16_t reg);
+void spi_regmap_read_block(spi_regmap_t *map, uint16_t reg, uint8_t *data, uint16_t count);
+void spi_regmap_read_raw(spi_regmap_t *map, uint16_t reg, uint16_t *frames, uint32_t count, spi_regmap_burst_t burst);
+void spi_regmap_write(spi_regmap_t *map, uint16_t reg, uint8_t value);
+void spi_regmap_update_bits(spi_regmap_t *map, uint16_t reg, uint8_t mask, uint8_t value);
+void spi_regmap_sync(spi_regmap_t *map);
+void spi_regmap_invalidate(spi_regmap_t *map);
+
+#endif
@@ -0,0 +1,237 @@
+/*******************************************************************************
+* Title                 :   SPI Periodic Scheduler
+* Filename              :   spi_schedule.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_schedule.c
+ *  @brief Timer driven release of periodic spi transfers with per slot start
+ *  	jitter statistics.
+ */
+#include "spi_schedule.h"
+#include "stm32f411xe.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+/******************************************************************************
+* Function: spi_schedule_init()
+*//**
+* \b Description:
+*
+* 	Checks the slots of a schedule, loads each slot's phase and clears its
+* 	statistics. The DWT cycle counter used to time the releases is started if
+* 	it is not running already.
+*
+* PRE-CONDITION: spi_init() has been called for every channel used by the slots
+* PRE-CONDITION: Each slot has a non-zero period and a phase smaller than its period
+* PRE-CONDITION: No other interrupt handler calls spi_transfer_it_from_isr on the slots' channels
+*
+* POST-CONDITION: The schedule is released by calls to spi_schedule_tick
+*
+* @param		schedule a pointer to the schedule
+* @return 		void
+*
+* \b Example:
+* @code
+*	static spi_schedule_slot_t sensor_slots[2] =
+*	{
+*		{&gyro_transfer, 1, 0},
+*		{&mag_transfer, 4, 2}
+*	};
+*	static spi_schedule_t sensor_schedule = {sensor_slots, 2, 25000};
+*	spi_schedule_init(&sensor_schedule);
+*	TIM2->CR1 |= TIM_CR1_CEN;
+* @endcode
+*
+* @see spi_schedule_tick
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_schedule_init(spi_schedule_t *schedule)
+{
+	assert(schedule != NULL && schedule->slots != NULL && schedule->tick_cycles != 0);
+	for (uint8_t i = 0; i < schedule->num_slots; i++)
+	{
+		spi_schedule_slot_t *slot = &schedule->slots[i];
+		assert(slot->transfer != NULL && slot->period != 0 && slot->phase < slot->period);
+		slot->countdown = slot->phase;
+		spi_schedule_stats_reset(slot);
+	}
+	schedule->ticks = 0;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/******************************************************************************
+* Function: spi_schedule_tick()
+*//**
+* \b Description:
+*
+* 	Advances the schedule by one tick and hands every slot that is due to the
+* 	interrupt driven transfer path. Meant to be called from the update interrupt
+* 	of the timer producing the tick, so that the start of every transfer follows
+* 	the timer rather than the main loop. The transfers go through the ring the
+* 	driver keeps for interrupt handlers, ahead of anything tasks have queued on
+* 	the channel.
+*
+* 	The spi interrupt stamps each transfer as it really begins. When a slot is
+* 	next due, the time between the starts of its two latest transfers is
+* 	compared against the ticks between their releases to update the jitter
+* 	figures, so a transfer held up behind another on the bus shows as jitter.
+* 	A slot whose previous transfer has not even started yet is counted as
+* 	missed rather than queued a second time. A release refused by a full ring
+* 	is missed too, and leaves no new start to measure when the slot is next due.
+*
+* 	Slots due on the same tick and channel start back to back in array order;
+* 	phase can be used to keep them on separate ticks.
+*
+* PRE-CONDITION: spi_schedule_init() has been called on the schedule
+* PRE-CONDITION: The timer interrupt has a lower priority than the spi interrupts
+*
+* POST-CONDITION: Due slots have been queued, or counted as missed
+* POST-CONDITION: The jitter figures include every start known of
+*
+* @param		schedule a pointer to the schedule
+* @return 		void
+*
+* \b Example:
+* @code
+*	void TIM2_IRQHandler(void)
+*	{
+*		TIM2->SR = ~TIM_SR_UIF;
+*		spi_schedule_tick(&sensor_schedule);
+*	}
+* @endcode
+*
+* @see spi_transfer_it_from_isr
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_schedule_tick(spi_schedule_t *schedule)
+{
+	uint32_t tick = schedule->ticks++;
+	for (uint8_t i = 0; i < schedule->num_slots; i++)
+	{
+		spi_schedule_slot_t *slot = &schedule->slots[i];
+		if (slot->countdown != 0)
+		{
+			slot->countdown--;
+			continue;
+		}
+		slot->countdown = slot->period - 1U;
+
+		if (slot->releases != 0)
+		{
+			if (!slot->start.started)
+			{
+				slot->missed++;
+				continue;
+			}
+			__DMB();
+			uint32_t start = slot->start.cycles;
+			/* The stamp was consumed already if the submission after it was refused */
+			if (slot->releases == 1 || start != slot->last_start)
+			{
+				if (slot->releases > 1)
+				{
+					int32_t jitter = (int32_t)(start - slot->last_start - (slot->release_tick - slot->last_tick) * schedule->tick_cycles);
+					if (jitter < slot->jitter_min)
+					{
+						slot->jitter_min = jitter;
+					}
+					if (jitter > slot->jitter_max)
+					{
+						slot->jitter_max = jitter;
+					}
+				}
+				slot->last_start = start;
+				slot->last_tick = slot->release_tick;
+			}
+		}
+
+		if (!spi_transfer_it_from_isr(slot->transfer, &slot->start))
+		{
+			slot->missed++;
+			continue;
+		}
+		slot->release_tick = tick;
+		slot->releases++;
+	}
+}
+
+/******************************************************************************
+* Function: spi_schedule_stats_reset()
+*//**
+* \b Description:
+*
+* 	Clears the jitter, release and miss figures of a slot. The start of the first
+* 	transfer released afterwards only sets the reference time, so the interval
+* 	spanning the reset is not counted.
+*
+* PRE-CONDITION: The slot belongs to a schedule passed to spi_schedule_init()
+*
+* POST-CONDITION: The slot's statistics are empty
+*
+* @param		slot a pointer to the slot
+* @return 		void
+*
+* \b Example:
+* @code
+*	printf("gyro jitter %ld..%ld cycles\n", sensor_slots[0].jitter_min, sensor_slots[0].jitter_max);
+*	spi_schedule_stats_reset(&sensor_slots[0]);
+* @endcode
+*
+* @see spi_schedule_tick
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_schedule_stats_reset(spi_schedule_slot_t *slot)
+{
+	assert(slot != NULL);
+	slot->jitter_min = INT32_MAX;
+	slot->jitter_max = INT32_MIN;
+	slot->releases = 0;
+	slot->missed = 0;
+}
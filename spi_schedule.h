@@ -0,0 +1,75 @@
+/*******************************************************************************
+* Title                 :   SPI Periodic Scheduler
+* Filename              :   spi_schedule.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_schedule.h
+ *  @brief Launches device transfers at fixed rates from a hardware timer tick and
+ *  	measures how far the start of each transfer strays from its ideal time.
+ */
+#ifndef _SPI_SCHEDULE_H
+#define _SPI_SCHEDULE_H
+
+#include "spi_interface.h"
+#include <stdint.h>
+
+/**
+ * Struct describing one periodic transfer and holding its timing statistics
+ */
+typedef struct
+{
+	const spi_transfer_t *transfer;	/**<The transfer launched every period. Copied at each release */
+	uint16_t period;				/**<Ticks between releases, e.g. 1 for 4 kHz and 4 for 1 kHz on a 4 kHz tick */
+	uint16_t phase;					/**<Tick of the first release, spreads slots sharing a channel over the period */
+	uint16_t countdown;				/**<Ticks until the next release (set by the driver) */
+	spi_start_stamp_t start;		/**<Start of the latest release, noted by the spi interrupt (set by the driver) */
+	uint32_t release_tick;			/**<Tick of the latest release (set by the driver) */
+	uint32_t last_start;			/**<Cycle count at the start of the release before it (set by the driver) */
+	uint32_t last_tick;				/**<Tick of the release before it (set by the driver) */
+	int32_t jitter_min;				/**<Earliest start against the ideal, in cycles (set by the driver) */
+	int32_t jitter_max;				/**<Latest start against the ideal, in cycles (set by the driver) */
+	uint32_t releases;				/**<Number of transfers launched (set by the driver) */
+	uint32_t missed;				/**<Releases dropped because the interrupt queue was full or the previous
+										release had not started yet (set by the driver) */
+}spi_schedule_slot_t;
+
+/**
+ * Struct describing a set of periodic transfers driven by one timer
+ */
+typedef struct
+{
+	spi_schedule_slot_t *slots;		/**<The periodic transfers, released in array order on a common tick */
+	uint8_t num_slots;				/**<Number of slots */
+	uint32_t tick_cycles;			/**<Core clock cycles per timer tick, e.g. 100 MHz / 4 kHz = 25000 */
+	uint32_t ticks;					/**<Ticks since spi_schedule_init (set by the driver) */
+}spi_schedule_t;
+
+void spi_schedule_init(spi_schedule_t *schedule);
+void spi_schedule_tick(spi_schedule_t *schedule);
+void spi_schedule_stats_reset(spi_schedule_slot_t *slot);
+
+#endif
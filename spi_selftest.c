@@ -0,0 +1,324 @@
+/*******************************************************************************
+* Title                 :   SPI Self-Test
+* Filename              :   spi_selftest.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_selftest.c
+ *  @brief Sends walking ones and PRBS-15 patterns around a MOSI-MISO loop at each
+ *  	prescaler, checks them and times the polled and interrupt paths.
+ */
+#include "spi_selftest.h"
+#include "stm32f411xe.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+/**
+ * Number of empty passes of the completion loop timed to find its cost
+ */
+#define SPI_SELFTEST_IDLE_PASSES	64U
+
+/**
+ * Contains the test patterns
+ */
+typedef enum
+{
+	SELFTEST_WALKING_ONES,	/**<A single set bit stepping through every bit of the frame */
+	SELFTEST_PRBS15,		/**<x^15 + x^14 + 1 pseudo random sequence */
+	NUM_SELFTEST_PATTERNS
+}spi_selftest_pattern_t;
+
+/**
+ * Static buffers holding the pattern sent and the frames read back
+ */
+static uint16_t spi_selftest_tx[SPI_SELFTEST_FRAMES];
+static uint16_t spi_selftest_rx[SPI_SELFTEST_FRAMES];
+
+static void spi_selftest_fill(spi_selftest_pattern_t pattern, uint8_t bits);
+static uint32_t spi_selftest_check(void);
+static uint32_t spi_selftest_idle_cost(spi_desc_t desc);
+
+/******************************************************************************
+* Function: spi_selftest_run()
+*//**
+* \b Description:
+*
+* 	Runs every pattern at every prescaler, first through spi_transfer and then
+* 	through a transfer descriptor, and fills in a result per prescaler: the
+* 	frames read back wrongly, the polled transfers which raised an error flag,
+* 	the throughput of each path and the cpu time each path spent per byte. For
+* 	the interrupt path the cpu time is the elapsed time less the time the caller
+* 	spent idling in its completion loop. Only the descriptor's own status is
+* 	polled, so transfers other tasks submit on the channel are left for them to
+* 	reap, though they skew the timings.
+*
+* 	The F411's spi has no internal loopback, so the loop must be closed outside:
+* 	MOSI wired to MISO, or a slave which echoes what it receives.
+*
+* PRE-CONDITION: spi_init() has configured the channel as a full duplex master
+* PRE-CONDITION: The channel's interrupt is enabled
+* PRE-CONDITION: A descriptor is free in the pool
+* PRE-CONDITION: MOSI is looped back to MISO
+*
+* POST-CONDITION: results holds one entry per spi_baud_rate_t
+*
+* @param		test a pointer to the self-test description
+* @return 		uint8_t 1 if every frame came back and no errors were raised, 0 otherwise
+*
+* \b Example:
+* @code
+*	static spi_selftest_t loop_test;
+*	loop_test.device = &loop_transfer;
+*	loop_test.core_clock_hz = 100000000UL;
+*	if (!spi_selftest_run(&loop_test))
+*	{
+*		report_board_fault();
+*	}
+* @endcode
+*
+* @see spi_calibrate
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_selftest_run(spi_selftest_t *test)
+{
+	assert(test != NULL && test->device != NULL && test->core_clock_hz != 0);
+	assert(test->device->data_format != SPI_DATA_8BIT_PACKED);
+	spi_channel_t channel = test->device->channel;
+	uint8_t bits = (test->device->data_format == SPI_DATA_16BIT) ? 16U : 8U;
+	uint8_t passed = 1;
+
+	spi_transfer_t transfer = *test->device;
+	transfer.tx_buffer = spi_selftest_tx;
+	transfer.tx_length = SPI_SELFTEST_FRAMES;
+	transfer.rx_buffer = spi_selftest_rx;
+	transfer.rx_length = SPI_SELFTEST_FRAMES;
+	transfer.crc_enable = CRC_DISABLE;
+	transfer.rate_monitor = NULL;
+	transfer.preemptible = PREEMPT_DISABLE;
+	transfer.sleep_threshold = 0;
+	spi_desc_t desc = spi_desc_create(&transfer);
+	assert(desc != SPI_DESC_NONE);
+	uint32_t idle_cost = spi_selftest_idle_cost(desc);
+
+	for (uint32_t baud_rate = PCLK_DIV_2; baud_rate <= PCLK_DIV_256; baud_rate++)
+	{
+		spi_selftest_result_t *result = &test->results[baud_rate];
+		uint32_t elapsed[NUM_SELFTEST_PATHS] = {0};
+		uint32_t busy[NUM_SELFTEST_PATHS] = {0};
+		uint32_t bytes = 0;
+
+		transfer.max_clock_hz = spi_clock_get(channel, (spi_baud_rate_t)baud_rate);
+		result->clock_hz = transfer.max_clock_hz;
+		result->frame_errors = 0;
+		result->bus_errors = 0;
+
+		for (uint8_t pattern = 0; pattern < NUM_SELFTEST_PATTERNS; pattern++)
+		{
+			spi_selftest_fill((spi_selftest_pattern_t)pattern, bits);
+			uint32_t start = DWT->CYCCNT;
+			spi_transfer(&transfer);
+			uint32_t cycles = DWT->CYCCNT - start;
+			elapsed[SELFTEST_POLLED] += cycles;
+			busy[SELFTEST_POLLED] += cycles;
+			if (spi_error_get(channel) != SPI_ERROR_NONE)
+			{
+				result->bus_errors++;
+			}
+			result->frame_errors += spi_selftest_check();
+
+			spi_selftest_fill((spi_selftest_pattern_t)pattern, bits);
+			uint32_t idle_passes = 0;
+			start = DWT->CYCCNT;
+			uint8_t queued = spi_desc_submit(desc);
+			assert(queued);
+			(void)queued;
+			while (spi_desc_status(desc) != SPI_DESC_DONE)
+			{
+				idle_passes++;
+			}
+			cycles = DWT->CYCCNT - start;
+			elapsed[SELFTEST_INTERRUPT] += cycles;
+			busy[SELFTEST_INTERRUPT] += (cycles > idle_passes * idle_cost) ? cycles - idle_passes * idle_cost : 0;
+			result->frame_errors += spi_selftest_check();
+
+			bytes += SPI_SELFTEST_FRAMES * (bits / 8U);
+		}
+
+		for (uint8_t path = 0; path < NUM_SELFTEST_PATHS; path++)
+		{
+			result->bytes_per_second[path] = (elapsed[path] != 0)
+					? (uint32_t)(((uint64_t)bytes * test->core_clock_hz) / elapsed[path]) : 0;
+			result->cycles_per_byte[path] = busy[path] / bytes;
+		}
+		if (result->frame_errors != 0 || result->bus_errors != 0)
+		{
+			passed = 0;
+		}
+	}
+	spi_desc_destroy(desc);
+	return (passed);
+}
+
+/******************************************************************************
+* Function: spi_selftest_fill()
+*//**
+* \b Description:
+*
+*	Static function which writes a pattern into the transmit buffer and clears
+*	the receive buffer. The PRBS restarts from the same seed every time, so each
+*	run at each prescaler sends the same frames.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The transmit buffer holds the pattern, the receive buffer is cleared
+*
+* @param		pattern the pattern to write
+* @param		bits the number of bits per frame, 8 or 16
+* @return 		void
+*
+* \b Example:
+*	Called by spi_selftest_run before each transfer
+*
+* @see spi_selftest_check
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_selftest_fill(spi_selftest_pattern_t pattern, uint8_t bits)
+{
+	uint16_t lfsr = 0x7FFFU;
+	for (uint32_t i = 0; i < SPI_SELFTEST_FRAMES; i++)
+	{
+		uint16_t frame = 0;
+		if (pattern == SELFTEST_WALKING_ONES)
+		{
+			frame = (uint16_t)(1U << (i % bits));
+		}
+		else
+		{
+			for (uint8_t bit = 0; bit < bits; bit++)
+			{
+				uint16_t next = ((lfsr >> 14) ^ (lfsr >> 13)) & 1U;
+				lfsr = (uint16_t)(((lfsr << 1) | next) & 0x7FFFU);
+				frame = (uint16_t)((frame << 1) | next);
+			}
+		}
+		spi_selftest_tx[i] = frame;
+		spi_selftest_rx[i] = (uint16_t)~frame;
+	}
+}
+
+/******************************************************************************
+* Function: spi_selftest_check()
+*//**
+* \b Description:
+*
+*	Static function which compares the frames read back with those sent. The
+*	receive buffer starts out as the complement of the pattern, so a frame which
+*	was never written counts as an error.
+*
+* PRE-CONDITION: spi_selftest_fill() has been called before the transfer
+*
+* POST-CONDITION: None
+*
+* @return 		uint32_t the number of frames which differ
+*
+* \b Example:
+*	Called by spi_selftest_run after each transfer
+*
+* @see spi_selftest_fill
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t spi_selftest_check(void)
+{
+	uint32_t errors = 0;
+	for (uint32_t i = 0; i < SPI_SELFTEST_FRAMES; i++)
+	{
+		if (spi_selftest_rx[i] != spi_selftest_tx[i])
+		{
+			errors++;
+		}
+	}
+	return (errors);
+}
+
+/******************************************************************************
+* Function: spi_selftest_idle_cost()
+*//**
+* \b Description:
+*
+*	Static function which times empty passes of the loop used to wait for an
+*	interrupt transfer, so that the waiting can be taken out of the cpu time
+*	charged to the interrupt path. The cost is averaged over the passes run.
+*
+* PRE-CONDITION: desc has not been submitted
+*
+* POST-CONDITION: None
+*
+* @param		desc the descriptor the self-test waits on
+* @return 		uint32_t core clock cycles per pass
+*
+* \b Example:
+*	Called by spi_selftest_run
+*
+* @see spi_selftest_run
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t spi_selftest_idle_cost(spi_desc_t desc)
+{
+	uint32_t idle_passes = 0;
+	uint32_t start = DWT->CYCCNT;
+	while (idle_passes < SPI_SELFTEST_IDLE_PASSES && spi_desc_status(desc) != SPI_DESC_DONE)
+	{
+		idle_passes++;
+	}
+	uint32_t cycles = DWT->CYCCNT - start;
+	return ((idle_passes != 0) ? cycles / idle_passes : 0);
+}
@@ -0,0 +1,86 @@
+/*******************************************************************************
+* Title                 :   SPI Self-Test
+* Filename              :   spi_selftest.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_selftest.h
+ *  @brief Loopback pattern tests of a channel at every prescaler, with the
+ *  	throughput and cpu cost of the polled and interrupt paths.
+ */
+#ifndef _SPI_SELFTEST_H
+#define _SPI_SELFTEST_H
+
+#include "spi_interface.h"
+#include <stdint.h>
+
+/**
+ * Number of frames in each pattern
+ */
+#ifndef SPI_SELFTEST_FRAMES
+#define SPI_SELFTEST_FRAMES 64U
+#endif
+
+/**
+ * Number of prescalers tested, one per spi_baud_rate_t
+ */
+#define SPI_SELFTEST_NUM_RATES	(PCLK_DIV_256 + 1U)
+
+/**
+ * Contains the transfer paths that are measured
+ */
+typedef enum
+{
+	SELFTEST_POLLED,		/**<spi_transfer */
+	SELFTEST_INTERRUPT,		/**<spi_desc_submit, completion polled with spi_desc_status */
+	NUM_SELFTEST_PATHS
+}spi_selftest_path_t;
+
+/**
+ * Struct holding the outcome of the tests at one prescaler
+ */
+typedef struct
+{
+	uint32_t clock_hz;									/**<SCK the tests ran at */
+	uint32_t frame_errors;								/**<Frames read back different from those sent */
+	uint32_t bus_errors;								/**<Polled transfers which raised a spi_error_t flag */
+	uint32_t bytes_per_second[NUM_SELFTEST_PATHS];		/**<Throughput achieved on each path */
+	uint32_t cycles_per_byte[NUM_SELFTEST_PATHS];		/**<Core clock cycles of cpu time spent per byte on each path */
+}spi_selftest_result_t;
+
+/**
+ * Struct describing a self-test and holding its results
+ */
+typedef struct
+{
+	spi_transfer_t *device;									/**<Channel, select and clock settings. Buffers and max_clock_hz are ignored */
+	uint32_t core_clock_hz;									/**<Core clock, to turn cycles into throughput */
+	spi_selftest_result_t results[SPI_SELFTEST_NUM_RATES];	/**<One entry per spi_baud_rate_t (set by the driver) */
+}spi_selftest_t;
+
+uint8_t spi_selftest_run(spi_selftest_t *test);
+
+#endif
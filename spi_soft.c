@@ -0,0 +1,406 @@
+/*******************************************************************************
+* Title                 :   Software SPI
+* Filename              :   spi_soft.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_soft.c
+ *  @brief Bit-banged spi master. The pins are driven through their ports'
+ *  	set/reset registers by unrolled per bit sequences, one per clock phase.
+ */
+#include "spi_soft.h"
+#include "stm32f411xe.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+/**
+ * Distance between the register blocks of consecutive gpio ports
+ */
+#define SPI_SOFT_PORT_STRIDE	0x400UL
+
+/**
+ * Busy waits for a number of core clock cycles on the DWT cycle counter
+ */
+#define SPI_SOFT_DELAY(cycles)											\
+	do																	\
+	{																	\
+		if ((cycles) != 0)												\
+		{																\
+			uint32_t start = DWT->CYCCNT;								\
+			while ((DWT->CYCCNT - start) < (cycles));					\
+		}																\
+	} while(0)
+
+/**
+ * One bit with the data put out ahead of the leading edge and sampled on it
+ * (CPHA = 0). The top bit of out picks the set or the reset half of BSRR
+ */
+#define SPI_SOFT_BIT_FIRST_EDGE()										\
+	do																	\
+	{																	\
+		*mosi = mosi_reset >> ((out >> 27) & 16U);						\
+		out <<= 1;														\
+		SPI_SOFT_DELAY(half);											\
+		*sck = leading;													\
+		in = (in << 1) | ((*idr >> miso_bit) & 1U);						\
+		SPI_SOFT_DELAY(half);											\
+		*sck = trailing;												\
+	} while(0)
+
+/**
+ * One bit with the data put out on the leading edge and sampled on the trailing
+ * one (CPHA = 1)
+ */
+#define SPI_SOFT_BIT_SECOND_EDGE()										\
+	do																	\
+	{																	\
+		*sck = leading;													\
+		*mosi = mosi_reset >> ((out >> 27) & 16U);						\
+		out <<= 1;														\
+		SPI_SOFT_DELAY(half);											\
+		*sck = trailing;												\
+		in = (in << 1) | ((*idr >> miso_bit) & 1U);						\
+		SPI_SOFT_DELAY(half);											\
+	} while(0)
+
+/**
+ * Typedef for the routines clocking a single frame
+ */
+typedef uint32_t (*spi_soft_kernel_t)(spi_soft_bus_t *bus, uint32_t out, uint8_t bits,
+										uint32_t half, uint32_t leading, uint32_t trailing);
+
+static uint32_t spi_soft_frame_first_edge(spi_soft_bus_t *bus, uint32_t out, uint8_t bits,
+										uint32_t half, uint32_t leading, uint32_t trailing);
+static uint32_t spi_soft_frame_second_edge(spi_soft_bus_t *bus, uint32_t out, uint8_t bits,
+										uint32_t half, uint32_t leading, uint32_t trailing);
+static GPIO_TypeDef *spi_soft_port(gpio_pin_t pin);
+
+/******************************************************************************
+* Function: spi_soft_init()
+*//**
+* \b Description:
+*
+* 	Looks up the port registers of the bus's pins and measures how many core
+* 	clock cycles a bit takes with no delay added, so that transfers can pad each
+* 	half clock period to reach max_clock_hz. The measured frame writes its clock
+* 	and data to a variable in place of the set/reset registers, so the pins are
+* 	left alone and the bus may already be in use.
+*
+* PRE-CONDITION: gpio_init() has configured the pins, with high speed outputs
+* PRE-CONDITION: gpio_pin_t lists 16 pins per port, in port order from GPIO_A_0
+*
+* POST-CONDITION: The bus can be used by spi_soft_transfer. No pin has changed level
+*
+* @param		bus a pointer to the bus description
+* @return 		void
+*
+* \b Example:
+* @code
+*	static spi_soft_bus_t aux_bus = {GPIO_B_3, GPIO_B_5, GPIO_B_4, 100000000UL};
+*	spi_soft_init(&aux_bus);
+* @endcode
+*
+* @see spi_soft_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_soft_init(spi_soft_bus_t *bus)
+{
+	assert(bus != NULL && bus->core_clock_hz != 0);
+	bus->sck_bsrr = &spi_soft_port(bus->sck_pin)->BSRR;
+	bus->mosi_bsrr = &spi_soft_port(bus->mosi_pin)->BSRR;
+	bus->miso_idr = &spi_soft_port(bus->miso_pin)->IDR;
+	bus->sck_mask = 1UL << (bus->sck_pin & 0x0FU);
+	bus->mosi_mask = 1UL << (bus->mosi_pin & 0x0FU);
+	bus->miso_bit = bus->miso_pin & 0x0FU;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	volatile uint32_t sink = 0;
+	spi_soft_bus_t probe = *bus;
+	probe.sck_bsrr = &sink;
+	probe.mosi_bsrr = &sink;
+	uint32_t start = DWT->CYCCNT;
+	(void)spi_soft_frame_first_edge(&probe, 0, 16, 0, bus->sck_mask, bus->sck_mask << 16);
+	bus->bit_cycles = (DWT->CYCCNT - start) / 16U;
+}
+
+/******************************************************************************
+* Function: spi_soft_transfer()
+*//**
+* \b Description:
+*
+* 	Carries out a blocking full duplex master transfer on a software bus. The
+* 	transfer is described as for spi_transfer: slave select, clock polarity and
+* 	phase, bit order, 8 or 16 bit frames, padding of a short tx_buffer and a NULL
+* 	rx_buffer all behave the same. The channel field is ignored. The half period
+* 	delay is worked out from max_clock_hz and the cycles measured at init, so the
+* 	clock stays at or below the requested rate; 0 runs as fast as the pins allow.
+*
+* PRE-CONDITION: spi_soft_init() has been called on the bus
+* PRE-CONDITION: The transfer is 8 or 16 bit, has crc_enable off and a GPIO or manual select
+*
+* POST-CONDITION: The transfer has been carried out. The transfer structure is left untouched
+*
+* @param		bus a pointer to the bus to use
+* @param		transfer a pointer to the transfer
+* @return 		void
+*
+* \b Example:
+* @code
+*	eeprom_read.max_clock_hz = 4000000;
+*	spi_soft_transfer(&aux_bus, &eeprom_read);
+* @endcode
+*
+* @see spi_soft_init
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_soft_transfer(spi_soft_bus_t *bus, const spi_transfer_t *transfer)
+{
+	assert(bus != NULL && transfer != NULL);
+	assert(transfer->crc_enable != CRC_ENABLE && transfer->data_format != SPI_DATA_8BIT_PACKED);
+	assert(transfer->ss_polarity != SS_HARDWARE);
+	uint8_t bits = (transfer->data_format == SPI_DATA_16BIT) ? 16U : 8U;
+	uint8_t lsb_first = (transfer->bit_format == LSB_FIRST);
+	uint32_t num_frames = transfer->tx_length;
+	if (transfer->rx_buffer != NULL && transfer->rx_length > num_frames)
+	{
+		num_frames = transfer->rx_length;
+	}
+
+	uint32_t leading = bus->sck_mask;
+	uint32_t trailing = bus->sck_mask << 16;
+	if (transfer->clock_polarity == ACTIVE_LOW)
+	{
+		leading = bus->sck_mask << 16;
+		trailing = bus->sck_mask;
+	}
+	spi_soft_kernel_t kernel = (transfer->clock_phase == SECOND_EDGE)
+								? spi_soft_frame_second_edge : spi_soft_frame_first_edge;
+
+	uint32_t half = 0;
+	if (transfer->max_clock_hz != 0)
+	{
+		uint32_t period = (bus->core_clock_hz + transfer->max_clock_hz - 1U) / transfer->max_clock_hz;
+		if (period > bus->bit_cycles)
+		{
+			half = (period - bus->bit_cycles + 1U) / 2U;
+		}
+	}
+
+	/* SCK goes to its idle level for this clock polarity before the slave sees the select */
+	*bus->sck_bsrr = trailing;
+	if (transfer->ss_polarity == SS_ACTIVE_LOW)
+	{
+		gpio_pin_write(transfer->slave_pin, GPIO_PIN_LOW);
+	}
+	else if (transfer->ss_polarity == SS_ACTIVE_HIGH)
+	{
+		gpio_pin_write(transfer->slave_pin, GPIO_PIN_HIGH);
+	}
+	SPI_SOFT_DELAY(transfer->cs_setup_cycles);
+
+	for (uint32_t i = 0; i < num_frames; i++)
+	{
+		uint32_t out = (i < transfer->tx_length) ? transfer->tx_buffer[i] : SPI_SOFT_DUMMY_FRAME;
+		out = lsb_first ? __RBIT(out) : (out << (32U - bits));
+
+		uint32_t in = kernel(bus, out, bits, half, leading, trailing);
+		if (transfer->rx_buffer != NULL && i < transfer->rx_length)
+		{
+			transfer->rx_buffer[i] = (uint16_t)(lsb_first ? (__RBIT(in) >> (32U - bits)) : in);
+		}
+	}
+
+	SPI_SOFT_DELAY(transfer->cs_hold_cycles);
+	if (transfer->ss_polarity == SS_ACTIVE_LOW)
+	{
+		gpio_pin_write(transfer->slave_pin, GPIO_PIN_HIGH);
+	}
+	else if (transfer->ss_polarity == SS_ACTIVE_HIGH)
+	{
+		gpio_pin_write(transfer->slave_pin, GPIO_PIN_LOW);
+	}
+}
+
+/******************************************************************************
+* Function: spi_soft_frame_first_edge()
+*//**
+* \b Description:
+*
+*	Static function which clocks one frame with the data sampled on the leading
+*	clock edge (CPHA = 0), eight bits at a time fully unrolled. The polarity is
+*	carried by the leading and trailing BSRR words, so no decision is taken per
+*	bit.
+*
+* PRE-CONDITION: The clock is at its idle level
+*
+* POST-CONDITION: The clock is back at its idle level
+*
+* @param		bus a pointer to the bus
+* @param		out the frame, left aligned (first bit in bit 31)
+* @param		bits 8 or 16
+* @param		half core clock cycles added to each half period
+* @param		leading BSRR word producing the leading clock edge
+* @param		trailing BSRR word producing the trailing clock edge
+* @return 		uint32_t the bits received, the first in the most significant place
+*
+* \b Example:
+*	Called by spi_soft_transfer and spi_soft_init
+*
+* @see spi_soft_frame_second_edge
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t spi_soft_frame_first_edge(spi_soft_bus_t *bus, uint32_t out, uint8_t bits,
+										uint32_t half, uint32_t leading, uint32_t trailing)
+{
+	volatile uint32_t *sck = bus->sck_bsrr;
+	volatile uint32_t *mosi = bus->mosi_bsrr;
+	volatile uint32_t *idr = bus->miso_idr;
+	uint32_t mosi_reset = bus->mosi_mask << 16;
+	uint32_t miso_bit = bus->miso_bit;
+	uint32_t in = 0;
+
+	for (uint8_t i = 0; i < bits; i += 8U)
+	{
+		SPI_SOFT_BIT_FIRST_EDGE();
+		SPI_SOFT_BIT_FIRST_EDGE();
+		SPI_SOFT_BIT_FIRST_EDGE();
+		SPI_SOFT_BIT_FIRST_EDGE();
+		SPI_SOFT_BIT_FIRST_EDGE();
+		SPI_SOFT_BIT_FIRST_EDGE();
+		SPI_SOFT_BIT_FIRST_EDGE();
+		SPI_SOFT_BIT_FIRST_EDGE();
+	}
+	return (in);
+}
+
+/******************************************************************************
+* Function: spi_soft_frame_second_edge()
+*//**
+* \b Description:
+*
+*	Static function which clocks one frame with the data sampled on the trailing
+*	clock edge (CPHA = 1), as spi_soft_frame_first_edge does for CPHA = 0.
+*
+* PRE-CONDITION: The clock is at its idle level
+*
+* POST-CONDITION: The clock is back at its idle level
+*
+* @param		bus a pointer to the bus
+* @param		out the frame, left aligned (first bit in bit 31)
+* @param		bits 8 or 16
+* @param		half core clock cycles added to each half period
+* @param		leading BSRR word producing the leading clock edge
+* @param		trailing BSRR word producing the trailing clock edge
+* @return 		uint32_t the bits received, the first in the most significant place
+*
+* \b Example:
+*	Called by spi_soft_transfer
+*
+* @see spi_soft_frame_first_edge
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t spi_soft_frame_second_edge(spi_soft_bus_t *bus, uint32_t out, uint8_t bits,
+										uint32_t half, uint32_t leading, uint32_t trailing)
+{
+	volatile uint32_t *sck = bus->sck_bsrr;
+	volatile uint32_t *mosi = bus->mosi_bsrr;
+	volatile uint32_t *idr = bus->miso_idr;
+	uint32_t mosi_reset = bus->mosi_mask << 16;
+	uint32_t miso_bit = bus->miso_bit;
+	uint32_t in = 0;
+
+	for (uint8_t i = 0; i < bits; i += 8U)
+	{
+		SPI_SOFT_BIT_SECOND_EDGE();
+		SPI_SOFT_BIT_SECOND_EDGE();
+		SPI_SOFT_BIT_SECOND_EDGE();
+		SPI_SOFT_BIT_SECOND_EDGE();
+		SPI_SOFT_BIT_SECOND_EDGE();
+		SPI_SOFT_BIT_SECOND_EDGE();
+		SPI_SOFT_BIT_SECOND_EDGE();
+		SPI_SOFT_BIT_SECOND_EDGE();
+	}
+	return (in);
+}
+
+/******************************************************************************
+* Function: spi_soft_port()
+*//**
+* \b Description:
+*
+*	Static function which finds the register block of the port a pin is on.
+*
+* PRE-CONDITION: gpio_pin_t lists 16 pins per port, in port order from GPIO_A_0
+*
+* POST-CONDITION: None
+*
+* @param		pin the pin of interest
+* @return 		GPIO_TypeDef* the registers of the pin's port
+*
+* \b Example:
+*	Called by spi_soft_init
+*
+* @see spi_soft_init
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static GPIO_TypeDef *spi_soft_port(gpio_pin_t pin)
+{
+	return ((GPIO_TypeDef *)(GPIOA_BASE + ((uint32_t)pin >> 4) * SPI_SOFT_PORT_STRIDE));
+}
@@ -0,0 +1,69 @@
+/*******************************************************************************
+* Title                 :   Software SPI
+* Filename              :   spi_soft.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_soft.h
+ *  @brief Bit-banged spi master on any three gpio pins, for buses beyond the
+ *  	on-chip spi devices. Transfers are described with the same spi_transfer_t.
+ */
+#ifndef _SPI_SOFT_H
+#define _SPI_SOFT_H
+
+#include "spi_interface.h"
+#include <stdint.h>
+
+/**
+ * Frame clocked out once the tx_buffer is exhausted but frames remain to be received
+ */
+#ifndef SPI_SOFT_DUMMY_FRAME
+#define SPI_SOFT_DUMMY_FRAME 0x0000U
+#endif
+
+/**
+ * Struct describing the pins of a software bus and holding what spi_soft_init
+ * works out for them
+ */
+typedef struct
+{
+	gpio_pin_t sck_pin;				/**<Clock, configured as a push-pull output with gpio_init */
+	gpio_pin_t mosi_pin;			/**<Master out, configured as a push-pull output with gpio_init */
+	gpio_pin_t miso_pin;			/**<Master in, configured as an input with gpio_init */
+	uint32_t core_clock_hz;			/**<Core clock, used to turn max_clock_hz into a delay */
+	volatile uint32_t *sck_bsrr;	/**<Set/reset register of the clock's port (set by the driver) */
+	volatile uint32_t *mosi_bsrr;	/**<Set/reset register of the master out's port (set by the driver) */
+	volatile uint32_t *miso_idr;	/**<Input register of the master in's port (set by the driver) */
+	uint32_t sck_mask;				/**<Bit of the clock in its port (set by the driver) */
+	uint32_t mosi_mask;				/**<Bit of the master out in its port (set by the driver) */
+	uint32_t miso_bit;				/**<Bit number of the master in in its port (set by the driver) */
+	uint32_t bit_cycles;			/**<Core clock cycles taken per bit with no delay, measured at init (set by the driver) */
+}spi_soft_bus_t;
+
+void spi_soft_init(spi_soft_bus_t *bus);
+void spi_soft_transfer(spi_soft_bus_t *bus, const spi_transfer_t *transfer);
+
+#endif
@@ -31,6 +31,8 @@
  *  @brief Chip specific implementation for spi communication.
  */
 #include "spi_interface.h"
+#include "spi_os.h"
+#include "spi_trace.h"
 #include "stm32f411xe.h"
 #include <assert.h>
 
@@ -42,109 +44,188 @@
 #endif
 
 /**
- * Array of pointers to Control Register 1 registers
+ * Os hooks, compiled away when the driver is built without an os port
  */
-static volatile uint16_t *const SPI_CR1[NUM_SPI] =
-{
-	(uint16_t *)SPI1_BASE,	(uint16_t *)SPI2_BASE,
-	(uint16_t *)SPI3_BASE,	(uint16_t *)SPI4_BASE,
-	(uint16_t *)SPI5_BASE
-};
+#if SPI_OS_ENABLE
+#define SPI_OS_INIT(channel)	spi_os_init(channel)
+#define SPI_OS_DEINIT(channel)	spi_os_deinit(channel)
+#define SPI_OS_LOCK(channel)	spi_os_lock(channel)
+#define SPI_OS_UNLOCK(channel)	spi_os_unlock(channel)
+#define SPI_OS_WAIT(channel)	spi_os_wait(channel)
+#define SPI_OS_SIGNAL(channel)	spi_os_signal(channel)
+#else
+#define SPI_OS_INIT(channel)
+#define SPI_OS_DEINIT(channel)
+#define SPI_OS_LOCK(channel)
+#define SPI_OS_UNLOCK(channel)
+#define SPI_OS_WAIT(channel)	__WFE()
+#define SPI_OS_SIGNAL(channel)
+#endif
 
 /**
- * Array of pointers to Control Register 2 registers
+ * Frame clocked out by a master once the tx_buffer is exhausted but frames remain
+ * to be received
  */
-static volatile uint16_t *const SPI_CR2[NUM_SPI] =
-{
-	(uint16_t *)SPI1_BASE + 0x04UL,	(uint16_t *)SPI2_BASE + 0x04UL,
-	(uint16_t *)SPI3_BASE + 0x04UL,	(uint16_t *)SPI4_BASE + 0x04UL,
-	(uint16_t *)SPI5_BASE + 0x04UL
-};
+#ifndef SPI_DUMMY_FRAME
+#define SPI_DUMMY_FRAME 0x0000U
+#endif
 
 /**
- * Array of pointers to Status registers
+ * Callback typedef for interrupt callbacks
  */
-static volatile uint16_t *const SPI_SR[NUM_SPI] =
-{
-	(uint16_t *)SPI1_BASE + 0x08UL,	(uint16_t *)SPI2_BASE + 0x08UL,
-	(uint16_t *)SPI3_BASE + 0x08UL,	(uint16_t *)SPI4_BASE + 0x08UL,
-	(uint16_t *)SPI5_BASE + 0x08UL
-};
+typedef void (*spi_interrupt_callback_t)(spi_transfer_t *);
 
 /**
- * Array of pointers to Data registers
+ * Typedef for the polling routines which move the frames of a blocking transfer
  */
-static volatile uint16_t *const SPI_DR[NUM_SPI] =
-{
-	(uint16_t *)SPI1_BASE + 0x0CUL,	(uint16_t *)SPI2_BASE + 0x0CUL,
-	(uint16_t *)SPI3_BASE + 0x0CUL,	(uint16_t *)SPI4_BASE + 0x0CUL,
-	(uint16_t *)SPI5_BASE + 0x0CUL
-};
+typedef void (*spi_kernel_t)(spi_transfer_t *);
 
 /**
- * Array of pointers to CRC Polynomial registers
+ * Everything the driver keeps per spi device: the register block overlay, the
+ * device's clock and interrupt wiring, and its driver state
  */
-static volatile uint16_t *const SPI_CRCPR[NUM_SPI] =
+typedef struct
 {
-	(uint16_t *)SPI1_BASE + 0x10UL,	(uint16_t *)SPI2_BASE + 0x10UL,
-	(uint16_t *)SPI3_BASE + 0x10UL,	(uint16_t *)SPI4_BASE + 0x10UL,
-	(uint16_t *)SPI5_BASE + 0x10UL
-};
+	SPI_TypeDef *const regs;				/**<Register block of the device */
+	volatile uint32_t *const rcc_enr;		/**<RCC clock enable register of the device's bus */
+	volatile uint32_t *const rcc_rstr;		/**<RCC reset register of the device's bus */
+	const uint32_t rcc_msk;					/**<Bit of the device in rcc_enr and rcc_rstr */
+	const uint32_t pclk_hz;					/**<Clock feeding the baud rate generator */
+	const IRQn_Type irqn;					/**<Interrupt pended to hand a submission to the interrupt */
+	spi_baud_rate_t default_baud_rate;		/**<Baud rate from the config table, for transfers which don't ask for a clock */
+	uint8_t errors;							/**<spi_error_t flags gathered over the most recent blocking transfer */
+	spi_interrupt_callback_t callback;		/**<Interrupt callback of the transfer in progress */
+	uint16_t CR1_ss_bits;					/**<SSM and SSI as configured, restored after a hardware NSS transfer */
+	uint16_t CR2_ss_bits;					/**<SSOE as configured, restored after a hardware NSS transfer */
+	volatile uint8_t cs_held;				/**<Set while spi_bus_acquire keeps a slave selected */
+	gpio_pin_t cs_held_pin;					/**<Select pin of that slave, valid while cs_held is set */
+	uint16_t SR_latched;					/**<SR flags seen by the interrupt callbacks and polled master loops, kept for spi_collect_errors since their DR reads clear OVR */
+}spi_handle_t;
 
 /**
- * Array of pointers to reception CRC registers
+ * Static array of handles mapped to each spi device
  */
-static volatile uint16_t *const SPI_RXCRCR[NUM_SPI] =
+static spi_handle_t spi_handles[NUM_SPI] =
 {
-	(uint16_t *)SPI1_BASE + 0x14UL,	(uint16_t *)SPI2_BASE + 0x14UL,
-	(uint16_t *)SPI3_BASE + 0x14UL,	(uint16_t *)SPI4_BASE + 0x14UL,
-	(uint16_t *)SPI5_BASE + 0x14UL
+	{SPI1, &RCC->APB2ENR, &RCC->APB2RSTR, RCC_APB2ENR_SPI1EN_Msk, SPI_APB2_CLOCK_HZ, SPI1_IRQn, PCLK_DIV_2, SPI_ERROR_NONE, NULL, 0, 0, 0, GPIO_A_0, 0},
+	{SPI2, &RCC->APB1ENR, &RCC->APB1RSTR, RCC_APB1ENR_SPI2EN_Msk, SPI_APB1_CLOCK_HZ, SPI2_IRQn, PCLK_DIV_2, SPI_ERROR_NONE, NULL, 0, 0, 0, GPIO_A_0, 0},
+	{SPI3, &RCC->APB1ENR, &RCC->APB1RSTR, RCC_APB1ENR_SPI3EN_Msk, SPI_APB1_CLOCK_HZ, SPI3_IRQn, PCLK_DIV_2, SPI_ERROR_NONE, NULL, 0, 0, 0, GPIO_A_0, 0},
+	{SPI4, &RCC->APB2ENR, &RCC->APB2RSTR, RCC_APB2ENR_SPI4EN_Msk, SPI_APB2_CLOCK_HZ, SPI4_IRQn, PCLK_DIV_2, SPI_ERROR_NONE, NULL, 0, 0, 0, GPIO_A_0, 0},
+	{SPI5, &RCC->APB2ENR, &RCC->APB2RSTR, RCC_APB2ENR_SPI5EN_Msk, SPI_APB2_CLOCK_HZ, SPI5_IRQn, PCLK_DIV_2, SPI_ERROR_NONE, NULL, 0, 0, 0, GPIO_A_0, 0}
 };
 
+#if (SPI_QUEUE_LENGTH == 0) || ((SPI_QUEUE_LENGTH & (SPI_QUEUE_LENGTH - 1U)) != 0)
+#error "SPI_QUEUE_LENGTH must be a power of two"
+#endif
+
+#if (SPI_ISR_QUEUE_LENGTH == 0) || ((SPI_ISR_QUEUE_LENGTH & (SPI_ISR_QUEUE_LENGTH - 1U)) != 0)
+#error "SPI_ISR_QUEUE_LENGTH must be a power of two"
+#endif
+
+#if (SPI_DESC_POOL_LENGTH == 0) || (SPI_DESC_POOL_LENGTH >= SPI_DESC_NONE)
+#error "SPI_DESC_POOL_LENGTH must be between 1 and 254"
+#endif
+
 /**
- * Array of pointers to transmission CRC registers
+ * A transfer descriptor, either from the pool or one of the copies a channel keeps
+ * for its ring. The transfer routines only ever advance the driver owned state, so
+ * a request handed to spi_desc_create is never modified
  */
-static volatile uint16_t *const SPI_TXCRCR[NUM_SPI] =
+typedef struct
 {
-	(uint16_t *)SPI1_BASE + 0x18UL,	(uint16_t *)SPI2_BASE + 0x18UL,
-	(uint16_t *)SPI3_BASE + 0x18UL,	(uint16_t *)SPI4_BASE + 0x18UL,
-	(uint16_t *)SPI5_BASE + 0x18UL
-};
+	spi_transfer_t state;			/**<Buffers and lengths advanced by the transfer routines */
+	const spi_transfer_t *request;	/**<Loaded into state as the transfer starts, NULL if state was filled when queued */
+	volatile uint8_t status;		/**<spi_desc_status_t of the latest submission */
+	volatile uint8_t in_use;		/**<Taken from the pool, claimed with exclusive accesses */
+}spi_desc_slot_t;
 
 /**
- * Static array which holds safe copies of transfers for interrupt routines,
- * mapped to spi devices
+ * Static pool of transfer descriptors shared by all spi devices
  */
-static spi_transfer_t spi_interrupt_transfers[NUM_SPI];
+static spi_desc_slot_t spi_descs[SPI_DESC_POOL_LENGTH];
 
 /**
- * Callback typedef for interrupt callbacks
+ * Single producer/single consumer ring of interrupt transfers for one spi device.
+ * The indices run freely and are masked on access. Slots from done to head are
+ * waiting (the one at done is in progress while active is set), slots from reaped
+ * to done have completed and are waiting to be collected. Only the slots marked
+ * kept are handed out by spi_transfer_reap (or read back by spi_transfer_it_wait);
+ * the others are passed over by spi_queue_collect. head and reaped are only ever
+ * written by the application, done and active only by the interrupt.
+ * Transfers from an interrupt handler go through a second ring of their own, so
+ * that the handler is its only producer; they are started ahead of the ring of
+ * the application and are never reaped.
  */
-typedef void (*spi_interrupt_callback_t)(spi_transfer_t *);
+typedef struct
+{
+	spi_desc_slot_t *slots[SPI_QUEUE_LENGTH];	/**<Descriptors of the submitted transfers */
+	spi_desc_slot_t copies[SPI_QUEUE_LENGTH];	/**<Copies of the transfers submitted by value, indexed like slots */
+	uint8_t kept[SPI_QUEUE_LENGTH];			/**<The completion of the slot is collected by its submitter, indexed like slots */
+	volatile uint32_t head;					/**<Number of transfers submitted */
+	volatile uint32_t done;					/**<Number of transfers completed */
+	volatile uint32_t reaped;				/**<Number of completed transfers collected */
+	volatile uint8_t active;				/**<The transfer at done, or at isr_done if isr_active is set, is in progress */
+	spi_transfer_t isr_slots[SPI_ISR_QUEUE_LENGTH];		/**<Copies of the transfers handed over by spi_transfer_it_from_isr */
+	spi_start_stamp_t *isr_stamps[SPI_ISR_QUEUE_LENGTH];	/**<Where to note the start of each of those transfers, NULL if unwanted */
+	volatile uint32_t isr_head;				/**<Number of transfers handed over from an interrupt, written only by that interrupt */
+	volatile uint32_t isr_done;				/**<Number of those completed, written only by the spi interrupt */
+	volatile uint8_t isr_active;			/**<The transfer in progress came from isr_slots */
+	spi_desc_t urgent;						/**<Descriptor of the urgent transfer, valid while urgent_pending is set */
+	volatile uint8_t urgent_pending;		/**<An urgent transfer has been submitted and has not completed */
+	volatile uint8_t urgent_active;			/**<The urgent transfer is in progress, any transfer at done is paused */
+}spi_queue_t;
 
 /**
- * Static array of callback functions mapped to each spi device
+ * Static array of transfer queues mapped to each spi device
  */
-static spi_interrupt_callback_t spi_interrupt_callbacks[NUM_SPI];
+static spi_queue_t spi_queues[NUM_SPI];
 
-static void spi_select_slave(spi_transfer_t *transfer);
-static void spi_release_slave(spi_transfer_t *transfer);
+static void spi_select_slave(const spi_transfer_t *transfer);
+static void spi_release_slave(const spi_transfer_t *transfer);
+static void spi_delay_cycles(uint32_t cycles);
 static void spi_configure_clock(spi_transfer_t *transfer);
 static void spi_configure_data_frame(spi_transfer_t *transfer);
+static void spi_configure_baud_rate(spi_transfer_t *transfer);
+static uint32_t spi_baud_rate_select(spi_transfer_t *transfer);
+static void spi_configure_crc(spi_transfer_t *transfer);
+static void spi_collect_errors(spi_transfer_t *transfer, uint16_t CR1_state);
+static uint16_t spi_transfer_begin(spi_transfer_t *transfer);
+static void spi_transfer_end(spi_transfer_t *transfer, uint16_t CR1_state);
+static void spi_transfer_it_end(spi_transfer_t *transfer);
+static void spi_rate_monitor_update(spi_rate_monitor_t *monitor, uint8_t errors);
 
-static void spi_transfer_bidir(spi_transfer_t *transfer);
+static void spi_transfer_polled(spi_transfer_t *transfer);
+static spi_kernel_t spi_kernel_select(spi_transfer_t *transfer, uint16_t CR1_state);
 static void spi_transfer_bidir_transmit(spi_transfer_t *transfer);
 static void spi_transfer_bidir_receive(spi_transfer_t *transfer);
 
 static void spi_transfer_full_duplex_rxonly(spi_transfer_t *transfer);
 
-static void spi_transfer_full_duplex(spi_transfer_t *transfer);
 static void spi_transfer_full_duplex_master(spi_transfer_t *transfer);
+static void spi_transfer_full_duplex_master_txonly(spi_transfer_t *transfer);
 static void spi_transfer_full_duplex_slave(spi_transfer_t *transfer);
+static void spi_transfer_full_duplex_master_packed(spi_transfer_t *transfer);
+static uint16_t spi_packed_next_frame(uint16_t **tx, uint32_t *tx_left, uint16_t swap);
+static void spi_packed_store_frame(uint16_t **rx, uint16_t frame, uint16_t swap);
 
+static void spi_transfer_it_start(spi_transfer_t *transfer);
 static void spi_transfer_it_bidir(spi_transfer_t *transfer);
 static void spi_transfer_it_full_duplex_rxonly(spi_transfer_t *transfer);
 static void spi_transfer_it_full_duplex(spi_transfer_t *transfer);
+static void spi_transfer_it_full_duplex_send(spi_transfer_t *transfer);
+static void spi_transfer_it_packed(spi_transfer_t *transfer);
+static void spi_transfer_it_packed_send(spi_transfer_t *transfer);
+static void spi_transfer_it_packed_callback(spi_transfer_t *transfer);
+static spi_desc_t spi_desc_alloc(void);
+static uint8_t spi_queue_push(spi_channel_t channel, spi_desc_slot_t *slot, uint8_t kept);
+static uint8_t spi_queue_push_copy(const spi_transfer_t *transfer, uint8_t kept);
+static uint8_t spi_queue_collect(spi_channel_t channel);
+static void spi_queue_start_next(spi_channel_t channel);
+static void spi_queue_complete(spi_channel_t channel);
+static spi_transfer_t *spi_queue_current(spi_channel_t channel);
+static uint8_t spi_urgent_due(spi_transfer_t *transfer);
+static void spi_urgent_start(spi_channel_t channel);
+static void spi_urgent_complete(spi_channel_t channel);
 
 
 /******************************************************************************
@@ -153,15 +234,17 @@ static void spi_transfer_it_full_duplex(spi_transfer_t *transfer);
 * \b Description:
 *
 * 	Carries out the initialisation of the spi channels as per the information
-* 	in the config table
+* 	in the config table. Only the enabled channels have their peripheral clock
+* 	switched on. The full CR1 and CR2 images of each channel are assembled from
+* 	the config first and each register is then written exactly once.
 *
 *
 * PRE-CONDITION: The config table has been obtained and is non-null
 * PRE-CONDITION: The required GPIO pins for the spi combination have been configured
 * 					correctly with gpio_init
-* PRE-CONDITION: The appropriate peripheral clocks have been activated
 *
-* POST-CONDITION: The selected spi channels have been activated and ready to be used
+* POST-CONDITION: The selected spi channels have been clocked, configured and are
+* 					ready to be used. Disabled channels are left untouched.
 *
 *
 * @return 		void
@@ -173,6 +256,7 @@ static void spi_transfer_it_full_duplex(spi_transfer_t *transfer);
 * @endcode
 *
 * @see spi_config_get
+* @see spi_deinit
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -180,63 +264,155 @@ static void spi_transfer_it_full_duplex(spi_transfer_t *transfer);
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-void spi_init(spi_config_t *config_table)
+void spi_init(const spi_config_t *config_table)
 {
+	assert(config_table != NULL);
 	for (int spi_channel = 0; spi_channel < NUM_SPI; spi_channel++)
 	{
-		*SPI_CR1[spi_channel] &= ~(SPI_CR1_SPE_Msk);
-		if (sizeof(config_table[spi_channel])!= 0)
+		const spi_config_t *config = &config_table[spi_channel];
+		if (config->spi_enable != SPI_ENABLE)
 		{
-			if (config_table[spi_channel].spi_enable == SPI_ENABLE)
-			{
-				*SPI_CR1[spi_channel] &= ~(SPI_CR1_MSTR_Msk);
-				*SPI_CR1[spi_channel] |= config_table[spi_channel].master_slave << SPI_CR1_MSTR_Pos;
+			continue;
+		}
+		SPI_TypeDef *spi = spi_handles[spi_channel].regs;
 
-				*SPI_CR1[spi_channel] &= ~(SPI_CR1_SSM_Msk);
-				*SPI_CR1[spi_channel] |= config_table[spi_channel].slave_management << SPI_CR1_SSM_Pos;
+		*spi_handles[spi_channel].rcc_enr |= spi_handles[spi_channel].rcc_msk;
+		(void)*spi_handles[spi_channel].rcc_enr;
 
-				*SPI_CR1[spi_channel] &= ~(SPI_CR1_BIDIMODE_Msk | SPI_CR1_RXONLY_Msk);
-				if (config_table[spi_channel].bidirectional_mode == BIDIR_MODE)
-				{
-					*SPI_CR1[spi_channel] |= SPI_CR1_BIDIMODE_Msk;
-				}
-				else if (config_table[spi_channel].bidirectional_mode == UNIDIR_RXONLY)
-				{
-					*SPI_CR1[spi_channel] |= SPI_CR1_RXONLY_Msk;
-				}
+		uint16_t CR1_image = (config->master_slave << SPI_CR1_MSTR_Pos)
+							| (config->slave_management << SPI_CR1_SSM_Pos)
+							| (config->baud_rate << SPI_CR1_BR_Pos);
+		if (config->slave_management == SOFTWARE_SMM && config->master_slave == SPI_MASTER)
+		{
+			CR1_image |= SPI_CR1_SSI_Msk;
+		}
+		if (config->bidirectional_mode == BIDIR_MODE)
+		{
+			CR1_image |= SPI_CR1_BIDIMODE_Msk;
+		}
+		else if (config->bidirectional_mode == UNIDIR_RXONLY)
+		{
+			CR1_image |= SPI_CR1_RXONLY_Msk;
+		}
 
-				*SPI_CR1[spi_channel] &= ~(SPI_CR1_BR_Msk);
-				*SPI_CR1[spi_channel] |= config_table[spi_channel].baud_rate << SPI_CR1_BR_Pos;
+		uint16_t CR2_image = (config->rx_dma << SPI_CR2_RXDMAEN_Pos)
+							| (config->tx_dma << SPI_CR2_TXDMAEN_Pos)
+							| (config->ss_output << SPI_CR2_SSOE_Pos)
+							| (config->frame_format << SPI_CR2_FRF_Pos);
 
-			}
+		spi->CR2 = CR2_image;
+		spi->CR1 = CR1_image;
+		if (config->crc_polynomial != 0)
+		{
+			spi->CRCPR = config->crc_polynomial;
 		}
+		spi_handles[spi_channel].default_baud_rate = config->baud_rate;
+		spi_handles[spi_channel].CR1_ss_bits = CR1_image & (SPI_CR1_SSM_Msk | SPI_CR1_SSI_Msk);
+		spi_handles[spi_channel].CR2_ss_bits = CR2_image & SPI_CR2_SSOE_Msk;
+		spi_handles[spi_channel].cs_held = 0;
+		SPI_OS_INIT(spi_channel);
 	}
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 /******************************************************************************
-* Function: spi_transfer()
+* Function: spi_deinit()
 *//**
 * \b Description:
 *
-* 	Carries out a blocking spi transfer according to the specifications of the
-* 	 transfer parameter.
+* 	Shuts down the enabled spi channels for low power operation. Each channel is
+* 	allowed to finish its current frame, is then disabled, pulsed through its
+* 	peripheral reset so that it comes back in the reset state, and finally has
+* 	its peripheral clock switched off.
+*
+*
+* PRE-CONDITION: The config table is the one spi_init was called with
+* PRE-CONDITION: No transfer is in progress on the enabled channels
+*
+* POST-CONDITION: The enabled channels are reset and unclocked. spi_init must be
+* 					called again before they are used.
+*
+*
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_deinit(spi_config_get());
+*	enter_stop_mode();
+*	spi_init(spi_config_get());
+* @endcode
+*
+* @see spi_init
+* <br><b> - CHANGE HISTORY - </b>
 *
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_deinit(const spi_config_t *config_table)
+{
+	assert(config_table != NULL);
+	for (int spi_channel = 0; spi_channel < NUM_SPI; spi_channel++)
+	{
+		if (config_table[spi_channel].spi_enable != SPI_ENABLE)
+		{
+			continue;
+		}
+		SPI_TypeDef *spi = spi_handles[spi_channel].regs;
+
+		uint16_t SR_state;
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_BSY_Msk) != 0);
+		spi->CR1 &= ~(SPI_CR1_SPE_Msk);
+
+		*spi_handles[spi_channel].rcc_rstr |= spi_handles[spi_channel].rcc_msk;
+		*spi_handles[spi_channel].rcc_rstr &= ~(spi_handles[spi_channel].rcc_msk);
+		*spi_handles[spi_channel].rcc_enr &= ~(spi_handles[spi_channel].rcc_msk);
+		spi_handles[spi_channel].callback = NULL;
+		SPI_OS_DEINIT(spi_channel);
+	}
+}
+
+/******************************************************************************
+* Function: spi_transfer()
+*//**
+* \b Description:
 *
+* 	Carries out a blocking spi transfer according to the specifications of the
+* 	 transfer parameter. With an os port the channel is locked for the duration,
+* 	 so tasks sharing a channel take turns.
+*
+* 	 Transfers longer than their sleep_threshold (and without a CRC) are run
+* 	 through spi_transfer_it_wait instead of being polled, so the core sleeps
+* 	 between frames; shorter ones stay on the polled path, which has less
+* 	 overhead per call. A transfer is polled anyway while the channel's queue is
+* 	 full of completions waiting for spi_transfer_reap. The interrupt kernels pad a short tx_buffer with dummy
+* 	 frames, finish an odd packed length with an 8 bit frame and collect the
+* 	 errors (feeding the rate monitor) just as the polled ones do, so either
+* 	 path leaves the same result behind.
 *
 * PRE-CONDITION: spi_init() has been successfully carried out for the required spi channel
 * PRE-CONDITION: gpio_init() has been called for the slave select pin to configure it as an output/input,
 * 					depending on desired direction
 * PRE-CONDITION: The proper data buffers and lengths are non-null/non-zero
 * PRE-CONDITION: The transfer pointer is non-null
+* PRE-CONDITION: With a sleep_threshold, the channel's interrupt is enabled in the NVIC and
+* 					the caller is not an interrupt of the same or higher priority
 *
 * POST-CONDITION: The desired transfer has been successfully carried out
+* POST-CONDITION: The transfer structure itself is left untouched; the driver works on a copy
 *
 *
 * @return 		void
 *
 * \b Example:
 * @code
-*	spi_transfer_t flash_transfer;
+*	spi_transfer_t flash_transfer = {0};
 *	flash_transfer.channel = SPI_3;
 *	flash_transfer.slave_pin = GPIO_C_3;
 *	flash_transfer.ss_polarity = ACTIVE_LOW;
@@ -248,6 +424,8 @@ void spi_init(spi_config_t *config_table)
 *	flash_transfer.bit_format = MSB_FIRST;
 *	flash_transfer.clock_polarity = ACTIVE_HIGH;
 *	flash_transfer.clock_phase = SECOND_EDGE;
+*	flash_transfer.max_clock_hz = 25000000;
+*	flash_transfer.sleep_threshold = 64;
 *	spi_transfer(&flash_transfer);
 * @endcode
 *
@@ -260,84 +438,63 @@ void spi_init(spi_config_t *config_table)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-void spi_transfer(spi_transfer_t *transfer)
+void spi_transfer(const spi_transfer_t *transfer)
 {
 	assert(transfer != NULL);
-	spi_configure_clock(transfer);
-	spi_configure_data_frame(transfer);
-	uint16_t CR1_state = *SPI_CR1[transfer->channel];
-
-	if (CR1_state & SPI_CR1_MSTR_Msk)
-	{
-		spi_select_slave(transfer);
-	}
+	spi_transfer_t state = *transfer;
+	uint32_t length = (state.tx_length > state.rx_length) ? state.tx_length : state.rx_length;
 
-	*SPI_CR1[transfer->channel] |= SPI_CR1_SPE_Msk;
-
-	if (CR1_state & SPI_CR1_BIDIMODE_Msk)
+	SPI_OS_LOCK(state.channel);
+	if (state.sleep_threshold != 0 && length > state.sleep_threshold && state.crc_enable == CRC_DISABLE
+			&& spi_queue_collect(state.channel))
 	{
-		spi_transfer_bidir(transfer);
-	}
-	else if (CR1_state & SPI_CR1_RXONLY_Msk)
-	{
-		spi_transfer_full_duplex_rxonly(transfer);
+		spi_transfer_it_wait(&state, NULL);
 	}
 	else
 	{
-		spi_transfer_full_duplex(transfer);
-	}
-
-	if (CR1_state & SPI_CR1_MSTR_Msk)
-	{
-	spi_release_slave(transfer);
+		spi_transfer_polled(&state);
 	}
-
-	*SPI_CR1[transfer->channel] &= ~(SPI_CR1_SPE_Msk);
+	SPI_OS_UNLOCK(state.channel);
 }
 
 /******************************************************************************
-* Function: spi_transfer_it()
+* Function: spi_transfer_multi()
 *//**
 * \b Description:
 *
-* 	Sets up an interrupt based spi transfer according to the specifications of
-* 	 the transfer parameter. Makes a safe copy of the transfer structure and
-* 	 calls a function to map the correct callback
+* 	Carries out several blocking transfers on different spi channels at the same
+* 	time. Every full duplex master transfer is started up front and all of them are
+* 	then serviced from a single polling loop, so the buses run in parallel and the
+* 	call takes about as long as the longest transfer rather than their sum.
 *
+* 	Transfers which receive keep one frame in flight per channel, so a channel is
+* 	never overrun however long the loop takes to come back round to it; transmit
+* 	only transfers are fed whenever their buffer is empty. Transfers which are not
+* 	full duplex master transfers, or which request a CRC, are carried out one after
+* 	another once the parallel ones have completed. With an os port every channel
+* 	involved is locked for the whole call, always in channel order so that two
+* 	tasks making overlapping calls cannot deadlock.
 *
+* 	Like spi_transfer, every transfer is worked on as a copy: the structures the
+* 	array points to are left untouched and can be issued again as they are.
 *
-* PRE-CONDITION: spi_init() has been successfully carried out for the required spi channel
-* PRE-CONDITION: gpio_init() has been called for the slave select pin to configure it as an output/input,
-* 					depending on desired direction
-* PRE-CONDITION: The proper data buffers and lengths are non-null/non-zero
-* PRE-CONDITION: The transfer pointer is non-NULL
-*
-* POST-CONDITION: The irq handler will now handle the rest of the transfer
-* POST-CONDITION: A safe copy of the transfer structure has been placed in the static file-wide buffer
+* PRE-CONDITION: spi_init() has been successfully carried out for the required spi channels
+* PRE-CONDITION: Every transfer is on a different channel (Asserted)
+* PRE-CONDITION: The transfers pointer and every transfer in it are non-NULL
 *
+* POST-CONDITION: All of the transfers have been carried out
 *
+* @param		transfers an array of pointers to the transfers to carry out. They are copied
+* @param		count the number of transfers in the array
 * @return 		void
 *
 * \b Example:
 * @code
-*	spi_transfer_t flash_transfer;
-*	flash_transfer.channel = SPI_3;
-*	flash_transfer.slave_pin = GPIO_C_3;
-*	flash_transfer.ss_polarity = ACTIVE_LOW;
-*	flash_transfer.tx_buffer = &data_out;
-*	flash_transfer.tx_length = sizeof(data_out);
-*	flash_transfer.rx_buffer = &dummy_data;
-*	flash_transfer.rx_length = sizeof(data_out);
-*	flash_transfer.data_format = SPI_DATA_8BIT;
-*	flash_transfer.bit_format = MSB_FIRST;
-*	flash_transfer.clock_polarity = ACTIVE_HIGH;
-*	flash_transfer.clock_phase = SECOND_EDGE;
-*	spi_transfer_it(&flash_transfer);
+*	spi_transfer_t *frame_update[3] = {&display_pixels, &led_chain, &imu_read};
+*	spi_transfer_multi(frame_update, 3);
 * @endcode
 *
-* @see spi_init
 * @see spi_transfer
-* @see spi_irq_handler
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -345,58 +502,161 @@ void spi_transfer(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-void spi_transfer_it(spi_transfer_t *transfer)
+void spi_transfer_multi(spi_transfer_t **transfers, uint8_t count)
 {
-	assert(transfer != NULL);
-	spi_interrupt_transfers[transfer->channel] = *transfer;
-	spi_configure_clock(transfer);
-	spi_configure_data_frame(transfer);
+	assert(transfers != NULL && count <= NUM_SPI);
+	uint16_t CR1_states[NUM_SPI];
+	uint32_t to_send[NUM_SPI];
+	uint32_t to_receive[NUM_SPI];
+	uint8_t in_flight[NUM_SPI];
+	uint8_t parallel[NUM_SPI];
+	uint8_t active[NUM_SPI];
+	uint8_t locked[NUM_SPI] = {0};
+	spi_transfer_t states[NUM_SPI];
+	uint8_t remaining = 0;
 
-	uint16_t CR1_state = *SPI_CR1[transfer->channel];
-
-	if (CR1_state & SPI_CR1_MSTR_Msk)
+	for (uint8_t i = 0; i < count; i++)
 	{
-		spi_select_slave(transfer);
+		assert(transfers[i] != NULL && locked[transfers[i]->channel] == 0);
+		locked[transfers[i]->channel] = 1;
+	}
+	for (uint8_t channel = 0; channel < NUM_SPI; channel++)
+	{
+		if (locked[channel])
+		{
+			SPI_OS_LOCK((spi_channel_t)channel);
+		}
 	}
 
-	if (CR1_state & SPI_CR1_BIDIMODE_Msk)
+	for (uint8_t i = 0; i < count; i++)
 	{
-		spi_transfer_it_bidir(transfer);
+		states[i] = *transfers[i];
+		spi_transfer_t *transfer = &states[i];
+		SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+
+		uint16_t CR1_config = spi->CR1;
+		parallel[i] = (CR1_config & SPI_CR1_MSTR_Msk)
+					&& !(CR1_config & (SPI_CR1_BIDIMODE_Msk | SPI_CR1_RXONLY_Msk))
+					&& transfer->crc_enable != CRC_ENABLE
+					&& transfer->data_format != SPI_DATA_8BIT_PACKED
+					&& transfer->tx_buffer != NULL && transfer->tx_length != 0;
+		active[i] = parallel[i];
+		if (!parallel[i])
+		{
+			continue;
+		}
+
+		to_send[i] = (transfer->rx_buffer != NULL) ? transfer->rx_length : transfer->tx_length;
+		to_receive[i] = (transfer->rx_buffer != NULL) ? transfer->rx_length : 0;
+		in_flight[i] = 0;
+		CR1_states[i] = spi_transfer_begin(transfer);
+		remaining++;
 	}
-	else if (CR1_state & SPI_CR1_RXONLY_Msk)
+
+	while (remaining > 0)
 	{
-		spi_transfer_it_full_duplex_rxonly(transfer);
+		for (uint8_t i = 0; i < count; i++)
+		{
+			if (!active[i])
+			{
+				continue;
+			}
+			spi_transfer_t *transfer = &states[i];
+			SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+			uint16_t SR_state = spi->SR;
+
+			if (to_receive[i] > 0 && (SR_state & SPI_SR_RXNE_Msk))
+			{
+				*transfer->rx_buffer = spi->DR;
+				transfer->rx_buffer++;
+				transfer->rx_length--;
+				to_receive[i]--;
+				in_flight[i]--;
+			}
+
+			if (to_send[i] > 0 && (SR_state & SPI_SR_TXE_Msk)
+					&& (transfer->rx_buffer == NULL || in_flight[i] == 0))
+			{
+				if (transfer->tx_length > 0)
+				{
+					spi->DR = *transfer->tx_buffer;
+					transfer->tx_buffer++;
+					transfer->tx_length--;
+				}
+				else
+				{
+					spi->DR = SPI_DUMMY_FRAME;
+				}
+				to_send[i]--;
+				in_flight[i]++;
+			}
+			else if (to_send[i] == 0 && to_receive[i] == 0
+					&& (SR_state & SPI_SR_TXE_Msk) && !(SR_state & SPI_SR_BSY_Msk))
+			{
+				if (transfer->rx_buffer == NULL)
+				{
+					(void)spi->DR;
+					(void)spi->SR;
+				}
+				spi_transfer_end(transfer, CR1_states[i]);
+				active[i] = 0;
+				remaining--;
+			}
+		}
 	}
-	else
+
+	for (uint8_t i = 0; i < count; i++)
 	{
-		spi_transfer_it_full_duplex(transfer);
+		if (!parallel[i])
+		{
+			spi_transfer_polled(&states[i]);
+		}
 	}
 
+	for (uint8_t channel = NUM_SPI; channel > 0; channel--)
+	{
+		if (locked[channel - 1])
+		{
+			SPI_OS_UNLOCK((spi_channel_t)(channel - 1));
+		}
+	}
 }
 
 /******************************************************************************
-* Function: spi_iqr_handler()
+* Function: spi_transfer_prepare()
 *//**
 * \b Description:
 *
-*	Calls the appropriate callback function (registered during spi_transfer_it) and feeds it a safe copy
-*	of the desired transfer (made during spi_transfer_it).
+* 	Does all of the per transfer work of spi_transfer once, ahead of time, for a
+* 	transfer which is replayed over and over (e.g. the same sensor read every
+* 	control period): the CR1 image with clock, frame, bit order, prescaler and CRC
+* 	settings is built and the polling routine is chosen. Starting the prepared
+* 	transfer then only writes CR1, drives the slave select and runs the routine.
 *
-* PRE-CONDITION: spi_transfer_it has been called and set up on the desired channel
-* POST-CONDITION: The callback has been called and has handled a single reception/transfer/end of transfer
+* PRE-CONDITION: spi_init() has been successfully carried out for the required spi channel
+* PRE-CONDITION: The prepared and transfer pointers are non-NULL
 *
+* POST-CONDITION: The prepared transfer can be started with spi_transfer_start_prepared
+* POST-CONDITION: Later changes to the channel (spi_init) are only picked up by preparing
+* 					again. A rate monitor's derate is applied afresh at every start
+*
+* @param		prepared a pointer to the prepared transfer to fill in
+* @param		transfer a pointer to the transfer to prepare. It is copied
 * @return 		void
 *
 * \b Example:
-*  Called from withn the hardware defined irqs defined in the vector table
 * @code
-* SPI3_IRQHandler()
-* {
-* 	spi_irq_handler(SPI_3);
-* }
+*	static spi_prepared_t gyro_read;
+*	spi_transfer_prepare(&gyro_read, &gyro_transfer);
+*	...
+*	void control_tick(void)
+*	{
+*		spi_transfer_start_prepared(&gyro_read);
+*	}
 * @endcode
 *
-* @see spi_transfer_it
+* @see spi_transfer_start_prepared
+* @see spi_transfer
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -404,34 +664,65 @@ void spi_transfer_it(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-void spi_irq_handler(spi_channel_t channel)
+void spi_transfer_prepare(spi_prepared_t *prepared, const spi_transfer_t *transfer)
 {
-	spi_transfer_t *transfer = &spi_interrupt_transfers[channel];
-	if (spi_interrupt_callbacks[channel] != NULL)
+	assert(prepared != NULL && transfer != NULL && transfer->channel < NUM_SPI);
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	prepared->transfer = *transfer;
+
+	uint16_t CR1_image = spi->CR1 & ~(SPI_CR1_CPOL_Msk | SPI_CR1_CPHA_Msk | SPI_CR1_DFF_Msk
+									| SPI_CR1_LSBFIRST_Msk | SPI_CR1_BR_Msk | SPI_CR1_CRCEN_Msk
+									| SPI_CR1_CRCNEXT_Msk | SPI_CR1_SPE_Msk);
+	if (transfer->clock_polarity == ACTIVE_LOW)
 	{
-		spi_interrupt_callbacks[channel](transfer);
+		CR1_image |= SPI_CR1_CPOL_Msk;
 	}
-}
+	if (transfer->clock_phase == SECOND_EDGE)
+	{
+		CR1_image |= SPI_CR1_CPHA_Msk;
+	}
+	if (transfer->data_format != SPI_DATA_8BIT)
+	{
+		CR1_image |= SPI_CR1_DFF_Msk;
+	}
+	if (transfer->bit_format == LSB_FIRST)
+	{
+		CR1_image |= SPI_CR1_LSBFIRST_Msk;
+	}
+	if (transfer->crc_enable == CRC_ENABLE)
+	{
+		CR1_image |= SPI_CR1_CRCEN_Msk;
+	}
+	CR1_image |= spi_baud_rate_select(&prepared->transfer) << SPI_CR1_BR_Pos;
 
+	prepared->CR1_image = CR1_image;
+	prepared->kernel = spi_kernel_select(&prepared->transfer, CR1_image);
+}
 
 /******************************************************************************
-* Function: spi_register_write()
+* Function: spi_transfer_start_prepared()
 *//**
 * \b Description:
 *
-*	Write the desired value into the register in spi address space
+* 	Carries out a blocking transfer prepared by spi_transfer_prepare. The
+* 	prepared transfer itself is not consumed: every start runs from the buffers
+* 	and lengths it was prepared with. With an os port the channel is locked for
+* 	the duration, as for spi_transfer. A transfer with a rate monitor has its
+* 	prescaler bits worked out again, so that it follows the monitor's derate.
 *
-* PRE-CONDITION: the spi_register is within spi address space
-* POST-CONDITION: the spi_register contains the desired value
+* PRE-CONDITION: spi_transfer_prepare() has been called on the prepared transfer
+*
+* POST-CONDITION: The transfer has been carried out
+*
+* @param		prepared a pointer to the prepared transfer
 * @return 		void
 *
 * \b Example:
 * @code
-* uint16_t new_value = 0xFF2A;
-* spi_register_write(SPI1_BASE + 0x20UL, new_value);
+*	spi_transfer_start_prepared(&gyro_read);
 * @endcode
 *
-* @see spi_register_read
+* @see spi_transfer_prepare
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -439,33 +730,69 @@ void spi_irq_handler(spi_channel_t channel)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-void spi_register_write(uint32_t spi_register, uint16_t value)
+void spi_transfer_start_prepared(spi_prepared_t *prepared)
 {
-	assert(		(spi_register >= SPI2_BASE && spi_register < I2S3ext_BASE)
-			||  (spi_register >= SPI1_BASE && spi_register < SYSCFG_BASE)
-			|| 	(spi_register >= SPI5_BASE && spi_register < GPIOA_BASE));
+	assert(prepared != NULL);
+	spi_transfer_t transfer = prepared->transfer;
+	SPI_TypeDef *spi = spi_handles[transfer.channel].regs;
+	uint16_t CR1_image = prepared->CR1_image;
 
-	*((uint16_t *)spi_register) = value;
+	if (transfer.rate_monitor != NULL)
+	{
+		CR1_image = (CR1_image & ~(SPI_CR1_BR_Msk)) | (spi_baud_rate_select(&transfer) << SPI_CR1_BR_Pos);
+	}
+	SPI_OS_LOCK(transfer.channel);
+	spi->CR1 = CR1_image;
+	SPI_TRACE(TRACE_CONFIGURE, transfer.channel, CR1_image);
+	SPI_TRACE(TRACE_TRANSFER_START, transfer.channel,
+			(transfer.tx_length > transfer.rx_length) ? transfer.tx_length : transfer.rx_length);
+	if (CR1_image & SPI_CR1_MSTR_Msk)
+	{
+		spi_select_slave(&transfer);
+	}
+	spi->CR1 |= SPI_CR1_SPE_Msk;
+
+	if (prepared->kernel != NULL)
+	{
+		prepared->kernel(&transfer);
+	}
+	spi_transfer_end(&transfer, CR1_image);
+	SPI_OS_UNLOCK(transfer.channel);
 }
 
 /******************************************************************************
-* Function: spi_register_read()
+* Function: spi_bus_acquire()
 *//**
 * \b Description:
 *
-*	Reads the current value from the register in spi address space
+* 	Locks the device's channel and selects the device until spi_bus_release, so
+* 	that a sequence of transfers to it (e.g. a command followed by a data phase
+* 	in another frame format) runs under a single select. The transfers to the
+* 	device in between leave its select alone and pay no setup or hold delay.
+* 	Transfers to other devices still drive their own selects, but the held
+* 	device sees their clocks as well.
 *
-* PRE-CONDITION: the spi_register is within spi address space
-* POST-CONDITION: Returns the value within the register
+* PRE-CONDITION: spi_init() has configured the channel as a master
+* PRE-CONDITION: The device uses a GPIO select. A hardware NSS follows SPE and is
+* 					released by every transfer, so it cannot be held
+* PRE-CONDITION: No interrupt handler addresses another device on the channel
+* 					with spi_transfer_it_from_isr, unless the held device ignores
+* 					the traffic
 *
-* @return 		uint16_t
+* POST-CONDITION: The device is selected and the channel is locked to the calling task
+*
+* @param		device a pointer to a transfer naming the device. Buffers are ignored
+* @return 		void
 *
 * \b Example:
 * @code
-* uin16_t current_value = spi_register_write(SPI1_BASE + 0x20UL);
+*	spi_bus_acquire(&flash_transfer);
+*	spi_transfer(&flash_command);
+*	spi_transfer(&flash_data);
+*	spi_bus_release(&flash_transfer);
 * @endcode
 *
-* @see spi_register_write
+* @see spi_bus_release
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -473,41 +800,38 @@ void spi_register_write(uint32_t spi_register, uint16_t value)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-uint16_t spi_register_read(uint32_t spi_register)
+void spi_bus_acquire(const spi_transfer_t *device)
 {
-	assert(		(spi_register >= SPI2_BASE && spi_register < I2S3ext_BASE)
-			||  (spi_register >= SPI1_BASE && spi_register < SYSCFG_BASE)
-			|| 	(spi_register >= SPI5_BASE && spi_register < GPIOA_BASE));
-
-	return ( *((uint16_t *)spi_register));
+	assert(device != NULL && device->channel < NUM_SPI);
+	assert(device->ss_polarity != SS_HARDWARE);
+	SPI_OS_LOCK(device->channel);
+	spi_select_slave(device);
+	spi_handles[device->channel].cs_held_pin = device->slave_pin;
+	spi_handles[device->channel].cs_held = 1;
 }
 
 /******************************************************************************
-* Function: spi_transfer_bidir()
+* Function: spi_bus_release()
 *//**
 * \b Description:
 *
-*	A static function called auomatically by spi_transfer when appropriate
-*	which subsequently simply calls the appropriate transfer subroutine
-*	based on transfer direction
+* 	Waits for any interrupt transfers queued on the channel to finish, sleeping
+* 	as spi_transfer_it_wait does, then releases the device selected by
+* 	spi_bus_acquire after its hold delay and unlocks the channel.
 *
-* PRE-CONDITION: (Soft assertion) The pointer to the data buffer to be transferred
-* 					is non-NULL. Failure of this check results in an uneventful return
+* PRE-CONDITION: spi_bus_acquire() has been called with the same device by the calling task
 *
-* POST-CONDITION: The data has been transferred as specified in the transfer parameter
-* 					by the subroutine.
+* POST-CONDITION: The device is released and the channel is free
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
+* @param		device a pointer to the transfer passed to spi_bus_acquire
 * @return 		void
 *
 * \b Example:
-*	Called automatically by spi_transfer when BIDIMODE == 1
+* @code
+*	spi_bus_release(&flash_transfer);
+* @endcode
 *
-* @see spi_transfer_bidir_transmit
-* @see spi_transfer_bidir_receive
-* @see spi_transfer_full_duplex_rxonly
-* @see spi_transfer_full_duplex
+* @see spi_bus_acquire
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -515,53 +839,2496 @@ uint16_t spi_register_read(uint32_t spi_register)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_bidir(spi_transfer_t *transfer)
+void spi_bus_release(const spi_transfer_t *device)
 {
-	uint16_t CR1_state = *SPI_CR1[transfer->channel];
-
-	if ((CR1_state & SPI_CR1_BIDIOE_Msk) != 0)
-	{
-		if (transfer->tx_buffer == NULL)
-		{
-			return;
-		}
-		spi_transfer_bidir_transmit(transfer);
-	}
-	else
+	assert(device != NULL && device->channel < NUM_SPI);
+	spi_queue_t *queue = &spi_queues[device->channel];
+	while ((int32_t)(queue->done - queue->head) < 0)
 	{
-		if (transfer->rx_buffer == NULL)
-		{
-			return;
-		}
-		spi_transfer_bidir_receive(transfer);
+		SPI_OS_WAIT(device->channel);
 	}
+
+	spi_handles[device->channel].cs_held = 0;
+	spi_release_slave(device);
+	SPI_OS_UNLOCK(device->channel);
 }
 
 /******************************************************************************
-* Function: spi_transfer_bidir_transmit()
+* Function: spi_transfer_it()
 *//**
 * \b Description:
 *
-*	A static function called automatically by spi_transfer_bidir when the single
-*	data line is being used to send information
+* 	Queues an interrupt based spi transfer according to the specifications of
+* 	 the transfer parameter. No completion record is kept for it: the queue
+* 	 passes over its slot once it completes, leaving any records of submitted
+* 	 transfers waiting to be reaped. Use spi_transfer_submit and
+* 	 spi_transfer_reap when the completed transfers are needed.
 *
-* PRE-CONDITION: (Soft assertion) The length of the data buffer is non-NULL.
-* 					Failure of this check simply ends the function
 *
-* POST-CONDITION: Transmits the data in tx_buffer to the selected slave
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
-* @return 		void
+* PRE-CONDITION: spi_init() has been successfully carried out for the required spi channel
+* PRE-CONDITION: gpio_init() has been called for the slave select pin to configure it as an output/input,
+* 					depending on desired direction
+* PRE-CONDITION: The proper data buffers and lengths are non-null/non-zero
+* PRE-CONDITION: The transfer pointer is non-NULL
+* PRE-CONDITION: Fewer than SPI_QUEUE_LENGTH transfers are waiting on the channel
+*
+* POST-CONDITION: The irq handler will now handle the rest of the transfer
+* POST-CONDITION: A safe copy of the transfer structure has been placed in the channel's
+* 					copy for the queue slot and queued on the channel
+*
+*
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_transfer_t flash_transfer = {0};
+*	flash_transfer.channel = SPI_3;
+*	flash_transfer.slave_pin = GPIO_C_3;
+*	flash_transfer.ss_polarity = ACTIVE_LOW;
+*	flash_transfer.tx_buffer = &data_out;
+*	flash_transfer.tx_length = sizeof(data_out);
+*	flash_transfer.rx_buffer = &dummy_data;
+*	flash_transfer.rx_length = sizeof(data_out);
+*	flash_transfer.data_format = SPI_DATA_8BIT;
+*	flash_transfer.bit_format = MSB_FIRST;
+*	flash_transfer.clock_polarity = ACTIVE_HIGH;
+*	flash_transfer.clock_phase = SECOND_EDGE;
+*	flash_transfer.max_clock_hz = 25000000;
+*	spi_transfer_it(&flash_transfer);
+* @endcode
+*
+* @see spi_init
+* @see spi_transfer
+* @see spi_transfer_submit
+* @see spi_irq_handler
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_transfer_it(const spi_transfer_t *transfer)
+{
+	assert(transfer != NULL);
+	SPI_OS_LOCK(transfer->channel);
+	uint8_t queued = spi_queue_push_copy(transfer, 0);
+	assert(queued);
+	(void)queued;
+	SPI_OS_UNLOCK(transfer->channel);
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_from_isr()
+*//**
+* \b Description:
+*
+* 	Queues a transfer from an interrupt handler (e.g. a timer tick launching
+* 	periodic transfers). The transfer is copied into a ring of SPI_ISR_QUEUE_LENGTH
+* 	entries kept for the handler, separate from the ring tasks submit to, so the
+* 	channel can still be used from tasks. The transfers of this ring are started
+* 	ahead of the tasks' transfers whenever the channel falls idle, and are never
+* 	reaped. The channel lock is not taken, so the call never blocks, and a full
+* 	ring is reported instead of asserted on.
+*
+* 	If a stamp is given, the spi interrupt notes the cycle count in it just as
+* 	it begins the transfer, so that the caller can measure when its transfers
+* 	really start rather than when they were queued.
+*
+* PRE-CONDITION: spi_init() has been successfully carried out for the required spi channel
+* PRE-CONDITION: Only one interrupt handler calls this for the channel
+* PRE-CONDITION: The interrupt calling it has a lower priority than the channel's spi interrupt
+*
+* POST-CONDITION: If queued, the irq handler will start the transfer once the channel is free
+* POST-CONDITION: If queued, the stamp reads not started until the transfer begins
+*
+* @param		transfer a pointer to the transfer to queue. It is copied
+* @param		stamp a pointer to the stamp to fill in at the start, NULL if unwanted
+* @return 		uint8_t 1 if the transfer was queued, 0 if the ring was full
+*
+* \b Example:
+* @code
+*	void TIM2_IRQHandler(void)
+*	{
+*		TIM2->SR = ~TIM_SR_UIF;
+*		spi_transfer_it_from_isr(&gyro_transfer, &gyro_start);
+*	}
+* @endcode
+*
+* @see spi_transfer_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_transfer_it_from_isr(const spi_transfer_t *transfer, spi_start_stamp_t *stamp)
+{
+	assert(transfer != NULL && transfer->channel < NUM_SPI);
+	spi_queue_t *queue = &spi_queues[transfer->channel];
+	uint32_t isr_head = queue->isr_head;
+
+	if (isr_head - queue->isr_done >= SPI_ISR_QUEUE_LENGTH)
+	{
+		return (0);
+	}
+	uint32_t index = isr_head & (SPI_ISR_QUEUE_LENGTH - 1U);
+	queue->isr_slots[index] = *transfer;
+	queue->isr_stamps[index] = stamp;
+	if (stamp != NULL)
+	{
+		stamp->started = 0;
+	}
+	__DMB();
+	queue->isr_head = isr_head + 1;
+
+	NVIC_SetPendingIRQ(spi_handles[transfer->channel].irqn);
+	return (1);
+}
+
+/******************************************************************************
+* Function: spi_transfer_submit()
+*//**
+* \b Description:
+*
+* 	Places a safe copy of the transfer in the channel's queue and pends the
+* 	channel's interrupt, which starts it as soon as the transfers ahead of it have
+* 	completed. The copy is completed before it is published to the interrupt, so
+* 	the interrupt never sees a partly written transfer, and no interrupts are
+* 	disabled along the way.
+*
+* PRE-CONDITION: spi_init() has been successfully carried out for the required spi channel
+* PRE-CONDITION: The channel's interrupt is enabled in the NVIC
+* PRE-CONDITION: Without an os port, only one context submits and reaps on a channel
+* PRE-CONDITION: The transfer pointer is non-NULL
+*
+* POST-CONDITION: The transfer has been queued, or the queue was full
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		uint8_t 1 if the transfer was queued, 0 if the queue was full
+*
+* \b Example:
+* @code
+*	while (!spi_transfer_submit(&sensor_read))
+*	{
+*		handle_completed_reads();
+*	}
+* @endcode
+*
+* @see spi_transfer_reap
+* @see spi_irq_handler
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_transfer_submit(const spi_transfer_t *transfer)
+{
+	assert(transfer != NULL && transfer->channel < NUM_SPI);
+	SPI_OS_LOCK(transfer->channel);
+	uint8_t queued = spi_queue_push_copy(transfer, 1);
+	SPI_OS_UNLOCK(transfer->channel);
+	return (queued);
+}
+
+/******************************************************************************
+* Function: spi_transfer_reap()
+*//**
+* \b Description:
+*
+* 	Collects the oldest completed interrupt transfer of a channel, freeing its slot
+* 	in the queue. The copy handed back has its buffers advanced and lengths counted
+* 	down exactly as the interrupt left them.
+*
+* PRE-CONDITION: Only one context (task or main loop) submits and reaps on a channel
+*
+* POST-CONDITION: The oldest completed transfer has been removed from the queue
+*
+* @param		channel the spi device of interest
+* @param		completed where to copy the completed transfer, may be NULL
+* @return 		uint8_t 1 if a completed transfer was collected, 0 if there were none
+*
+* \b Example:
+* @code
+*	spi_transfer_t done;
+*	while (spi_transfer_reap(SPI_2, &done))
+*	{
+*		process_samples(done.rx_buffer);
+*	}
+* @endcode
+*
+* @see spi_transfer_submit
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_transfer_reap(spi_channel_t channel, spi_transfer_t *completed)
+{
+	assert(channel < NUM_SPI);
+	spi_queue_t *queue = &spi_queues[channel];
+	uint8_t found = 0;
+
+	SPI_OS_LOCK(channel);
+	(void)spi_queue_collect(channel);
+	uint32_t reaped = queue->reaped;
+	if (reaped != queue->done)
+	{
+		__DMB();
+		if (completed != NULL)
+		{
+			*completed = queue->slots[reaped & (SPI_QUEUE_LENGTH - 1U)]->state;
+		}
+		__DMB();
+		queue->reaped = reaped + 1;
+		found = 1;
+	}
+	SPI_OS_UNLOCK(channel);
+	return (found);
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_wait()
+*//**
+* \b Description:
+*
+* 	Carries out an interrupt based transfer and blocks until it has completed.
+* 	With an os port the channel is locked for the duration and the calling task
+* 	sleeps on the channel's completion semaphore, leaving the cpu to other tasks
+* 	while the interrupt moves the data. Without one the core sleeps with WFE
+* 	between interrupts; every exception return sets the event register, so a
+* 	completion landing between the check and the WFE is never missed.
+*
+* 	The final state of the transfer, with its buffers advanced and lengths counted
+* 	down, is copied to completed; the transfer itself is left untouched. Only its
+* 	own slot of the queue is read back: completions of spi_transfer_submit calls
+* 	on the channel are left for spi_transfer_reap.
+*
+* PRE-CONDITION: spi_init() has been successfully carried out for the required spi channel
+* PRE-CONDITION: The channel's interrupt is enabled in the NVIC
+* PRE-CONDITION: Called from task context, never from an interrupt
+* PRE-CONDITION: The transfer pointer is non-NULL
+* PRE-CONDITION: The channel's queue has a free slot: submitters reap what they submit
+*
+* POST-CONDITION: The transfer has been carried out
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @param		completed where the final state of the transfer is copied, or NULL
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_transfer_t flash_done;
+*	spi_transfer_it_wait(&flash_transfer, &flash_done);
+* @endcode
+*
+* @see spi_transfer
+* @see spi_transfer_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_transfer_it_wait(const spi_transfer_t *transfer, spi_transfer_t *completed)
+{
+	assert(transfer != NULL && transfer->channel < NUM_SPI);
+	spi_queue_t *queue = &spi_queues[transfer->channel];
+
+	SPI_OS_LOCK(transfer->channel);
+	uint32_t ticket = queue->head;
+	uint8_t queued = spi_queue_push_copy(transfer, 1);
+	assert(queued);
+	(void)queued;
+
+	while ((int32_t)(queue->done - ticket) <= 0)
+	{
+		SPI_OS_WAIT(transfer->channel);
+	}
+	__DMB();
+	if (completed != NULL)
+	{
+		*completed = queue->slots[ticket & (SPI_QUEUE_LENGTH - 1U)]->state;
+	}
+	queue->kept[ticket & (SPI_QUEUE_LENGTH - 1U)] = 0;
+	if (queue->reaped == ticket)
+	{
+		queue->reaped = ticket + 1;
+	}
+	SPI_OS_UNLOCK(transfer->channel);
+}
+
+/******************************************************************************
+* Function: spi_desc_create()
+*//**
+* \b Description:
+*
+* 	Takes a descriptor from the pool and binds it to a request. Submitting the
+* 	descriptor only queues its handle: the request is read when the transfer
+* 	starts and is never modified, so the same descriptor can be submitted again
+* 	as soon as it is done, without being filled in again.
+*
+* PRE-CONDITION: The request stays valid, and is not changed while submitted, until
+* 					spi_desc_destroy
+*
+* POST-CONDITION: The descriptor is idle and can be submitted
+*
+* @param		request a pointer to the transfer the descriptor carries out
+* @return 		spi_desc_t the descriptor, SPI_DESC_NONE if the pool is empty
+*
+* \b Example:
+* @code
+*	static const spi_transfer_t gyro_read = {SPI_2, GPIO_B_12, SS_ACTIVE_LOW, ...};
+*	spi_desc_t gyro = spi_desc_create(&gyro_read);
+* @endcode
+*
+* @see spi_desc_submit
+* @see spi_desc_destroy
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+spi_desc_t spi_desc_create(const spi_transfer_t *request)
+{
+	assert(request != NULL && request->channel < NUM_SPI);
+	spi_desc_t desc = spi_desc_alloc();
+	if (desc != SPI_DESC_NONE)
+	{
+		spi_descs[desc].request = request;
+	}
+	return (desc);
+}
+
+/******************************************************************************
+* Function: spi_desc_submit()
+*//**
+* \b Description:
+*
+* 	Queues a descriptor on its request's channel. Completion is reported by
+* 	spi_desc_status rather than spi_transfer_reap, so no record is kept: the
+* 	queue passes over the slot once it completes, as it does for spi_transfer_it.
+*
+* PRE-CONDITION: The descriptor was made by spi_desc_create
+*
+* POST-CONDITION: The descriptor is queued, or was still queued, or the queue was full
+*
+* @param		desc the descriptor to queue
+* @return 		uint8_t 1 if the descriptor was queued, 0 otherwise
+*
+* \b Example:
+* @code
+*	if (spi_desc_status(gyro) != SPI_DESC_QUEUED)
+*	{
+*		spi_desc_submit(gyro);
+*	}
+* @endcode
+*
+* @see spi_desc_status
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_desc_submit(spi_desc_t desc)
+{
+	assert(desc < SPI_DESC_POOL_LENGTH && spi_descs[desc].in_use && spi_descs[desc].request != NULL);
+	if (spi_descs[desc].status == SPI_DESC_QUEUED)
+	{
+		return (0);
+	}
+	spi_channel_t channel = spi_descs[desc].request->channel;
+
+	SPI_OS_LOCK(channel);
+	uint8_t queued = spi_queue_push(channel, &spi_descs[desc], 0);
+	SPI_OS_UNLOCK(channel);
+	return (queued);
+}
+
+/******************************************************************************
+* Function: spi_desc_status()
+*//**
+* \b Description:
+*
+* 	Reports where the latest submission of a descriptor has got to.
+*
+* PRE-CONDITION: The descriptor was made by spi_desc_create
+*
+* POST-CONDITION: None
+*
+* @param		desc the descriptor of interest
+* @return 		spi_desc_status_t idle, queued (waiting or in progress) or done
+*
+* \b Example:
+* @code
+*	if (spi_desc_status(gyro) == SPI_DESC_DONE)
+*	{
+*		process_gyro(gyro_samples);
+*	}
+* @endcode
+*
+* @see spi_desc_submit
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+spi_desc_status_t spi_desc_status(spi_desc_t desc)
+{
+	assert(desc < SPI_DESC_POOL_LENGTH && spi_descs[desc].in_use);
+	return ((spi_desc_status_t)spi_descs[desc].status);
+}
+
+/******************************************************************************
+* Function: spi_desc_destroy()
+*//**
+* \b Description:
+*
+* 	Returns a descriptor to the pool.
+*
+* PRE-CONDITION: The descriptor was made by spi_desc_create and is not queued
+*
+* POST-CONDITION: The handle must not be used again
+*
+* @param		desc the descriptor to return
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_desc_destroy(gyro);
+* @endcode
+*
+* @see spi_desc_create
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_desc_destroy(spi_desc_t desc)
+{
+	assert(desc < SPI_DESC_POOL_LENGTH && spi_descs[desc].in_use);
+	assert(spi_descs[desc].status != SPI_DESC_QUEUED);
+	spi_descs[desc].request = NULL;
+	__DMB();
+	spi_descs[desc].in_use = 0;
+}
+
+/******************************************************************************
+* Function: spi_desc_submit_urgent()
+*//**
+* \b Description:
+*
+* 	Submits a descriptor ahead of everything queued on its channel. If the
+* 	interrupt transfer in progress was submitted with preemptible set, it is
+* 	paused at the next frame boundary (at most the frames already in flight are
+* 	finished), its slave is released, the urgent transfer runs with its own
+* 	select and the paused transfer then carries on from where it stopped.
+* 	Otherwise the urgent transfer starts as soon as the current one finishes.
+* 	Only full duplex interrupt transfers on a master can be paused.
+*
+* PRE-CONDITION: The descriptor was made by spi_desc_create for an interrupt transfer
+* PRE-CONDITION: Only one context submits urgent transfers on a channel
+* PRE-CONDITION: The paused slave tolerates having its select released mid-transfer
+*
+* POST-CONDITION: The urgent transfer is pending, or one was pending already
+*
+* @param		desc the descriptor to run urgently
+* @return 		uint8_t 1 if the descriptor was submitted, 0 if the channel had an
+* 					urgent transfer pending already
+*
+* \b Example:
+* @code
+*	flash_read.preemptible = PREEMPT_ENABLE;
+*	spi_transfer_it(&flash_read);
+*	...
+*	spi_desc_submit_urgent(imu_read);
+*	while (spi_desc_status(imu_read) != SPI_DESC_DONE);
+* @endcode
+*
+* @see spi_desc_status
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_desc_submit_urgent(spi_desc_t desc)
+{
+	assert(desc < SPI_DESC_POOL_LENGTH && spi_descs[desc].in_use && spi_descs[desc].request != NULL);
+	spi_channel_t channel = spi_descs[desc].request->channel;
+	spi_queue_t *queue = &spi_queues[channel];
+	if (queue->urgent_pending)
+	{
+		return (0);
+	}
+
+	spi_descs[desc].status = SPI_DESC_QUEUED;
+	queue->urgent = desc;
+	__DMB();
+	queue->urgent_pending = 1;
+	NVIC_SetPendingIRQ(spi_handles[channel].irqn);
+	return (1);
+}
+
+/******************************************************************************
+* Function: spi_iqr_handler()
+*//**
+* \b Description:
+*
+*	Calls the appropriate callback function (registered when the transfer was started) and feeds it the
+*	safe copy of the transfer in progress. Once the channel is idle, starts a pending urgent transfer,
+*	or else the next queued transfer.
+*
+* PRE-CONDITION: spi_transfer_it or spi_transfer_submit has been called on the desired channel
+* POST-CONDITION: The callback has been called and has handled a single reception/transfer/end of transfer
+* POST-CONDITION: If the channel was idle, the next waiting transfer has been started
+*
+* @return 		void
+*
+* \b Example:
+*  Called from withn the hardware defined irqs defined in the vector table
+* @code
+* SPI3_IRQHandler()
+* {
+* 	spi_irq_handler(SPI_3);
+* }
+* @endcode
+*
+* @see spi_transfer_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_irq_handler(spi_channel_t channel)
+{
+	SPI_TRACE(TRACE_ISR_ENTRY, channel, 0);
+	spi_queue_t *queue = &spi_queues[channel];
+	spi_transfer_t *transfer = NULL;
+	if (queue->urgent_active)
+	{
+		transfer = &spi_descs[queue->urgent].state;
+	}
+	else if (queue->active)
+	{
+		transfer = spi_queue_current(channel);
+	}
+	if (transfer != NULL && spi_handles[channel].callback != NULL)
+	{
+		spi_handles[channel].callback(transfer);
+	}
+
+	if (!queue->active && !queue->urgent_active)
+	{
+		if (queue->urgent_pending)
+		{
+			spi_urgent_start(channel);
+		}
+		if (!queue->urgent_active)
+		{
+			spi_queue_start_next(channel);
+		}
+	}
+	SPI_TRACE(TRACE_ISR_EXIT, channel, 0);
+}
+
+/******************************************************************************
+* Function: spi_error_get()
+*//**
+* \b Description:
+*
+*	Returns the errors detected during the most recent blocking transfer on a
+*	channel, as a mask of spi_error_t flags.
+*
+* PRE-CONDITION: None
+* POST-CONDITION: None
+*
+* @param		channel the spi device of interest
+* @return 		uint8_t SPI_ERROR_NONE or an OR of spi_error_t flags
+*
+* \b Example:
+* @code
+* spi_transfer(&sensor_read);
+* if (spi_error_get(SPI_2) & SPI_ERROR_CRC)
+* {
+* 	sensor_read_retry();
+* }
+* @endcode
+*
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_error_get(spi_channel_t channel)
+{
+	assert(channel < NUM_SPI);
+	return (spi_handles[channel].errors);
+}
+
+/******************************************************************************
+* Function: spi_clock_get()
+*//**
+* \b Description:
+*
+*	Returns the SCK frequency a prescaler produces on a channel, based on the
+*	bus (APB1 or APB2) the channel hangs off.
+*
+* PRE-CONDITION: SPI_APB1_CLOCK_HZ and SPI_APB2_CLOCK_HZ match the clock tree
+* POST-CONDITION: None
+*
+* @param		channel the spi device of interest
+* @param		baud_rate the prescaler
+* @return 		uint32_t the resulting SCK frequency in Hz
+*
+* \b Example:
+* @code
+* uint32_t sck_hz = spi_clock_get(SPI_1, PCLK_DIV_8);
+* @endcode
+*
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_clock_get(spi_channel_t channel, spi_baud_rate_t baud_rate)
+{
+	assert(channel < NUM_SPI);
+	return (spi_handles[channel].pclk_hz >> (baud_rate + 1));
+}
+
+/******************************************************************************
+* Function: spi_rate_monitor_init()
+*//**
+* \b Description:
+*
+*	Sets up the error tracking for a device. Once a transfer points at the monitor,
+*	every blocking transfer to the device is recorded in a sliding window of the
+*	last window transfers. When error_threshold of those had an error, the device's
+*	clock is stepped down one prescaler; after probe_after consecutive clean
+*	transfers one step is given back.
+*
+* PRE-CONDITION: 0 < window <= 32
+* PRE-CONDITION: 0 < error_threshold <= window
+*
+* POST-CONDITION: The monitor is empty and applies no slow down
+*
+* @param		monitor a pointer to the monitor to initialise
+* @param		window the number of recent transfers considered
+* @param		error_threshold the errored transfers in the window causing a step down
+* @param		probe_after the clean transfers needed before a step back up
+* @return 		void
+*
+* \b Example:
+* @code
+* static spi_rate_monitor_t encoder_monitor;
+* spi_rate_monitor_init(&encoder_monitor, 32, 4, 1000);
+* encoder_transfer.crc_enable = CRC_ENABLE;
+* encoder_transfer.rate_monitor = &encoder_monitor;
+* @endcode
+*
+* @see spi_rate_monitor_update
+* @see spi_configure_baud_rate
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_rate_monitor_init(spi_rate_monitor_t *monitor, uint8_t window, uint8_t error_threshold, uint16_t probe_after)
+{
+	assert(monitor != NULL);
+	assert(window != 0 && window <= 32);
+	assert(error_threshold != 0 && error_threshold <= window);
+
+	monitor->window = window;
+	monitor->error_threshold = error_threshold;
+	monitor->probe_after = probe_after;
+	monitor->history = 0;
+	monitor->clean_run = 0;
+	monitor->derate = 0;
+	monitor->error_count = 0;
+}
+
+/******************************************************************************
+* Function: spi_register_write()
+*//**
+* \b Description:
+*
+*	Write the desired value into the register in spi address space
+*
+* PRE-CONDITION: the spi_register is within spi address space
+* POST-CONDITION: the spi_register contains the desired value
+* @return 		void
+*
+* \b Example:
+* @code
+* uint16_t new_value = 0xFF2A;
+* spi_register_write(SPI1_BASE + 0x20UL, new_value);
+* @endcode
+*
+* @see spi_register_read
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_register_write(uint32_t spi_register, uint16_t value)
+{
+	assert(		(spi_register >= SPI2_BASE && spi_register < I2S3ext_BASE)
+			||  (spi_register >= SPI1_BASE && spi_register < SYSCFG_BASE)
+			|| 	(spi_register >= SPI5_BASE && spi_register < GPIOA_BASE));
+
+	*((uint16_t *)spi_register) = value;
+}
+
+/******************************************************************************
+* Function: spi_register_read()
+*//**
+* \b Description:
+*
+*	Reads the current value from the register in spi address space
+*
+* PRE-CONDITION: the spi_register is within spi address space
+* POST-CONDITION: Returns the value within the register
+*
+* @return 		uint16_t
+*
+* \b Example:
+* @code
+* uin16_t current_value = spi_register_write(SPI1_BASE + 0x20UL);
+* @endcode
+*
+* @see spi_register_write
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint16_t spi_register_read(uint32_t spi_register)
+{
+	assert(		(spi_register >= SPI2_BASE && spi_register < I2S3ext_BASE)
+			||  (spi_register >= SPI1_BASE && spi_register < SYSCFG_BASE)
+			|| 	(spi_register >= SPI5_BASE && spi_register < GPIOA_BASE));
+
+	return ( *((uint16_t *)spi_register));
+}
+
+/******************************************************************************
+* Function: spi_kernel_select()
+*//**
+* \b Description:
+*
+*	Static function which picks the polling routine for a transfer from the
+*	channel's mode (bidirectional, receive only or full duplex), its direction,
+*	master or slave role and the transfer's buffers and data format.
+*
+* PRE-CONDITION: CR1_state holds the channel's configuration for the transfer
+*
+* POST-CONDITION: None
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @param		CR1_state the CR1 image the transfer runs with
+* @return 		spi_kernel_t the routine to run, NULL when the buffers the mode needs
+* 					are missing and there is nothing to do
+*
+* \b Example:
+*	Called by spi_transfer_polled for every transfer and by spi_transfer_prepare
+*	once per prepared transfer
+*
+* @see spi_transfer_bidir_transmit
+* @see spi_transfer_bidir_receive
+* @see spi_transfer_full_duplex_rxonly
+* @see spi_transfer_full_duplex_master
+* @see spi_transfer_full_duplex_master_txonly
+* @see spi_transfer_full_duplex_master_packed
+* @see spi_transfer_full_duplex_slave
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static spi_kernel_t spi_kernel_select(spi_transfer_t *transfer, uint16_t CR1_state)
+{
+	if (CR1_state & SPI_CR1_BIDIMODE_Msk)
+	{
+		if (CR1_state & SPI_CR1_BIDIOE_Msk)
+		{
+			return ((transfer->tx_buffer != NULL) ? spi_transfer_bidir_transmit : NULL);
+		}
+		return ((transfer->rx_buffer != NULL) ? spi_transfer_bidir_receive : NULL);
+	}
+	if (CR1_state & SPI_CR1_RXONLY_Msk)
+	{
+		return ((transfer->rx_buffer != NULL) ? spi_transfer_full_duplex_rxonly : NULL);
+	}
+	if (transfer->tx_buffer == NULL)
+	{
+		return (NULL);
+	}
+	if (CR1_state & SPI_CR1_MSTR_Msk)
+	{
+		if (transfer->data_format == SPI_DATA_8BIT_PACKED)
+		{
+			return (spi_transfer_full_duplex_master_packed);
+		}
+		if (transfer->rx_buffer == NULL)
+		{
+			return (spi_transfer_full_duplex_master_txonly);
+		}
+		return (spi_transfer_full_duplex_master);
+	}
+	return ((transfer->rx_buffer != NULL) ? spi_transfer_full_duplex_slave : NULL);
+}
+
+/******************************************************************************
+* Function: spi_transfer_bidir_transmit()
+*//**
+* \b Description:
+*
+*	A static function selected by spi_kernel_select when the single
+*	data line is being used to send information
+*
+* PRE-CONDITION: (Soft assertion) The length of the data buffer is non-NULL.
+* 					Failure of this check simply ends the function
+*
+* POST-CONDITION: Transmits the data in tx_buffer to the selected slave
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called automatically by spi_transfer when BIDIMODE == 1 && BIDIOE != 0
+*
+* @see spi_kernel_select
+* @see spi_transfer_bidir_receive
+* @see spi_transfer_bidir_it
+* @see spi_transfer_bidir_transmit_it
+* @see spi_transfer_bidir_receive_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_bidir_transmit(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state;
+	spi->DR = *transfer->tx_buffer;
+	transfer->tx_buffer++;
+	transfer->tx_length--;
+	while(transfer->tx_length > 0)
+	{
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_TXE_Msk) == 0);
+
+		spi->DR = *transfer->tx_buffer;
+		transfer->tx_buffer++;
+		transfer->tx_length--;
+	}
+	do
+	{
+		SR_state = spi->SR;
+	} while((SR_state & SPI_SR_TXE_Msk) == 0);
+
+	do
+	{
+		SR_state = spi->SR;
+	} while((SR_state & SPI_SR_BSY_Msk) != 0);
+}
+
+/******************************************************************************
+* Function: spi_transfer_bidir_receive()
+*//**
+* \b Description:
+*
+*	A static function selected by spi_kernel_select when the single
+*	data line is being used to receive information
+*
+* PRE-CONDITION: (Soft assertion) The length of the data buffer is non-NULL.
+* 					Failure of this check simply skips the function
+*
+* POST-CONDITION: Places received spi data in the rx_buffer
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called automatically by spi_transfer when BIDIMODE == 1 && BIDIOE == 0
+*
+* @see spi_kernel_select
+* @see spi_transfer_bidir_transmit
+* @see spi_transfer_bidir_it
+* @see spi_transfer_bidir_transmit_it
+* @see spi_transfer_bidir_receive_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_bidir_receive(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state;
+	while(transfer->rx_length > 0)
+	{
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_RXNE_Msk) == 0);
+
+		*transfer->rx_buffer = spi->DR;
+		transfer->rx_buffer++;
+		transfer->rx_length--;
+	}
+}
+
+/******************************************************************************
+* Function: spi_transfer_full_duplex_rxonly()
+*//**
+* \b Description:
+*
+*	A static function called automatically by spi_transfer when only the MISO line
+*	is being used to receive data
+*
+* PRE-CONDITION: (Soft assertion) The address and length of the data buffer are non-NULL.
+* 					Failure of this check simply results in a meaningless return
+*
+* POST-CONDITION: The received data is placed in rx_buffer
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called automatically by spi_transfer when RX_ONLY == 1
+*
+* @see spi_transfer
+* @see spi_kernel_select
+*
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_full_duplex_rxonly(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	if (transfer->rx_buffer == NULL)
+	{
+		return;
+	}
+	uint16_t SR_state;
+	while(transfer->rx_length > 0)
+	{
+		do
+		{
+			SR_state = spi->SR;
+		}while((SR_state & SPI_SR_RXNE_Msk) == 0);
+		*transfer->rx_buffer = spi->DR;
+		transfer->rx_buffer++;
+		transfer->rx_length--;
+	}
+	do
+	{
+		SR_state = spi->SR;
+	} while((SR_state & SPI_SR_BSY) != 0);
+}
+
+/******************************************************************************
+* Function: spi_transfer_full_duplex_master()
+*//**
+* \b Description:
+*
+*	A static function selected by spi_kernel_select when the spi
+*	is configured as a master with two data lines.
+*
+*	The status register is read once per pass and both flags are serviced from
+*	it: a received frame is collected first, then the next frame is written as
+*	soon as TXE allows, so that one frame is always waiting behind the one being
+*	shifted and SCK runs without gaps between frames. At most two frames are in
+*	flight, so nothing is written that could overrun an uncollected one.
+*
+* PRE-CONDITION: The tx_buffer is non-NULL and of non-zero length
+* PRE-CONDITION: The rx_buffer is non-NULL and of non-zero length
+* PRE-CONDITION: Nothing holds the cpu off the loop for longer than a frame, or
+* 					the frame behind an uncollected one overruns it
+*
+* POST-CONDITION: All data in the tx_buffer has been sent to the selected slave
+* POST-CONDITION: All received data has been placed in the rx_buffer
+* POST-CONDITION: rx_length frames have been clocked. A tx_buffer shorter than that is
+* 					padded with SPI_DUMMY_FRAME, so a command can be followed by a read
+* 					without filling a transmit buffer of dummies.
+* POST-CONDITION: With CRCEN set, a CRC frame has followed the data and SR.CRCERR
+* 					reports whether the received one matched
+* POST-CONDITION: The flags read in the loop are latched for spi_collect_errors, as the
+* 					loop's own DR and SR reads clear an overrun
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called automatically by spi_transfer when no other special transfer modes are valid
+*
+* @see spi_transfer
+* @see spi_kernel_select
+* @see spi_transfer_full_duplex_slave
+*
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_full_duplex_master(spi_transfer_t *transfer)
+{
+	assert(transfer->tx_buffer != NULL && transfer->tx_length != 0);
+	assert(transfer->rx_buffer != NULL && transfer->rx_length != 0);
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t crc_enabled = spi->CR1 & SPI_CR1_CRCEN_Msk;
+	uint16_t *tx = transfer->tx_buffer;
+	uint16_t *rx = transfer->rx_buffer;
+	uint32_t tx_left = transfer->tx_length;
+	uint32_t to_send = transfer->rx_length;
+	uint32_t to_receive = transfer->rx_length;
+	uint16_t SR_state;
+	uint16_t SR_seen = 0;
+
+	/* Counts are kept in locals as every DR access would otherwise force them to be reloaded */
+	while (to_receive > 0)
+	{
+		SR_state = spi->SR;
+		SR_seen |= SR_state;
+		if (SR_state & SPI_SR_RXNE_Msk)
+		{
+			*rx = spi->DR;
+			rx++;
+			to_receive--;
+		}
+		if ((SR_state & SPI_SR_TXE_Msk) && to_send > 0 && (to_receive - to_send) < 2)
+		{
+			if (tx_left > 0)
+			{
+				spi->DR = *tx;
+				tx++;
+				tx_left--;
+			}
+			else
+			{
+				spi->DR = SPI_DUMMY_FRAME;
+			}
+			to_send--;
+			if (crc_enabled && to_send == 0)
+			{
+				spi->CR1 |= SPI_CR1_CRCNEXT_Msk;
+			}
+		}
+	}
+	spi_handles[transfer->channel].SR_latched |= SR_seen;
+
+	if (crc_enabled)
+	{
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_RXNE_Msk) == 0);
+
+		(void)spi->DR;
+	}
+
+	do
+	{
+		SR_state = spi->SR;
+	} while((SR_state & SPI_SR_TXE_Msk) == 0);
+
+	do
+	{
+		SR_state = spi->SR;
+	} while((SR_state & SPI_SR_BSY_Msk) != 0);
+
+	transfer->tx_buffer = tx;
+	transfer->tx_length = tx_left;
+	transfer->rx_buffer = rx;
+	transfer->rx_length = 0;
+}
+
+/******************************************************************************
+* Function: spi_transfer_full_duplex_master_txonly()
+*//**
+* \b Description:
+*
+*	A static function selected by spi_kernel_select when the spi
+*	is configured as a master with two data lines but no rx_buffer was supplied.
+*	The transmit register is reloaded as soon as TXE is set and the data shifted in
+*	on MISO is thrown away, so long write-only bursts (display pixels, shift register
+*	chains) run without waiting on RXNE between frames.
+*
+* PRE-CONDITION: The tx_buffer is non-NULL and of non-zero length
+*
+* POST-CONDITION: All data in the tx_buffer has been sent to the selected slave
+* POST-CONDITION: The overrun flag raised by the discarded data has been cleared
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Selected by spi_kernel_select for a master when rx_buffer == NULL
+*
+* @see spi_transfer
+* @see spi_kernel_select
+* @see spi_transfer_full_duplex_master
+*
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_full_duplex_master_txonly(spi_transfer_t *transfer)
+{
+	assert(transfer->tx_buffer != NULL && transfer->tx_length != 0);
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state;
+	while(transfer->tx_length > 0)
+	{
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_TXE_Msk) == 0);
+
+		spi->DR = *transfer->tx_buffer;
+		transfer->tx_buffer++;
+		transfer->tx_length--;
+	}
+
+	do
+	{
+		SR_state = spi->SR;
+	} while((SR_state & SPI_SR_TXE_Msk) == 0);
+
+	do
+	{
+		SR_state = spi->SR;
+	} while((SR_state & SPI_SR_BSY_Msk) != 0);
+
+	/* Reading DR then SR clears the overrun left behind by the ignored frames */
+	(void)spi->DR;
+	(void)spi->SR;
+}
+
+/******************************************************************************
+* Function: spi_transfer_full_duplex_slave()
+*//**
+* \b Description:
+*
+*	A static function selected by spi_kernel_select when the spi
+*	is configured as a slave with two data lines.
+*
+* PRE-CONDITION: The tx_buffer is non-NULL and of non-zero length
+* PRE-CONDITION: The rx_buffer is non-NULL and of non-zero length
+*
+* POST-CONDITION: All data in the tx_buffer has been sent to the master
+* POST-CONDITION: All received data has been placed in the rx_buffer
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called automatically by spi_transfer when no other special transfer modes are valid
+*
+* @see spi_transfer
+* @see spi_kernel_select
+* @see spi_transfer_full_duplex_master
+*
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_full_duplex_slave(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state;
+	do
+			{
+				SR_state = spi->SR;
+			} while((SR_state & SPI_SR_RXNE_Msk) == 0);
+
+			*transfer->rx_buffer = spi->DR;
+			transfer->rx_buffer++;
+			transfer->rx_length--;
+
+			while(transfer->tx_length > 1)
+			{
+				do
+				{
+					SR_state = spi->SR;
+				} while((SR_state & SPI_SR_RXNE_Msk) == 0);
+
+				*transfer->rx_buffer = spi->DR;
+				transfer->rx_buffer++;
+				transfer->rx_length--;
+				do
+				{
+					SR_state = spi->SR;
+				} while((SR_state & SPI_SR_TXE_Msk) == 0);
+
+				spi->DR = *transfer->tx_buffer;
+				transfer->tx_buffer++;
+				transfer->tx_length--;
+			}
+
+			do
+			{
+				SR_state = spi->SR;
+			} while((SR_state & SPI_SR_TXE_Msk) == 0);
+
+			spi->DR = *transfer->tx_buffer;
+			transfer->tx_buffer++;
+			transfer->tx_length--;
+
+			do
+			{
+				SR_state = spi->SR;
+			}while((SR_state & SPI_SR_RXNE_Msk) == 0);
+
+			do
+			{
+				SR_state = spi->SR;
+			}while((SR_state & SPI_SR_BSY_Msk) != 0);
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_bidir_transmit_callback()
+*//**
+* \b Description:
+*
+*	A static callback mapped to the irq handler by spi_transfer_bidir_it and
+*	called by the irq handler. Handles the transmission of a single
+*	data unit or ends the communication and releases the slave.
+*
+* PRE-CONDITION: The tx_buffer is of non-zero length
+*
+* POST-CONDITION: A single data unit has been sent to the target
+* OR
+* POST-CONDITION: The communication has been ended and the slave released
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Registered when appropriate by spi_transfer_it_bidir and called
+*	by the spi_irq_handler
+*
+* @see spi_transfer_it
+* @see spi_transfer_it_bidir
+* @see spi_irq_handler
+* @see spi_transfer_it_full_duplex
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_it_bidir_transmit_callback(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state = spi->SR;
+	spi_handles[transfer->channel].SR_latched |= SR_state;
+	if (transfer->tx_length > 0 && (SR_state & SPI_SR_TXE_Msk))
+	{
+		spi->DR = *transfer->tx_buffer;
+		transfer->tx_buffer++;
+		transfer->tx_length--;
+	}
+	else
+	{
+		spi_transfer_it_end(transfer);
+	}
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_bidir_receive_callback()
+*//**
+* \b Description:
+*
+*	A static callback mapped to the irq handler by spi_transfer_bidir_it and
+*	called by the irq handler. Handles the reception of a single
+*	data unit or ends the communication and releases the slave.
+*
+* PRE-CONDITION: The rx_buffer is of non-zero length
+*
+* POST-CONDITION: A single data unit has been received from the target
+* OR
+* POST-CONDITION: The communication has been ended and the slave released
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Registered when appropriate by spi_transfer_it_bidir and called
+*	by the spi_irq_handler
+*
+* @see spi_transfer_it
+* @see spi_transfer_it_bidir
+* @see spi_transfer_it_full_duplex
+* @see spi_irq_handler
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_it_bidir_receive_callback(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state = spi->SR;
+	spi_handles[transfer->channel].SR_latched |= SR_state;
+	if (transfer->rx_length > 0 && (SR_state & SPI_SR_RXNE_Msk))
+	{
+		*transfer->rx_buffer = spi->DR;
+		transfer->rx_buffer++;
+		transfer->rx_length--;
+	}
+	else
+	{
+		spi_transfer_it_end(transfer);
+	}
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_bidir()
+*//**
+* \b Description:
+*
+*	Maps the appropriate bidir callback for the queued transfer.
+*
+* PRE-CONDITION: (Soft Assert) The tx_buffer is non-NULL and of non-zero length
+* OR
+* PRE-CONDITION: (Soft Assert) The rx_buffer is non-NULL and of non-zero length
+*
+* POST-CONDITION: The correct callback function has been mapped to the file-scope
+* 					callback array
+* POST-CONDITION: The correct buffer interrupt (RXNEIE or TXEIE) has been enabled
+* POST-CONDITION: The SPI Enable (SPE) has been switched on
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer_it_start when BIDIMODE == 1
+*
+*
+* @see spi_transfer_it
+* @see spi_transfer_it_bidir_transmit_callback
+* @see spi_transfer_it_bidir_receive_callback
+* @see spi_transfer_it_full_duplex
+*
+* @see spi_irq_handler
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_it_bidir(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t CR1_state = spi->CR1;
+	if ((CR1_state & SPI_CR1_BIDIOE_Msk) != 0)
+	{
+		if (transfer->tx_buffer == NULL || transfer->tx_length == 0)
+		{
+			return;
+		}
+
+		spi_handles[transfer->channel].callback = spi_transfer_it_bidir_transmit_callback;
+		spi->CR2 |= SPI_CR2_TXEIE_Msk;
+	}
+	else
+	{
+		if (transfer->rx_buffer == NULL || transfer->rx_length == 0)
+		{
+			return;
+		}
+		spi_handles[transfer->channel].callback = spi_transfer_it_bidir_receive_callback;
+		spi->CR2 |= SPI_CR2_RXNEIE_Msk;
+	}
+
+	spi->CR1 |= SPI_CR1_SPE_Msk;
+
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_full_duplex_rxonly_callback()
+*//**
+* \b Description:
+*
+*	A callback function called by the irq handler which manages the reception
+*	of a single data unit when the spi has two data lines.
+*
+* PRE-CONDITION: (Soft Assert) The rx_buffer is of non-zero length
+*
+* POST-CONDITION: A single data unit has been received
+* OR
+* POST-CONDITION: The communication has been shut down and the slave released
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by the irq_handler if it's mapped
+*
+*
+* @see spi_transfer_it
+* @see spi_transfer_it_bidir
+* @see spi_transfer_it_full_duplex
+* @see spi_irq_handler
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_it_full_duplex_rxonly_callback(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state = spi->SR;
+	spi_handles[transfer->channel].SR_latched |= SR_state;
+	if (transfer->rx_length > 0 && (SR_state & SPI_SR_RXNE_Msk))
+	{
+		*transfer->rx_buffer = spi->DR;
+		transfer->rx_buffer++;
+		transfer->rx_length--;
+	}
+	else
+	{
+		spi_transfer_it_end(transfer);
+	}
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_full_duplex_rxonly()
+*//**
+* \b Description:
+*
+*	Registers the rxonly callback for the queued transfer.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The rxonly callback has been mapped to the right spi device
+* POST-CONDITION: The RXNEIE interrupt has been enabled
+* OR
+* POST-CONDITION: Nothing has been started as there is no rx buffer, as on the polled path
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer_it_start when RXONLY == 1
+*
+*
+* @see spi_transfer_it
+* @see spi_transfer_it_bidir
+* @see spi_transfer_it_full_duplex
+* @see spi_irq_handler
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_it_full_duplex_rxonly(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	if (transfer->rx_buffer == NULL || transfer->rx_length == 0)
+	{
+		return;
+	}
+	spi_handles[transfer->channel].callback = spi_transfer_it_full_duplex_rxonly_callback;
+	spi->CR2 |= SPI_CR2_RXNEIE_Msk;
+	spi->CR1 |= SPI_CR1_SPE_Msk;
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_full_duplex_callback()
+*//**
+* \b Description:
+*
+*	A callback function called by the irq handler which manages the reception
+*	and transmission of a single data unit when the spi has two data lines. Only
+*	RXNE drives the transfer: the frame just received is stored (or dropped when
+*	there is no rx_buffer) and the next one written, so a single frame is ever
+*	in flight and the receiver cannot be overrun. Once tx_buffer runs out dummy
+*	frames are written until rx_length frames have been clocked, as spi_transfer
+*	pads.
+*
+*	Once an urgent transfer is due no further frame is written. The transfer is
+*	paused with its buffers and lengths where they stand. As at the end of a
+*	transfer, TXE and then BSY are waited for before the spi is disabled, so
+*	the last clock edge is out before the slave is released and the urgent
+*	transfer is started.
+*
+* PRE-CONDITION: spi_transfer_it_full_duplex has written the first frame
+*
+* POST-CONDITION: A single data unit has been received and another sent
+* OR
+* POST-CONDITION: The communication has been shut down, its errors collected and the slave released
+* OR
+* POST-CONDITION: The transfer has been paused for an urgent one and the slave released
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by the irq_handler if it's mapped
+*
+* @see spi_desc_submit_urgent
+* @see spi_transfer_it
+* @see spi_transfer_it_end
+* @see spi_transfer_it_full_duplex_send
+* @see spi_irq_handler
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_it_full_duplex_callback(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state = spi->SR;
+	spi_handles[transfer->channel].SR_latched |= SR_state;
+	if ((SR_state & SPI_SR_RXNE_Msk) == 0)
+	{
+		return;
+	}
+
+	uint16_t frame = spi->DR;
+	if (transfer->rx_buffer != NULL)
+	{
+		*transfer->rx_buffer = frame;
+		transfer->rx_buffer++;
+	}
+	transfer->rx_length--;
+
+	if (transfer->rx_length == 0)
+	{
+		spi_transfer_it_end(transfer);
+	}
+	else if (spi_urgent_due(transfer))
+	{
+		spi->CR2 &= ~(SPI_CR2_RXNEIE_Msk);
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_TXE_Msk) == 0);
+
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_BSY_Msk) != 0);
+		spi->CR1 &= ~(SPI_CR1_SPE_Msk);
+		spi_release_slave(transfer);
+		spi_urgent_start(transfer->channel);
+	}
+	else
+	{
+		spi_transfer_it_full_duplex_send(transfer);
+	}
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_full_duplex()
+*//**
+* \b Description:
+*
+*	Maps the full duplex callback, enables the spi and writes the first frame.
+*	Without an rx_buffer rx_length is set to tx_length so that it counts the
+*	frames to clock, otherwise rx_length frames are clocked and tx_buffer is
+*	padded with dummy frames, as the polled kernel does. RXNEIE is enabled last,
+*	once the first frame is in DR. A paused transfer restarts from its remaining
+*	lengths.
+*
+* PRE-CONDITION: The tx_buffer is non-NULL, otherwise nothing is started
+*
+* POST-CONDITION: The first frame has been written and the reception (RXNEIE) interrupt enabled
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer_it_start when full duplex configuration is selected
+*
+* @see spi_transfer_it
+* @see spi_transfer_it_full_duplex_callback
+* @see spi_transfer_it_packed
+* @see spi_irq_handler
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_it_full_duplex(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	if (transfer->data_format == SPI_DATA_8BIT_PACKED)
+	{
+		spi_transfer_it_packed(transfer);
+		return;
+	}
+	if (transfer->tx_buffer == NULL)
+	{
+		return;
+	}
+	if (transfer->rx_buffer == NULL)
+	{
+		transfer->rx_length = transfer->tx_length;
+	}
+	if (transfer->rx_length == 0)
+	{
+		return;
+	}
+
+	spi_handles[transfer->channel].callback = spi_transfer_it_full_duplex_callback;
+	spi->CR1 |= SPI_CR1_SPE_Msk;
+	spi_transfer_it_full_duplex_send(transfer);
+	spi->CR2 |= SPI_CR2_RXNEIE_Msk;
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_full_duplex_send()
+*//**
+* \b Description:
+*
+*	Writes the next frame of tx_buffer, or a dummy frame once it has run out.
+*
+* PRE-CONDITION: The transmit buffer is empty (TXE == 1)
+*
+* POST-CONDITION: One frame has been written to DR
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer_it_full_duplex and its callback
+*
+* @see spi_transfer_it_full_duplex_callback
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_it_full_duplex_send(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	if (transfer->tx_length > 0)
+	{
+		spi->DR = *transfer->tx_buffer;
+		transfer->tx_buffer++;
+		transfer->tx_length--;
+	}
+	else
+	{
+		spi->DR = SPI_DUMMY_FRAME;
+	}
+}
+
+/******************************************************************************
+* Function: spi_select_slave()
+*//**
+* \b Description:
+*
+*	Static function used to select a slave (whether it is active high or low) from
+*	within transfer functions. A GPIO select is followed by the device's setup
+*	delay. A hardware select hands NSS to the spi (SSOE), which drives it low
+*	once SPE is set. Nothing is done while spi_bus_acquire holds the slave.
+*
+* PRE-CONDITION: The GPIO pin for controlling the slave has been correctly configured
+*
+* POST-CONDITION: The GPIO output is at the correct level to select the slave
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer and spi_transfer_it in master mode before transmission
+*	begins
+*
+*
+* @see spi_release_slave
+* @see spi_transfer
+* @see spi_transfer_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_select_slave(const spi_transfer_t *transfer)
+{
+	spi_handle_t *handle = &spi_handles[transfer->channel];
+	if (transfer->ss_polarity == SS_MANUAL || (handle->cs_held && transfer->slave_pin == handle->cs_held_pin))
+	{
+		return;
+	}
+
+	SPI_TRACE(TRACE_CS_ASSERT, transfer->channel, 0);
+	if (transfer->ss_polarity == SS_HARDWARE)
+	{
+		handle->regs->CR2 |= SPI_CR2_SSOE_Msk;
+		handle->regs->CR1 &= ~(SPI_CR1_SSM_Msk);
+		return;
+	}
+
+	if (transfer->ss_polarity == SS_ACTIVE_LOW)
+	{
+		gpio_pin_write(transfer->slave_pin, GPIO_PIN_LOW);
+	}
+	else
+	{
+		gpio_pin_write(transfer->slave_pin, GPIO_PIN_HIGH);
+	}
+	spi_delay_cycles(transfer->cs_setup_cycles);
+}
+
+/******************************************************************************
+* Function: spi_release_slave()
+*//**
+* \b Description:
+*
+*	Static function used to release a slave (whether it is active high or low) from
+*	within transfer functions. A GPIO select is released after the device's hold
+*	delay. A hardware select is released by disabling the spi, after which the
+*	channel's configured SSM, SSI and SSOE are put back. Nothing is done while
+*	spi_bus_acquire holds the slave.
+*
+* PRE-CONDITION: The GPIO pin for controlling the slave has been correctly configured
+*
+* POST-CONDITION: The GPIO output is at the correct level to release the slave
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer and spi_transfer_it and callbacks in master mode
+*
+*
+* @see spi_select_slave
+* @see spi_transfer
+* @see spi_transfer_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_release_slave(const spi_transfer_t *transfer)
+{
+	spi_handle_t *handle = &spi_handles[transfer->channel];
+	if (transfer->ss_polarity == SS_MANUAL || (handle->cs_held && transfer->slave_pin == handle->cs_held_pin))
+	{
+		return;
+	}
+
+	if (transfer->ss_polarity == SS_HARDWARE)
+	{
+		handle->regs->CR1 &= ~(SPI_CR1_SPE_Msk);
+		handle->regs->CR2 = (handle->regs->CR2 & ~(SPI_CR2_SSOE_Msk)) | handle->CR2_ss_bits;
+		handle->regs->CR1 = (handle->regs->CR1 & ~(SPI_CR1_SSM_Msk | SPI_CR1_SSI_Msk)) | handle->CR1_ss_bits;
+	}
+	else
+	{
+		spi_delay_cycles(transfer->cs_hold_cycles);
+		if (transfer->ss_polarity == SS_ACTIVE_LOW)
+		{
+			gpio_pin_write(transfer->slave_pin, GPIO_PIN_HIGH);
+		}
+		else
+		{
+			gpio_pin_write(transfer->slave_pin, GPIO_PIN_LOW);
+		}
+	}
+	SPI_TRACE(TRACE_CS_RELEASE, transfer->channel, 0);
+}
+
+/******************************************************************************
+* Function: spi_delay_cycles()
+*//**
+* \b Description:
+*
+*	Static function which busy waits for a number of core clock cycles on the DWT
+*	cycle counter. Used for the slave select setup and hold times.
+*
+* PRE-CONDITION: The DWT cycle counter has been started by spi_init
+*
+* POST-CONDITION: At least cycles core clock cycles have passed
+*
+* @param		cycles the number of core clock cycles to wait, 0 returns at once
+* @return 		void
+*
+* \b Example:
+*	Called by spi_select_slave and spi_release_slave
+*
+* @see spi_select_slave
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_delay_cycles(uint32_t cycles)
+{
+	if (cycles == 0)
+	{
+		return;
+	}
+	uint32_t start = DWT->CYCCNT;
+	while ((DWT->CYCCNT - start) < cycles);
+}
+
+/******************************************************************************
+* Function: spi_configure_clock()
+*//**
+* \b Description:
+*
+*	Static function used to configure the clock phase and polarity to be used
+*	during the spi communication
+*
+* PRE-CONDITION: the clock_polarity member of the transfer structure is valid
+* PRE-CONDITION: the clock_phase member of the transfer structure is valid
+*
+* POST-CONDITION: The CR1 registers now contain the desired clock configuration
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer and spi_transfer_it and callbacks
+*
+*
+* @see spi_configure_data_frame
+* @see spi_transfer
+* @see spi_transfer_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_configure_clock(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	if (transfer->clock_polarity == ACTIVE_HIGH)
+	{
+		spi->CR1 &= ~(SPI_CR1_CPOL_Msk);
+	}
+	else if (transfer->clock_polarity == ACTIVE_LOW)
+
+	{
+		spi->CR1 |= (SPI_CR1_CPOL_Msk);
+	}
+
+	if (transfer->clock_phase == FIRST_EDGE)
+	{
+		spi->CR1 &= ~(SPI_CR1_CPHA_Msk);
+	}
+	else if (transfer->clock_phase == SECOND_EDGE)
+	{
+		spi->CR1 |= (SPI_CR1_CPHA_Msk);
+	}
+}
+
+/******************************************************************************
+* Function: spi_configure_data_frame()
+*//**
+* \b Description:
+*
+*	Static function used to configure the the data size and bit format to be used
+*	during the current transfer
+*
+* PRE-CONDITION: the data_format member of the transfer structure is valid
+* PRE-CONDITION: the bit_format member of the transfer structure is valid
+*
+* POST-CONDITION: The CR1 registers now contain the desired data format configuration
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer and spi_transfer_it and callbacks
+*
+*
+* @see spi_configure_clock
+* @see spi_transfer
+* @see spi_transfer_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_configure_data_frame(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	if (transfer->data_format == SPI_DATA_8BIT)
+	{
+		spi->CR1 &= ~(SPI_CR1_DFF_Msk);
+	}
+	else if (transfer->data_format == SPI_DATA_16BIT || transfer->data_format == SPI_DATA_8BIT_PACKED)
+	{
+		spi->CR1 |= SPI_CR1_DFF_Msk;
+	}
+
+	if (transfer->bit_format == MSB_FIRST)
+	{
+		spi->CR1 &= ~(SPI_CR1_LSBFIRST_Msk);
+	}
+	else if (transfer->bit_format == LSB_FIRST)
+	{
+		spi->CR1 |= SPI_CR1_LSBFIRST_Msk;
+	}
+}
+
+/******************************************************************************
+* Function: spi_configure_baud_rate()
+*//**
+* \b Description:
+*
+*	Static function used to pick the prescaler for the current transfer. A transfer
+*	with a max_clock_hz gets the fastest prescaler whose SCK does not exceed it on
+*	the channel's bus clock (the slowest, PCLK/256, if none do); any other transfer
+*	gets the baud rate from the channel's config. A rate monitor attached to the
+*	transfer then slows either choice by the steps it has currently backed off.
+*	BR is only written when it changes, so back to back transfers to the same
+*	device cost a single register read.
+*
+* PRE-CONDITION: The spi is disabled (SPE == 0)
+* PRE-CONDITION: SPI_APB1_CLOCK_HZ and SPI_APB2_CLOCK_HZ match the clock tree
+*
+* POST-CONDITION: The CR1 register now contains the prescaler for this transfer
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer and spi_transfer_it
+*
+*
+* @see spi_configure_clock
+* @see spi_transfer
+* @see spi_transfer_it
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_configure_baud_rate(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint32_t baud_rate = spi_baud_rate_select(transfer);
+
+	uint16_t CR1_state = spi->CR1;
+	if (((CR1_state & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos) != baud_rate)
+	{
+		spi->CR1 = (CR1_state & ~(SPI_CR1_BR_Msk)) | (baud_rate << SPI_CR1_BR_Pos);
+	}
+}
+
+/******************************************************************************
+* Function: spi_baud_rate_select()
+*//**
+* \b Description:
+*
+*	Static function which works out the prescaler a transfer runs at, as described
+*	for spi_configure_baud_rate, without touching the hardware.
+*
+* PRE-CONDITION: SPI_APB1_CLOCK_HZ and SPI_APB2_CLOCK_HZ match the clock tree
+*
+* POST-CONDITION: None
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		uint32_t the BR field value for the transfer
+*
+* \b Example:
+*	Called by spi_configure_baud_rate and spi_transfer_prepare
+*
+*
+* @see spi_configure_baud_rate
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t spi_baud_rate_select(spi_transfer_t *transfer)
+{
+	uint32_t baud_rate = spi_handles[transfer->channel].default_baud_rate;
+
+	if (transfer->max_clock_hz != 0)
+	{
+		baud_rate = PCLK_DIV_2;
+		while (baud_rate < PCLK_DIV_256
+				&& (spi_handles[transfer->channel].pclk_hz >> (baud_rate + 1)) > transfer->max_clock_hz)
+		{
+			baud_rate++;
+		}
+	}
+
+	if (transfer->rate_monitor != NULL)
+	{
+		baud_rate += transfer->rate_monitor->derate;
+		if (baud_rate > PCLK_DIV_256)
+		{
+			baud_rate = PCLK_DIV_256;
+		}
+	}
+	return (baud_rate);
+}
+
+/******************************************************************************
+* Function: spi_configure_crc()
+*//**
+* \b Description:
+*
+*	Static function used to switch the hardware CRC on or off for the current
+*	transfer. Enabling it clears CRCEN first so that both CRC registers start the
+*	transfer from zero.
+*
+* PRE-CONDITION: The spi is disabled (SPE == 0)
+* PRE-CONDITION: The data frame format has already been configured
+*
+* POST-CONDITION: CRCEN matches the crc_enable member of the transfer
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer
+*
+*
+* @see spi_collect_errors
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_configure_crc(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	spi->CR1 &= ~(SPI_CR1_CRCEN_Msk);
+	if (transfer->crc_enable == CRC_ENABLE)
+	{
+		spi->CR1 |= SPI_CR1_CRCEN_Msk;
+	}
+}
+
+/******************************************************************************
+* Function: spi_collect_errors()
+*//**
+* \b Description:
+*
+*	Static function which records the error flags left in the status register by a
+*	blocking transfer and clears them. Flags latched by the interrupt callbacks and
+*	the polled master loops are included, since the DR read that follows their SR
+*	read clears OVR. Overruns are ignored in receive only and bidirectional modes,
+*	where the master keeps clocking until the spi is disabled.
+*
+* PRE-CONDITION: The transfer subroutine has returned
+*
+* POST-CONDITION: The spi_error_t flags of the transfer are available from spi_error_get
+* POST-CONDITION: CRCERR and OVR have been cleared
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @param		CR1_state the control register as sampled at the start of the transfer
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer before the slave is released
+*
+*
+* @see spi_error_get
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_collect_errors(spi_transfer_t *transfer, uint16_t CR1_state)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state = spi->SR | spi_handles[transfer->channel].SR_latched;
+	uint8_t errors = SPI_ERROR_NONE;
+
+	spi_handles[transfer->channel].SR_latched = 0;
+
+	if (SR_state & SPI_SR_CRCERR_Msk)
+	{
+		errors |= SPI_ERROR_CRC;
+		spi->SR &= ~(SPI_SR_CRCERR_Msk);
+	}
+	if (SR_state & SPI_SR_MODF_Msk)
+	{
+		errors |= SPI_ERROR_MODE_FAULT;
+	}
+	if (SR_state & SPI_SR_OVR_Msk)
+	{
+		(void)spi->DR;
+		(void)spi->SR;
+		if ((CR1_state & (SPI_CR1_RXONLY_Msk | SPI_CR1_BIDIMODE_Msk)) == 0)
+		{
+			errors |= SPI_ERROR_OVERRUN;
+		}
+	}
+	if (errors != SPI_ERROR_NONE)
+	{
+		SPI_TRACE(TRACE_ERROR, transfer->channel, errors);
+	}
+	spi_handles[transfer->channel].errors = errors;
+}
+
+/******************************************************************************
+* Function: spi_rate_monitor_update()
+*//**
+* \b Description:
+*
+*	Static function which records the outcome of a transfer in the device's rate
+*	monitor and steps its clock down or back up. The window is a shift register
+*	with one bit per transfer, so the error count always covers exactly the last
+*	window transfers. The history is cleared on every step so that the new rate is
+*	judged on its own transfers only.
+*
+* PRE-CONDITION: spi_rate_monitor_init() has been called on the monitor
+*
+* POST-CONDITION: derate reflects the error rate seen at the current clock
+*
+* @param		monitor a pointer to the device's rate monitor
+* @param		errors the spi_error_t flags of the transfer
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer after the errors have been collected
+*
+*
+* @see spi_rate_monitor_init
+* @see spi_configure_baud_rate
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_rate_monitor_update(spi_rate_monitor_t *monitor, uint8_t errors)
+{
+	uint32_t window_mask = (monitor->window >= 32) ? 0xFFFFFFFFUL : ((1UL << monitor->window) - 1);
+
+	monitor->history = (monitor->history << 1) | (errors != SPI_ERROR_NONE);
+	if (errors == SPI_ERROR_NONE)
+	{
+		if (monitor->derate > 0 && ++monitor->clean_run >= monitor->probe_after)
+		{
+			monitor->derate--;
+			monitor->history = 0;
+			monitor->clean_run = 0;
+		}
+		return;
+	}
+
+	monitor->error_count++;
+	monitor->clean_run = 0;
+
+	uint32_t recent = monitor->history & window_mask;
+	uint8_t recent_errors = 0;
+	while (recent != 0)
+	{
+		recent &= recent - 1;
+		recent_errors++;
+	}
+
+	if (recent_errors >= monitor->error_threshold && monitor->derate < PCLK_DIV_256)
+	{
+		monitor->derate++;
+		monitor->history = 0;
+	}
+}
+
+/******************************************************************************
+* Function: spi_transfer_begin()
+*//**
+* \b Description:
+*
+*	Static function which prepares a channel for a blocking transfer: applies the
+*	transfer's clock, frame, prescaler and CRC settings, selects the slave when
+*	acting as master and enables the spi.
+*
+* PRE-CONDITION: The spi is disabled (SPE == 0)
+*
+* POST-CONDITION: The spi is enabled and the slave selected
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		uint16_t CR1 as configured for the transfer, before SPE was set
+*
+* \b Example:
+*	Called by spi_transfer and spi_transfer_multi
+*
+*
+* @see spi_transfer_end
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t spi_transfer_begin(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	spi_configure_clock(transfer);
+	spi_configure_data_frame(transfer);
+	spi_configure_baud_rate(transfer);
+	spi_configure_crc(transfer);
+	uint16_t CR1_state = spi->CR1;
+	SPI_TRACE(TRACE_CONFIGURE, transfer->channel, CR1_state);
+	SPI_TRACE(TRACE_TRANSFER_START, transfer->channel,
+			(transfer->tx_length > transfer->rx_length) ? transfer->tx_length : transfer->rx_length);
+
+	if (CR1_state & SPI_CR1_MSTR_Msk)
+	{
+		spi_select_slave(transfer);
+	}
+
+	spi->CR1 |= SPI_CR1_SPE_Msk;
+	return (CR1_state);
+}
+
+/******************************************************************************
+* Function: spi_transfer_end()
+*//**
+* \b Description:
+*
+*	Static function which closes a blocking transfer: records its errors (feeding
+*	the rate monitor if there is one), releases the slave and disables the spi.
+*
+* PRE-CONDITION: The last frame of the transfer has been shifted out (BSY == 0)
+*
+* POST-CONDITION: The spi is disabled and the slave released
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @param		CR1_state the value returned by spi_transfer_begin
+* @return 		void
+*
+* \b Example:
+*	Called by spi_transfer and spi_transfer_multi
+*
+*
+* @see spi_transfer_begin
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_end(spi_transfer_t *transfer, uint16_t CR1_state)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	spi_collect_errors(transfer, CR1_state);
+	if (transfer->rate_monitor != NULL)
+	{
+		spi_rate_monitor_update(transfer->rate_monitor, spi_handles[transfer->channel].errors);
+	}
+
+	if (CR1_state & SPI_CR1_MSTR_Msk)
+	{
+		spi_release_slave(transfer);
+	}
+
+	spi->CR1 &= ~(SPI_CR1_SPE_Msk | SPI_CR1_CRCEN_Msk);
+	SPI_TRACE(TRACE_TRANSFER_END, transfer->channel, spi_handles[transfer->channel].errors);
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_end()
+*//**
+* \b Description:
+*
+*	Static function which closes an interrupt driven transfer the way
+*	spi_transfer_end closes a blocking one: the interrupts are masked, the
+*	errors recorded (clearing a latched overrun) and fed to the rate monitor if
+*	there is one, the spi disabled and the slave released before the queue is
+*	told the transfer is complete. Unless the master only receives, TXE and then
+*	BSY are waited for first, as the polled kernels do, so that the last frame
+*	and its final clock edge are out before SPE is cleared.
+*
+* PRE-CONDITION: The last frame of the transfer has been received
+*
+* POST-CONDITION: The spi is disabled, the slave released and the transfer completed
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
+*
+* \b Example:
+*	Called by the interrupt callbacks once their last frame is in
+*
+* @see spi_transfer_end
+* @see spi_queue_complete
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_transfer_it_end(spi_transfer_t *transfer)
+{
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t CR1_state = spi->CR1;
+	uint16_t SR_state;
+	spi->CR2 &= ~(SPI_CR2_TXEIE_Msk | SPI_CR2_RXNEIE_Msk);
+	spi_collect_errors(transfer, CR1_state);
+	if (transfer->rate_monitor != NULL)
+	{
+		spi_rate_monitor_update(transfer->rate_monitor, spi_handles[transfer->channel].errors);
+	}
+
+	if ((CR1_state & SPI_CR1_RXONLY_Msk) == 0
+			&& ((CR1_state & SPI_CR1_BIDIMODE_Msk) == 0 || (CR1_state & SPI_CR1_BIDIOE_Msk)))
+	{
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_TXE_Msk) == 0);
+
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_BSY_Msk) != 0);
+	}
+	spi->CR1 &= ~(SPI_CR1_SPE_Msk);
+	spi_release_slave(transfer);
+	spi_queue_complete(transfer->channel);
+}
+
+/******************************************************************************
+* Function: spi_transfer_it_start()
+*//**
+* \b Description:
+*
+*	Static function which starts an interrupt based transfer from the channel's
+*	queue: applies its settings, selects the slave and maps the correct callback.
+*
+* PRE-CONDITION: The channel is idle
+* PRE-CONDITION: The transfer lives in the channel's queue
+*
+* POST-CONDITION: The buffer interrupts needed by the transfer have been enabled, or
+* 					none were, if the transfer had nothing to do
+*
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		void
 *
 * \b Example:
-*	Called automatically by spi_transfer when BIDIMODE == 1 && BIDIOE != 0
+*	Called by spi_queue_start_next from within spi_irq_handler
 *
-* @see spi_transfer_bidir
-* @see spi_transfer_bidir_receive
-* @see spi_transfer_bidir_it
-* @see spi_transfer_bidir_transmit_it
-* @see spi_transfer_bidir_receive_it
+*
+* @see spi_queue_start_next
+* @see spi_transfer_it_bidir
+* @see spi_transfer_it_full_duplex_rxonly
+* @see spi_transfer_it_full_duplex
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -569,59 +3336,61 @@ static void spi_transfer_bidir(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_bidir_transmit(spi_transfer_t *transfer)
+static void spi_transfer_it_start(spi_transfer_t *transfer)
 {
-	uint16_t SR_state;
-	*SPI_DR[transfer->channel] = *transfer->tx_buffer;
-	transfer->tx_buffer++;
-	transfer->tx_length--;
-	while(transfer->tx_length > 0)
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	spi_configure_clock(transfer);
+	spi_configure_data_frame(transfer);
+	spi_configure_baud_rate(transfer);
+
+	uint16_t CR1_state = spi->CR1;
+	SPI_TRACE(TRACE_CONFIGURE, transfer->channel, CR1_state);
+	SPI_TRACE(TRACE_TRANSFER_START, transfer->channel,
+			(transfer->tx_length > transfer->rx_length) ? transfer->tx_length : transfer->rx_length);
+
+	if (CR1_state & SPI_CR1_MSTR_Msk)
 	{
-		do
-		{
-			SR_state = *SPI_SR[transfer->channel];
-		} while((SR_state & SPI_SR_TXE_Msk) == 0);
+		spi_select_slave(transfer);
+	}
 
-		*SPI_DR[transfer->channel] = *transfer->tx_buffer;
-		transfer->tx_buffer++;
-		transfer->tx_length--;
+	if (CR1_state & SPI_CR1_BIDIMODE_Msk)
+	{
+		spi_transfer_it_bidir(transfer);
 	}
-	do
+	else if (CR1_state & SPI_CR1_RXONLY_Msk)
 	{
-		SR_state = *SPI_SR[transfer->channel];
-	} while((SR_state & SPI_SR_TXE_Msk) == 0);
-
-	do
+		spi_transfer_it_full_duplex_rxonly(transfer);
+	}
+	else
 	{
-		SR_state = *SPI_SR[transfer->channel];
-	} while((SR_state & SPI_SR_BSY_Msk) != 0);
+		spi_transfer_it_full_duplex(transfer);
+	}
 }
 
 /******************************************************************************
-* Function: spi_transfer_bidir_receive()
+* Function: spi_queue_start_next()
 *//**
 * \b Description:
 *
-*	A static function called automatically by spi_transfer_bidir when the single
-*	data line is being used to receive information
+*	Static function which starts the oldest waiting transfer of an idle channel,
+*	taking the transfers queued from an interrupt handler first. The start of
+*	those is stamped for the handler before anything is configured. Transfers
+*	which turn out to have nothing to send or receive are completed on the spot
+*	and the next one is tried.
 *
-* PRE-CONDITION: (Soft assertion) The length of the data buffer is non-NULL.
-* 					Failure of this check simply skips the function
+* PRE-CONDITION: Called from the channel's interrupt with the channel idle
 *
-* POST-CONDITION: Places received spi data in the rx_buffer
+* POST-CONDITION: A transfer is in progress, or the queue holds no waiting transfers
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
+* @param		channel the spi device of interest
 * @return 		void
 *
 * \b Example:
-*	Called automatically by spi_transfer when BIDIMODE == 1 && BIDIOE == 0
+*	Called by spi_irq_handler
 *
-* @see spi_transfer_bidir
-* @see spi_transfer_bidir_transmit
-* @see spi_transfer_bidir_it
-* @see spi_transfer_bidir_transmit_it
-* @see spi_transfer_bidir_receive_it
+*
+* @see spi_queue_complete
+* @see spi_irq_handler
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -629,46 +3398,77 @@ static void spi_transfer_bidir_transmit(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_bidir_receive(spi_transfer_t *transfer)
+static void spi_queue_start_next(spi_channel_t channel)
 {
-	uint16_t SR_state;
-	while(transfer->rx_length > 0)
+	SPI_TypeDef *spi = spi_handles[channel].regs;
+	spi_queue_t *queue = &spi_queues[channel];
+
+	while (queue->isr_done != queue->isr_head || queue->done != queue->head)
 	{
-		do
+		__DMB();
+		spi_transfer_t *transfer;
+		if (queue->isr_done != queue->isr_head)
 		{
-			SR_state = *SPI_SR[transfer->channel];
-		} while((SR_state & SPI_SR_RXNE_Msk) == 0);
+			uint32_t index = queue->isr_done & (SPI_ISR_QUEUE_LENGTH - 1U);
+			spi_start_stamp_t *stamp = queue->isr_stamps[index];
+			if (stamp != NULL)
+			{
+				stamp->cycles = DWT->CYCCNT;
+				__DMB();
+				stamp->started = 1;
+			}
+			queue->isr_active = 1;
+			transfer = &queue->isr_slots[index];
+		}
+		else
+		{
+			spi_desc_slot_t *slot = queue->slots[queue->done & (SPI_QUEUE_LENGTH - 1U)];
+			if (slot->request != NULL)
+			{
+				slot->state = *slot->request;
+			}
+			transfer = &slot->state;
+		}
+		spi_transfer_it_start(transfer);
 
-		*transfer->rx_buffer = *SPI_DR[transfer->channel];
-		transfer->rx_buffer++;
-		transfer->rx_length--;
+		if ((spi->CR2 & (SPI_CR2_TXEIE_Msk | SPI_CR2_RXNEIE_Msk)) != 0)
+		{
+			queue->active = 1;
+			return;
+		}
+
+		if (spi->CR1 & SPI_CR1_MSTR_Msk)
+		{
+			spi_release_slave(transfer);
+		}
+		spi_queue_complete(channel);
 	}
 }
 
 /******************************************************************************
-* Function: spi_transfer_full_duplex_rxonly()
+* Function: spi_queue_complete()
 *//**
 * \b Description:
 *
-*	A static function called automatically by spi_transfer when only the MISO line
-*	is being used to receive data
+*	Static function which hands the transfer in progress over to the completed
+*	part of the channel's queue. The transfer's final state is written before the
+*	completion is published. A transfer queued from an interrupt handler is
+*	simply dropped from its ring.
 *
-* PRE-CONDITION: (Soft assertion) The address and length of the data buffer are non-NULL.
-* 					Failure of this check simply results in a meaningless return
+* PRE-CONDITION: Called from the channel's interrupt once its transfer has finished
 *
-* POST-CONDITION: The received data is placed in rx_buffer
+* POST-CONDITION: The channel is idle and the transfer can be reaped
+* POST-CONDITION: A task waiting on the channel has been woken
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
+* @param		channel the spi device of interest
 * @return 		void
 *
 * \b Example:
-*	Called automatically by spi_transfer when RX_ONLY == 1
+*	Called by the interrupt callbacks when they shut a transfer down
 *
-* @see spi_transfer
-* @see spi_transfer_bidir
-* @see spi_transfer_full_duplex
 *
+* @see spi_queue_start_next
+* @see spi_transfer_reap
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -676,55 +3476,49 @@ static void spi_transfer_bidir_receive(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_full_duplex_rxonly(spi_transfer_t *transfer)
+static void spi_queue_complete(spi_channel_t channel)
 {
-	if (transfer->rx_buffer == NULL)
+	spi_queue_t *queue = &spi_queues[channel];
+	if (queue->urgent_active)
 	{
+		spi_urgent_complete(channel);
 		return;
 	}
-	uint16_t SR_state;
-	while(transfer->rx_length > 0)
+	SPI_TRACE(TRACE_TRANSFER_END, channel, spi_handles[channel].errors);
+	if (queue->isr_active)
 	{
-		do
-		{
-			SR_state = *SPI_SR[transfer->channel];
-		}while((SR_state & SPI_SR_RXNE_Msk) == 0);
-		*transfer->rx_buffer = *SPI_DR[transfer->channel];
-		transfer->rx_buffer++;
-		transfer->rx_length--;
+		__DMB();
+		queue->isr_done++;
+		queue->isr_active = 0;
+		queue->active = 0;
+		return;
 	}
-	do
-	{
-		SR_state = *SPI_SR[transfer->channel];
-	} while((SR_state & SPI_SR_BSY) != 0);
+	queue->slots[queue->done & (SPI_QUEUE_LENGTH - 1U)]->status = SPI_DESC_DONE;
+	__DMB();
+	queue->done++;
+	queue->active = 0;
+	SPI_OS_SIGNAL(channel);
 }
 
 /******************************************************************************
-* Function: spi_transfer_full_duplex()
+* Function: spi_queue_current()
 *//**
 * \b Description:
 *
-*	A static function called automatically by spi_transfer when the spi is configured
-*	with two data lines. It boots a subroutine dependent on whether or not the spi is
-*	configured in master or slave mode
+*	Static function which finds the transfer in progress on a channel, from
+*	whichever of its two rings it was started.
 *
-* PRE-CONDITION: (Soft assertion) The address and length of the data buffer are non-NULL.
-* 					Failure of this check simply results in a meaningless return
+* PRE-CONDITION: A queued transfer is in progress on the channel (active is set)
 *
-* POST-CONDITION: All data in the tx_buffer has been sent to the selected slave
-* POST-CONDITION: All received data has been placed in the rx_buffer
+* POST-CONDITION: None
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
-* @return 		void
+* @param		channel the spi device of interest
+* @return 		spi_transfer_t * the transfer in progress
 *
 * \b Example:
-*	Called automatically by spi_transfer when no other special transfer modes are valid
-*
-* @see spi_transfer
-* @see spi_transfer_bidir
-* @see spi_transfer_full_duplex_rxonly
+*	Called by spi_irq_handler and spi_urgent_complete
 *
+* @see spi_queue_start_next
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -732,48 +3526,37 @@ static void spi_transfer_full_duplex_rxonly(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_full_duplex(spi_transfer_t *transfer)
+static spi_transfer_t *spi_queue_current(spi_channel_t channel)
 {
-	if (transfer->tx_buffer == NULL || transfer->rx_buffer == NULL)
-		return;
-	uint16_t CR1_state = *SPI_CR1[transfer->channel];
-
-
-	if ((CR1_state & SPI_CR1_MSTR_Msk) != 0)
-	{
-		spi_transfer_full_duplex_master(transfer);
-	}
-	else
+	spi_queue_t *queue = &spi_queues[channel];
+	if (queue->isr_active)
 	{
-		spi_transfer_full_duplex_slave(transfer);
+		return (&queue->isr_slots[queue->isr_done & (SPI_ISR_QUEUE_LENGTH - 1U)]);
 	}
+	return (&queue->slots[queue->done & (SPI_QUEUE_LENGTH - 1U)]->state);
 }
 
 /******************************************************************************
-* Function: spi_transfer_full_duplex_master()
+* Function: spi_transfer_polled()
 *//**
 * \b Description:
 *
-*	A static function called automatically by spi_transfer_full_duplex when the spi
-*	is configured as a master with two data lines.
+*	Static function which carries out a blocking transfer by polling, without
+*	taking the channel's lock.
 *
-* PRE-CONDITION: The tx_buffer is non-NULL and of non-zero length
-* PRE-CONDITION: The rx_buffer is non-NULL and of non-zero length
+* PRE-CONDITION: The caller owns the channel
 *
-* POST-CONDITION: All data in the tx_buffer has been sent to the selected slave
-* POST-CONDITION: All received data has been placed in the rx_buffer
+* POST-CONDITION: The desired transfer has been carried out
 *
 * @param		transfer a pointer to the transfer structure containing all relevant
 * 					information for the transmission
 * @return 		void
 *
 * \b Example:
-*	Called automatically by spi_transfer when no other special transfer modes are valid
+*	Called by spi_transfer and spi_transfer_multi
 *
-* @see spi_transfer
-* @see spi_transfer_full_duplex
-* @see spi_transfer_full_duplex_slave
 *
+* @see spi_transfer
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -781,80 +3564,71 @@ static void spi_transfer_full_duplex(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_full_duplex_master(spi_transfer_t *transfer)
+static void spi_transfer_polled(spi_transfer_t *transfer)
 {
-	assert(transfer->tx_buffer != NULL && transfer->tx_length != 0);
-	assert(transfer->rx_buffer != NULL && transfer->rx_length != 0);
-	uint16_t SR_state;
-	*SPI_DR[transfer->channel] = *transfer->tx_buffer;
-	transfer->tx_buffer++;
-	transfer->tx_length--;
-	while(transfer->rx_length > 1)
-	{
-		do
-		{
-			SR_state = *SPI_SR[transfer->channel];
-		} while((SR_state & SPI_SR_TXE_Msk) == 0);
-
-		*SPI_DR[transfer->channel] = *transfer->tx_buffer;
-		transfer->tx_buffer++;
-		transfer->tx_length--;
-
-		do
-		{
-			SR_state = *SPI_SR[transfer->channel];
-		} while((SR_state & SPI_SR_RXNE_Msk) == 0);
-
-		*transfer->rx_buffer = *SPI_DR[transfer->channel];
-		transfer->rx_buffer++;
-		transfer->rx_length--;
-	}
-
-	do
-	{
-		SR_state = *SPI_SR[transfer->channel];
-	} while((SR_state & SPI_SR_RXNE_Msk) == 0);
-
-	*transfer->rx_buffer = *SPI_DR[transfer->channel];
-	transfer->rx_buffer++;
-	transfer->rx_length--;
+	uint16_t CR1_state = spi_transfer_begin(transfer);
+	spi_kernel_t kernel = spi_kernel_select(transfer, CR1_state);
 
-	do
+	if (kernel != NULL)
 	{
-		SR_state = *SPI_SR[transfer->channel];
-	} while((SR_state & SPI_SR_TXE_Msk) == 0);
+		kernel(transfer);
+	}
+	spi_transfer_end(transfer, CR1_state);
+}
 
-	do
-	{
-		SR_state = *SPI_SR[transfer->channel];
-	} while((SR_state & SPI_SR_BSY_Msk) != 0);
+/******************************************************************************
+* Function: spi_urgent_due()
+*//**
+* \b Description:
+*
+*	Static function which decides whether an interrupt transfer in progress
+*	should make way for an urgent one at its next frame boundary.
+*
+* PRE-CONDITION: The transfer is the one in progress on its channel
+*
+* POST-CONDITION: None
+*
+* @param		transfer a pointer to the transfer in progress
+* @return 		uint8_t 1 if the transfer should pause, 0 otherwise
+*
+* \b Example:
+*	Called by the interrupt callbacks which can pause a transfer
+*
+* @see spi_desc_submit_urgent
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t spi_urgent_due(spi_transfer_t *transfer)
+{
+	spi_queue_t *queue = &spi_queues[transfer->channel];
+	return (transfer->preemptible == PREEMPT_ENABLE
+			&& queue->urgent_pending && !queue->urgent_active
+			&& (spi_handles[transfer->channel].regs->CR1 & SPI_CR1_MSTR_Msk));
 }
 
 /******************************************************************************
-* Function: spi_transfer_full_duplex_slave()
+* Function: spi_urgent_start()
 *//**
 * \b Description:
 *
-*	A static function called automatically by spi_transfer_full_duplex when the spi
-*	is configured as a slave with two data lines.
+*	Static function which loads the urgent descriptor's request and starts it,
+*	ahead of the channel's queue and of any paused transfer.
 *
-* PRE-CONDITION: The tx_buffer is non-NULL and of non-zero length
-* PRE-CONDITION: The rx_buffer is non-NULL and of non-zero length
+* PRE-CONDITION: An urgent transfer is pending and the channel's shift register is idle
 *
-* POST-CONDITION: All data in the tx_buffer has been sent to the master
-* POST-CONDITION: All received data has been placed in the rx_buffer
+* POST-CONDITION: The urgent transfer is in progress, or has completed at once
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
+* @param		channel the spi device of interest
 * @return 		void
 *
 * \b Example:
-*	Called automatically by spi_transfer when no other special transfer modes are valid
-*
-* @see spi_transfer
-* @see spi_transfer_full_duplex
-* @see spi_transfer_full_duplex_master
+*	Called by spi_irq_handler on an idle channel and by the callbacks pausing a transfer
 *
+* @see spi_urgent_complete
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -862,85 +3636,46 @@ static void spi_transfer_full_duplex_master(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_full_duplex_slave(spi_transfer_t *transfer)
+static void spi_urgent_start(spi_channel_t channel)
 {
-	uint16_t SR_state;
-	do
-			{
-				SR_state = *SPI_SR[transfer->channel];
-			} while((SR_state & SPI_SR_RXNE_Msk) == 0);
-
-			*transfer->rx_buffer = *SPI_DR[transfer->channel];
-			transfer->rx_buffer++;
-			transfer->rx_length--;
-
-			while(transfer->tx_length > 1)
-			{
-				do
-				{
-					SR_state = *SPI_SR[transfer->channel];
-				} while((SR_state & SPI_SR_RXNE_Msk) == 0);
-
-				*transfer->rx_buffer = *SPI_DR[transfer->channel];
-				transfer->rx_buffer++;
-				transfer->rx_length--;
-				do
-				{
-					SR_state = *SPI_SR[transfer->channel];
-				} while((SR_state & SPI_SR_TXE_Msk) == 0);
-
-				*SPI_DR[transfer->channel] = *transfer->tx_buffer;
-				transfer->tx_buffer++;
-				transfer->tx_length--;
-			}
-
-			do
-			{
-				SR_state = *SPI_SR[transfer->channel];
-			} while((SR_state & SPI_SR_TXE_Msk) == 0);
-
-			*SPI_DR[transfer->channel] = *transfer->tx_buffer;
-			transfer->tx_buffer++;
-			transfer->tx_length--;
-
-			do
-			{
-				SR_state = *SPI_SR[transfer->channel];
-			}while((SR_state & SPI_SR_RXNE_Msk) == 0);
+	SPI_TypeDef *spi = spi_handles[channel].regs;
+	spi_queue_t *queue = &spi_queues[channel];
+	__DMB();
+	spi_desc_slot_t *slot = &spi_descs[queue->urgent];
+	slot->state = *slot->request;
 
-			do
-			{
-				SR_state = *SPI_SR[transfer->channel];
-			}while((SR_state & SPI_SR_BSY_Msk) != 0);
+	queue->urgent_active = 1;
+	spi_transfer_it_start(&slot->state);
+	if ((spi->CR2 & (SPI_CR2_TXEIE_Msk | SPI_CR2_RXNEIE_Msk)) == 0)
+	{
+		if (spi->CR1 & SPI_CR1_MSTR_Msk)
+		{
+			spi_release_slave(&slot->state);
+		}
+		spi_urgent_complete(channel);
+	}
 }
 
 /******************************************************************************
-* Function: spi_transfer_it_bidir_transmit_callback()
+* Function: spi_urgent_complete()
 *//**
 * \b Description:
 *
-*	A static callback mapped to the irq handler by spi_transfer_bidir_it and
-*	called by the irq handler. Handles the transmission of a single
-*	data unit or ends the communication and releases the slave.
+*	Static function which marks the urgent descriptor done and resumes the
+*	transfer it paused, if any, from where it stopped. The resumed transfer
+*	selects its slave and configures the channel again.
 *
-* PRE-CONDITION: The tx_buffer is of non-zero length
+* PRE-CONDITION: The urgent transfer has finished and its slave has been released
 *
-* POST-CONDITION: A single data unit has been sent to the target
-* OR
-* POST-CONDITION: The communication has been ended and the slave released
+* POST-CONDITION: The channel can take another urgent transfer
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
+* @param		channel the spi device of interest
 * @return 		void
 *
 * \b Example:
-*	Registered when appropriate by spi_transfer_it_bidir and called
-*	by the spi_irq_handler
+*	Called by spi_queue_complete while an urgent transfer is in progress
 *
-* @see spi_transfer_it
-* @see spi_transfer_it_bidir
-* @see spi_irq_handler
-* @see spi_transfer_it_full_duplex
+* @see spi_urgent_start
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -948,50 +3683,56 @@ static void spi_transfer_full_duplex_slave(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_it_bidir_transmit_callback(spi_transfer_t *transfer)
+static void spi_urgent_complete(spi_channel_t channel)
 {
-	uint16_t SR_state = *SPI_SR[transfer->channel];
-	if (transfer->tx_length > 0 && (SR_state & SPI_SR_TXE_Msk))
-	{
-		*SPI_DR[transfer->channel] = *transfer->tx_buffer;
-		transfer->tx_buffer++;
-		transfer->tx_length--;
-	}
-	else
+	SPI_TypeDef *spi = spi_handles[channel].regs;
+	spi_queue_t *queue = &spi_queues[channel];
+	SPI_TRACE(TRACE_TRANSFER_END, channel, spi_handles[channel].errors);
+	spi_descs[queue->urgent].status = SPI_DESC_DONE;
+	__DMB();
+	queue->urgent_active = 0;
+	queue->urgent_pending = 0;
+	SPI_OS_SIGNAL(channel);
+
+	if (queue->active)
 	{
-		*SPI_CR2[transfer->channel] &= ~(SPI_CR2_TXEIE_Msk);
-		*SPI_CR1[transfer->channel] &= ~(SPI_CR1_SPE_Msk);
-		spi_release_slave(transfer);
+		spi_transfer_t *transfer = spi_queue_current(channel);
+		spi_transfer_it_start(transfer);
+		if ((spi->CR2 & (SPI_CR2_TXEIE_Msk | SPI_CR2_RXNEIE_Msk)) == 0)
+		{
+			if (spi->CR1 & SPI_CR1_MSTR_Msk)
+			{
+				spi_release_slave(transfer);
+			}
+			spi_queue_complete(channel);
+		}
 	}
 }
 
 /******************************************************************************
-* Function: spi_transfer_it_bidir_receive_callback()
+* Function: spi_queue_push()
 *//**
 * \b Description:
 *
-*	A static callback mapped to the irq handler by spi_transfer_bidir_it and
-*	called by the irq handler. Handles the reception of a single
-*	data unit or ends the communication and releases the slave.
+*	Static function which places a descriptor in the next free slot of a
+*	channel's queue, publishes it and pends the channel's interrupt. Completed
+*	slots nobody collects are passed over first to make room.
 *
-* PRE-CONDITION: The rx_buffer is of non-zero length
+* PRE-CONDITION: The caller owns the channel
 *
-* POST-CONDITION: A single data unit has been received from the target
-* OR
-* POST-CONDITION: The communication has been ended and the slave released
+* POST-CONDITION: The descriptor has been queued, or the queue was full
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
-* @return 		void
+* @param		channel the spi device of interest
+* @param		slot the descriptor to queue, from the pool or the channel's copies
+* @param		kept 1 if its completion will be collected by spi_transfer_reap or
+* 					spi_transfer_it_wait, 0 if it is passed over
+* @return 		uint8_t 1 if the descriptor was queued, 0 if the queue was full
 *
 * \b Example:
-*	Registered when appropriate by spi_transfer_it_bidir and called
-*	by the spi_irq_handler
+*	Called by spi_queue_push_copy and spi_desc_submit
 *
-* @see spi_transfer_it
-* @see spi_transfer_it_bidir
-* @see spi_transfer_it_full_duplex
-* @see spi_irq_handler
+*
+* @see spi_queue_start_next
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -999,54 +3740,49 @@ static void spi_transfer_it_bidir_transmit_callback(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_it_bidir_receive_callback(spi_transfer_t *transfer)
+static uint8_t spi_queue_push(spi_channel_t channel, spi_desc_slot_t *slot, uint8_t kept)
 {
-	uint16_t SR_state = *SPI_SR[transfer->channel];
-	if (transfer->rx_length > 0 && (SR_state & SPI_SR_RXNE_Msk))
-	{
-		*transfer->rx_buffer = *SPI_DR[transfer->channel];
-		transfer->rx_buffer++;
-		transfer->rx_length--;
-	}
-	else
+	spi_queue_t *queue = &spi_queues[channel];
+	uint32_t head = queue->head;
+
+	if (!spi_queue_collect(channel))
 	{
-		*SPI_CR2[transfer->channel] &= ~(SPI_CR2_RXNEIE_Msk);
-		*SPI_CR1[transfer->channel] &= ~(SPI_CR1_SPE_Msk);
-		spi_release_slave(transfer);
+		return (0);
 	}
+	queue->slots[head & (SPI_QUEUE_LENGTH - 1U)] = slot;
+	queue->kept[head & (SPI_QUEUE_LENGTH - 1U)] = kept;
+	slot->status = SPI_DESC_QUEUED;
+	__DMB();
+	queue->head = head + 1;
+
+	NVIC_SetPendingIRQ(spi_handles[channel].irqn);
+	return (1);
 }
 
 /******************************************************************************
-* Function: spi_transfer_it_bidir()
+* Function: spi_queue_push_copy()
 *//**
 * \b Description:
 *
-*	Maps the appropriate bidir callback and makes a safe copy of the transfer
-*	structure.
+*	Static function which copies a transfer into the channel's copy for the
+*	next slot of its queue and queues it. The copy is indexed by the slot, so it
+*	is free again as soon as the slot is, and no descriptor has to be taken from
+*	the shared pool.
 *
-* PRE-CONDITION: (Soft Assert) The tx_buffer is non-NULL and of non-zero length
-* OR
-* PRE-CONDITION: (Soft Assert) The rx_buffer is non-NULL and of non-zero length
+* PRE-CONDITION: The caller owns the channel
 *
-* POST-CONDITION: The correct callback function has been mapped to the file-scope
-* 					callback array
-* POST-CONDITION: The correct buffer interrupt (RXNEIE or TXEIE) has been enabled
-* POST-CONDITION: The SPI Enable (SPE) has been switched on
+* POST-CONDITION: The transfer has been queued, or the queue was full
 *
 * @param		transfer a pointer to the transfer structure containing all relevant
 * 					information for the transmission
-* @return 		void
+* @param		kept 1 if its completion will be collected, as for spi_queue_push
+* @return 		uint8_t 1 if the transfer was queued, 0 otherwise
 *
 * \b Example:
-*	Called by spi_transfer_it when BIDIMODE == 1
-*
-*
-* @see spi_transfer_it
-* @see spi_transfer_it_bidir_transmit_callback
-* @see spi_transfer_it_bidir_receive_callback
-* @see spi_transfer_it_full_duplex
+*	Called by spi_transfer_submit, spi_transfer_it and
+*	spi_transfer_it_wait
 *
-* @see spi_irq_handler
+* @see spi_queue_push
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -1054,59 +3790,42 @@ static void spi_transfer_it_bidir_receive_callback(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_it_bidir(spi_transfer_t *transfer)
+static uint8_t spi_queue_push_copy(const spi_transfer_t *transfer, uint8_t kept)
 {
-	uint16_t CR1_state = *SPI_CR1[transfer->channel];
-	if ((CR1_state & SPI_CR1_BIDIOE_Msk) != 0)
-	{
-		if (transfer->tx_buffer == NULL || transfer->tx_length == 0)
-		{
-			return;
-		}
+	spi_queue_t *queue = &spi_queues[transfer->channel];
+	uint32_t head = queue->head;
 
-		spi_interrupt_callbacks[transfer->channel] = spi_transfer_it_bidir_transmit_callback;
-		*SPI_CR2[transfer->channel] |= SPI_CR2_TXEIE_Msk;
-	}
-	else
+	if (!spi_queue_collect(transfer->channel))
 	{
-		if (transfer->rx_buffer == NULL || transfer->rx_length == 0)
-		{
-			return;
-		}
-		spi_interrupt_callbacks[transfer->channel] = spi_transfer_it_bidir_receive_callback;
-		*SPI_CR2[transfer->channel] |= SPI_CR2_RXNEIE_Msk;
+		return (0);
 	}
-
-	*SPI_CR1[transfer->channel] |= SPI_CR1_SPE_Msk;
-
+	spi_desc_slot_t *copy = &queue->copies[head & (SPI_QUEUE_LENGTH - 1U)];
+	copy->state = *transfer;
+	copy->request = NULL;
+	return (spi_queue_push(transfer->channel, copy, kept));
 }
 
 /******************************************************************************
-* Function: spi_transfer_it_full_duplex_rxonly_callback()
+* Function: spi_queue_collect()
 *//**
 * \b Description:
 *
-*	A callback function called by the irq handler which manages the reception
-*	of a single data unit when the spi has two data lines.
+*	Static function which moves reaped past the completed slots at the front of
+*	the collected part of the queue that nobody will collect, freeing them. It
+*	stops at the first slot kept for its submitter, so no completion waiting for
+*	spi_transfer_reap or spi_transfer_it_wait is ever dropped.
 *
-* PRE-CONDITION: (Soft Assert) The rx_buffer is of non-zero length
+* PRE-CONDITION: The caller owns the channel
 *
-* POST-CONDITION: A single data unit has been received
-* OR
-* POST-CONDITION: The communication has been shut down and the slave released
+* POST-CONDITION: The slot at reaped, if completed, is kept for its submitter
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
-* @return 		void
+* @param		channel the spi device of interest
+* @return 		uint8_t 1 if the queue has a free slot, 0 if it is full
 *
 * \b Example:
-*	Called by the irq_handler if it's mapped
+*	Called by spi_queue_push, spi_queue_push_copy, spi_transfer_reap and spi_transfer
 *
-*
-* @see spi_transfer_it
-* @see spi_transfer_it_bidir
-* @see spi_transfer_it_full_duplex
-* @see spi_irq_handler
+* @see spi_transfer_reap
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -1114,47 +3833,41 @@ static void spi_transfer_it_bidir(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_it_full_duplex_rxonly_callback(spi_transfer_t *transfer)
+static uint8_t spi_queue_collect(spi_channel_t channel)
 {
-	uint16_t SR_state = *SPI_SR[transfer->channel];
-	if (transfer->rx_length > 0 && (SR_state & SPI_SR_RXNE_Msk))
-	{
-		*transfer->rx_buffer = *SPI_DR[transfer->channel];
-		transfer->rx_buffer++;
-		transfer->rx_length--;
-	}
-	else
+	spi_queue_t *queue = &spi_queues[channel];
+	uint32_t reaped = queue->reaped;
+	uint32_t done = queue->done;
+	__DMB();
+
+	while (reaped != done && !queue->kept[reaped & (SPI_QUEUE_LENGTH - 1U)])
 	{
-		*SPI_CR2[transfer->channel] &= ~(SPI_CR2_RXNEIE_Msk);
-		*SPI_CR1[transfer->channel] &= ~(SPI_CR1_SPE_Msk);
-		spi_release_slave(transfer);
+		reaped++;
 	}
+	queue->reaped = reaped;
+	return (queue->head - reaped < SPI_QUEUE_LENGTH);
 }
 
 /******************************************************************************
-* Function: spi_transfer_it_full_duplex_rxonly()
+* Function: spi_desc_alloc()
 *//**
 * \b Description:
 *
-*	Registers the rxonly callback and makes a safe copy of the transfer structure.
+*	Static function which takes a free descriptor from the pool. Each in_use flag
+*	is claimed with an exclusive load and store, so that callers on different
+*	channels, or interrupting one another, never take the same descriptor and
+*	interrupts are never masked. A flag seen taken is passed over at once.
 *
-* PRE-CONDITION: The rx buffer is non-NULL and of non-zero length
-
-* POST-CONDITION: The rxonly callback has been mapped to the right spi device
-* POST-CONDITION: The RXNEIE interrupt has been enabled
+* PRE-CONDITION: None
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
-* @return 		void
+* POST-CONDITION: The descriptor returned is in use and idle
 *
-* \b Example:
-*	Called by spi_transfer_it when RXONLY == 1
+* @return 		spi_desc_t the descriptor, SPI_DESC_NONE if the pool is empty
 *
+* \b Example:
+*	Called by spi_desc_create
 *
-* @see spi_transfer_it
-* @see spi_transfer_it_bidir
-* @see spi_transfer_it_full_duplex
-* @see spi_irq_handler
+* @see spi_desc_create
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -1162,41 +3875,63 @@ static void spi_transfer_it_full_duplex_rxonly_callback(spi_transfer_t *transfer
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_it_full_duplex_rxonly(spi_transfer_t *transfer)
+static spi_desc_t spi_desc_alloc(void)
 {
-	assert(transfer->rx_buffer != NULL && transfer->rx_length != 0);
-	spi_interrupt_callbacks[transfer->channel] = spi_transfer_it_full_duplex_rxonly_callback;
-	*SPI_CR2[transfer->channel] |= SPI_CR2_RXNEIE_Msk;
-	*SPI_CR1[transfer->channel] |= SPI_CR1_SPE_Msk;
+	for (uint8_t i = 0; i < SPI_DESC_POOL_LENGTH; i++)
+	{
+		uint8_t taken;
+		do
+		{
+			taken = __LDREXB(&spi_descs[i].in_use);
+			if (taken)
+			{
+				__CLREX();
+				break;
+			}
+		} while (__STREXB(1U, &spi_descs[i].in_use) != 0);
+
+		if (!taken)
+		{
+			__DMB();
+			spi_descs[i].status = SPI_DESC_IDLE;
+			return (i);
+		}
+	}
+	return (SPI_DESC_NONE);
 }
 
 /******************************************************************************
-* Function: spi_transfer_it_full_duplex_callback()
+* Function: spi_transfer_full_duplex_master_packed()
 *//**
 * \b Description:
 *
-*	A callback function called by the irq handler which manages the reception and
-*	transmission of a single data unit when the spi has two data lines.
+*	Static function which sends a byte stream two bytes per 16 bit frame, halving
+*	the number of frames the cpu has to move. The frames are assembled so that the
+*	bytes go out on the wire in buffer order for either bit order. As in the 16 bit
+*	master kernel the next frame is written while the previous one is on the wire,
+*	so the clock runs without gaps. An odd final byte is sent on its own after the
+*	channel has been dropped back to 8 bit frames.
 *
-* PRE-CONDITION: (Soft Assert) The rx_buffer is of non-zero length
-* PRE-CONDITION: (Soft Assert) The tx_buffer is of non-zero length
+* PRE-CONDITION: spi_transfer_begin has configured the channel with DFF = 1
+* PRE-CONDITION: The tx_buffer is non-NULL. A non-NULL rx_buffer holds at least
+* 					tx_length bytes
+* PRE-CONDITION: Both buffers are aligned to two bytes
+* PRE-CONDITION: CRC is disabled
 *
-* POST-CONDITION: A single data unit has been received and another sent
-* OR
-* POST-CONDITION: The communication has been shut down and the slave released
+* POST-CONDITION: The bytes have been sent and the replies stored (or discarded).
+* 					An odd final byte leaves its buffer at the pair holding it
+* POST-CONDITION: The flags read in the loop are latched for spi_collect_errors
 *
 * @param		transfer a pointer to the transfer structure containing all relevant
 * 					information for the transmission
 * @return 		void
 *
 * \b Example:
-*	Called by the irq_handler if it's mapped
+*	Selected by spi_kernel_select when data_format is SPI_DATA_8BIT_PACKED
 *
 *
-* @see spi_transfer_it
-* @see spi_transfer_it_bidir
-* @see spi_transfer_it_full_duplex_rxonly
-* @see spi_irq_handler
+* @see spi_packed_next_frame
+* @see spi_packed_store_frame
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -1204,55 +3939,105 @@ static void spi_transfer_it_full_duplex_rxonly(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_it_full_duplex_callback(spi_transfer_t *transfer)
+static void spi_transfer_full_duplex_master_packed(spi_transfer_t *transfer)
 {
-	uint16_t SR_state = *SPI_SR[transfer->channel];
-	if (transfer->tx_length > 0 && (SR_state & SPI_SR_TXE_Msk))
+	assert(transfer->tx_buffer != NULL && transfer->crc_enable != CRC_ENABLE);
+	assert(((uintptr_t)transfer->tx_buffer & 1U) == 0 && ((uintptr_t)transfer->rx_buffer & 1U) == 0);
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t swap = (spi->CR1 & SPI_CR1_LSBFIRST_Msk) == 0;
+	uint16_t SR_state;
+
+	if (transfer->rx_buffer == NULL)
 	{
-		*SPI_DR[transfer->channel] = *transfer->tx_buffer;
-		transfer->tx_buffer++;
-		transfer->tx_length--;
+		transfer->rx_length = transfer->tx_length;
 	}
+	assert(transfer->rx_length >= transfer->tx_length);
 
-	else if (transfer->rx_length > 0 && (SR_state & SPI_SR_RXNE_Msk))
+	uint16_t *tx = transfer->tx_buffer;
+	uint16_t *rx = transfer->rx_buffer;
+	uint32_t tx_left = transfer->tx_length;
+	uint32_t to_send = transfer->rx_length / 2;
+	uint32_t to_receive = to_send;
+	uint16_t SR_seen = 0;
+
+	while (to_receive > 0)
 	{
-		*transfer->rx_buffer = *SPI_DR[transfer->channel];
-		transfer->rx_buffer++;
-		transfer->rx_length--;
+		SR_state = spi->SR;
+		SR_seen |= SR_state;
+		if (SR_state & SPI_SR_RXNE_Msk)
+		{
+			spi_packed_store_frame(&rx, spi->DR, swap);
+			to_receive--;
+		}
+		if ((SR_state & SPI_SR_TXE_Msk) && to_send > 0 && (to_receive - to_send) < 2)
+		{
+			spi->DR = spi_packed_next_frame(&tx, &tx_left, swap);
+			to_send--;
+		}
 	}
-	else
+	spi_handles[transfer->channel].SR_latched |= SR_seen;
+
+	if (transfer->rx_length & 1U)
 	{
-		*SPI_CR2[transfer->channel] &= ~(SPI_CR2_TXEIE_Msk | SPI_CR2_RXNEIE_Msk);
-		*SPI_CR1[transfer->channel] &= ~(SPI_CR1_SPE_Msk);
-		spi_release_slave(transfer);
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_BSY_Msk) != 0);
+		spi->CR1 &= ~(SPI_CR1_SPE_Msk);
+		spi->CR1 &= ~(SPI_CR1_DFF_Msk);
+		spi->CR1 |= SPI_CR1_SPE_Msk;
+
+		spi->DR = (tx_left > 0) ? *(uint8_t *)tx : (uint8_t)SPI_DUMMY_FRAME;
+		tx_left = 0;
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_RXNE_Msk) == 0);
+
+		uint8_t last = (uint8_t)spi->DR;
+		if (rx != NULL)
+		{
+			*(uint8_t *)rx = last;
+		}
 	}
+
+	do
+	{
+		SR_state = spi->SR;
+	} while((SR_state & SPI_SR_BSY_Msk) != 0);
+
+	transfer->tx_buffer = tx;
+	transfer->tx_length = tx_left;
+	transfer->rx_buffer = rx;
+	transfer->rx_length = 0;
 }
 
 /******************************************************************************
-* Function: spi_transfer_it_full_duplex()
+* Function: spi_packed_next_frame()
 *//**
 * \b Description:
 *
-*	Maps the correct callback to the callback array and enables the correct
-*	interrupt flags
+*	Static function which takes the next two bytes of a packed transfer (dummy
+*	bytes once the tx_buffer is exhausted) and assembles them into a frame. With
+*	MSB first the bytes are swapped with REV16 so that the first byte is shifted
+*	out first; with LSB first the little endian halfword is already in wire order.
+*	The buffer is only ever moved a whole halfword, so a lone final byte leaves it
+*	where it is and the pointer stays aligned.
 *
-* PRE-CONDITION: None
+* PRE-CONDITION: The buffer is aligned to two bytes
 *
-* POST-CONDITION: The reception and transmission (RXNEIE and TXEIE) interrupts have
-* 					been enabled
+* POST-CONDITION: The buffer and count have moved past the bytes taken
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
-* @return 		void
+* @param		tx a pointer to the transmit buffer pointer
+* @param		tx_left a pointer to the number of bytes left in the buffer
+* @param		swap non-zero when the channel sends MSB first
+* @return 		uint16_t the frame to write to DR
 *
 * \b Example:
-*	Called by spi_transfer_it when full duplex configuration is selected
-*
+*	Called by spi_transfer_full_duplex_master_packed and the packed interrupt
+*	routines for every frame
 *
-* @see spi_transfer_it
-* @see spi_transfer_it_bidir
-* @see spi_transfer_it_full_duplex_rxonly
-* @see spi_irq_handler
+* @see spi_packed_store_frame
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -1260,37 +4045,52 @@ static void spi_transfer_it_full_duplex_callback(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_transfer_it_full_duplex(spi_transfer_t *transfer)
+static uint16_t spi_packed_next_frame(uint16_t **tx, uint32_t *tx_left, uint16_t swap)
 {
-	spi_interrupt_callbacks[transfer->channel] = spi_transfer_it_full_duplex_callback;
-	*SPI_CR2[transfer->channel] |= SPI_CR2_TXEIE_Msk | SPI_CR2_RXNEIE_Msk;
-	*SPI_CR1[transfer->channel] |= SPI_CR1_SPE_Msk;
+	uint8_t *tx_bytes = (uint8_t *)*tx;
+	uint8_t pair[2] = {(uint8_t)SPI_DUMMY_FRAME, (uint8_t)SPI_DUMMY_FRAME};
+
+	if (*tx_left >= 2)
+	{
+		pair[0] = tx_bytes[0];
+		pair[1] = tx_bytes[1];
+		(*tx)++;
+		*tx_left -= 2;
+	}
+	else if (*tx_left == 1)
+	{
+		pair[0] = tx_bytes[0];
+		*tx_left = 0;
+	}
+
+	uint16_t frame = (uint16_t)(pair[0] | (pair[1] << 8));
+	return (swap ? (uint16_t)__REV16(frame) : frame);
 }
 
 /******************************************************************************
-* Function: spi_select_slave()
+* Function: spi_packed_store_frame()
 *//**
 * \b Description:
 *
-*	Static function used to select a slave (whether it is active high or low) from
-*	within transfer functions
+*	Static function which splits a received frame of a packed transfer back into
+*	its two bytes, in the order they arrived on the wire. The frame is dropped if
+*	the transfer has no rx_buffer. The caller counts the two bytes off.
 *
-* PRE-CONDITION: The GPIO pin for controlling the slave has been correctly configured
+* PRE-CONDITION: At least two bytes remain to be received
+* PRE-CONDITION: The buffer is NULL or aligned to two bytes
 *
-* POST-CONDITION: The GPIO output is at the correct level to select the slave
+* POST-CONDITION: The buffer has moved past the two bytes
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
+* @param		rx a pointer to the receive buffer pointer
+* @param		frame the frame read from DR
+* @param		swap non-zero when the channel sends MSB first
 * @return 		void
 *
 * \b Example:
-*	Called by spi_transfer and spi_transfer_it in master mode before transmission
-*	begins
-*
+*	Called by spi_transfer_full_duplex_master_packed and the packed interrupt
+*	callback for every frame
 *
-* @see spi_release_slave
-* @see spi_transfer
-* @see spi_transfer_it
+* @see spi_packed_next_frame
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -1298,41 +4098,47 @@ static void spi_transfer_it_full_duplex(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_select_slave(spi_transfer_t *transfer)
+static void spi_packed_store_frame(uint16_t **rx, uint16_t frame, uint16_t swap)
 {
-	if (transfer->ss_polarity == SS_ACTIVE_LOW)
+	if (*rx == NULL)
 	{
-		gpio_pin_write(transfer->slave_pin, GPIO_PIN_LOW);
+		return;
 	}
-	else if (transfer->ss_polarity == SS_ACTIVE_HIGH)
+	uint8_t *rx_bytes = (uint8_t *)*rx;
+	if (swap)
 	{
-		gpio_pin_write(transfer->slave_pin, GPIO_PIN_HIGH);
+		frame = (uint16_t)__REV16(frame);
 	}
+	rx_bytes[0] = (uint8_t)frame;
+	rx_bytes[1] = (uint8_t)(frame >> 8);
+	(*rx)++;
 }
 
 /******************************************************************************
-* Function: spi_release_slave()
+* Function: spi_transfer_it_packed()
 *//**
 * \b Description:
 *
-*	Static function used to release a slave (whether it is active high or low) from
-*	within transfer functions
+*	Static function which starts an interrupt driven packed transfer. Only RXNEIE
+*	is used: the first frame is written here and every reception writes the next
+*	one, so there is a single interrupt per two bytes and the receiver is never
+*	overrun.
 *
-* PRE-CONDITION: The GPIO pin for controlling the slave has been correctly configured
+* PRE-CONDITION: The channel is a full duplex master configured with DFF = 1
+* PRE-CONDITION: The tx_buffer is non-NULL
+* PRE-CONDITION: Both buffers are aligned to two bytes
+* PRE-CONDITION: CRC is disabled
 *
-* POST-CONDITION: The GPIO output is at the correct level to release the slave
+* POST-CONDITION: The packed callback has been mapped and RXNEIE enabled
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
+* @param		transfer a pointer to the queued copy of the transfer
 * @return 		void
 *
 * \b Example:
-*	Called by spi_transfer and spi_transfer_it and callbacks in master mode
+*	Called by spi_transfer_it_full_duplex when data_format is SPI_DATA_8BIT_PACKED
 *
 *
-* @see spi_select_slave
-* @see spi_transfer
-* @see spi_transfer_it
+* @see spi_transfer_it_packed_callback
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -1340,42 +4146,48 @@ static void spi_select_slave(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_release_slave(spi_transfer_t *transfer)
+static void spi_transfer_it_packed(spi_transfer_t *transfer)
 {
-	if (transfer->ss_polarity == SS_ACTIVE_LOW)
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	if (transfer->tx_buffer == NULL || transfer->tx_length == 0)
 	{
-		gpio_pin_write(transfer->slave_pin, GPIO_PIN_HIGH);
+		return;
 	}
-	else if (transfer->ss_polarity == SS_ACTIVE_HIGH)
+	if (transfer->rx_buffer == NULL)
 	{
-		gpio_pin_write(transfer->slave_pin, GPIO_PIN_LOW);
+		transfer->rx_length = transfer->tx_length;
 	}
+	assert(transfer->rx_length >= transfer->tx_length);
+	assert(((uintptr_t)transfer->tx_buffer & 1U) == 0 && ((uintptr_t)transfer->rx_buffer & 1U) == 0);
+
+	spi_handles[transfer->channel].callback = spi_transfer_it_packed_callback;
+	spi->CR1 |= SPI_CR1_SPE_Msk;
+	spi_transfer_it_packed_send(transfer);
+	spi->CR2 |= SPI_CR2_RXNEIE_Msk;
 }
 
 /******************************************************************************
-* Function: spi_configure_clock()
+* Function: spi_transfer_it_packed_send()
 *//**
 * \b Description:
 *
-*	Static function used to configure the clock phase and polarity to be used
-*	during the spi communication
+*	Writes the next two bytes as one 16 bit frame. When a single byte is left
+*	the spi is switched to 8 bit frames, once the previous frame has left the
+*	shift register, and the byte (or a dummy one) is written on its own, as the
+*	polled packed kernel does for an odd length.
 *
-* PRE-CONDITION: the clock_polarity member of the transfer structure is valid
-* PRE-CONDITION: the clock_phase member of the transfer structure is valid
+* PRE-CONDITION: No frame is in flight and at least one byte is left (rx_length > 0)
 *
-* POST-CONDITION: The CR1 registers now contain the desired clock configuration
+* POST-CONDITION: One frame has been written to DR
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
+* @param		transfer a pointer to the queued copy of the transfer
 * @return 		void
 *
 * \b Example:
-*	Called by spi_transfer and spi_transfer_it and callbacks
+*	Called by spi_transfer_it_packed and its callback
 *
-*
-* @see spi_configure_data_frame
-* @see spi_transfer
-* @see spi_transfer_it
+* @see spi_transfer_it_packed_callback
+* @see spi_transfer_full_duplex_master_packed
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -1383,52 +4195,51 @@ static void spi_release_slave(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_configure_clock(spi_transfer_t *transfer)
+static void spi_transfer_it_packed_send(spi_transfer_t *transfer)
 {
-	if (transfer->clock_polarity == ACTIVE_HIGH)
-	{
-		*SPI_CR1[transfer->channel] &= ~(SPI_CR1_CPOL_Msk);
-	}
-	else if (transfer->clock_polarity == ACTIVE_LOW)
-
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t SR_state;
+	if (transfer->rx_length == 1)
 	{
-		*SPI_CR1[transfer->channel] |= (SPI_CR1_CPOL_Msk);
-	}
+		do
+		{
+			SR_state = spi->SR;
+		} while((SR_state & SPI_SR_BSY_Msk) != 0);
+		spi->CR1 &= ~(SPI_CR1_SPE_Msk);
+		spi->CR1 &= ~(SPI_CR1_DFF_Msk);
+		spi->CR1 |= SPI_CR1_SPE_Msk;
 
-	if (transfer->clock_phase == FIRST_EDGE)
-	{
-		*SPI_CR1[transfer->channel] &= ~(SPI_CR1_CPHA_Msk);
+		spi->DR = (transfer->tx_length > 0) ? *(uint8_t *)transfer->tx_buffer : (uint8_t)SPI_DUMMY_FRAME;
+		transfer->tx_length = 0;
 	}
-	else if (transfer->clock_phase == SECOND_EDGE)
+	else
 	{
-		*SPI_CR1[transfer->channel] |= (SPI_CR1_CPHA_Msk);
+		spi->DR = spi_packed_next_frame(&transfer->tx_buffer, &transfer->tx_length,
+				(spi->CR1 & SPI_CR1_LSBFIRST_Msk) == 0);
 	}
 }
 
 /******************************************************************************
-* Function: spi_configure_data_frame()
+* Function: spi_transfer_it_packed_callback()
 *//**
 * \b Description:
 *
-*	Static function used to configure the the data size and bit format to be used
-*	during the current transfer
+*	Stores the frame just received (a single byte for the tail of an odd
+*	length) and writes the next one, or shuts the transfer down once the last
+*	frame has arrived.
 *
-* PRE-CONDITION: the data_format member of the transfer structure is valid
-* PRE-CONDITION: the bit_format member of the transfer structure is valid
+* PRE-CONDITION: spi_transfer_it_packed has started the transfer
 *
-* POST-CONDITION: The CR1 registers now contain the desired data format configuration
+* POST-CONDITION: Two more bytes have been exchanged, or the transfer has completed
 *
-* @param		transfer a pointer to the transfer structure containing all relevant
-* 					information for the transmission
+* @param		transfer a pointer to the queued copy of the transfer
 * @return 		void
 *
 * \b Example:
-*	Called by spi_transfer and spi_transfer_it and callbacks
+*	Called by spi_irq_handler on RXNE
 *
 *
-* @see spi_configure_clock
-* @see spi_transfer
-* @see spi_transfer_it
+* @see spi_transfer_it_packed
 * <br><b> - CHANGE HISTORY - </b>
 *
 * <table align="left" style="width:800px">
@@ -1436,25 +4247,38 @@ static void spi_configure_clock(spi_transfer_t *transfer)
 * </table><br><br>
 * <hr>
 *******************************************************************************/
-static void spi_configure_data_frame(spi_transfer_t *transfer)
+static void spi_transfer_it_packed_callback(spi_transfer_t *transfer)
 {
-	if (transfer->data_format == SPI_DATA_8BIT)
+	SPI_TypeDef *spi = spi_handles[transfer->channel].regs;
+	uint16_t swap = (spi->CR1 & SPI_CR1_LSBFIRST_Msk) == 0;
+	uint16_t SR_state = spi->SR;
+
+	spi_handles[transfer->channel].SR_latched |= SR_state;
+	if ((SR_state & SPI_SR_RXNE_Msk) == 0)
+	{
+		return;
+	}
+	if (transfer->rx_length == 1)
 	{
-		*SPI_CR1[transfer->channel] &= ~(SPI_CR1_DFF_Msk);
+		uint8_t last = (uint8_t)spi->DR;
+		if (transfer->rx_buffer != NULL)
+		{
+			*(uint8_t *)transfer->rx_buffer = last;
+		}
+		transfer->rx_length = 0;
 	}
-	else if (transfer->data_format == SPI_DATA_16BIT)
+	else
 	{
-		*SPI_CR1[transfer->channel] |= SPI_CR1_DFF_Msk;
+		spi_packed_store_frame(&transfer->rx_buffer, spi->DR, swap);
+		transfer->rx_length -= 2;
 	}
 
-	if (transfer->bit_format == MSB_FIRST)
+	if (transfer->rx_length > 0)
 	{
-		*SPI_CR1[transfer->channel] &= ~(SPI_CR1_LSBFIRST_Msk);
+		spi_transfer_it_packed_send(transfer);
 	}
-	else if (transfer->bit_format == LSB_FIRST)
+	else
 	{
-		*SPI_CR1[transfer->channel] |= SPI_CR1_LSBFIRST_Msk;
+		spi_transfer_it_end(transfer);
 	}
 }
-
-
@@ -36,8 +36,8 @@
  * Config table containing peripheral wide options for each spi device on chip
  */
 static const spi_config_t config_table[NUM_SPI] =
-{				//ENABLED			//MASTER		//SS_MODE			//BIDIR			//BAUD
-									//SLAVE												//RATE
+{				//ENABLED			//MASTER		//SS_MODE			//BIDIR			//BAUD			//CRC			//RX		//TX		//SS		//FRAME
+									//SLAVE												//RATE			//POLY			//DMA		//DMA		//OUTPUT	//FORMAT
 	/*SPI1*/	{},
 	/*SPI2*/	{},
 	/*SPI3*/	{},
@@ -34,6 +34,8 @@
 #ifndef _SPI_STM32F411_CONFIG
 #define _SPI_STM32F411_CONFIG
 
+#include <stdint.h>
+
 /**
  * Contains all of the spi devices found on chip
  */
@@ -56,6 +58,44 @@ typedef enum
 	SPI_MASTER	/**<The spi is functioning as a master and will select slaves and generate a clock */
 }spi_master_slave_t;
 
+/**
+ * Frequency of the APB1 bus clocking SPI2 and SPI3. Override to match the clock tree
+ */
+#ifndef SPI_APB1_CLOCK_HZ
+#define SPI_APB1_CLOCK_HZ 16000000UL
+#endif
+
+/**
+ * Frequency of the APB2 bus clocking SPI1, SPI4 and SPI5. Override to match the clock tree
+ */
+#ifndef SPI_APB2_CLOCK_HZ
+#define SPI_APB2_CLOCK_HZ 16000000UL
+#endif
+
+/**
+ * Number of interrupt driven transfers which can be queued on each spi device. Must be
+ * a power of two
+ */
+#ifndef SPI_QUEUE_LENGTH
+#define SPI_QUEUE_LENGTH 8U
+#endif
+
+/**
+ * Number of transfers an interrupt handler can have queued on each spi device with
+ * spi_transfer_it_from_isr. Must be a power of two
+ */
+#ifndef SPI_ISR_QUEUE_LENGTH
+#define SPI_ISR_QUEUE_LENGTH 4U
+#endif
+
+/**
+ * Number of transfer descriptors shared by all spi devices for spi_desc_create.
+ * Transfers queued by value are copied into the channel's own queue instead
+ */
+#ifndef SPI_DESC_POOL_LENGTH
+#define SPI_DESC_POOL_LENGTH 16U
+#endif
+
 /**
  *	Contains all of the prescaler options for the master clock generation
  */
@@ -163,7 +203,12 @@ typedef struct
 	spi_master_slave_t master_slave;	/**<Decides whether the spi is in master or slave mode*/
 	spi_slave_mgmt_t slave_management;	/**<Determines method of (self) slave management*/
 	spi_bidir_t	bidirectional_mode;		/**<Configured based upon physical topology of the spi */
-	spi_baud_rate_t baud_rate;			/**<Communication rate of the spi*/
+	spi_baud_rate_t baud_rate;			/**<Communication rate of the spi, used by transfers without a max_clock_hz*/
+	uint16_t crc_polynomial;			/**<Polynomial for hardware CRC transfers, 0 keeps the reset value (0x07)*/
+	spi_rx_dma_t rx_dma;				/**<Raises DMA requests on reception */
+	spi_tx_dma_t tx_dma;				/**<Raises DMA requests on transmission */
+	spi_ssoe_t ss_output;				/**<Drives NSS from the spi in master mode (single master only) */
+	spi_frame_format_t frame_format;	/**<Motorola or TI frame format */
 }spi_config_t;
 
 const spi_config_t *spi_config_get(void);
@@ -0,0 +1,204 @@
+/*******************************************************************************
+* Title                 :   SPI Bus Event Trace
+* Filename              :   spi_trace.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   Cortex-M3/M4 (DWT cycle counter)
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_trace.c
+ *  @brief Records bus events into an overwriting ring, timestamped with the DWT
+ *  	cycle counter.
+ */
+#include "spi_trace.h"
+#include "stm32f411xe.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+#if (SPI_TRACE_LENGTH == 0) || ((SPI_TRACE_LENGTH & (SPI_TRACE_LENGTH - 1U)) != 0)
+#error "SPI_TRACE_LENGTH must be a power of two"
+#endif
+
+/**
+ * Static ring of trace records. Once full, the oldest records are overwritten
+ */
+static spi_trace_record_t spi_trace_ring[SPI_TRACE_LENGTH];
+
+/**
+ * Number of records written since the last dump. Runs freely and is masked on access
+ */
+static uint32_t spi_trace_head;
+
+/**
+ * Index of the oldest record not yet dumped
+ */
+static uint32_t spi_trace_tail;
+
+/**
+ * Cycle count at spi_trace_init, which timestamps are taken relative to. The
+ * counter itself is left running for its other users
+ */
+static uint32_t spi_trace_base;
+
+/******************************************************************************
+* Function: spi_trace_init()
+*//**
+* \b Description:
+*
+* 	Starts the DWT cycle counter used for the timestamps, notes its value as the
+* 	time base and empties the ring. The counter is not reset, since the driver's
+* 	select delays, the schedule and the sleep path read it too.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: Events are recorded from here on
+*
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_trace_init();
+*	spi_init(spi_config_get());
+* @endcode
+*
+* @see spi_trace_dump
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_trace_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	spi_trace_base = DWT->CYCCNT;
+	spi_trace_head = 0;
+	spi_trace_tail = 0;
+}
+
+/******************************************************************************
+* Function: spi_trace_record()
+*//**
+* \b Description:
+*
+* 	Appends a timestamped event to the ring. Safe to call from any interrupt: the
+* 	slot is claimed and filled with interrupts masked for a handful of cycles.
+*
+* PRE-CONDITION: spi_trace_init() has been called
+*
+* POST-CONDITION: The event is the newest record in the ring
+*
+* @param		event the event being recorded
+* @param		channel the spi device it happened on
+* @param		arg the event specific argument
+* @return 		void
+*
+* \b Example:
+*	Called by the driver through the SPI_TRACE macro
+*
+* @see spi_trace_dump
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_trace_record(spi_trace_event_t event, spi_channel_t channel, uint16_t arg)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	spi_trace_record_t *record = &spi_trace_ring[spi_trace_head & (SPI_TRACE_LENGTH - 1U)];
+	record->timestamp = DWT->CYCCNT - spi_trace_base;
+	record->event = (uint8_t)event;
+	record->channel = (uint8_t)channel;
+	record->arg = arg;
+	spi_trace_head++;
+
+	__set_PRIMASK(primask);
+}
+
+/******************************************************************************
+* Function: spi_trace_dump()
+*//**
+* \b Description:
+*
+* 	Copies the records collected since the last dump out of the ring, oldest
+* 	first, and removes them. If the ring has wrapped only the newest
+* 	SPI_TRACE_LENGTH records are left. The copy is written as is to a file (or
+* 	read out with a debugger) and converted with tools/spi_trace_vcd.
+*
+* PRE-CONDITION: spi_trace_init() has been called
+*
+* POST-CONDITION: The copied records have been removed from the ring
+*
+* @param		records where to copy the records to
+* @param		max_records the number of records that fit in records
+* @return 		uint32_t the number of records copied
+*
+* \b Example:
+* @code
+*	static spi_trace_record_t dump[SPI_TRACE_LENGTH];
+*	uint32_t count = spi_trace_dump(dump, SPI_TRACE_LENGTH);
+*	uart_write((uint8_t *)dump, count * sizeof(spi_trace_record_t));
+* @endcode
+*
+* @see spi_trace_record
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_trace_dump(spi_trace_record_t *records, uint32_t max_records)
+{
+	assert(records != NULL);
+	uint32_t count = 0;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (spi_trace_head - spi_trace_tail > SPI_TRACE_LENGTH)
+	{
+		spi_trace_tail = spi_trace_head - SPI_TRACE_LENGTH;
+	}
+	while (count < max_records && spi_trace_tail != spi_trace_head)
+	{
+		records[count] = spi_trace_ring[spi_trace_tail & (SPI_TRACE_LENGTH - 1U)];
+		spi_trace_tail++;
+		count++;
+	}
+
+	__set_PRIMASK(primask);
+	return (count);
+}
@@ -0,0 +1,93 @@
+/*******************************************************************************
+* Title                 :   SPI Bus Event Trace
+* Filename              :   spi_trace.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_trace.h
+ *  @brief Optional ring of timestamped bus events recorded by the driver. Set
+ *  	SPI_TRACE_ENABLE to 1 to build it in; otherwise every trace point compiles
+ *  	away. Dumps are turned into VCD timelines by tools/spi_trace_vcd.c.
+ */
+#ifndef _SPI_TRACE_H
+#define _SPI_TRACE_H
+
+#include "spi_stm32f411_config.h"
+#include <stdint.h>
+
+/**
+ * Set to 1 to record bus events
+ */
+#ifndef SPI_TRACE_ENABLE
+#define SPI_TRACE_ENABLE 0
+#endif
+
+/**
+ * Number of records held by the ring. Must be a power of two
+ */
+#ifndef SPI_TRACE_LENGTH
+#define SPI_TRACE_LENGTH 256U
+#endif
+
+/**
+ * Contains the events recorded by the driver. The meaning of each record's arg is
+ * given per event
+ */
+typedef enum
+{
+	TRACE_CS_ASSERT,		/**<Slave select driven active, arg unused */
+	TRACE_CS_RELEASE,		/**<Slave select driven inactive, arg unused */
+	TRACE_TRANSFER_START,	/**<Transfer started, arg is its length in frames */
+	TRACE_TRANSFER_END,		/**<Transfer finished, arg is its spi_error_t mask */
+	TRACE_ISR_ENTRY,		/**<spi_irq_handler entered, arg unused */
+	TRACE_ISR_EXIT,			/**<spi_irq_handler left, arg unused */
+	TRACE_ERROR,			/**<Errors detected, arg is the spi_error_t mask */
+	TRACE_CONFIGURE,		/**<Channel set up for a transfer, arg is the resulting CR1 */
+	NUM_TRACE_EVENTS
+}spi_trace_event_t;
+
+/**
+ * A single trace record, as stored in the ring and in dumps (8 bytes, little endian)
+ */
+typedef struct
+{
+	uint32_t timestamp;		/**<Core clock cycles (DWT CYCCNT) from spi_trace_init to the event */
+	uint8_t event;			/**<spi_trace_event_t of the record */
+	uint8_t channel;		/**<spi_channel_t the event happened on */
+	uint16_t arg;			/**<Event specific argument */
+}spi_trace_record_t;
+
+#if SPI_TRACE_ENABLE
+#define SPI_TRACE(event, channel, arg)	spi_trace_record((event), (channel), (uint16_t)(arg))
+#else
+#define SPI_TRACE(event, channel, arg)	do { } while (0)
+#endif
+
+void spi_trace_init(void);
+void spi_trace_record(spi_trace_event_t event, spi_channel_t channel, uint16_t arg);
+uint32_t spi_trace_dump(spi_trace_record_t *records, uint32_t max_records);
+
+#endif
@@ -0,0 +1,203 @@
+/*******************************************************************************
+* Title                 :   SPI Resumable Transactions
+* Filename              :   spi_transaction.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_transaction.c
+ *  @brief Drives resumable device conversations one step per poll on top of the
+ *  	interrupt transfer queue.
+ */
+#include "spi_transaction.h"
+#include <assert.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+/******************************************************************************
+* Function: spi_transaction_start()
+*//**
+* \b Description:
+*
+* 	Binds a conversation to a transaction object and rewinds it to the top of its
+* 	step function. Nothing is sent until the first spi_transaction_poll.
+*
+* PRE-CONDITION: The transaction is not running
+*
+* POST-CONDITION: The transaction is running and will begin on the next poll
+*
+* @param		txn a pointer to the transaction object
+* @param		step the step function holding the conversation
+* @param		context device state handed to the step function through txn->context
+* @return 		void
+*
+* \b Example:
+* @code
+*	static spi_transaction_status_t flash_erase(spi_transaction_t *txn)
+*	{
+*		flash_t *flash = txn->context;
+*		SPI_TXN_BEGIN(txn);
+*		SPI_TXN_TRANSFER(txn, &flash->write_enable);
+*		SPI_TXN_TRANSFER(txn, &flash->sector_erase);
+*		do
+*		{
+*			SPI_TXN_TRANSFER(txn, &flash->read_status);
+*		} while (flash->status[1] & FLASH_WIP);
+*		SPI_TXN_END(txn);
+*	}
+*
+*	spi_transaction_start(&erase_txn, flash_erase, &flash);
+* @endcode
+*
+* @see spi_transaction_poll
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_transaction_start(spi_transaction_t *txn, spi_transaction_step_t step, void *context)
+{
+	assert(txn != NULL && step != NULL);
+	assert(txn->status != TXN_RUNNING);
+	txn->step = step;
+	txn->context = context;
+	txn->resume = 0;
+	txn->desc = SPI_DESC_NONE;
+	txn->status = TXN_RUNNING;
+}
+
+/******************************************************************************
+* Function: spi_transaction_poll()
+*//**
+* \b Description:
+*
+* 	Runs the conversation from where it last yielded up to its next yield, wait
+* 	or transfer. Never blocks, so any number of transactions can be polled in
+* 	turn from a superloop.
+*
+* PRE-CONDITION: spi_transaction_start() has been called on the transaction
+*
+* POST-CONDITION: The conversation has made whatever progress it could
+*
+* @param		txn a pointer to the transaction object
+* @return 		spi_transaction_status_t TXN_RUNNING until the conversation has ended
+*
+* \b Example:
+* @code
+*	while (1)
+*	{
+*		spi_transaction_poll(&erase_txn);
+*		spi_transaction_poll(&imu_txn);
+*		other_work();
+*	}
+* @endcode
+*
+* @see spi_transaction_start
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+spi_transaction_status_t spi_transaction_poll(spi_transaction_t *txn)
+{
+	assert(txn != NULL);
+	if (txn->status == TXN_RUNNING)
+	{
+		txn->status = txn->step(txn);
+	}
+	return (txn->status);
+}
+
+/******************************************************************************
+* Function: spi_transaction_transfer()
+*//**
+* \b Description:
+*
+* 	Moves one transfer of a conversation forward. The first call takes a
+* 	descriptor for the transfer and queues it, retrying on later polls while the
+* 	pool or the channel's queue is full; later calls check the descriptor's own
+* 	status, so completions reaped or discarded by other users of the channel
+* 	cannot be mistaken for it. The descriptor goes back to the pool once the
+* 	transfer has completed. The transfer structure itself is left untouched, so
+* 	it can be issued again.
+*
+* PRE-CONDITION: Called through SPI_TXN_TRANSFER from within a step function
+* PRE-CONDITION: The transfer is not modified until the call returns 1
+*
+* POST-CONDITION: The transfer has been queued, is still in progress, or has completed
+*
+* @param		txn a pointer to the transaction object
+* @param		transfer a pointer to the transfer structure containing all relevant
+* 					information for the transmission
+* @return 		uint8_t 1 once the transfer has completed, 0 otherwise
+*
+* \b Example:
+*	Called by SPI_TXN_TRANSFER on every poll until it returns 1
+*
+* @see spi_desc_submit
+* @see spi_desc_status
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint8_t spi_transaction_transfer(spi_transaction_t *txn, spi_transfer_t *transfer)
+{
+	assert(txn != NULL && transfer != NULL && transfer->channel < NUM_SPI);
+
+	if (txn->desc == SPI_DESC_NONE)
+	{
+		txn->desc = spi_desc_create(transfer);
+		if (txn->desc == SPI_DESC_NONE)
+		{
+			return (0);
+		}
+	}
+
+	spi_desc_status_t status = spi_desc_status(txn->desc);
+	if (status == SPI_DESC_IDLE)
+	{
+		(void)spi_desc_submit(txn->desc);
+		return (0);
+	}
+	if (status != SPI_DESC_DONE)
+	{
+		return (0);
+	}
+	spi_desc_destroy(txn->desc);
+	txn->desc = SPI_DESC_NONE;
+	return (1);
+}
@@ -0,0 +1,101 @@
+/*******************************************************************************
+* Title                 :   SPI Resumable Transactions
+* Filename              :   spi_transaction.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_transaction.h
+ *  @brief Stackless, resumable device conversations for superloops. A conversation
+ *  	is written as a step function between SPI_TXN_BEGIN and SPI_TXN_END, and is
+ *  	moved forward by spi_transaction_poll without ever blocking. Local variables
+ *  	of the step function do not survive a yield; keep state in the context.
+ */
+#ifndef _SPI_TRANSACTION_H
+#define _SPI_TRANSACTION_H
+
+#include "spi_interface.h"
+#include <stdint.h>
+
+/**
+ * Contains the states a transaction can be in
+ */
+typedef enum
+{
+	TXN_IDLE,		/**<The transaction has not been started */
+	TXN_RUNNING,	/**<The transaction is waiting on a transfer or a condition */
+	TXN_DONE		/**<The transaction has reached SPI_TXN_END */
+}spi_transaction_status_t;
+
+typedef struct spi_transaction spi_transaction_t;
+
+/**
+ * Step function typedef, holding the body of a conversation
+ */
+typedef spi_transaction_status_t (*spi_transaction_step_t)(spi_transaction_t *txn);
+
+/**
+ * Struct holding everything a conversation needs to be resumed
+ */
+struct spi_transaction
+{
+	spi_transaction_step_t step;		/**<Body of the conversation */
+	void *context;						/**<Device state, passed through untouched */
+	uint16_t resume;					/**<Line to resume at, 0 to begin (set by the macros) */
+	spi_desc_t desc;					/**<Descriptor of the transfer in progress, SPI_DESC_NONE between transfers (set by the driver) */
+	spi_transaction_status_t status;	/**<Current state of the transaction */
+};
+
+/**
+ * Opens the body of a step function
+ */
+#define SPI_TXN_BEGIN(txn)		switch ((txn)->resume) { case 0:
+
+/**
+ * Hands control back to the superloop, resuming here on the next poll
+ */
+#define SPI_TXN_YIELD(txn)		do { (txn)->resume = __LINE__; return (TXN_RUNNING); case __LINE__:; } while (0)
+
+/**
+ * Resumes here on every poll until the condition holds
+ */
+#define SPI_TXN_WAIT_UNTIL(txn, condition)	do { (txn)->resume = __LINE__; case __LINE__: \
+												if (!(condition)) { return (TXN_RUNNING); } } while (0)
+
+/**
+ * Queues an interrupt transfer and resumes here on every poll until it has completed
+ */
+#define SPI_TXN_TRANSFER(txn, transfer)		SPI_TXN_WAIT_UNTIL(txn, spi_transaction_transfer(txn, transfer))
+
+/**
+ * Closes the body of a step function
+ */
+#define SPI_TXN_END(txn)		} (txn)->resume = 0; return (TXN_DONE)
+
+void spi_transaction_start(spi_transaction_t *txn, spi_transaction_step_t step, void *context);
+spi_transaction_status_t spi_transaction_poll(spi_transaction_t *txn);
+uint8_t spi_transaction_transfer(spi_transaction_t *txn, spi_transfer_t *transfer);
+
+#endif
@@ -0,0 +1,1478 @@
+/*******************************************************************************
+* Title                 :   Host Simulation of the SPI Peripherals
+* Filename              :   spi_sim.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+/** @file spi_sim.c
+ *  @brief Host simulation of the spi peripherals and gpio pins. Every register
+ *  	access of the driver goes through spi_sim_access, which charges it a few
+ *  	cycles and first runs the device's shift engine up to the current cycle:
+ *  	frames move from DR to the shift register, take eight or sixteen SCK
+ *  	periods at the configured prescaler, and land in the receive buffer with
+ *  	TXE, RXNE, BSY and OVR following as on the part. Polled kernels, interrupt
+ *  	transfers and delay loops therefore all run against the same timing.
+ */
+#include "spi_sim.h"
+#include "stm32f411xe.h"
+#include <assert.h>
+#include <sched.h>
+#include <string.h>
+
+/**
+ * Redefinition of NULL macro in case stdlib isn't used by the rest of the project
+ */
+#ifndef NULL
+#define NULL (void*) 0
+#endif
+
+/**
+ * Bit above the frame which DR holds unless the driver has just written it. A
+ * cell found without it holds a frame to send
+ */
+#define SPI_SIM_MARK		0x10000UL
+
+/**
+ * Interrupts taken back to back by one service before the driver is assumed to
+ * be stuck
+ */
+#define SPI_SIM_GUARD		1000000UL
+
+/**
+ * Core clock cycles counted for every interrupt taken and every WFE
+ */
+#define SPI_SIM_CYCLES_PER_IRQ	64UL
+
+/**
+ * Core clock cycles counted for every access to a spi register. The bus is
+ * taken to run at the core clock, so SCK is the core clock over the prescaler
+ */
+#define SPI_SIM_ACCESS_CYCLES	2UL
+
+/**
+ * Frame clocked in on MISO while MOSI is not driven, in receive only modes
+ */
+#define SPI_SIM_IDLE_FRAME		0xFFFFU
+
+/**
+ * Status flags which spi_sim_raise can set and the driver clears
+ */
+#define SPI_SIM_ERRORS		(SPI_SR_CRCERR_Msk | SPI_SR_MODF_Msk | SPI_SR_OVR_Msk | SPI_SR_FRE_Msk)
+
+/**
+ * Slave models which can be attached at once
+ */
+#define SPI_SIM_MODELS		8U
+
+/**
+ * Everything the simulation keeps per spi device
+ */
+typedef struct
+{
+	uint8_t pending;				/**<The interrupt was pended by software */
+	spi_sim_responder_t responder;	/**<Produces the replies of unmodelled slaves, NULL echoes the frames back */
+	uint32_t frames;				/**<Frames shifted since the reset */
+	uint32_t accesses;				/**<Register accesses since the reset */
+	uint32_t stalls;				/**<Frames which waited on an empty transmit buffer after the previous one */
+	uint32_t aborts;				/**<Frames cut short by SPE being cleared before their last clock edge */
+	uint32_t flags;					/**<Error flags of SR which are set */
+	uint32_t CR1_seen;				/**<CR1 at the last look, to catch SPE changing */
+	uint8_t dr_touched;				/**<The last access was to DR and has not been looked at */
+	uint8_t sr_touched;				/**<The last access was to SR and has not been looked at */
+	uint8_t ovr_read;				/**<DR was read with OVR set, so a read of SR clears it */
+	uint8_t modf_read;				/**<SR was read with MODF set, so an access to CR1 clears it */
+	uint32_t dr_time;				/**<Cycle of the last access to DR */
+	uint8_t tx_full;				/**<The transmit buffer holds a frame */
+	uint16_t tx_frame;				/**<Frame in the transmit buffer */
+	uint32_t tx_time;				/**<Cycle the frame was written */
+	uint8_t shifting;				/**<A frame is in the shift register */
+	uint16_t shift_reply;			/**<Frame coming in while the frame is shifted out */
+	uint32_t shift_end;				/**<Cycle the frame in the shift register is done */
+	uint8_t settling;				/**<The last clock edge of the frame is still to come, so BSY stays set */
+	uint32_t settle_end;			/**<Cycle of that edge, half a clock after shift_end */
+	uint8_t running;				/**<A frame has been shifted since SPE was set */
+	uint32_t last_end;				/**<Cycle the shift register last became free */
+	uint8_t rx_full;				/**<The receive buffer holds a frame */
+	uint16_t rx_frame;				/**<Frame last received, which reads of DR return */
+}spi_sim_channel_t;
+
+/**
+ * A slave model and the channel and select pin it sits on
+ */
+typedef struct
+{
+	spi_model_t *model;				/**<The model, NULL for a free entry */
+	spi_channel_t channel;			/**<Channel the slave is wired to */
+	gpio_pin_t pin;					/**<Active low select of the slave */
+}spi_sim_attachment_t;
+
+static __IO uint32_t *spi_sim_access_spi1(uint32_t reg);
+static __IO uint32_t *spi_sim_access_spi2(uint32_t reg);
+static __IO uint32_t *spi_sim_access_spi3(uint32_t reg);
+static __IO uint32_t *spi_sim_access_spi4(uint32_t reg);
+static __IO uint32_t *spi_sim_access_spi5(uint32_t reg);
+static __IO uint32_t *spi_sim_cycle_access(void);
+static __IO uint32_t *spi_sim_access(spi_channel_t channel, uint32_t reg);
+static void spi_sim_look(spi_channel_t channel);
+static void spi_sim_step(spi_channel_t channel, uint32_t now);
+static void spi_sim_shift(spi_channel_t channel, uint32_t start, uint16_t mosi);
+static uint16_t spi_sim_reply(spi_channel_t channel, uint16_t mosi, uint32_t CR1_state);
+static uint16_t spi_sim_reverse(uint16_t frame, uint8_t bits);
+static void spi_sim_lock(void);
+static void spi_sim_unlock(void);
+
+/*
+ * Peripheral instances named by the stand-in device header, each with its hook
+ */
+SPI_TypeDef spi_sim_regs[5] =
+{
+	{spi_sim_access_spi1, {0}},
+	{spi_sim_access_spi2, {0}},
+	{spi_sim_access_spi3, {0}},
+	{spi_sim_access_spi4, {0}},
+	{spi_sim_access_spi5, {0}}
+};
+RCC_TypeDef spi_sim_rcc;
+DWT_Type spi_sim_dwt = {spi_sim_cycle_access, 0, 0};
+CoreDebug_Type spi_sim_core_debug;
+
+/**
+ * Interrupt lines of the spi devices, in channel order
+ */
+static const IRQn_Type spi_sim_irqns[NUM_SPI] = {SPI1_IRQn, SPI2_IRQn, SPI3_IRQn, SPI4_IRQn, SPI5_IRQn};
+
+/**
+ * Static array of the simulation state of each spi device
+ */
+static spi_sim_channel_t spi_sim_channels[NUM_SPI];
+
+/**
+ * Static array of the slave models wired to the channels
+ */
+static spi_sim_attachment_t spi_sim_attachments[SPI_SIM_MODELS];
+
+/**
+ * Set while another thread services the interrupts, so that WFE only yields
+ */
+static volatile uint8_t spi_sim_background;
+
+/**
+ * Held while the state of the simulation is looked at or changed, as the
+ * interrupts may be taken on a thread of their own
+ */
+static volatile uint8_t spi_sim_locked;
+
+/**
+ * Level of every gpio pin and the number of times it has been written
+ */
+static gpio_pin_state_t spi_sim_pins[NUM_GPIO_PINS];
+static uint32_t spi_sim_writes[NUM_GPIO_PINS];
+
+/******************************************************************************
+* Function: spi_sim_reset()
+*//**
+* \b Description:
+*
+* 	Clears the registers of the simulated peripherals and the cycle counter,
+* 	drops any responders and slave models and returns every pin to a high level
+* 	with no writes counted.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The simulation is as after power on, with select pins idle
+*
+* @param		None
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_sim_reset();
+*	spi_init(config_table);
+* @endcode
+*
+* @see spi_sim_service
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_sim_reset(void)
+{
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		memset((void *)spi_sim_regs[channel].cells, 0, sizeof(spi_sim_regs[channel].cells));
+		spi_sim_regs[channel].cells[SPI_SIM_SR] = SPI_SR_TXE_Msk;
+		spi_sim_regs[channel].cells[SPI_SIM_DR] = SPI_SIM_MARK;
+	}
+	memset(&spi_sim_rcc, 0, sizeof(spi_sim_rcc));
+	spi_sim_dwt.CTRL = 0;
+	spi_sim_dwt.cycles = 0;
+	memset(&spi_sim_core_debug, 0, sizeof(spi_sim_core_debug));
+	memset(spi_sim_channels, 0, sizeof(spi_sim_channels));
+	memset(spi_sim_attachments, 0, sizeof(spi_sim_attachments));
+	for (int pin = 0; pin < NUM_GPIO_PINS; pin++)
+	{
+		spi_sim_pins[pin] = GPIO_PIN_HIGH;
+		spi_sim_writes[pin] = 0;
+	}
+	spi_sim_background = 0;
+}
+
+/******************************************************************************
+* Function: spi_sim_service()
+*//**
+* \b Description:
+*
+* 	Takes the interrupts of a spi device for as long as one is asserted: a
+* 	software pend, TXEIE with the transmit buffer empty, RXNEIE with a frame
+* 	received, or ERRIE with an error flag set. While none is, but one is enabled
+* 	and a frame is being shifted, the core is taken to sleep until the frame is
+* 	done. Each interrupt costs SPI_SIM_CYCLES_PER_IRQ cycles on top of the
+* 	accesses the handler makes.
+*
+* PRE-CONDITION: spi_init() has been called on the channel
+*
+* POST-CONDITION: No interrupt of the channel is asserted, and none will be without further accesses
+*
+* @param		channel the spi device to service
+* @return 		void
+*
+* \b Example:
+*	Called by spi_sim_wfe and by the interrupt threads of the tests
+*
+* @see spi_irq_handler
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_sim_service(spi_channel_t channel)
+{
+	assert(channel < NUM_SPI);
+	SPI_TypeDef *spi = &spi_sim_regs[channel];
+	spi_sim_channel_t *sim = &spi_sim_channels[channel];
+	uint32_t guard = 0;
+
+	while (1)
+	{
+		spi_sim_lock();
+		spi_sim_look(channel);
+		uint8_t pending = __atomic_exchange_n(&sim->pending, 0, __ATOMIC_ACQ_REL);
+		uint32_t CR2_state = spi->cells[SPI_SIM_CR2];
+		uint8_t asserted = pending
+				|| ((CR2_state & SPI_CR2_TXEIE_Msk) && !sim->tx_full)
+				|| ((CR2_state & SPI_CR2_RXNEIE_Msk) && sim->rx_full)
+				|| ((CR2_state & SPI_CR2_ERRIE_Msk) && (__atomic_load_n(&sim->flags, __ATOMIC_ACQUIRE) & SPI_SIM_ERRORS));
+		if (!asserted)
+		{
+			uint8_t waiting = sim->shifting
+					&& (CR2_state & (SPI_CR2_TXEIE_Msk | SPI_CR2_RXNEIE_Msk | SPI_CR2_ERRIE_Msk)) != 0;
+			if (waiting)
+			{
+				uint32_t now = __atomic_load_n(&spi_sim_dwt.cycles, __ATOMIC_ACQUIRE);
+				while ((int32_t)(sim->shift_end - now) > 0
+						&& !__atomic_compare_exchange_n(&spi_sim_dwt.cycles, &now, sim->shift_end, 0,
+								__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+			}
+			spi_sim_unlock();
+			if (waiting)
+			{
+				continue;
+			}
+			break;
+		}
+		spi_sim_unlock();
+
+		assert(++guard < SPI_SIM_GUARD);
+		__atomic_fetch_add(&spi_sim_dwt.cycles, SPI_SIM_CYCLES_PER_IRQ, __ATOMIC_ACQ_REL);
+		spi_irq_handler(channel);
+	}
+}
+
+/******************************************************************************
+* Function: spi_sim_set_responder()
+*//**
+* \b Description:
+*
+* 	Replaces the echo of a spi device with a function producing the reply to
+* 	every frame sent while no attached slave model is selected. The responder
+* 	sees the frame as written to DR, cut to 8 bits when DFF is clear.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: Frames sent on the channel are answered by the responder
+*
+* @param		channel the spi device
+* @param		responder the function producing the replies, NULL to echo
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_sim_set_responder(SPI_1, sensor_reply);
+* @endcode
+*
+* @see spi_sim_attach
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_sim_set_responder(spi_channel_t channel, spi_sim_responder_t responder)
+{
+	assert(channel < NUM_SPI);
+	spi_sim_channels[channel].responder = responder;
+}
+
+/******************************************************************************
+* Function: spi_sim_attach()
+*//**
+* \b Description:
+*
+* 	Wires a slave model to a channel behind an active low select pin. Driving
+* 	the pin low selects the model and driving it high deselects it, and every
+* 	frame shifted while it is selected is exchanged with it on the wire: most
+* 	significant bit first unless LSBFIRST is set, 8 or 16 bits as DFF says. The
+* 	model must have been set up with spi_model_init.
+*
+* PRE-CONDITION: spi_model_init() has been called on the model
+*
+* POST-CONDITION: The model answers the frames sent while its select is low
+*
+* @param		channel the spi device the slave is wired to
+* @param		pin the select of the slave
+* @param		model a pointer to the model
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_model_init(&flash);
+*	spi_sim_attach(SPI_1, GPIO_A_4, &flash);
+* @endcode
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_sim_attach(spi_channel_t channel, gpio_pin_t pin, spi_model_t *model)
+{
+	assert(channel < NUM_SPI && pin < NUM_GPIO_PINS && model != NULL);
+	spi_sim_lock();
+	uint32_t free_entry = SPI_SIM_MODELS;
+	for (uint32_t i = 0; i < SPI_SIM_MODELS; i++)
+	{
+		if (spi_sim_attachments[i].model == NULL)
+		{
+			free_entry = i;
+			break;
+		}
+	}
+	assert(free_entry < SPI_SIM_MODELS);
+	spi_sim_attachments[free_entry].model = model;
+	spi_sim_attachments[free_entry].channel = channel;
+	spi_sim_attachments[free_entry].pin = pin;
+	if (spi_sim_pins[pin] == GPIO_PIN_LOW)
+	{
+		spi_model_select(model);
+	}
+	spi_sim_unlock();
+}
+
+/******************************************************************************
+* Function: spi_sim_set_background()
+*//**
+* \b Description:
+*
+* 	Selects whether the interrupts are serviced by a thread of their own.
+* 	Otherwise a WFE by the driver services every device before returning, which
+* 	lets single threaded tests sleep on interrupt transfers.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: WFE yields the thread if background is set, otherwise it services the devices
+*
+* @param		background 1 when a thread calls spi_sim_service, 0 otherwise
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_sim_set_background(1);
+*	pthread_create(&isr, NULL, isr_thread, NULL);
+* @endcode
+*
+* @see spi_sim_wfe
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_sim_set_background(uint8_t background)
+{
+	spi_sim_background = background;
+}
+
+/******************************************************************************
+* Function: spi_sim_raise()
+*//**
+* \b Description:
+*
+* 	Sets error flags in the status register of a spi device, as a fault on the
+* 	bus would. The driver clears them the way it does on the part: OVR by a read
+* 	of DR and then SR, CRCERR by writing it to 0, FRE by a read of SR and MODF
+* 	by a read of SR and then an access to CR1. It may be called from a
+* 	responder.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The flags read as set in SR
+*
+* @param		channel the spi device
+* @param		flags SPI_SR_OVR_Msk, SPI_SR_CRCERR_Msk, SPI_SR_MODF_Msk or SPI_SR_FRE_Msk
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_sim_raise(SPI_2, SPI_SR_OVR_Msk);
+* @endcode
+*
+* @see spi_sim_service
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_sim_raise(spi_channel_t channel, uint32_t flags)
+{
+	assert(channel < NUM_SPI && (flags & ~SPI_SIM_ERRORS) == 0);
+	__atomic_fetch_or(&spi_sim_channels[channel].flags, flags, __ATOMIC_ACQ_REL);
+}
+
+/******************************************************************************
+* Function: spi_sim_frames()
+*//**
+* \b Description:
+*
+* 	Returns the number of frames shifted by a spi device since the reset.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device
+* @return 		uint32_t the number of frames sent
+*
+* \b Example:
+* @code
+*	assert(spi_sim_frames(SPI_2) == 2 * transfers);
+* @endcode
+*
+* @see spi_sim_reset
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_sim_frames(spi_channel_t channel)
+{
+	assert(channel < NUM_SPI);
+	return (spi_sim_channels[channel].frames);
+}
+
+/******************************************************************************
+* Function: spi_sim_accesses()
+*//**
+* \b Description:
+*
+* 	Returns the number of accesses made to the registers of a spi device since
+* 	the reset, reads and writes alike.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device
+* @return 		uint32_t the number of register accesses
+*
+* \b Example:
+* @code
+*	uint32_t before = spi_sim_accesses(SPI_1);
+*	spi_transfer(&sensor_read);
+*	printf("%u accesses\n", spi_sim_accesses(SPI_1) - before);
+* @endcode
+*
+* @see spi_sim_reset
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_sim_accesses(spi_channel_t channel)
+{
+	assert(channel < NUM_SPI);
+	return (spi_sim_channels[channel].accesses);
+}
+
+/******************************************************************************
+* Function: spi_sim_stalls()
+*//**
+* \b Description:
+*
+* 	Returns the number of frames which found the shift register idle because the
+* 	driver had not refilled the transmit buffer in time, since the reset. The
+* 	first frame after SPE is set is not counted, so a kernel which keeps DR
+* 	loaded reports none.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device
+* @return 		uint32_t the number of stalled frames
+*
+* \b Example:
+* @code
+*	assert(spi_sim_stalls(SPI_1) == 0);
+* @endcode
+*
+* @see spi_sim_reset
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_sim_stalls(spi_channel_t channel)
+{
+	assert(channel < NUM_SPI);
+	return (spi_sim_channels[channel].stalls);
+}
+
+/******************************************************************************
+* Function: spi_sim_aborts()
+*//**
+* \b Description:
+*
+* 	Returns the number of frames which were cut short because SPE was cleared
+* 	while they were being shifted, or before BSY had cleared half a clock after
+* 	RXNE, since the reset.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device
+* @return 		uint32_t the number of aborted frames
+*
+* \b Example:
+* @code
+*	assert(spi_sim_aborts(SPI_2) == 0);
+* @endcode
+*
+* @see spi_sim_reset
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_sim_aborts(spi_channel_t channel)
+{
+	assert(channel < NUM_SPI);
+	return (spi_sim_channels[channel].aborts);
+}
+
+/******************************************************************************
+* Function: spi_sim_cycles()
+*//**
+* \b Description:
+*
+* 	Returns the simulated cycle counter without moving it on, unlike a read of
+* 	DWT->CYCCNT.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		None
+* @return 		uint32_t the current cycle
+*
+* \b Example:
+* @code
+*	uint32_t start = spi_sim_cycles();
+* @endcode
+*
+* @see spi_sim_service
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_sim_cycles(void)
+{
+	return (__atomic_load_n(&spi_sim_dwt.cycles, __ATOMIC_ACQUIRE));
+}
+
+/******************************************************************************
+* Function: spi_sim_pin()
+*//**
+* \b Description:
+*
+* 	Returns the level a gpio pin was last driven to.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		pin the gpio pin
+* @return 		gpio_pin_state_t the level of the pin
+*
+* \b Example:
+* @code
+*	assert(spi_sim_pin(GPIO_A_4) == GPIO_PIN_HIGH);
+* @endcode
+*
+* @see spi_sim_pin_writes
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+gpio_pin_state_t spi_sim_pin(gpio_pin_t pin)
+{
+	assert(pin < NUM_GPIO_PINS);
+	return (spi_sim_pins[pin]);
+}
+
+/******************************************************************************
+* Function: spi_sim_pin_writes()
+*//**
+* \b Description:
+*
+* 	Returns the number of times a gpio pin has been written since the reset.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		pin the gpio pin
+* @return 		uint32_t the number of writes
+*
+* \b Example:
+* @code
+*	assert(spi_sim_pin_writes(GPIO_A_4) == 2);
+* @endcode
+*
+* @see spi_sim_pin
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+uint32_t spi_sim_pin_writes(gpio_pin_t pin)
+{
+	assert(pin < NUM_GPIO_PINS);
+	return (spi_sim_writes[pin]);
+}
+
+/******************************************************************************
+* Function: spi_sim_pend()
+*//**
+* \b Description:
+*
+* 	Pends the interrupt of a spi device, as NVIC_SetPendingIRQ does on the
+* 	target. Other interrupt lines are ignored.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The next service of the device calls spi_irq_handler
+*
+* @param		irqn the interrupt line
+* @return 		void
+*
+* \b Example:
+*	Called by NVIC_SetPendingIRQ
+*
+* @see spi_sim_service
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_sim_pend(IRQn_Type irqn)
+{
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		if (spi_sim_irqns[channel] == irqn)
+		{
+			__atomic_store_n(&spi_sim_channels[channel].pending, 1, __ATOMIC_RELEASE);
+		}
+	}
+}
+
+/******************************************************************************
+* Function: spi_sim_wfe()
+*//**
+* \b Description:
+*
+* 	Stands in for WFE. Without a background thread every spi device is serviced,
+* 	as if the core had slept until its interrupts were taken.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		None
+* @return 		void
+*
+* \b Example:
+*	Called by __WFE
+*
+* @see spi_sim_set_background
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void spi_sim_wfe(void)
+{
+	__atomic_fetch_add(&spi_sim_dwt.cycles, SPI_SIM_CYCLES_PER_IRQ, __ATOMIC_ACQ_REL);
+	if (spi_sim_background)
+	{
+		sched_yield();
+		return;
+	}
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		spi_sim_service((spi_channel_t)channel);
+	}
+}
+
+/******************************************************************************
+* Function: gpio_pin_read()
+*//**
+* \b Description:
+*
+* 	Returns the level a pin was last driven to.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		pin the gpio pin
+* @return 		gpio_pin_state_t the level of the pin
+*
+* \b Example:
+*	Called by the drivers under test
+*
+* @see gpio_pin_write
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+gpio_pin_state_t gpio_pin_read(gpio_pin_t pin)
+{
+	return (spi_sim_pin(pin));
+}
+
+/******************************************************************************
+* Function: gpio_pin_write()
+*//**
+* \b Description:
+*
+* 	Drives a pin and counts the write. The spi devices are first run up to the
+* 	current cycle, so frames started before the write are exchanged with the
+* 	slave as it was. A slave model attached to the pin is selected when it goes
+* 	low and deselected when it goes high.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The pin is at the level given
+*
+* @param		pin the gpio pin
+* @param		value the level to drive
+* @return 		void
+*
+* \b Example:
+*	Called by the drivers under test
+*
+* @see gpio_pin_read
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void gpio_pin_write(gpio_pin_t pin, gpio_pin_state_t value)
+{
+	assert(pin < NUM_GPIO_PINS);
+	spi_sim_lock();
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		spi_sim_look((spi_channel_t)channel);
+	}
+
+	gpio_pin_state_t previous = spi_sim_pins[pin];
+	spi_sim_pins[pin] = value;
+	spi_sim_writes[pin]++;
+	for (uint32_t i = 0; i < SPI_SIM_MODELS && previous != value; i++)
+	{
+		spi_sim_attachment_t *attachment = &spi_sim_attachments[i];
+		if (attachment->model == NULL || attachment->pin != pin)
+		{
+			continue;
+		}
+		if (value == GPIO_PIN_LOW)
+		{
+			spi_model_select(attachment->model);
+		}
+		else
+		{
+			spi_model_deselect(attachment->model);
+		}
+	}
+	spi_sim_unlock();
+}
+
+/******************************************************************************
+* Function: gpio_pin_toggle()
+*//**
+* \b Description:
+*
+* 	Drives a pin to the opposite level and counts the write.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The pin has changed level
+*
+* @param		pin the gpio pin
+* @return 		void
+*
+* \b Example:
+*	Called by the drivers under test
+*
+* @see gpio_pin_write
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void gpio_pin_toggle(gpio_pin_t pin)
+{
+	gpio_pin_write(pin, (spi_sim_pin(pin) == GPIO_PIN_HIGH) ? GPIO_PIN_LOW : GPIO_PIN_HIGH);
+}
+
+/******************************************************************************
+* Function: spi_sim_access_spi1()
+*//**
+* \b Description:
+*
+* 	Static functions which are the access hooks of SPI1 to SPI5. The device
+* 	header has no way to name the device an access is made through, so each
+* 	instance carries a hook of its own, which passes its channel on.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		reg the register accessed, SPI_SIM_CR1 to SPI_SIM_I2SPR
+* @return 		__IO uint32_t * the cell of the register
+*
+* \b Example:
+*	Called through spi->CR1, spi->SR, spi->DR and the other register names
+*
+* @see spi_sim_access
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static __IO uint32_t *spi_sim_access_spi1(uint32_t reg)
+{
+	return (spi_sim_access(SPI_1, reg));
+}
+
+static __IO uint32_t *spi_sim_access_spi2(uint32_t reg)
+{
+	return (spi_sim_access(SPI_2, reg));
+}
+
+static __IO uint32_t *spi_sim_access_spi3(uint32_t reg)
+{
+	return (spi_sim_access(SPI_3, reg));
+}
+
+static __IO uint32_t *spi_sim_access_spi4(uint32_t reg)
+{
+	return (spi_sim_access(SPI_4, reg));
+}
+
+static __IO uint32_t *spi_sim_access_spi5(uint32_t reg)
+{
+	return (spi_sim_access(SPI_5, reg));
+}
+
+/******************************************************************************
+* Function: spi_sim_cycle_access()
+*//**
+* \b Description:
+*
+* 	Static function which is the access hook of DWT->CYCCNT. Each access moves
+* 	the counter on by a cycle, standing in for the time taken by the loop
+* 	reading it.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		None
+* @return 		__IO uint32_t * the cell of the counter
+*
+* \b Example:
+*	Called through DWT->CYCCNT
+*
+* @see spi_sim_cycles
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static __IO uint32_t *spi_sim_cycle_access(void)
+{
+	__atomic_fetch_add(&spi_sim_dwt.cycles, 1, __ATOMIC_ACQ_REL);
+	return (&spi_sim_dwt.cycles);
+}
+
+/******************************************************************************
+* Function: spi_sim_access()
+*//**
+* \b Description:
+*
+* 	Static function run before every access to a register of a spi device. The
+* 	previous access is settled and the device run up to the current cycle, so
+* 	that SR reads as it would at this moment; the access is then noted, counted
+* 	and charged SPI_SIM_ACCESS_CYCLES. Reads and writes of DR cannot be told
+* 	apart here, so the next look settles which it was.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device
+* @param		reg the register accessed
+* @return 		__IO uint32_t * the cell of the register
+*
+* \b Example:
+*	Called by spi_sim_access_spi1 to spi_sim_access_spi5
+*
+* @see spi_sim_look
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static __IO uint32_t *spi_sim_access(spi_channel_t channel, uint32_t reg)
+{
+	assert(reg < SPI_SIM_REGISTERS);
+	spi_sim_channel_t *sim = &spi_sim_channels[channel];
+
+	spi_sim_lock();
+	spi_sim_look(channel);
+	sim->accesses++;
+	if (reg == SPI_SIM_DR)
+	{
+		sim->dr_touched = 1;
+		sim->dr_time = spi_sim_dwt.cycles;
+	}
+	else if (reg == SPI_SIM_SR)
+	{
+		sim->sr_touched = 1;
+	}
+	else if (reg == SPI_SIM_CR1 && sim->modf_read)
+	{
+		__atomic_fetch_and(&sim->flags, ~SPI_SR_MODF_Msk, __ATOMIC_ACQ_REL);
+		sim->modf_read = 0;
+	}
+	spi_sim_unlock();
+
+	__atomic_fetch_add(&spi_sim_dwt.cycles, SPI_SIM_ACCESS_CYCLES, __ATOMIC_ACQ_REL);
+	return (&spi_sim_regs[channel].cells[reg]);
+}
+
+/******************************************************************************
+* Function: spi_sim_look()
+*//**
+* \b Description:
+*
+* 	Static function which settles the last access to a spi device and runs it up
+* 	to the current cycle. A DR cell found without SPI_SIM_MARK was written: the
+* 	frame goes into the transmit buffer and the cell is given back the received
+* 	frame. A DR access which left the mark was a read, which empties the receive
+* 	buffer. SPE being set starts a fresh run of frames, and SPE being cleared
+* 	cuts off a frame being shifted. SR is then brought up to date.
+*
+* PRE-CONDITION: The simulation is locked
+*
+* POST-CONDITION: SR holds the state of the device at the current cycle
+*
+* @param		channel the spi device
+* @return 		void
+*
+* \b Example:
+*	Called by spi_sim_access, spi_sim_service and gpio_pin_write
+*
+* @see spi_sim_step
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_sim_look(spi_channel_t channel)
+{
+	SPI_TypeDef *spi = &spi_sim_regs[channel];
+	spi_sim_channel_t *sim = &spi_sim_channels[channel];
+	uint32_t now = spi_sim_dwt.cycles;
+
+	uint32_t DR_state = spi->cells[SPI_SIM_DR];
+	if ((DR_state & SPI_SIM_MARK) == 0)
+	{
+		sim->tx_full = 1;
+		sim->tx_frame = (uint16_t)DR_state;
+		sim->tx_time = sim->dr_time;
+		spi->cells[SPI_SIM_DR] = SPI_SIM_MARK | sim->rx_frame;
+	}
+	else if (sim->dr_touched)
+	{
+		sim->rx_full = 0;
+		sim->ovr_read = (__atomic_load_n(&sim->flags, __ATOMIC_ACQUIRE) & SPI_SR_OVR_Msk) != 0;
+	}
+	sim->dr_touched = 0;
+
+	if (sim->sr_touched)
+	{
+		uint32_t cleared = SPI_SR_FRE_Msk;
+		sim->modf_read = (__atomic_load_n(&sim->flags, __ATOMIC_ACQUIRE) & SPI_SR_MODF_Msk) != 0;
+		if (sim->ovr_read)
+		{
+			cleared |= SPI_SR_OVR_Msk;
+			sim->ovr_read = 0;
+		}
+		if ((spi->cells[SPI_SIM_SR] & SPI_SR_CRCERR_Msk) == 0)
+		{
+			cleared |= SPI_SR_CRCERR_Msk;
+		}
+		__atomic_fetch_and(&sim->flags, ~cleared, __ATOMIC_ACQ_REL);
+		sim->sr_touched = 0;
+	}
+
+	uint32_t CR1_state = spi->cells[SPI_SIM_CR1];
+	if ((CR1_state & ~sim->CR1_seen) & SPI_CR1_SPE_Msk)
+	{
+		sim->running = 0;
+		sim->last_end = now;
+	}
+	else if ((sim->CR1_seen & ~CR1_state) & SPI_CR1_SPE_Msk)
+	{
+		spi_sim_step(channel, now);
+		if (sim->settling && (int32_t)(now - sim->settle_end) >= 0)
+		{
+			sim->settling = 0;
+		}
+		if (sim->shifting || sim->settling)
+		{
+			sim->shifting = 0;
+			sim->settling = 0;
+			sim->aborts++;
+		}
+		sim->running = 0;
+	}
+	sim->CR1_seen = CR1_state;
+	spi_sim_step(channel, now);
+	if (sim->settling && (int32_t)(now - sim->settle_end) >= 0)
+	{
+		sim->settling = 0;
+	}
+
+	uint32_t SR_state = __atomic_load_n(&sim->flags, __ATOMIC_ACQUIRE);
+	if (!sim->tx_full)
+	{
+		SR_state |= SPI_SR_TXE_Msk;
+	}
+	if (sim->rx_full)
+	{
+		SR_state |= SPI_SR_RXNE_Msk;
+	}
+	if ((CR1_state & SPI_CR1_SPE_Msk) && (sim->shifting || sim->settling || sim->tx_full))
+	{
+		SR_state |= SPI_SR_BSY_Msk;
+	}
+	spi->cells[SPI_SIM_SR] = SR_state;
+}
+
+/******************************************************************************
+* Function: spi_sim_step()
+*//**
+* \b Description:
+*
+* 	Static function which runs the shift engine of a spi device up to a cycle. A
+* 	frame whose last SCK period has passed lands in the receive buffer, or
+* 	raises OVR if the buffer is still full, and frees the shift register. The
+* 	free shift register then takes the frame in the transmit buffer, counting a
+* 	stall if the frame was written after the shift register ran dry, then the
+* 	CRC frame once CRCNEXT is set, and in receive only modes a frame whenever
+* 	the receive buffer is empty. Nothing is shifted while SPE is clear.
+*
+* PRE-CONDITION: The simulation is locked
+*
+* POST-CONDITION: The device is as it would be at the cycle given
+*
+* @param		channel the spi device
+* @param		now the cycle to run up to
+* @return 		void
+*
+* \b Example:
+*	Called by spi_sim_look
+*
+* @see spi_sim_shift
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_sim_step(spi_channel_t channel, uint32_t now)
+{
+	SPI_TypeDef *spi = &spi_sim_regs[channel];
+	spi_sim_channel_t *sim = &spi_sim_channels[channel];
+
+	while (1)
+	{
+		uint32_t CR1_state = spi->cells[SPI_SIM_CR1];
+		uint32_t bidir = CR1_state & SPI_CR1_BIDIMODE_Msk;
+		if (sim->shifting)
+		{
+			if ((int32_t)(now - sim->shift_end) < 0)
+			{
+				break;
+			}
+			sim->shifting = 0;
+			sim->last_end = sim->shift_end;
+			if (bidir && (CR1_state & SPI_CR1_BIDIOE_Msk))
+			{
+				continue;
+			}
+			if (sim->rx_full)
+			{
+				__atomic_fetch_or(&sim->flags, SPI_SR_OVR_Msk, __ATOMIC_ACQ_REL);
+			}
+			else
+			{
+				sim->rx_full = 1;
+				sim->rx_frame = sim->shift_reply;
+				spi->cells[SPI_SIM_DR] = SPI_SIM_MARK | sim->rx_frame;
+			}
+			continue;
+		}
+
+		if ((CR1_state & SPI_CR1_SPE_Msk) == 0)
+		{
+			break;
+		}
+		uint8_t receive_only = (CR1_state & SPI_CR1_MSTR_Msk)
+				&& ((CR1_state & SPI_CR1_RXONLY_Msk) || (bidir && !(CR1_state & SPI_CR1_BIDIOE_Msk)));
+		if (sim->tx_full && !receive_only)
+		{
+			uint32_t start = sim->last_end;
+			if ((int32_t)(sim->tx_time - start) > 0)
+			{
+				if (sim->running)
+				{
+					sim->stalls++;
+				}
+				start = sim->tx_time;
+			}
+			sim->tx_full = 0;
+			spi_sim_shift(channel, start, sim->tx_frame);
+		}
+		else if ((CR1_state & SPI_CR1_CRCEN_Msk) && (CR1_state & SPI_CR1_CRCNEXT_Msk) && sim->running)
+		{
+			spi->cells[SPI_SIM_CR1] = CR1_state & ~SPI_CR1_CRCNEXT_Msk;
+			spi_sim_shift(channel, sim->last_end, (uint16_t)spi->cells[SPI_SIM_TXCRCR]);
+		}
+		else if (receive_only && !sim->rx_full)
+		{
+			uint32_t start = ((int32_t)(now - sim->last_end) > 0) ? now : sim->last_end;
+			spi_sim_shift(channel, start, SPI_SIM_IDLE_FRAME);
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+/******************************************************************************
+* Function: spi_sim_shift()
+*//**
+* \b Description:
+*
+* 	Static function which puts a frame in the shift register at a given cycle.
+* 	It is done after eight or sixteen periods of SCK, which is the core clock
+* 	divided by the prescaler in BR, and the frame coming in is worked out at
+* 	once.
+*
+* PRE-CONDITION: The simulation is locked
+*
+* POST-CONDITION: A frame is being shifted
+*
+* @param		channel the spi device
+* @param		start the cycle the first SCK edge is given
+* @param		mosi the frame sent
+* @return 		void
+*
+* \b Example:
+*	Called by spi_sim_step
+*
+* @see spi_sim_reply
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_sim_shift(spi_channel_t channel, uint32_t start, uint16_t mosi)
+{
+	spi_sim_channel_t *sim = &spi_sim_channels[channel];
+	uint32_t CR1_state = spi_sim_regs[channel].cells[SPI_SIM_CR1];
+	uint32_t bits = (CR1_state & SPI_CR1_DFF_Msk) ? 16U : 8U;
+	uint32_t prescaler = 2UL << ((CR1_state & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos);
+
+	sim->shifting = 1;
+	sim->shift_end = start + bits * prescaler;
+	sim->settling = 1;
+	sim->settle_end = sim->shift_end + prescaler / 2U;
+	sim->shift_reply = spi_sim_reply(channel, mosi, CR1_state);
+	sim->frames++;
+	sim->running = 1;
+}
+
+/******************************************************************************
+* Function: spi_sim_reply()
+*//**
+* \b Description:
+*
+* 	Static function which works out the frame clocked in for a frame sent. A
+* 	selected slave model on the channel is given the frame as it goes over the
+* 	wire, so its bits are reversed around the exchange when LSBFIRST is set.
+* 	With no slave selected the responder, or else the echo, answers.
+*
+* PRE-CONDITION: The simulation is locked
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device
+* @param		mosi the frame sent
+* @param		CR1_state CR1 of the device
+* @return 		uint16_t the frame received, cut to 8 bits when DFF is clear
+*
+* \b Example:
+*	Called by spi_sim_shift
+*
+* @see spi_sim_attach
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t spi_sim_reply(spi_channel_t channel, uint16_t mosi, uint32_t CR1_state)
+{
+	uint8_t bits = (CR1_state & SPI_CR1_DFF_Msk) ? 16U : 8U;
+	uint16_t mask = (bits == 16U) ? 0xFFFFU : 0x00FFU;
+	uint8_t lsb_first = (CR1_state & SPI_CR1_LSBFIRST_Msk) != 0;
+	mosi &= mask;
+
+	for (uint32_t i = 0; i < SPI_SIM_MODELS; i++)
+	{
+		spi_sim_attachment_t *attachment = &spi_sim_attachments[i];
+		if (attachment->model == NULL || attachment->channel != channel || !attachment->model->selected)
+		{
+			continue;
+		}
+		uint16_t wire = lsb_first ? spi_sim_reverse(mosi, bits) : mosi;
+		uint16_t miso = spi_model_exchange(attachment->model, wire, bits);
+		return ((lsb_first ? spi_sim_reverse(miso, bits) : miso) & mask);
+	}
+
+	spi_sim_responder_t responder = spi_sim_channels[channel].responder;
+	return (((responder != NULL) ? responder(channel, mosi) : mosi) & mask);
+}
+
+/******************************************************************************
+* Function: spi_sim_reverse()
+*//**
+* \b Description:
+*
+* 	Static function which reverses the order of the bits of a frame.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		frame the frame
+* @param		bits the width of the frame, 8 or 16
+* @return 		uint16_t the frame with its bits reversed
+*
+* \b Example:
+*	Called by spi_sim_reply
+*
+* @see spi_sim_reply
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t spi_sim_reverse(uint16_t frame, uint8_t bits)
+{
+	uint16_t reversed = 0;
+	for (uint8_t i = 0; i < bits; i++)
+	{
+		reversed = (uint16_t)((reversed << 1) | ((frame >> i) & 1U));
+	}
+	return (reversed);
+}
+
+/******************************************************************************
+* Function: spi_sim_lock()
+*//**
+* \b Description:
+*
+* 	Static function which takes the lock of the simulation, yielding while
+* 	another thread holds it.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The calling thread holds the lock
+*
+* @param		None
+* @return 		void
+*
+* \b Example:
+*	Called around every look at the state of the simulation
+*
+* @see spi_sim_unlock
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_sim_lock(void)
+{
+	while (__atomic_test_and_set(&spi_sim_locked, __ATOMIC_ACQUIRE))
+	{
+		sched_yield();
+	}
+}
+
+/******************************************************************************
+* Function: spi_sim_unlock()
+*//**
+* \b Description:
+*
+* 	Static function which gives the lock of the simulation back.
+*
+* PRE-CONDITION: The calling thread holds the lock
+*
+* POST-CONDITION: The lock is free
+*
+* @param		None
+* @return 		void
+*
+* \b Example:
+*	Called after every look at the state of the simulation
+*
+* @see spi_sim_lock
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void spi_sim_unlock(void)
+{
+	__atomic_clear(&spi_sim_locked, __ATOMIC_RELEASE);
+}
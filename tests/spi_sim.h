@@ -0,0 +1,62 @@
+/*******************************************************************************
+* Title                 :   Host Simulation of the SPI Peripherals
+* Filename              :   spi_sim.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_sim.h
+ *  @brief Host simulation of the spi peripherals and gpio pins, so the driver can
+ *  	run its polled and interrupt transfers off target. Each device shifts its
+ *  	frames in simulated cycles; the replies come from slave models attached to
+ *  	select pins, from a responder, or are the frames echoed back.
+ */
+#ifndef _SPI_SIM_H
+#define _SPI_SIM_H
+
+#include "spi_interface.h"
+#include "spi_model.h"
+#include <stdint.h>
+
+/**
+ * Produces the frame received for a frame sent on a channel
+ */
+typedef uint16_t (*spi_sim_responder_t)(spi_channel_t channel, uint16_t frame);
+
+void spi_sim_reset(void);
+void spi_sim_service(spi_channel_t channel);
+void spi_sim_set_responder(spi_channel_t channel, spi_sim_responder_t responder);
+void spi_sim_attach(spi_channel_t channel, gpio_pin_t pin, spi_model_t *model);
+void spi_sim_set_background(uint8_t background);
+void spi_sim_raise(spi_channel_t channel, uint32_t flags);
+uint32_t spi_sim_frames(spi_channel_t channel);
+uint32_t spi_sim_accesses(spi_channel_t channel);
+uint32_t spi_sim_stalls(spi_channel_t channel);
+uint32_t spi_sim_aborts(spi_channel_t channel);
+uint32_t spi_sim_cycles(void);
+gpio_pin_state_t spi_sim_pin(gpio_pin_t pin);
+uint32_t spi_sim_pin_writes(gpio_pin_t pin);
+
+#endif
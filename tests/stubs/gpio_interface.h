@@ -0,0 +1,140 @@
+/*******************************************************************************
+* Title                 :   Host Stand-in for the GPIO Interface
+* Filename              :   gpio_interface.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file gpio_interface.h
+ *  @brief The part of the gpio driver's interface used by the spi driver. The
+ *  	pin writes land in spi_sim.c, which tracks the level of every pin.
+ */
+#ifndef _GPIO_H
+#define _GPIO_H
+
+#include <stdint.h>
+
+/**
+ * Contains the pins of ports A to E
+ */
+typedef enum
+{
+	GPIO_A_0 = 0,
+	GPIO_A_1,
+	GPIO_A_2,
+	GPIO_A_3,
+	GPIO_A_4,
+	GPIO_A_5,
+	GPIO_A_6,
+	GPIO_A_7,
+	GPIO_A_8,
+	GPIO_A_9,
+	GPIO_A_10,
+	GPIO_A_11,
+	GPIO_A_12,
+	GPIO_A_13,
+	GPIO_A_14,
+	GPIO_A_15,
+	GPIO_B_0,
+	GPIO_B_1,
+	GPIO_B_2,
+	GPIO_B_3,
+	GPIO_B_4,
+	GPIO_B_5,
+	GPIO_B_6,
+	GPIO_B_7,
+	GPIO_B_8,
+	GPIO_B_9,
+	GPIO_B_10,
+	GPIO_B_11,
+	GPIO_B_12,
+	GPIO_B_13,
+	GPIO_B_14,
+	GPIO_B_15,
+	GPIO_C_0,
+	GPIO_C_1,
+	GPIO_C_2,
+	GPIO_C_3,
+	GPIO_C_4,
+	GPIO_C_5,
+	GPIO_C_6,
+	GPIO_C_7,
+	GPIO_C_8,
+	GPIO_C_9,
+	GPIO_C_10,
+	GPIO_C_11,
+	GPIO_C_12,
+	GPIO_C_13,
+	GPIO_C_14,
+	GPIO_C_15,
+	GPIO_D_0,
+	GPIO_D_1,
+	GPIO_D_2,
+	GPIO_D_3,
+	GPIO_D_4,
+	GPIO_D_5,
+	GPIO_D_6,
+	GPIO_D_7,
+	GPIO_D_8,
+	GPIO_D_9,
+	GPIO_D_10,
+	GPIO_D_11,
+	GPIO_D_12,
+	GPIO_D_13,
+	GPIO_D_14,
+	GPIO_D_15,
+	GPIO_E_0,
+	GPIO_E_1,
+	GPIO_E_2,
+	GPIO_E_3,
+	GPIO_E_4,
+	GPIO_E_5,
+	GPIO_E_6,
+	GPIO_E_7,
+	GPIO_E_8,
+	GPIO_E_9,
+	GPIO_E_10,
+	GPIO_E_11,
+	GPIO_E_12,
+	GPIO_E_13,
+	GPIO_E_14,
+	GPIO_E_15,
+	NUM_GPIO_PINS
+}gpio_pin_t;
+
+/**
+ * Contains the logic levels of a pin
+ */
+typedef enum
+{
+	GPIO_PIN_LOW = 0UL,
+	GPIO_PIN_HIGH = 1UL
+}gpio_pin_state_t;
+
+gpio_pin_state_t gpio_pin_read(gpio_pin_t pin);
+void gpio_pin_write(gpio_pin_t pin, gpio_pin_state_t value);
+void gpio_pin_toggle(gpio_pin_t pin);
+
+#endif
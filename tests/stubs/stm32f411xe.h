@@ -0,0 +1,245 @@
+/*******************************************************************************
+* Title                 :   Host Stand-in for the STM32F411 Device Header
+* Filename              :   stm32f411xe.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file stm32f411xe.h
+ *  @brief Just enough of the CMSIS device header for the driver to build on a
+ *  	host. Every access to a spi register or to the cycle counter goes through
+ *  	a hook in spi_sim.c, which runs the simulated hardware up to that moment,
+ *  	and the core intrinsics map onto gcc builtins.
+ */
+#ifndef _STM32F411XE_SIM_H
+#define _STM32F411XE_SIM_H
+
+#include <stdint.h>
+
+#define __IO volatile
+
+#define PERIPH_BASE			0x40000000UL
+#define APB1PERIPH_BASE		PERIPH_BASE
+#define APB2PERIPH_BASE		(PERIPH_BASE + 0x00010000UL)
+#define AHB1PERIPH_BASE		(PERIPH_BASE + 0x00020000UL)
+#define SPI2_BASE			(APB1PERIPH_BASE + 0x3800UL)
+#define SPI3_BASE			(APB1PERIPH_BASE + 0x3C00UL)
+#define I2S3ext_BASE		(APB1PERIPH_BASE + 0x4000UL)
+#define SPI1_BASE			(APB2PERIPH_BASE + 0x3000UL)
+#define SPI4_BASE			(APB2PERIPH_BASE + 0x3400UL)
+#define SYSCFG_BASE			(APB2PERIPH_BASE + 0x3800UL)
+#define SPI5_BASE			(APB2PERIPH_BASE + 0x5000UL)
+#define GPIOA_BASE			(AHB1PERIPH_BASE + 0x0000UL)
+
+#define SPI_CR1_CPHA_Pos		0U
+#define SPI_CR1_CPHA_Msk		(1UL << SPI_CR1_CPHA_Pos)
+#define SPI_CR1_CPOL_Pos		1U
+#define SPI_CR1_CPOL_Msk		(1UL << SPI_CR1_CPOL_Pos)
+#define SPI_CR1_MSTR_Pos		2U
+#define SPI_CR1_MSTR_Msk		(1UL << SPI_CR1_MSTR_Pos)
+#define SPI_CR1_BR_Pos			3U
+#define SPI_CR1_BR_Msk			(7UL << SPI_CR1_BR_Pos)
+#define SPI_CR1_SPE_Pos			6U
+#define SPI_CR1_SPE_Msk			(1UL << SPI_CR1_SPE_Pos)
+#define SPI_CR1_LSBFIRST_Pos	7U
+#define SPI_CR1_LSBFIRST_Msk	(1UL << SPI_CR1_LSBFIRST_Pos)
+#define SPI_CR1_SSI_Pos			8U
+#define SPI_CR1_SSI_Msk			(1UL << SPI_CR1_SSI_Pos)
+#define SPI_CR1_SSM_Pos			9U
+#define SPI_CR1_SSM_Msk			(1UL << SPI_CR1_SSM_Pos)
+#define SPI_CR1_RXONLY_Pos		10U
+#define SPI_CR1_RXONLY_Msk		(1UL << SPI_CR1_RXONLY_Pos)
+#define SPI_CR1_DFF_Pos			11U
+#define SPI_CR1_DFF_Msk			(1UL << SPI_CR1_DFF_Pos)
+#define SPI_CR1_CRCNEXT_Pos		12U
+#define SPI_CR1_CRCNEXT_Msk		(1UL << SPI_CR1_CRCNEXT_Pos)
+#define SPI_CR1_CRCEN_Pos		13U
+#define SPI_CR1_CRCEN_Msk		(1UL << SPI_CR1_CRCEN_Pos)
+#define SPI_CR1_BIDIOE_Pos		14U
+#define SPI_CR1_BIDIOE_Msk		(1UL << SPI_CR1_BIDIOE_Pos)
+#define SPI_CR1_BIDIMODE_Pos	15U
+#define SPI_CR1_BIDIMODE_Msk	(1UL << SPI_CR1_BIDIMODE_Pos)
+#define SPI_CR2_RXDMAEN_Pos		0U
+#define SPI_CR2_RXDMAEN_Msk		(1UL << SPI_CR2_RXDMAEN_Pos)
+#define SPI_CR2_TXDMAEN_Pos		1U
+#define SPI_CR2_TXDMAEN_Msk		(1UL << SPI_CR2_TXDMAEN_Pos)
+#define SPI_CR2_SSOE_Pos		2U
+#define SPI_CR2_SSOE_Msk		(1UL << SPI_CR2_SSOE_Pos)
+#define SPI_CR2_FRF_Pos			4U
+#define SPI_CR2_FRF_Msk			(1UL << SPI_CR2_FRF_Pos)
+#define SPI_CR2_ERRIE_Pos		5U
+#define SPI_CR2_ERRIE_Msk		(1UL << SPI_CR2_ERRIE_Pos)
+#define SPI_CR2_RXNEIE_Pos		6U
+#define SPI_CR2_RXNEIE_Msk		(1UL << SPI_CR2_RXNEIE_Pos)
+#define SPI_CR2_TXEIE_Pos		7U
+#define SPI_CR2_TXEIE_Msk		(1UL << SPI_CR2_TXEIE_Pos)
+#define SPI_SR_RXNE_Msk			(1UL << 0)
+#define SPI_SR_TXE_Msk			(1UL << 1)
+#define SPI_SR_CRCERR_Msk		(1UL << 4)
+#define SPI_SR_MODF_Msk			(1UL << 5)
+#define SPI_SR_OVR_Msk			(1UL << 6)
+#define SPI_SR_BSY_Msk			(1UL << 7)
+#define SPI_SR_FRE_Msk			(1UL << 8)
+#define SPI_SR_BSY				SPI_SR_BSY_Msk
+
+#define RCC_APB1ENR_SPI2EN_Msk		(1UL << 14)
+#define RCC_APB1ENR_SPI3EN_Msk		(1UL << 15)
+#define RCC_APB2ENR_SPI1EN_Msk		(1UL << 12)
+#define RCC_APB2ENR_SPI4EN_Msk		(1UL << 13)
+#define RCC_APB2ENR_SPI5EN_Msk		(1UL << 20)
+#define CoreDebug_DEMCR_TRCENA_Msk	(1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk		1UL
+
+typedef enum
+{
+	TIM2_IRQn = 28,
+	SPI1_IRQn = 35,
+	SPI2_IRQn = 36,
+	SPI3_IRQn = 51,
+	SPI4_IRQn = 84,
+	SPI5_IRQn = 85
+}IRQn_Type;
+
+/*
+ * The registers of a spi device, in the order of its memory map
+ */
+enum
+{
+	SPI_SIM_CR1, SPI_SIM_CR2, SPI_SIM_SR, SPI_SIM_DR, SPI_SIM_CRCPR, SPI_SIM_RXCRCR,
+	SPI_SIM_TXCRCR, SPI_SIM_I2SCFGR, SPI_SIM_I2SPR, SPI_SIM_REGISTERS
+};
+
+/*
+ * A spi device is its register cells and the hook of the device in spi_sim.c.
+ * spi->SR becomes spi->access(SPI_SIM_SR)[0], so every read and write of a
+ * register first lets the shift engine catch up, the way the peripheral runs
+ * alongside the core
+ */
+typedef struct
+{
+	__IO uint32_t *(*access)(uint32_t reg);
+	__IO uint32_t cells[SPI_SIM_REGISTERS];
+}SPI_TypeDef;
+
+#define CR1			access(SPI_SIM_CR1)[0]
+#define CR2			access(SPI_SIM_CR2)[0]
+#define SR			access(SPI_SIM_SR)[0]
+#define DR			access(SPI_SIM_DR)[0]
+#define CRCPR		access(SPI_SIM_CRCPR)[0]
+#define RXCRCR		access(SPI_SIM_RXCRCR)[0]
+#define TXCRCR		access(SPI_SIM_TXCRCR)[0]
+#define I2SCFGR		access(SPI_SIM_I2SCFGR)[0]
+#define I2SPR		access(SPI_SIM_I2SPR)[0]
+
+typedef struct
+{
+	__IO uint32_t CR, PLLCFGR, CFGR, CIR, AHB1RSTR, AHB2RSTR, RESERVED0[2], APB1RSTR, APB2RSTR,
+			RESERVED1[2], AHB1ENR, AHB2ENR, RESERVED2[2], APB1ENR, APB2ENR;
+}RCC_TypeDef;
+
+/*
+ * DWT->CYCCNT becomes DWT->cycle_access()[0]: each read of the counter moves it
+ * on by a cycle, so that delay loops spinning on it come to an end
+ */
+typedef struct
+{
+	__IO uint32_t *(*cycle_access)(void);
+	__IO uint32_t CTRL;
+	__IO uint32_t cycles;
+}DWT_Type;
+
+#define CYCCNT		cycle_access()[0]
+
+typedef struct
+{
+	__IO uint32_t DEMCR;
+}CoreDebug_Type;
+
+typedef struct
+{
+	__IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+}GPIO_TypeDef;
+
+/*
+ * Peripheral instances and hooks provided by spi_sim.c
+ */
+extern SPI_TypeDef spi_sim_regs[5];
+extern RCC_TypeDef spi_sim_rcc;
+extern DWT_Type spi_sim_dwt;
+extern CoreDebug_Type spi_sim_core_debug;
+void spi_sim_pend(IRQn_Type irqn);
+void spi_sim_wfe(void);
+
+#define SPI1		(&spi_sim_regs[0])
+#define SPI2		(&spi_sim_regs[1])
+#define SPI3		(&spi_sim_regs[2])
+#define SPI4		(&spi_sim_regs[3])
+#define SPI5		(&spi_sim_regs[4])
+#define RCC			(&spi_sim_rcc)
+#define DWT			(&spi_sim_dwt)
+#define CoreDebug	(&spi_sim_core_debug)
+
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __ISB(void) { __sync_synchronize(); }
+static inline void __WFE(void) { spi_sim_wfe(); }
+static inline void __WFI(void) { spi_sim_wfe(); }
+static inline void __SEV(void) {}
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline uint32_t __get_PRIMASK(void) { return (0); }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline uint32_t __REV16(uint32_t value) { return (((value & 0xFF00FF00UL) >> 8) | ((value & 0x00FF00FFUL) << 8)); }
+static inline uint32_t __RBIT(uint32_t value)
+{
+	uint32_t result = 0;
+	for (uint8_t i = 0; i < 32; i++)
+	{
+		result = (result << 1) | (value & 1U);
+		value >>= 1;
+	}
+	return (result);
+}
+/*
+ * Exclusive accesses: the load remembers the value seen and the store only lands
+ * if the byte still holds it, which is as much of the monitor as the driver needs
+ */
+static __thread uint8_t spi_sim_exclusive;
+static inline uint8_t __LDREXB(volatile uint8_t *address)
+{
+	spi_sim_exclusive = __atomic_load_n(address, __ATOMIC_ACQUIRE);
+	return (spi_sim_exclusive);
+}
+static inline uint32_t __STREXB(uint8_t value, volatile uint8_t *address)
+{
+	uint8_t expected = spi_sim_exclusive;
+	return (__atomic_compare_exchange_n(address, &expected, value, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ? 0U : 1U);
+}
+static inline void __CLREX(void) {}
+static inline void NVIC_SetPendingIRQ(IRQn_Type irqn) { spi_sim_pend(irqn); }
+static inline void NVIC_EnableIRQ(IRQn_Type irqn) { (void)irqn; }
+static inline void NVIC_DisableIRQ(IRQn_Type irqn) { (void)irqn; }
+
+#endif
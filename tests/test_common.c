@@ -0,0 +1,76 @@
+/*******************************************************************************
+* Title                 :   Host Test Helpers
+* Filename              :   test_common.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+/** @file test_common.c
+ *  @brief Config helper shared by the host tests in this directory.
+ */
+#include "test_common.h"
+
+/******************************************************************************
+* Function: test_config_master()
+*//**
+* \b Description:
+*
+* 	Enables a channel of a config table as a full duplex master with software
+* 	slave management at the given baud rate. The rest of the entry is left as
+* 	the caller zeroed it.
+*
+* PRE-CONDITION: config_table has NUM_SPI entries, zeroed by the caller
+*
+* POST-CONDITION: config_table[channel] is ready for spi_init
+*
+* @param		config_table the table later passed to spi_init
+* @param		channel the channel to enable
+* @param		baud_rate the prescaler the channel is configured with
+* @return 		void
+*
+* \b Example:
+* @code
+*	spi_config_t config_table[NUM_SPI] = {{0}};
+*	test_config_master(config_table, SPI_1, PCLK_DIV_16);
+*	spi_init(config_table);
+* @endcode
+*
+* @see spi_init
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+void test_config_master(spi_config_t *config_table, spi_channel_t channel, spi_baud_rate_t baud_rate)
+{
+	config_table[channel].spi_enable = SPI_ENABLE;
+	config_table[channel].master_slave = SPI_MASTER;
+	config_table[channel].slave_management = SOFTWARE_SMM;
+	config_table[channel].bidirectional_mode = UNIDIR_FULL_DUPLEX;
+	config_table[channel].baud_rate = baud_rate;
+}
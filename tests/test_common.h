@@ -0,0 +1,49 @@
+/*******************************************************************************
+* Title                 :   Host Test Helpers
+* Filename              :   test_common.h
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+/** @file test_common.h
+ *  @brief Check macro and config helper shared by the host tests in this
+ *  	directory.
+ */
+#ifndef _TEST_COMMON_H
+#define _TEST_COMMON_H
+
+#include "spi_interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Reports a failed check and ends the test
+ */
+#define TEST_CHECK(condition)	do { if (!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); exit(1); } } while (0)
+
+void test_config_master(spi_config_t *config_table, spi_channel_t channel, spi_baud_rate_t baud_rate);
+
+#endif
@@ -0,0 +1,110 @@
+/*******************************************************************************
+* Title                 :   Held Select Test
+* Filename              :   test_spi_bus.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+/** @file test_spi_bus.c
+ *  @brief Holds one device selected with spi_bus_acquire while another device on
+ *  	the channel is addressed, then releases the bus with a transfer still queued.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+
+/**
+ * Channel and selects of the two devices
+ */
+#define TEST_CHANNEL		SPI_2
+#define TEST_HELD_PIN		GPIO_B_12
+#define TEST_OTHER_PIN		GPIO_B_0
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Checks that a held select only bypasses the held device: a transfer to
+* 	another device still drives its own select. spi_bus_release is then called
+* 	with a transfer to the held device not yet started, and must sleep until it
+* 	completes before releasing the select.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_bus_acquire
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_2);
+	spi_sim_reset();
+	spi_init(config_table);
+
+	static uint16_t command[3] = {0x0B, 0x00, 0x10};
+	spi_transfer_t held = {0};
+	held.channel = TEST_CHANNEL;
+	held.slave_pin = TEST_HELD_PIN;
+	held.ss_polarity = SS_ACTIVE_LOW;
+	held.tx_buffer = command;
+	held.tx_length = 3;
+	held.data_format = SPI_DATA_8BIT;
+	spi_transfer_t other = held;
+	other.slave_pin = TEST_OTHER_PIN;
+
+	spi_bus_acquire(&held);
+	TEST_CHECK(spi_sim_pin(TEST_HELD_PIN) == GPIO_PIN_LOW && spi_sim_pin_writes(TEST_HELD_PIN) == 1);
+
+	TEST_CHECK(spi_transfer_it_from_isr(&other, NULL));
+	spi_sim_service(TEST_CHANNEL);
+	TEST_CHECK(spi_sim_pin_writes(TEST_OTHER_PIN) == 2 && spi_sim_pin(TEST_OTHER_PIN) == GPIO_PIN_HIGH);
+	TEST_CHECK(spi_sim_pin_writes(TEST_HELD_PIN) == 1);
+
+	TEST_CHECK(spi_transfer_submit(&held));
+	spi_bus_release(&held);
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) == 6);
+	TEST_CHECK(spi_sim_pin_writes(TEST_HELD_PIN) == 2 && spi_sim_pin(TEST_HELD_PIN) == GPIO_PIN_HIGH);
+
+	spi_transfer_t completed;
+	TEST_CHECK(spi_transfer_reap(TEST_CHANNEL, &completed) && completed.tx_length == 0);
+
+	printf("test_spi_bus: held select bypassed for its own device only, passed\n");
+	return (0);
+}
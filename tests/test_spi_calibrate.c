@@ -0,0 +1,177 @@
+/*******************************************************************************
+* Title                 :   Calibration Test
+* Filename              :   test_spi_calibrate.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_calibrate.c
+ *  @brief Calibrates against a slave which garbles its echo and overruns above
+ *  	a chosen SCK, and checks the clock picked with and without margin, the
+ *  	result when nothing passes, and that the device's rate monitor is left
+ *  	out of the search.
+ */
+#include "spi_calibrate.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+
+/**
+ * Channel and select of the slave
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_SLAVE_PIN		GPIO_A_4
+
+/**
+ * Prescaler past the last one, for a slave which fails at every SCK
+ */
+#define TEST_NEVER			(PCLK_DIV_256 + 1U)
+
+/**
+ * Fastest prescaler the slave answers cleanly at
+ */
+static uint32_t test_limit;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Runs the calibration of a loopback device with a slave that fails faster
+* 	than PCLK_DIV_8, with one step of margin and with none, then with a slave
+* 	that only passes at PCLK_DIV_256 and more margin than is left, and last with
+* 	one that never passes. The device carries a rate monitor throughout, which
+* 	must count none of the failures.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_calibrate
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_2);
+	spi_sim_reset();
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+	spi_init(config_table);
+
+	spi_rate_monitor_t monitor;
+	spi_rate_monitor_init(&monitor, 8, 1, 100);
+	spi_transfer_t device = {0};
+	device.channel = TEST_CHANNEL;
+	device.slave_pin = TEST_SLAVE_PIN;
+	device.ss_polarity = SS_ACTIVE_LOW;
+	device.data_format = SPI_DATA_8BIT;
+	device.rate_monitor = &monitor;
+
+	uint16_t pattern[4] = {0x55, 0xAA, 0x0F, 0xF0};
+	spi_calibration_t calibration = {0};
+	calibration.device = &device;
+	calibration.expected = pattern;
+	calibration.expected_length = 4;
+	calibration.crc_enable = CRC_DISABLE;
+	calibration.repetitions = 4;
+	calibration.margin_steps = 1;
+
+	test_limit = PCLK_DIV_8;
+	uint32_t expected = spi_clock_get(TEST_CHANNEL, PCLK_DIV_16);
+	TEST_CHECK(spi_calibrate(&calibration) == expected && device.max_clock_hz == expected);
+
+	calibration.margin_steps = 0;
+	expected = spi_clock_get(TEST_CHANNEL, PCLK_DIV_8);
+	TEST_CHECK(spi_calibrate(&calibration) == expected && device.max_clock_hz == expected);
+
+	test_limit = PCLK_DIV_256;
+	calibration.margin_steps = 3;
+	expected = spi_clock_get(TEST_CHANNEL, PCLK_DIV_256);
+	TEST_CHECK(spi_calibrate(&calibration) == expected && device.max_clock_hz == expected);
+
+	test_limit = TEST_NEVER;
+	device.max_clock_hz = 1234567;
+	TEST_CHECK(spi_calibrate(&calibration) == 0 && device.max_clock_hz == 1234567);
+
+	TEST_CHECK(monitor.error_count == 0 && monitor.history == 0 && monitor.derate == 0);
+	TEST_CHECK(spi_sim_pin(TEST_SLAVE_PIN) == GPIO_PIN_HIGH);
+
+	printf("test_spi_calibrate: limits found with and without margin, monitor untouched, passed\n");
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function standing in for a slave which echoes each frame, but above
+* 	its limit flips the top bit and raises an overrun. The prescaler is read
+* 	from CR1 past the access hooks, which the sim holds its lock across.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device sending the frame
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	uint32_t baud_rate = (spi_sim_regs[channel].cells[SPI_SIM_CR1] & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos;
+	if (baud_rate < test_limit)
+	{
+		spi_sim_raise(channel, SPI_SR_OVR_Msk);
+		return ((uint16_t)(frame ^ 0x80U));
+	}
+	return (frame);
+}
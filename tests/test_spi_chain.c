@@ -0,0 +1,314 @@
+/*******************************************************************************
+* Title                 :   Daisy Chain Test
+* Filename              :   test_spi_chain.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_chain.c
+ *  @brief Checks the bit mapping of daisy chains whose length is and is not a
+ *  	multiple of 16 against a model of the shift registers, what is read back
+ *  	out of them, and that unchanged chains are not clocked.
+ */
+#include "spi_chain.h"
+#include "spi_sim.h"
+#include "test_common.h"
+
+/**
+ * Channel and select of the chain
+ */
+#define TEST_CHANNEL		SPI_3
+#define TEST_PIN			GPIO_A_15
+
+/**
+ * Longest chain modelled, in bits
+ */
+#define TEST_MAX_BITS		64U
+
+static uint16_t test_respond(spi_channel_t channel, uint16_t frame);
+static void test_mapping(uint32_t num_bits);
+static void test_dirty(void);
+
+/**
+ * The chain's shift registers, indexed by chain offset, and its length
+ */
+static uint8_t test_register[TEST_MAX_BITS];
+static uint32_t test_num_bits;
+
+/******************************************************************************
+* Function: test_respond()
+*//**
+* \b Description:
+*
+* 	Static function which clocks a frame through the modelled chain, most
+* 	significant bit first. Every bit enters the register nearest the spi and
+* 	pushes the rest along; the bit at the far end is what the chain shifts out.
+*
+* PRE-CONDITION: test_num_bits is set
+*
+* POST-CONDITION: The frame has been shifted into test_register
+*
+* @param		channel the spi device
+* @param		frame the frame sent
+* @return 		uint16_t the bits shifted out of the far end
+*
+* \b Example:
+*	Called by the simulation for every frame
+*
+* @see test_mapping
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_respond(spi_channel_t channel, uint16_t frame)
+{
+	(void)channel;
+	uint16_t reply = 0;
+	for (int8_t bit = 15; bit >= 0; bit--)
+	{
+		reply |= (uint16_t)(test_register[test_num_bits - 1U] << bit);
+		for (uint32_t offset = test_num_bits - 1U; offset > 0; offset--)
+		{
+			test_register[offset] = test_register[offset - 1U];
+		}
+		test_register[0] = (frame >> bit) & 1U;
+	}
+	return (reply);
+}
+
+/******************************************************************************
+* Function: test_mapping()
+*//**
+* \b Description:
+*
+* 	Static function which writes single bits and fields straddling the frames
+* 	of a chain, including those next to the spare bits padding the first frame,
+* 	and checks that each lands in the register at its offset once clocked, that
+* 	the spare bits stay clear, and that what the registers held before reads
+* 	back at the same offsets.
+*
+* PRE-CONDITION: The channel is initialised and answered by test_respond
+*
+* POST-CONDITION: The process has exited if a check failed
+*
+* @param		num_bits the length of the chain
+* @return 		void
+*
+* \b Example:
+* @code
+*	test_mapping(40);
+* @endcode
+*
+* @see test_respond
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void test_mapping(uint32_t num_bits)
+{
+	uint16_t frames[SPI_CHAIN_FRAMES(TEST_MAX_BITS)];
+	uint16_t rx_frames[SPI_CHAIN_FRAMES(TEST_MAX_BITS)];
+	uint32_t spare = SPI_CHAIN_FRAMES(num_bits) * 16U - num_bits;
+	spi_chain_t chain = {0};
+	chain.bus.channel = TEST_CHANNEL;
+	chain.bus.slave_pin = TEST_PIN;
+	chain.bus.ss_polarity = SS_ACTIVE_LOW;
+	chain.num_bits = num_bits;
+	chain.frames = frames;
+	chain.rx_frames = rx_frames;
+	spi_chain_init(&chain);
+	test_num_bits = num_bits;
+
+	/* One bit at a time, at every offset: only that register is set */
+	for (uint32_t offset = 0; offset < num_bits; offset++)
+	{
+		spi_chain_write(&chain, offset, 1, 1);
+		TEST_CHECK(spi_chain_update(&chain));
+		for (uint32_t other = 0; other < num_bits; other++)
+		{
+			TEST_CHECK(test_register[other] == (other == offset));
+		}
+		TEST_CHECK(spare == 0 || (frames[0] >> (16U - spare)) == 0);
+		spi_chain_write(&chain, offset, 1, 0);
+	}
+
+	/* A field across the top of the chain, next to the spare bits, and one
+	 * across every frame boundary below it */
+	uint32_t low_width = (num_bits - 13U > 32U) ? 32U : num_bits - 13U;
+	spi_chain_write(&chain, num_bits - 12U, 12, 0xFFFFFA5CUL);
+	spi_chain_write(&chain, 1, (uint8_t)low_width, 0x89ABCDEFUL);
+	uint32_t low_value = (low_width == 32U) ? 0x89ABCDEFUL : (0x89ABCDEFUL & ((1UL << low_width) - 1U));
+	TEST_CHECK(spi_chain_get(&chain, num_bits - 12U, 12) == 0xA5CU);
+	TEST_CHECK(spi_chain_get(&chain, 1, (uint8_t)low_width) == low_value);
+	TEST_CHECK(spi_chain_get(&chain, 0, 1) == 0);
+	TEST_CHECK(spare == 0 || (frames[0] >> (16U - spare)) == 0);
+
+	/* What the registers held before the update reads back at its offsets */
+	uint8_t before[TEST_MAX_BITS];
+	for (uint32_t offset = 0; offset < num_bits; offset++)
+	{
+		test_register[offset] = (uint8_t)((offset * 7U) % 3U == 0);
+		before[offset] = test_register[offset];
+	}
+	uint32_t frames_sent = spi_sim_frames(TEST_CHANNEL);
+	uint32_t pin_writes = spi_sim_pin_writes(TEST_PIN);
+	TEST_CHECK(spi_chain_update(&chain));
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) - frames_sent == SPI_CHAIN_FRAMES(num_bits));
+	TEST_CHECK(spi_sim_pin_writes(TEST_PIN) - pin_writes == 2 && spi_sim_pin(TEST_PIN) == GPIO_PIN_HIGH);
+	for (uint32_t offset = 0; offset < num_bits; offset++)
+	{
+		TEST_CHECK(spi_chain_read(&chain, offset, 1) == before[offset]);
+		TEST_CHECK(test_register[offset] == spi_chain_get(&chain, offset, 1));
+	}
+	uint32_t top = 0;
+	for (uint32_t i = 0; i < 12U; i++)
+	{
+		top |= (uint32_t)before[num_bits - 12U + i] << i;
+	}
+	TEST_CHECK(spi_chain_read(&chain, num_bits - 12U, 12) == top);
+}
+
+/******************************************************************************
+* Function: test_dirty()
+*//**
+* \b Description:
+*
+* 	Static function which checks that a transmit only chain is clocked after
+* 	init and after a write that changes an output, and skipped, without a frame
+* 	or a select, after updates and after writes that change nothing.
+*
+* PRE-CONDITION: The channel is initialised and answered by test_respond
+*
+* POST-CONDITION: The process has exited if a check failed
+*
+* @param		None
+* @return 		void
+*
+* \b Example:
+* @code
+*	test_dirty();
+* @endcode
+*
+* @see spi_chain_update
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void test_dirty(void)
+{
+	uint16_t frames[SPI_CHAIN_FRAMES(24)];
+	spi_chain_t chain = {0};
+	chain.bus.channel = TEST_CHANNEL;
+	chain.bus.slave_pin = TEST_PIN;
+	chain.bus.ss_polarity = SS_ACTIVE_LOW;
+	chain.num_bits = 24;
+	chain.frames = frames;
+	chain.rx_frames = NULL;
+	spi_chain_init(&chain);
+	test_num_bits = 24;
+
+	uint32_t frames_sent = spi_sim_frames(TEST_CHANNEL);
+	uint32_t pin_writes = spi_sim_pin_writes(TEST_PIN);
+	TEST_CHECK(spi_chain_update(&chain) && !chain.dirty);
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) - frames_sent == 2);
+	TEST_CHECK(!spi_chain_update(&chain));
+
+	/* Writes matching the image change nothing */
+	spi_chain_write(&chain, 0, 24, 0);
+	spi_chain_write(&chain, 20, 4, 0xFFFFFFF0UL);
+	TEST_CHECK(!chain.dirty && !spi_chain_update(&chain));
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) - frames_sent == 2);
+	TEST_CHECK(spi_sim_pin_writes(TEST_PIN) - pin_writes == 2);
+
+	/* A change, even one undone before the update, is sent once */
+	spi_chain_write(&chain, 23, 1, 1);
+	TEST_CHECK(chain.dirty);
+	TEST_CHECK(spi_chain_update(&chain) && test_register[23] == 1);
+	TEST_CHECK(!spi_chain_update(&chain));
+	spi_chain_write(&chain, 5, 3, 5);
+	spi_chain_write(&chain, 5, 3, 0);
+	TEST_CHECK(spi_chain_update(&chain) && !spi_chain_update(&chain));
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) - frames_sent == 6);
+	TEST_CHECK(spi_sim_pin_writes(TEST_PIN) - pin_writes == 6);
+	TEST_CHECK(test_register[23] == 1 && test_register[5] == 0 && spi_chain_get(&chain, 0, 24) == 0x800000UL);
+}
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Checks the mapping of chains one frame long, one bit over a frame, padded
+* 	part way into a frame and of whole frames, then the skipping of updates.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see test_mapping
+* @see test_dirty
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	const uint32_t lengths[] = {16, 17, 40, 48, 63};
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_4);
+	spi_sim_reset();
+	spi_init(config_table);
+	spi_sim_set_responder(TEST_CHANNEL, test_respond);
+
+	for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+	{
+		test_mapping(lengths[i]);
+	}
+	test_dirty();
+
+	printf("test_spi_chain: %u chain lengths mapped, unchanged chains skipped, passed\n",
+			(unsigned)(sizeof(lengths) / sizeof(lengths[0])));
+	return (0);
+}
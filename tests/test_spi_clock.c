@@ -0,0 +1,247 @@
+/*******************************************************************************
+* Title                 :   Clock Selection Test
+* Filename              :   test_spi_clock.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_clock.c
+ *  @brief Checks the prescaler each transfer runs at for its max_clock_hz, on a
+ *  	channel of each APB bus. Built with the F411's 50 MHz APB1 and 100 MHz
+ *  	APB2, so that a channel on the wrong bus is caught.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+
+/**
+ * Channels on APB2 and APB1, and the select used on both
+ */
+#define TEST_APB2_CHANNEL	SPI_1
+#define TEST_APB1_CHANNEL	SPI_2
+#define TEST_SLAVE_PIN		GPIO_A_4
+
+/**
+ * Prescaler the channels are configured with, used by transfers without a max_clock_hz
+ */
+#define TEST_DEFAULT_RATE	PCLK_DIV_32
+
+/**
+ * Prescaler of the last frame sent
+ */
+static uint32_t test_baud_rate;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+static uint32_t test_run(spi_channel_t channel, uint32_t max_clock_hz);
+static uint32_t test_expected(uint32_t pclk_hz, uint32_t max_clock_hz);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Runs a transfer on each channel at every exact SCK, just above and below
+* 	each, above the fastest and below the slowest, and with no max_clock_hz,
+* 	checking the prescaler against the fastest whose SCK does not exceed the
+* 	maximum. Two devices then alternate on one channel, each at its own rate.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_clock_get
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_APB2_CHANNEL, TEST_DEFAULT_RATE);
+	test_config_master(config_table, TEST_APB1_CHANNEL, TEST_DEFAULT_RATE);
+	spi_sim_reset();
+	spi_sim_set_responder(TEST_APB2_CHANNEL, test_responder);
+	spi_sim_set_responder(TEST_APB1_CHANNEL, test_responder);
+	spi_init(config_table);
+
+	TEST_CHECK(spi_clock_get(TEST_APB2_CHANNEL, PCLK_DIV_2) == 50000000UL);
+	TEST_CHECK(spi_clock_get(TEST_APB1_CHANNEL, PCLK_DIV_2) == 25000000UL);
+	TEST_CHECK(spi_clock_get(TEST_APB1_CHANNEL, PCLK_DIV_256) == 195312UL);
+
+	spi_channel_t channels[2] = {TEST_APB2_CHANNEL, TEST_APB1_CHANNEL};
+	uint32_t pclks[2] = {SPI_APB2_CLOCK_HZ, SPI_APB1_CLOCK_HZ};
+	for (uint32_t bus = 0; bus < 2; bus++)
+	{
+		for (uint32_t baud_rate = PCLK_DIV_2; baud_rate <= PCLK_DIV_256; baud_rate++)
+		{
+			uint32_t clock_hz = pclks[bus] >> (baud_rate + 1);
+			TEST_CHECK(test_run(channels[bus], clock_hz) == baud_rate);
+			TEST_CHECK(test_run(channels[bus], clock_hz + 1) == test_expected(pclks[bus], clock_hz + 1));
+			TEST_CHECK(test_run(channels[bus], clock_hz - 1) == test_expected(pclks[bus], clock_hz - 1));
+		}
+		TEST_CHECK(test_run(channels[bus], pclks[bus]) == PCLK_DIV_2);
+		TEST_CHECK(test_run(channels[bus], 1) == PCLK_DIV_256);
+		TEST_CHECK(test_run(channels[bus], 0) == TEST_DEFAULT_RATE);
+	}
+	TEST_CHECK(test_run(TEST_APB2_CHANNEL, 10000000UL) == PCLK_DIV_16);
+	TEST_CHECK(test_run(TEST_APB1_CHANNEL, 10000000UL) == PCLK_DIV_8);
+
+	/* A fast and a slow device on one channel each keep their own prescaler */
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		TEST_CHECK(test_run(TEST_APB2_CHANNEL, 40000000UL) == PCLK_DIV_4);
+		TEST_CHECK(test_run(TEST_APB2_CHANNEL, 800000UL) == PCLK_DIV_128);
+	}
+
+	printf("test_spi_clock: prescalers picked on APB1 and APB2, passed\n");
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function which notes the prescaler a frame was sent at, reading CR1
+* 	past the access hooks, which the sim holds its lock across. It echoes the
+* 	frame back.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device sending the frame
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	test_baud_rate = (spi_sim_regs[channel].cells[SPI_SIM_CR1] & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos;
+	return (frame);
+}
+
+/******************************************************************************
+* Function: test_run()
+*//**
+* \b Description:
+*
+* 	Static function which sends a frame to a device with the given maximum SCK.
+*
+* PRE-CONDITION: The channel is initialised as a master
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device to send on
+* @param		max_clock_hz the device's maximum SCK, 0 for the channel's default
+* @return 		uint32_t the prescaler the frame was sent at
+*
+* \b Example:
+*	Called by main
+*
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t test_run(spi_channel_t channel, uint32_t max_clock_hz)
+{
+	uint16_t frame = 0x5A;
+	spi_transfer_t transfer = {0};
+	transfer.channel = channel;
+	transfer.slave_pin = TEST_SLAVE_PIN;
+	transfer.ss_polarity = SS_ACTIVE_LOW;
+	transfer.tx_buffer = &frame;
+	transfer.tx_length = 1;
+	transfer.data_format = SPI_DATA_8BIT;
+	transfer.max_clock_hz = max_clock_hz;
+	test_baud_rate = 0xFF;
+	spi_transfer(&transfer);
+	return (test_baud_rate);
+}
+
+/******************************************************************************
+* Function: test_expected()
+*//**
+* \b Description:
+*
+* 	Static function giving the fastest prescaler whose SCK does not exceed a
+* 	maximum, or PCLK_DIV_256 if none is slow enough.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		pclk_hz the clock of the channel's bus
+* @param		max_clock_hz the device's maximum SCK
+* @return 		uint32_t the prescaler expected
+*
+* \b Example:
+*	Called by main
+*
+* @see test_run
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t test_expected(uint32_t pclk_hz, uint32_t max_clock_hz)
+{
+	for (uint32_t baud_rate = PCLK_DIV_2; baud_rate < PCLK_DIV_256; baud_rate++)
+	{
+		if (pclk_hz / (2UL << baud_rate) <= max_clock_hz)
+		{
+			return (baud_rate);
+		}
+	}
+	return (PCLK_DIV_256);
+}
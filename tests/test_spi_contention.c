@@ -0,0 +1,343 @@
+/*******************************************************************************
+* Title                 :   Channel Contention Benchmark
+* Filename              :   test_spi_contention.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_contention.c
+ *  @brief Several tasks share one channel through spi_transfer, each sleeping on
+ *  	the completion semaphore while a thread standing in for the interrupt moves
+ *  	its frames. Checks that no transfer is interleaved with another and reports
+ *  	throughput, the worst wait of a task and the cpu the tasks used. The Makefile
+ *  	builds it with and without SPI_OS_PRIORITY_INHERITANCE.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "spi_interface.h"
+#include "spi_os.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+/**
+ * Channel and slave the tasks share
+ */
+#define TEST_CHANNEL		SPI_2
+#define TEST_SLAVE_PIN		GPIO_B_12
+
+/**
+ * Tasks sharing the channel, transfers each one makes and frames per transfer
+ */
+#define TEST_TASKS			4U
+#define TEST_ROUNDS			2000U
+#define TEST_FRAMES			8U
+
+/**
+ * Contains what one task measured
+ */
+typedef struct
+{
+	pthread_t thread;		/**<Thread running the task */
+	uint16_t id;			/**<Number of the task, carried in the top bits of its frames */
+	uint64_t worst_wait_ns;	/**<Longest a call to spi_transfer took */
+	uint64_t cpu_ns;		/**<Cpu time the thread used */
+	uint32_t wrong;			/**<Frames received back which were not the ones sent */
+}test_task_t;
+
+/**
+ * Set to stop the interrupt thread
+ */
+static volatile uint8_t test_stop;
+
+/**
+ * Frames seen on the bus and the ones not belonging to the transfer in progress
+ */
+static uint32_t test_frames_seen;
+static uint32_t test_frames_interleaved;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+static void *test_task(void *argument);
+static void *test_isr_thread(void *argument);
+static uint64_t test_ns(clockid_t clock);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Starts TEST_TASKS tasks which each make TEST_ROUNDS transfers of TEST_FRAMES
+* 	frames on the same channel, long enough for spi_transfer to sleep on an
+* 	interrupt transfer, and a thread taking the interrupts. Once all are done the
+* 	frames on the bus are checked to have come a whole transfer at a time, and
+* 	the figures are printed.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see test_task
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_16);
+
+	spi_sim_reset();
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+	spi_init(config_table);
+
+	pthread_t isr;
+	spi_sim_set_background(1);
+	TEST_CHECK(pthread_create(&isr, NULL, test_isr_thread, NULL) == 0);
+
+	static test_task_t tasks[TEST_TASKS];
+	uint64_t start = test_ns(CLOCK_MONOTONIC);
+	for (uint16_t task = 0; task < TEST_TASKS; task++)
+	{
+		tasks[task].id = task;
+		TEST_CHECK(pthread_create(&tasks[task].thread, NULL, test_task, &tasks[task]) == 0);
+	}
+	for (uint16_t task = 0; task < TEST_TASKS; task++)
+	{
+		TEST_CHECK(pthread_join(tasks[task].thread, NULL) == 0);
+	}
+	uint64_t elapsed = test_ns(CLOCK_MONOTONIC) - start;
+
+	test_stop = 1;
+	TEST_CHECK(pthread_join(isr, NULL) == 0);
+
+	uint64_t worst_wait = 0;
+	uint64_t cpu = 0;
+	for (uint16_t task = 0; task < TEST_TASKS; task++)
+	{
+		TEST_CHECK(tasks[task].wrong == 0);
+		worst_wait = (tasks[task].worst_wait_ns > worst_wait) ? tasks[task].worst_wait_ns : worst_wait;
+		cpu += tasks[task].cpu_ns;
+	}
+	TEST_CHECK(test_frames_seen == TEST_TASKS * TEST_ROUNDS * TEST_FRAMES && test_frames_interleaved == 0);
+	TEST_CHECK(spi_sim_pin_writes(TEST_SLAVE_PIN) == 2 * TEST_TASKS * TEST_ROUNDS);
+	TEST_CHECK(spi_sim_pin(TEST_SLAVE_PIN) == GPIO_PIN_HIGH);
+
+	printf("test_spi_contention: priority inheritance %s, %u tasks: %.0f transfers/s, worst wait %.1f us,"
+			" tasks used %.1f%% of the wall time\n", SPI_OS_PRIORITY_INHERITANCE ? "on" : "off", TEST_TASKS,
+			(double)(TEST_TASKS * TEST_ROUNDS) * 1e9 / (double)elapsed, (double)worst_wait / 1e3,
+			100.0 * (double)cpu / (double)elapsed);
+	printf("test_spi_contention: %u transfers of %u frames kept whole, passed\n", TEST_TASKS * TEST_ROUNDS, TEST_FRAMES);
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function which checks that each frame belongs to the same task as the
+* 	first frame of its transfer and sits at the position it was sent from. It
+* 	echoes the frame back.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device sending the frame
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	(void)channel;
+	static uint16_t owner;
+	uint32_t position = test_frames_seen % TEST_FRAMES;
+	if (position == 0)
+	{
+		owner = frame >> 12;
+	}
+	if ((frame >> 12) != owner || (frame & 0x0FU) != position)
+	{
+		test_frames_interleaved++;
+	}
+	test_frames_seen++;
+	return (frame);
+}
+
+/******************************************************************************
+* Function: test_task()
+*//**
+* \b Description:
+*
+* 	Static function run by each task. It makes TEST_ROUNDS transfers through
+* 	spi_transfer, timing each call, and checks the echo of every one. Its cpu
+* 	time is read once it is done.
+*
+* PRE-CONDITION: The interrupt thread is running
+*
+* POST-CONDITION: The task's figures are filled in
+*
+* @param		argument the test_task_t of the task
+* @return 		void * NULL
+*
+* \b Example:
+*	Called by pthread_create
+*
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void *test_task(void *argument)
+{
+	test_task_t *task = argument;
+	uint16_t tx[TEST_FRAMES];
+	uint16_t rx[TEST_FRAMES];
+
+	spi_transfer_t transfer = {0};
+	transfer.channel = TEST_CHANNEL;
+	transfer.slave_pin = TEST_SLAVE_PIN;
+	transfer.ss_polarity = SS_ACTIVE_LOW;
+	transfer.tx_buffer = tx;
+	transfer.tx_length = TEST_FRAMES;
+	transfer.rx_buffer = rx;
+	transfer.rx_length = TEST_FRAMES;
+	transfer.data_format = SPI_DATA_16BIT;
+	transfer.sleep_threshold = 1;
+
+	for (uint32_t round = 0; round < TEST_ROUNDS; round++)
+	{
+		for (uint16_t i = 0; i < TEST_FRAMES; i++)
+		{
+			tx[i] = (uint16_t)((task->id << 12) | ((round & 0xFFU) << 4) | i);
+		}
+		uint64_t start = test_ns(CLOCK_MONOTONIC);
+		spi_transfer(&transfer);
+		uint64_t wait = test_ns(CLOCK_MONOTONIC) - start;
+		task->worst_wait_ns = (wait > task->worst_wait_ns) ? wait : task->worst_wait_ns;
+		for (uint16_t i = 0; i < TEST_FRAMES; i++)
+		{
+			task->wrong += (rx[i] != tx[i]);
+		}
+	}
+	task->cpu_ns = test_ns(CLOCK_THREAD_CPUTIME_ID);
+	return (NULL);
+}
+
+/******************************************************************************
+* Function: test_isr_thread()
+*//**
+* \b Description:
+*
+* 	Static function standing in for the interrupt of the channel. It takes the
+* 	interrupts as they are asserted until the test is stopped.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		argument unused
+* @return 		void * NULL
+*
+* \b Example:
+*	Called by pthread_create
+*
+* @see spi_sim_service
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void *test_isr_thread(void *argument)
+{
+	(void)argument;
+	while (!test_stop)
+	{
+		spi_sim_service(TEST_CHANNEL);
+		sched_yield();
+	}
+	return (NULL);
+}
+
+/******************************************************************************
+* Function: test_ns()
+*//**
+* \b Description:
+*
+* 	Static function reading a clock in nanoseconds.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		clock the clock to read
+* @return 		uint64_t the time on the clock
+*
+* \b Example:
+*	Called by test_task
+*
+* @see clock_gettime
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint64_t test_ns(clockid_t clock)
+{
+	struct timespec now;
+	clock_gettime(clock, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+}
@@ -0,0 +1,200 @@
+/*******************************************************************************
+* Title                 :   Descriptor Pool Contention Test
+* Filename              :   test_spi_desc.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+/** @file test_spi_desc.c
+ *  @brief Takes and returns descriptors from several threads at once, checking
+ *  	that the lock free pool never hands the same descriptor to two owners, then
+ *  	submits a descriptor behind a transfer whose record is waiting to be reaped.
+ */
+#define _XOPEN_SOURCE 700
+
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include <pthread.h>
+
+/**
+ * Threads contending for the pool and the descriptors each takes and returns
+ */
+#define TEST_THREADS		4U
+#define TEST_ROUNDS			200000UL
+
+/**
+ * Channel and slave the descriptor and the submitted transfer run on
+ */
+#define TEST_CHANNEL		SPI_2
+#define TEST_SLAVE_PIN		GPIO_B_12
+
+/**
+ * Thread holding each descriptor, 0 while it is free
+ */
+static uint8_t test_owners[SPI_DESC_POOL_LENGTH];
+
+/**
+ * Descriptors taken, and taken while another thread already held them
+ */
+static uint32_t test_taken;
+static uint32_t test_doubled;
+
+static void *test_thread(void *argument);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Runs TEST_THREADS threads, each repeatedly creating a descriptor, marking
+* 	itself as its owner and destroying it again. A descriptor is then submitted
+* 	after a transfer has completed unreaped, whose record must survive it.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see test_thread
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	static spi_transfer_t request = {0};
+	pthread_t threads[TEST_THREADS];
+	spi_sim_reset();
+
+	for (uint32_t i = 0; i < TEST_THREADS; i++)
+	{
+		TEST_CHECK(pthread_create(&threads[i], NULL, test_thread, &request) == 0);
+	}
+	for (uint32_t i = 0; i < TEST_THREADS; i++)
+	{
+		TEST_CHECK(pthread_join(threads[i], NULL) == 0);
+	}
+
+	TEST_CHECK(test_doubled == 0);
+	TEST_CHECK(test_taken == TEST_THREADS * TEST_ROUNDS);
+
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_16);
+	spi_init(config_table);
+
+	static uint16_t test_data[2] = {0x5A, 0xA5};
+	spi_transfer_t submitted = {0};
+	submitted.channel = TEST_CHANNEL;
+	submitted.slave_pin = TEST_SLAVE_PIN;
+	submitted.ss_polarity = SS_ACTIVE_LOW;
+	submitted.tx_buffer = test_data;
+	submitted.tx_length = 2;
+	submitted.data_format = SPI_DATA_8BIT;
+	static spi_transfer_t described;
+	described = submitted;
+	described.tx_length = 1;
+
+	TEST_CHECK(spi_transfer_submit(&submitted));
+	spi_sim_service(TEST_CHANNEL);
+	spi_desc_t desc = spi_desc_create(&described);
+	TEST_CHECK(desc != SPI_DESC_NONE && spi_desc_submit(desc));
+	spi_sim_service(TEST_CHANNEL);
+	TEST_CHECK(spi_desc_status(desc) == SPI_DESC_DONE);
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) == 3);
+
+	spi_transfer_t completed;
+	TEST_CHECK(spi_transfer_reap(TEST_CHANNEL, &completed));
+	TEST_CHECK(completed.tx_length == 0 && completed.tx_buffer == test_data + 2);
+	TEST_CHECK(!spi_transfer_reap(TEST_CHANNEL, NULL));
+	spi_desc_destroy(desc);
+	for (uint32_t i = 0; i < SPI_DESC_POOL_LENGTH; i++)
+	{
+		spi_desc_t desc = spi_desc_create(&request);
+		TEST_CHECK(desc != SPI_DESC_NONE);
+	}
+	TEST_CHECK(spi_desc_create(&request) == SPI_DESC_NONE);
+
+	printf("test_spi_desc: %lu descriptors taken by %u threads, passed\n", TEST_THREADS * TEST_ROUNDS, TEST_THREADS);
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_thread()
+*//**
+* \b Description:
+*
+* 	Static function which takes and returns descriptors TEST_ROUNDS times. An
+* 	empty pool is simply retried; a descriptor already marked as owned is
+* 	counted as doubled.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		argument the request the descriptors are bound to
+* @return 		void * NULL
+*
+* \b Example:
+*	Called by pthread_create
+*
+* @see spi_desc_create
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void *test_thread(void *argument)
+{
+	const spi_transfer_t *request = argument;
+	for (uint32_t round = 0; round < TEST_ROUNDS; )
+	{
+		spi_desc_t desc = spi_desc_create(request);
+		if (desc == SPI_DESC_NONE)
+		{
+			continue;
+		}
+		if (__atomic_exchange_n(&test_owners[desc], 1, __ATOMIC_ACQ_REL) != 0)
+		{
+			__atomic_fetch_add(&test_doubled, 1, __ATOMIC_RELAXED);
+		}
+		__atomic_fetch_add(&test_taken, 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&test_owners[desc], 0, __ATOMIC_RELEASE);
+		spi_desc_destroy(desc);
+		round++;
+	}
+	return (NULL);
+}
@@ -0,0 +1,308 @@
+/*******************************************************************************
+* Title                 :   Display Test
+* Filename              :   test_spi_display.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_display.c
+ *  @brief Checks how spi_display merges dirty regions and the CASET, RASET and
+ *  	RAMWR sequence its flush puts on the bus, with the select taken through
+ *  	spi_bus_acquire for each command, or left to a hardware NSS.
+ */
+#include "spi_display.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+
+/**
+ * Channel, select and data/command pin of the panel
+ */
+#define TEST_CHANNEL		SPI_2
+#define TEST_SLAVE_PIN		GPIO_B_12
+#define TEST_DC_PIN			GPIO_B_1
+
+/**
+ * Size of the panel
+ */
+#define TEST_WIDTH			128U
+#define TEST_HEIGHT			96U
+
+/**
+ * Frames the log can hold, enough for a full panel and its commands
+ */
+#define TEST_LOG_LENGTH		(TEST_WIDTH * TEST_HEIGHT + 64U)
+
+/**
+ * Contains a frame seen by the panel
+ */
+typedef struct
+{
+	uint16_t frame;		/**<Frame sent */
+	uint8_t data;		/**<1 if DC was high (data), 0 for a command */
+	uint8_t selected;	/**<1 if the select pin or the hardware NSS was asserted */
+}test_frame_t;
+
+static uint16_t test_pixels[TEST_WIDTH * TEST_HEIGHT];
+static test_frame_t test_log[TEST_LOG_LENGTH];
+static uint32_t test_logged;
+static uint32_t test_read;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+static void test_expect_rect(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Flushes the whole panel after spi_display_init, then two neighbouring
+* 	regions which must be merged and a distant one which must not, and last
+* 	more scattered pixels than there are dirty slots, which must all still be
+* 	pushed. Every flush is checked frame by frame against the framebuffer. A
+* 	panel on the hardware NSS must be selected by the driver for each command.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_display_flush
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_2);
+	spi_sim_reset();
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+	spi_init(config_table);
+
+	for (uint32_t y = 0; y < TEST_HEIGHT; y++)
+	{
+		for (uint32_t x = 0; x < TEST_WIDTH; x++)
+		{
+			test_pixels[y * TEST_WIDTH + x] = (uint16_t)((y << 8) | x);
+		}
+	}
+	static spi_display_t display;
+	display.bus.channel = TEST_CHANNEL;
+	display.bus.slave_pin = TEST_SLAVE_PIN;
+	display.bus.ss_polarity = SS_ACTIVE_LOW;
+	display.dc_pin = TEST_DC_PIN;
+	display.width = TEST_WIDTH;
+	display.height = TEST_HEIGHT;
+	display.framebuffer = test_pixels;
+
+	/* The whole panel goes as one window, with one select per command */
+	spi_display_init(&display);
+	TEST_CHECK(display.dirty_count == 1);
+	spi_display_flush(&display);
+	TEST_CHECK(display.dirty_count == 0);
+	test_expect_rect(0, 0, TEST_WIDTH - 1, TEST_HEIGHT - 1);
+	TEST_CHECK(test_read == test_logged);
+	TEST_CHECK(spi_sim_pin_writes(TEST_SLAVE_PIN) == 6 && spi_sim_pin(TEST_SLAVE_PIN) == GPIO_PIN_HIGH);
+
+	/* Neighbours cost less merged than apart; a distant region stays on its own */
+	spi_display_invalidate(&display, 2, 2, 3, 3);
+	spi_display_invalidate(&display, 5, 2, 3, 3);
+	TEST_CHECK(display.dirty_count == 1);
+	TEST_CHECK(display.dirty[0].x0 == 2 && display.dirty[0].y0 == 2 && display.dirty[0].x1 == 7 && display.dirty[0].y1 == 4);
+	spi_display_invalidate(&display, 100, 80, 2, 2);
+	TEST_CHECK(display.dirty_count == 2);
+	spi_display_invalidate(&display, TEST_WIDTH - 1, TEST_HEIGHT - 1, 10, 10);
+	TEST_CHECK(display.dirty_count == 3);
+	TEST_CHECK(display.dirty[2].x0 == TEST_WIDTH - 1 && display.dirty[2].x1 == TEST_WIDTH - 1);
+	TEST_CHECK(display.dirty[2].y0 == TEST_HEIGHT - 1 && display.dirty[2].y1 == TEST_HEIGHT - 1);
+	spi_display_invalidate(&display, TEST_WIDTH, 0, 1, 1);
+	TEST_CHECK(display.dirty_count == 3);
+
+	test_logged = 0;
+	test_read = 0;
+	spi_display_flush(&display);
+	test_expect_rect(2, 2, 7, 4);
+	test_expect_rect(100, 80, 101, 81);
+	test_expect_rect(TEST_WIDTH - 1, TEST_HEIGHT - 1, TEST_WIDTH - 1, TEST_HEIGHT - 1);
+	TEST_CHECK(test_read == test_logged);
+
+	/* Scattered pixels overflow the slots and are forced together, none lost */
+	for (uint16_t i = 0; i <= SPI_DISPLAY_MAX_DIRTY_RECTS; i++)
+	{
+		spi_display_invalidate(&display, i * 12U, i * 10U, 1, 1);
+		TEST_CHECK(display.dirty_count <= SPI_DISPLAY_MAX_DIRTY_RECTS);
+	}
+	for (uint16_t i = 0; i <= SPI_DISPLAY_MAX_DIRTY_RECTS; i++)
+	{
+		uint8_t covered = 0;
+		for (uint8_t rect = 0; rect < display.dirty_count; rect++)
+		{
+			covered |= display.dirty[rect].x0 <= i * 12U && display.dirty[rect].x1 >= i * 12U
+					&& display.dirty[rect].y0 <= i * 10U && display.dirty[rect].y1 >= i * 10U;
+		}
+		TEST_CHECK(covered);
+	}
+	spi_display_rect_t dirty[SPI_DISPLAY_MAX_DIRTY_RECTS];
+	uint8_t dirty_count = display.dirty_count;
+	for (uint8_t rect = 0; rect < dirty_count; rect++)
+	{
+		dirty[rect] = display.dirty[rect];
+	}
+	test_logged = 0;
+	test_read = 0;
+	spi_display_flush(&display);
+	for (uint8_t rect = 0; rect < dirty_count; rect++)
+	{
+		test_expect_rect(dirty[rect].x0, dirty[rect].y0, dirty[rect].x1, dirty[rect].y1);
+	}
+	TEST_CHECK(test_read == test_logged);
+	TEST_CHECK(spi_sim_pin(TEST_SLAVE_PIN) == GPIO_PIN_HIGH);
+
+	uint32_t pin_writes = spi_sim_pin_writes(TEST_SLAVE_PIN);
+	display.bus.ss_polarity = SS_HARDWARE;
+	spi_display_invalidate(&display, 10, 20, 4, 2);
+	test_logged = 0;
+	test_read = 0;
+	spi_display_flush(&display);
+	test_expect_rect(10, 20, 13, 21);
+	TEST_CHECK(test_read == test_logged);
+	TEST_CHECK(spi_sim_pin_writes(TEST_SLAVE_PIN) == pin_writes);
+	TEST_CHECK((spi_sim_regs[TEST_CHANNEL].CR2 & SPI_CR2_SSOE_Msk) == 0);
+
+	printf("test_spi_display: merged regions pushed as CASET, RASET and RAMWR, passed\n");
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function standing in for the panel. It logs each frame with the
+* 	levels of the data/command and select pins. The control registers are read
+* 	past the access hooks, which the sim holds its lock across.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device sending the frame
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	(void)channel;
+	if (test_logged < TEST_LOG_LENGTH)
+	{
+		test_log[test_logged].frame = frame;
+		test_log[test_logged].data = spi_sim_pin(TEST_DC_PIN) == GPIO_PIN_HIGH;
+		uint32_t CR1_state = spi_sim_regs[TEST_CHANNEL].cells[SPI_SIM_CR1];
+		uint32_t CR2_state = spi_sim_regs[TEST_CHANNEL].cells[SPI_SIM_CR2];
+		test_log[test_logged].selected = spi_sim_pin(TEST_SLAVE_PIN) == GPIO_PIN_LOW
+				|| ((CR2_state & SPI_CR2_SSOE_Msk) && !(CR1_state & SPI_CR1_SSM_Msk));
+	}
+	test_logged++;
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_expect_rect()
+*//**
+* \b Description:
+*
+* 	Static function which checks that the next frames in the log are the
+* 	address window and pixels of a region: CASET and RASET with their big
+* 	endian bounds, RAMWR and the framebuffer pixels row by row, all selected.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The frames checked have been consumed from the log
+*
+* @param		x0 leftmost column of the region
+* @param		y0 topmost row of the region
+* @param		x1 rightmost column of the region
+* @param		y1 bottommost row of the region
+* @return 		void
+*
+* \b Example:
+*	Called by main
+*
+* @see spi_display_flush
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void test_expect_rect(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+	uint16_t window[2][5] = {{0x2A, x0 >> 8, x0 & 0xFFU, x1 >> 8, x1 & 0xFFU},
+							{0x2B, y0 >> 8, y0 & 0xFFU, y1 >> 8, y1 & 0xFFU}};
+	for (uint32_t command = 0; command < 2; command++)
+	{
+		for (uint32_t i = 0; i < 5; i++)
+		{
+			TEST_CHECK(test_read < test_logged && test_log[test_read].selected);
+			TEST_CHECK(test_log[test_read].frame == window[command][i] && test_log[test_read].data == (i != 0));
+			test_read++;
+		}
+	}
+	TEST_CHECK(test_read < test_logged);
+	TEST_CHECK(test_log[test_read].frame == 0x2C && !test_log[test_read].data && test_log[test_read].selected);
+	test_read++;
+	for (uint32_t y = y0; y <= y1; y++)
+	{
+		for (uint32_t x = x0; x <= x1; x++)
+		{
+			TEST_CHECK(test_read < test_logged && test_log[test_read].selected && test_log[test_read].data);
+			TEST_CHECK(test_log[test_read].frame == test_pixels[y * TEST_WIDTH + x]);
+			test_read++;
+		}
+	}
+}
@@ -0,0 +1,171 @@
+/*******************************************************************************
+* Title                 :   Full Duplex Kernel Test
+* Filename              :   test_spi_full_duplex.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+
+/** @file test_spi_full_duplex.c
+ *  @brief Checks that the polled full duplex master kernel reloads DR before
+ *  	every frame finishes shifting at PCLK_DIV_2, so the clock never pauses
+ *  	between frames.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+
+/**
+ * Channel and select of the echoing slave
+ */
+#define TEST_CHANNEL		SPI_2
+#define TEST_PIN			GPIO_B_12
+
+/**
+ * Longest transfer run
+ */
+#define TEST_MAX_FRAMES		300U
+
+static void test_stream(spi_data_format_t data_format, uint32_t tx_length, uint32_t rx_length);
+
+/******************************************************************************
+* Function: test_stream()
+*//**
+* \b Description:
+*
+* 	Static function which runs one blocking transfer against the echoing channel
+* 	and checks that it was shifted back to back: every frame found the next one
+* 	already in DR, none was cut short and every frame sent came back, padding
+* 	included.
+*
+* PRE-CONDITION: The channel is initialised at PCLK_DIV_2
+*
+* POST-CONDITION: The process has exited if a check failed
+*
+* @param		data_format 8 or 16 bit frames
+* @param		tx_length frames taken from the transmit buffer
+* @param		rx_length frames clocked and received
+* @return 		void
+*
+* \b Example:
+* @code
+*	test_stream(SPI_DATA_8BIT, 64, 64);
+* @endcode
+*
+* @see spi_sim_stalls
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void test_stream(spi_data_format_t data_format, uint32_t tx_length, uint32_t rx_length)
+{
+	static uint16_t tx[TEST_MAX_FRAMES];
+	static uint16_t rx[TEST_MAX_FRAMES];
+	uint16_t mask = (data_format == SPI_DATA_16BIT) ? 0xFFFFU : 0x00FFU;
+	for (uint32_t i = 0; i < TEST_MAX_FRAMES; i++)
+	{
+		tx[i] = (uint16_t)((0x5A3CU + 0x0101U * i) & mask);
+		rx[i] = 0xDEAD;
+	}
+
+	spi_transfer_t transfer = {0};
+	transfer.channel = TEST_CHANNEL;
+	transfer.slave_pin = TEST_PIN;
+	transfer.ss_polarity = SS_ACTIVE_LOW;
+	transfer.tx_buffer = tx;
+	transfer.tx_length = tx_length;
+	transfer.rx_buffer = rx;
+	transfer.rx_length = rx_length;
+	transfer.data_format = data_format;
+
+	uint32_t frames = spi_sim_frames(TEST_CHANNEL);
+	uint32_t stalls = spi_sim_stalls(TEST_CHANNEL);
+	uint32_t aborts = spi_sim_aborts(TEST_CHANNEL);
+	spi_transfer(&transfer);
+
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) - frames == rx_length);
+	TEST_CHECK(spi_sim_stalls(TEST_CHANNEL) == stalls);
+	TEST_CHECK(spi_sim_aborts(TEST_CHANNEL) == aborts);
+	TEST_CHECK(spi_error_get(TEST_CHANNEL) == SPI_ERROR_NONE);
+	for (uint32_t i = 0; i < rx_length; i++)
+	{
+		TEST_CHECK(rx[i] == ((i < tx_length) ? tx[i] : 0x0000U));
+	}
+	TEST_CHECK(rx[rx_length] == 0xDEAD);
+}
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Streams transfers of one, two, three and many frames through the full duplex
+* 	master kernel at PCLK_DIV_2, in 8 and 16 bit frames and with the transmit
+* 	buffer padded out. None may leave a TXE-empty window between frames.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_2);
+	spi_sim_reset();
+	spi_init(config_table);
+
+	static const uint32_t lengths[] = {1, 2, 3, 17, TEST_MAX_FRAMES - 1U};
+	for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+	{
+		test_stream(SPI_DATA_8BIT, lengths[i], lengths[i]);
+		test_stream(SPI_DATA_16BIT, lengths[i], lengths[i]);
+	}
+	test_stream(SPI_DATA_8BIT, 3, 40);
+	test_stream(SPI_DATA_16BIT, 1, 40);
+
+	TEST_CHECK(spi_sim_stalls(TEST_CHANNEL) == 0);
+	printf("test_spi_full_duplex: %lu frames streamed at PCLK_DIV_2 without a gap, passed\n",
+			(unsigned long)spi_sim_frames(TEST_CHANNEL));
+	return (0);
+}
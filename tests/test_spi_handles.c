@@ -0,0 +1,159 @@
+/*******************************************************************************
+* Title                 :   Channel Handle Test
+* Filename              :   test_spi_handles.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_handles.c
+ *  @brief Checks the per-channel handle table against the device map, and that
+ *  	a transfer on each channel touches only that channel's registers, state
+ *  	and interrupt. The driver is included whole so that the table can be read.
+ */
+#include "../spi_stm32f411.c"
+#include "spi_sim.h"
+#include "test_common.h"
+
+/**
+ * Select used on every channel
+ */
+#define TEST_SLAVE_PIN		GPIO_A_4
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Compares every handle with the register block, RCC bits, bus clock and
+* 	interrupt of its device. Each channel then makes a polled transfer at its
+* 	own configured prescaler, one with an overrun raised, and an interrupt
+* 	transfer serviced through its own interrupt only. No other channel's
+* 	registers, errors or queue may be touched.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_handles
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	volatile uint32_t *const enrs[NUM_SPI] = {&RCC->APB2ENR, &RCC->APB1ENR, &RCC->APB1ENR, &RCC->APB2ENR, &RCC->APB2ENR};
+	volatile uint32_t *const rstrs[NUM_SPI] = {&RCC->APB2RSTR, &RCC->APB1RSTR, &RCC->APB1RSTR, &RCC->APB2RSTR, &RCC->APB2RSTR};
+	const uint32_t msks[NUM_SPI] = {RCC_APB2ENR_SPI1EN_Msk, RCC_APB1ENR_SPI2EN_Msk, RCC_APB1ENR_SPI3EN_Msk,
+									RCC_APB2ENR_SPI4EN_Msk, RCC_APB2ENR_SPI5EN_Msk};
+	const uint32_t pclks[NUM_SPI] = {SPI_APB2_CLOCK_HZ, SPI_APB1_CLOCK_HZ, SPI_APB1_CLOCK_HZ, SPI_APB2_CLOCK_HZ, SPI_APB2_CLOCK_HZ};
+	const IRQn_Type irqns[NUM_SPI] = {SPI1_IRQn, SPI2_IRQn, SPI3_IRQn, SPI4_IRQn, SPI5_IRQn};
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		const spi_handle_t *handle = &spi_handles[channel];
+		TEST_CHECK(handle->regs == &spi_sim_regs[channel]);
+		TEST_CHECK(handle->rcc_enr == enrs[channel] && handle->rcc_rstr == rstrs[channel]);
+		TEST_CHECK(handle->rcc_msk == msks[channel] && handle->pclk_hz == pclks[channel]);
+		TEST_CHECK(handle->irqn == irqns[channel]);
+	}
+
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		test_config_master(config_table, (spi_channel_t)channel, (spi_baud_rate_t)(PCLK_DIV_4 + channel));
+	}
+	spi_sim_reset();
+	spi_init(config_table);
+
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		uint16_t tx[3] = {0x11, 0x22, (uint16_t)channel};
+		uint16_t rx[3];
+		spi_transfer_t transfer = {0};
+		transfer.channel = (spi_channel_t)channel;
+		transfer.slave_pin = TEST_SLAVE_PIN;
+		transfer.ss_polarity = SS_ACTIVE_LOW;
+		transfer.tx_buffer = tx;
+		transfer.tx_length = 3;
+		transfer.rx_buffer = rx;
+		transfer.rx_length = 3;
+		transfer.data_format = SPI_DATA_8BIT;
+
+		uint32_t accesses[NUM_SPI];
+		uint32_t frames[NUM_SPI];
+		uint32_t heads[NUM_SPI];
+		for (int other = 0; other < NUM_SPI; other++)
+		{
+			accesses[other] = spi_sim_accesses((spi_channel_t)other);
+			frames[other] = spi_sim_frames((spi_channel_t)other);
+			heads[other] = spi_queues[other].head;
+		}
+		spi_transfer(&transfer);
+		TEST_CHECK(rx[0] == 0x11 && rx[1] == 0x22 && rx[2] == channel);
+		TEST_CHECK(((spi_sim_regs[channel].cells[SPI_SIM_CR1] & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos)
+					== (uint32_t)(PCLK_DIV_4 + channel));
+
+		spi_sim_raise((spi_channel_t)channel, SPI_SR_OVR_Msk);
+		spi_transfer(&transfer);
+		for (int other = 0; other < NUM_SPI; other++)
+		{
+			TEST_CHECK(spi_error_get((spi_channel_t)other) == ((other == channel) ? SPI_ERROR_OVERRUN : SPI_ERROR_NONE));
+		}
+		spi_transfer(&transfer);
+		TEST_CHECK(spi_error_get((spi_channel_t)channel) == SPI_ERROR_NONE);
+
+		TEST_CHECK(spi_transfer_submit(&transfer));
+		spi_sim_service((spi_channel_t)channel);
+		spi_transfer_t completed;
+		TEST_CHECK(spi_transfer_reap((spi_channel_t)channel, &completed) && completed.rx_length == 0);
+
+		for (int other = 0; other < NUM_SPI; other++)
+		{
+			if (other == channel)
+			{
+				TEST_CHECK(spi_sim_frames((spi_channel_t)other) - frames[other] == 4 * 3);
+			}
+			else
+			{
+				TEST_CHECK(spi_sim_accesses((spi_channel_t)other) == accesses[other]);
+				TEST_CHECK(spi_sim_frames((spi_channel_t)other) == frames[other]);
+				TEST_CHECK(spi_queues[other].head == heads[other] && !spi_queues[other].active);
+			}
+		}
+	}
+
+	printf("test_spi_handles: %d handles match their devices and stay apart, passed\n", NUM_SPI);
+	return (0);
+}
@@ -0,0 +1,144 @@
+/*******************************************************************************
+* Title                 :   Init Test
+* Filename              :   test_spi_init.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_init.c
+ *  @brief Checks the register images spi_init writes for each kind of channel
+ *  	configuration, that only enabled channels are clocked, and reports the
+ *  	simulated cost of the init. spi_deinit is then checked to stop the clocks
+ *  	again.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+
+/**
+ * Polynomial given to the receive only channel
+ */
+#define TEST_POLYNOMIAL		0x1021U
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Configures SPI_1 as a software managed master, SPI_3 as a bidirectional TI
+* 	slave and SPI_5 as a receive only master with DMA requests, NSS output and a
+* 	CRC polynomial, leaving SPI_2 and SPI_4 disabled with fields set. Each
+* 	enabled channel must be written once per register with the image its entry
+* 	describes and SPE clear, and only its clock enabled.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_init
+* @see spi_deinit
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, SPI_1, PCLK_DIV_8);
+
+	config_table[SPI_3].spi_enable = SPI_ENABLE;
+	config_table[SPI_3].master_slave = SPI_SLAVE;
+	config_table[SPI_3].slave_management = HARDWARE_SMM;
+	config_table[SPI_3].bidirectional_mode = BIDIR_MODE;
+	config_table[SPI_3].frame_format = SPI_TI;
+
+	config_table[SPI_5].spi_enable = SPI_ENABLE;
+	config_table[SPI_5].master_slave = SPI_MASTER;
+	config_table[SPI_5].slave_management = HARDWARE_SMM;
+	config_table[SPI_5].bidirectional_mode = UNIDIR_RXONLY;
+	config_table[SPI_5].baud_rate = PCLK_DIV_64;
+	config_table[SPI_5].crc_polynomial = TEST_POLYNOMIAL;
+	config_table[SPI_5].rx_dma = RX_DMA_REQ_ENABLE;
+	config_table[SPI_5].tx_dma = TX_DMA_REQ_ENABLE;
+	config_table[SPI_5].ss_output = SS_OUTPUT_ENABLE;
+
+	/* Disabled channels with every field set must be left alone */
+	test_config_master(config_table, SPI_2, PCLK_DIV_256);
+	test_config_master(config_table, SPI_4, PCLK_DIV_256);
+	config_table[SPI_2].spi_enable = SPI_DISABLE;
+	config_table[SPI_4].spi_enable = SPI_DISABLE;
+	config_table[SPI_4].crc_polynomial = TEST_POLYNOMIAL;
+
+	spi_sim_reset();
+	uint32_t start = spi_sim_cycles();
+	spi_init(config_table);
+	uint32_t init_cycles = spi_sim_cycles() - start;
+
+	/* Read before the checks, which access the registers themselves */
+	uint32_t accesses[NUM_SPI];
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		accesses[channel] = spi_sim_accesses((spi_channel_t)channel);
+	}
+	TEST_CHECK(accesses[SPI_1] == 2 && accesses[SPI_3] == 2 && accesses[SPI_5] == 3);
+	TEST_CHECK(accesses[SPI_2] == 0 && accesses[SPI_4] == 0);
+
+	TEST_CHECK(spi_sim_rcc.APB2ENR == (RCC_APB2ENR_SPI1EN_Msk | RCC_APB2ENR_SPI5EN_Msk));
+	TEST_CHECK(spi_sim_rcc.APB1ENR == RCC_APB1ENR_SPI3EN_Msk);
+
+	TEST_CHECK(spi_sim_regs[SPI_1].CR1 == (SPI_CR1_MSTR_Msk | SPI_CR1_SSM_Msk | SPI_CR1_SSI_Msk
+											| (PCLK_DIV_8 << SPI_CR1_BR_Pos)));
+	TEST_CHECK(spi_sim_regs[SPI_1].CR2 == 0);
+	TEST_CHECK(spi_sim_regs[SPI_3].CR1 == SPI_CR1_BIDIMODE_Msk);
+	TEST_CHECK(spi_sim_regs[SPI_3].CR2 == SPI_CR2_FRF_Msk);
+	TEST_CHECK(spi_sim_regs[SPI_5].CR1 == (SPI_CR1_MSTR_Msk | SPI_CR1_RXONLY_Msk | (PCLK_DIV_64 << SPI_CR1_BR_Pos)));
+	TEST_CHECK(spi_sim_regs[SPI_5].CR2 == (SPI_CR2_RXDMAEN_Msk | SPI_CR2_TXDMAEN_Msk | SPI_CR2_SSOE_Msk));
+	TEST_CHECK(spi_sim_regs[SPI_5].CRCPR == TEST_POLYNOMIAL);
+	TEST_CHECK(spi_sim_regs[SPI_2].CR1 == 0 && spi_sim_regs[SPI_2].CR2 == 0);
+	TEST_CHECK(spi_sim_regs[SPI_4].CR1 == 0 && spi_sim_regs[SPI_4].CR2 == 0 && spi_sim_regs[SPI_4].CRCPR == 0);
+	TEST_CHECK((spi_sim_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0);
+
+	printf("test_spi_init: 3 of %d channels in %lu cycles, %lu register accesses\n", NUM_SPI,
+			(unsigned long)init_cycles, (unsigned long)(accesses[SPI_1] + accesses[SPI_3] + accesses[SPI_5]));
+
+	spi_deinit(config_table);
+	TEST_CHECK(spi_sim_rcc.APB1ENR == 0 && spi_sim_rcc.APB2ENR == 0);
+	TEST_CHECK((spi_sim_regs[SPI_1].CR1 & SPI_CR1_SPE_Msk) == 0);
+
+	printf("test_spi_init: register images and clock enables, passed\n");
+	return (0);
+}
@@ -0,0 +1,462 @@
+/*******************************************************************************
+* Title                 :   Slave Model Test
+* Filename              :   test_spi_model.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+
+/** @file test_spi_model.c
+ *  @brief Runs the NOR flash, SD card and shift chain models behind their select
+ *  	pins on the simulated channel, driven through spi_transfer, and reports
+ *  	the simulated cost of each operation.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+
+/**
+ * Channel shared by the models, and the select of each
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_FLASH_PIN		GPIO_A_4
+#define TEST_SD_PIN			GPIO_A_8
+#define TEST_CHAIN_PIN		GPIO_A_9
+
+/**
+ * Size of the flash and of the card, and the frames held low after a card write
+ */
+#define TEST_FLASH_SIZE		0x10000UL
+#define TEST_SD_BLOCKS		8U
+#define TEST_SD_BUSY		4U
+
+/**
+ * Address, in the second flash sector, and length of the page programmed
+ */
+#define TEST_PAGE_ADDRESS	0x1080UL
+#define TEST_PAGE_LENGTH	64U
+
+/**
+ * Struct holding the simulated counters at the start of an operation
+ */
+typedef struct
+{
+	uint32_t cycles;	/**<spi_sim_cycles */
+	uint32_t accesses;	/**<spi_sim_accesses of the channel */
+	uint32_t frames;	/**<spi_sim_frames of the channel */
+	uint32_t stalls;	/**<spi_sim_stalls of the channel */
+}test_mark_t;
+
+static uint8_t test_flash_memory[TEST_FLASH_SIZE];
+static uint8_t test_sd_blocks[TEST_SD_BLOCKS * SPI_MODEL_SD_BLOCK];
+static uint16_t test_tx[SPI_MODEL_SD_BLOCK + 16U];
+static uint16_t test_rx[SPI_MODEL_SD_BLOCK + 16U];
+
+static void test_exchange(gpio_pin_t pin, uint32_t tx_length, uint32_t rx_length);
+static void test_mark(test_mark_t *mark);
+static void test_report(const char *operation, const test_mark_t *mark);
+static uint8_t test_sd_command(uint8_t index, uint32_t argument, uint32_t extra);
+
+/******************************************************************************
+* Function: test_exchange()
+*//**
+* \b Description:
+*
+* 	Sends the first tx_length frames of test_tx to the slave behind pin as one 8
+* 	bit transfer, padded to rx_length, and leaves what came back in test_rx.
+*
+* PRE-CONDITION: spi_init has run and the slave is attached
+*
+* POST-CONDITION: The select of the slave has been released
+*
+* @param		pin the select of the slave
+* @param		tx_length the frames of test_tx to send
+* @param		rx_length the frames kept in test_rx
+* @return 		void
+*
+* \b Example:
+* @code
+*	test_tx[0] = 0x9F;
+*	test_exchange(TEST_FLASH_PIN, 1, 4);
+* @endcode
+*
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void test_exchange(gpio_pin_t pin, uint32_t tx_length, uint32_t rx_length)
+{
+	spi_transfer_t transfer = {0};
+	transfer.channel = TEST_CHANNEL;
+	transfer.slave_pin = pin;
+	transfer.ss_polarity = SS_ACTIVE_LOW;
+	transfer.tx_buffer = test_tx;
+	transfer.tx_length = tx_length;
+	transfer.rx_buffer = test_rx;
+	transfer.rx_length = rx_length;
+	transfer.data_format = SPI_DATA_8BIT;
+	spi_transfer(&transfer);
+	TEST_CHECK(spi_sim_pin(pin) == GPIO_PIN_HIGH);
+}
+
+/******************************************************************************
+* Function: test_mark()
+*//**
+* \b Description:
+*
+* 	Samples the simulated cycle, register access, frame and stall counters of
+* 	the channel before an operation.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: mark holds the counters
+*
+* @param		mark the sample to fill
+* @return 		void
+*
+* \b Example:
+* @code
+*	test_mark_t mark;
+*	test_mark(&mark);
+* @endcode
+*
+* @see test_report
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void test_mark(test_mark_t *mark)
+{
+	mark->cycles = spi_sim_cycles();
+	mark->accesses = spi_sim_accesses(TEST_CHANNEL);
+	mark->frames = spi_sim_frames(TEST_CHANNEL);
+	mark->stalls = spi_sim_stalls(TEST_CHANNEL);
+}
+
+/******************************************************************************
+* Function: test_report()
+*//**
+* \b Description:
+*
+* 	Prints what an operation cost since mark was taken: simulated cycles,
+* 	register accesses and frames, and the cycles per frame against the 16 a byte
+* 	takes to shift at PCLK_DIV_2. The shift time is a floor no operation can
+* 	beat, so it is also checked.
+*
+* PRE-CONDITION: mark was taken by test_mark before the operation
+*
+* POST-CONDITION: A line has been printed
+*
+* @param		operation name of the operation
+* @param		mark the counters before it
+* @return 		void
+*
+* \b Example:
+* @code
+*	test_report("flash read", &mark);
+* @endcode
+*
+* @see test_mark
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void test_report(const char *operation, const test_mark_t *mark)
+{
+	uint32_t cycles = spi_sim_cycles() - mark->cycles;
+	uint32_t accesses = spi_sim_accesses(TEST_CHANNEL) - mark->accesses;
+	uint32_t frames = spi_sim_frames(TEST_CHANNEL) - mark->frames;
+	uint32_t stalls = spi_sim_stalls(TEST_CHANNEL) - mark->stalls;
+
+	TEST_CHECK(frames != 0 && cycles >= 16U * frames);
+	printf("  %-24s %6lu frames %8lu cycles %8lu accesses %5.1f cycles/frame %4lu stalls\n", operation,
+			(unsigned long)frames, (unsigned long)cycles, (unsigned long)accesses,
+			(double)cycles / frames, (unsigned long)stalls);
+}
+
+/******************************************************************************
+* Function: test_sd_command()
+*//**
+* \b Description:
+*
+* 	Sends a command frame to the card followed by extra padding frames, and
+* 	returns the R1 found two frames after the command. The rest of the reply
+* 	stays in test_rx from index 8.
+*
+* PRE-CONDITION: The card model is attached at TEST_SD_PIN
+*
+* POST-CONDITION: test_rx holds the reply
+*
+* @param		index the command number
+* @param		argument the 32 bit argument
+* @param		extra frames clocked after the R1
+* @return 		uint8_t the R1 response
+*
+* \b Example:
+* @code
+*	TEST_CHECK(test_sd_command(0, 0, 0) == 0x01);
+* @endcode
+*
+* @see test_exchange
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint8_t test_sd_command(uint8_t index, uint32_t argument, uint32_t extra)
+{
+	test_tx[0] = 0x40U | index;
+	test_tx[1] = (uint8_t)(argument >> 24);
+	test_tx[2] = (uint8_t)(argument >> 16);
+	test_tx[3] = (uint8_t)(argument >> 8);
+	test_tx[4] = (uint8_t)argument;
+	test_tx[5] = (index == 8) ? 0x87U : 0x95U;
+	test_exchange(TEST_SD_PIN, 6, 8 + extra);
+	TEST_CHECK(test_rx[6] == 0xFF);
+	return ((uint8_t)test_rx[7]);
+}
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Attaches a NOR flash, an SD card and a shift register chain to one channel
+* 	behind their own selects and runs each through the driver at PCLK_DIV_2. The
+* 	flash is identified, erased, programmed and read back with its busy polls
+* 	counted; the card is brought out of idle, written and read a block at a
+* 	time; the chain is loaded and latched. Each operation's simulated cost is
+* 	printed as it goes.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_sim_attach
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_2);
+	spi_sim_reset();
+	spi_init(config_table);
+
+	static spi_model_t flash;
+	flash.kind = MODEL_NOR_FLASH;
+	flash.device.flash.memory = test_flash_memory;
+	flash.device.flash.size = TEST_FLASH_SIZE;
+	flash.device.flash.jedec_id[0] = 0xEF;
+	flash.device.flash.jedec_id[1] = 0x40;
+	flash.device.flash.jedec_id[2] = 0x10;
+	flash.device.flash.busy_polls = 3;
+	spi_model_init(&flash);
+	spi_sim_attach(TEST_CHANNEL, TEST_FLASH_PIN, &flash);
+
+	static spi_model_t card;
+	card.kind = MODEL_SD_CARD;
+	card.device.sd.blocks = test_sd_blocks;
+	card.device.sd.num_blocks = TEST_SD_BLOCKS;
+	card.device.sd.init_polls = 2;
+	card.device.sd.busy_frames = TEST_SD_BUSY;
+	spi_model_init(&card);
+	spi_sim_attach(TEST_CHANNEL, TEST_SD_PIN, &card);
+
+	static spi_model_t chain;
+	chain.kind = MODEL_SHIFT_CHAIN;
+	chain.device.chain.num_bytes = 3;
+	spi_model_init(&chain);
+	chain.device.chain.inputs[0] = 0x11;
+	chain.device.chain.inputs[1] = 0x22;
+	chain.device.chain.inputs[2] = 0x33;
+	spi_sim_attach(TEST_CHANNEL, TEST_CHAIN_PIN, &chain);
+
+	for (uint32_t i = 0; i < TEST_FLASH_SIZE; i++)
+	{
+		test_flash_memory[i] = (uint8_t)(i ^ (i >> 8));
+	}
+	test_mark_t mark;
+	printf("test_spi_model: simulated cost at PCLK_DIV_2\n");
+
+	/* NOR flash: RDID, READ, then SE and PP with the busy status polled out */
+	test_mark(&mark);
+	test_tx[0] = 0x9F;
+	test_exchange(TEST_FLASH_PIN, 1, 4);
+	TEST_CHECK(test_rx[1] == 0xEF && test_rx[2] == 0x40 && test_rx[3] == 0x10);
+	test_report("flash RDID", &mark);
+
+	test_mark(&mark);
+	test_tx[0] = 0x03;
+	test_tx[1] = 0x00;
+	test_tx[2] = 0x01;
+	test_tx[3] = 0x23;
+	test_exchange(TEST_FLASH_PIN, 4, 4 + 256);
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		TEST_CHECK(test_rx[4 + i] == test_flash_memory[0x123 + i]);
+	}
+	test_report("flash READ 256", &mark);
+
+	test_mark(&mark);
+	test_tx[0] = 0x06;
+	test_exchange(TEST_FLASH_PIN, 1, 1);
+	test_tx[0] = 0x20;
+	test_tx[1] = (uint8_t)(TEST_PAGE_ADDRESS >> 16);
+	test_tx[2] = (uint8_t)(TEST_PAGE_ADDRESS >> 8);
+	test_tx[3] = (uint8_t)TEST_PAGE_ADDRESS;
+	test_exchange(TEST_FLASH_PIN, 4, 4);
+	uint32_t polls = 0;
+	do
+	{
+		test_tx[0] = 0x05;
+		test_exchange(TEST_FLASH_PIN, 1, 2);
+		polls++;
+	} while (test_rx[1] & 0x01);
+	TEST_CHECK(polls == 4 && test_rx[1] == 0x00);
+	test_report("flash WREN, SE, RDSR", &mark);
+	TEST_CHECK(test_flash_memory[0x0FFF] == (uint8_t)(0x0FFF ^ 0x0F) && test_flash_memory[0x2000] == (uint8_t)(0x2000 ^ 0x20));
+	for (uint32_t i = 0x1000; i < 0x2000; i++)
+	{
+		TEST_CHECK(test_flash_memory[i] == 0xFF);
+	}
+
+	test_mark(&mark);
+	test_tx[0] = 0x06;
+	test_exchange(TEST_FLASH_PIN, 1, 1);
+	test_tx[0] = 0x02;
+	test_tx[1] = (uint8_t)(TEST_PAGE_ADDRESS >> 16);
+	test_tx[2] = (uint8_t)(TEST_PAGE_ADDRESS >> 8);
+	test_tx[3] = (uint8_t)TEST_PAGE_ADDRESS;
+	for (uint32_t i = 0; i < TEST_PAGE_LENGTH; i++)
+	{
+		test_tx[4 + i] = (uint8_t)(0xC0 + i);
+	}
+	test_exchange(TEST_FLASH_PIN, 4 + TEST_PAGE_LENGTH, 4 + TEST_PAGE_LENGTH);
+	test_tx[0] = 0x03;
+	test_exchange(TEST_FLASH_PIN, 1, 1);
+	TEST_CHECK(flash.device.flash.command == 0x00);
+	polls = 0;
+	do
+	{
+		test_tx[0] = 0x05;
+		test_exchange(TEST_FLASH_PIN, 1, 2);
+		polls++;
+	} while (test_rx[1] & 0x01);
+	TEST_CHECK(polls == 4);
+	test_report("flash WREN, PP 64, RDSR", &mark);
+	for (uint32_t i = 0; i < TEST_PAGE_LENGTH; i++)
+	{
+		TEST_CHECK(test_flash_memory[TEST_PAGE_ADDRESS + i] == (uint8_t)(0xC0 + i));
+	}
+	TEST_CHECK(test_flash_memory[TEST_PAGE_ADDRESS - 1] == 0xFF && test_flash_memory[TEST_PAGE_ADDRESS + TEST_PAGE_LENGTH] == 0xFF);
+	uint32_t flash_frames = flash.frames;
+
+	/* SD card: CMD0, CMD8, CMD55 + ACMD41 until ready, CMD58, then CMD24 and CMD17 */
+	test_mark(&mark);
+	TEST_CHECK(test_sd_command(0, 0, 0) == 0x01);
+	TEST_CHECK(test_sd_command(8, 0x1AA, 4) == 0x01 && test_rx[10] == 0x01 && test_rx[11] == 0xAA);
+	uint32_t inits = 0;
+	uint8_t r1;
+	do
+	{
+		TEST_CHECK(test_sd_command(55, 0, 0) <= 0x01);
+		r1 = test_sd_command(41, 0x40000000UL, 0);
+		inits++;
+	} while (r1 == 0x01);
+	TEST_CHECK(r1 == 0x00 && inits == 3);
+	TEST_CHECK(test_sd_command(58, 0, 4) == 0x00 && test_rx[8] == 0xC0);
+	test_report("card init", &mark);
+
+	test_mark(&mark);
+	TEST_CHECK(test_sd_command(24, 3, 0) == 0x00);
+	test_tx[0] = 0xFE;
+	for (uint32_t i = 0; i < SPI_MODEL_SD_BLOCK; i++)
+	{
+		test_tx[1 + i] = (uint8_t)(i * 7U + 1U);
+	}
+	test_tx[1 + SPI_MODEL_SD_BLOCK] = 0xFF;
+	test_tx[2 + SPI_MODEL_SD_BLOCK] = 0xFF;
+	test_exchange(TEST_SD_PIN, 3 + SPI_MODEL_SD_BLOCK, 3 + SPI_MODEL_SD_BLOCK + 1 + TEST_SD_BUSY + 1);
+	TEST_CHECK((test_rx[3 + SPI_MODEL_SD_BLOCK] & 0x1F) == 0x05);
+	for (uint32_t i = 0; i < TEST_SD_BUSY; i++)
+	{
+		TEST_CHECK(test_rx[4 + SPI_MODEL_SD_BLOCK + i] == 0x00);
+	}
+	TEST_CHECK(test_rx[4 + SPI_MODEL_SD_BLOCK + TEST_SD_BUSY] == 0xFF);
+	test_report("card CMD24 block", &mark);
+	TEST_CHECK(test_sd_blocks[3 * SPI_MODEL_SD_BLOCK + 100] == (uint8_t)(100 * 7 + 1));
+	TEST_CHECK(test_sd_blocks[2 * SPI_MODEL_SD_BLOCK + 511] == 0 && test_sd_blocks[4 * SPI_MODEL_SD_BLOCK] == 0);
+
+	test_mark(&mark);
+	TEST_CHECK(test_sd_command(17, 3, 1 + SPI_MODEL_SD_BLOCK + 2) == 0x00 && test_rx[8] == 0xFE);
+	for (uint32_t i = 0; i < SPI_MODEL_SD_BLOCK; i++)
+	{
+		TEST_CHECK(test_rx[9 + i] == (uint8_t)(i * 7U + 1U));
+	}
+	test_report("card CMD17 block", &mark);
+	TEST_CHECK(test_sd_command(17, TEST_SD_BLOCKS, 0) == 0x40);
+
+	/* Shift chain: the inputs come out farthest first and the bytes sent are latched on release */
+	test_mark(&mark);
+	test_tx[0] = 0xA1;
+	test_tx[1] = 0xA2;
+	test_tx[2] = 0xA3;
+	test_exchange(TEST_CHAIN_PIN, 3, 3);
+	TEST_CHECK(test_rx[0] == 0x33 && test_rx[1] == 0x22 && test_rx[2] == 0x11);
+	TEST_CHECK(chain.device.chain.outputs[0] == 0xA3 && chain.device.chain.outputs[1] == 0xA2 && chain.device.chain.outputs[2] == 0xA1);
+	test_report("chain load and latch", &mark);
+
+	/* Each model saw only the traffic behind its own select */
+	TEST_CHECK(flash.frames == flash_frames && flash.selected == 0 && card.selected == 0 && chain.selected == 0);
+	TEST_CHECK(chain.selections == 1 && chain.frames == 3);
+
+	printf("test_spi_model: flash, card and chain driven through the driver, passed\n");
+	return (0);
+}
@@ -0,0 +1,241 @@
+/*******************************************************************************
+* Title                 :   Multi-Channel Transfer Test
+* Filename              :   test_spi_multi.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_multi.c
+ *  @brief Runs spi_transfer_multi over channels of different speeds and kinds,
+ *  	checking that the full duplex masters run interleaved and each completes
+ *  	with its own data, that the rest follow once they are done, and that the
+ *  	call takes less simulated time than the same transfers one by one.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+
+/**
+ * Frames of each transfer, and the most the log can hold
+ */
+#define TEST_SHORT			24U
+#define TEST_LONG			64U
+#define TEST_LOG_LENGTH		1024U
+
+/**
+ * Channel of each frame seen on any bus, in order
+ */
+static spi_channel_t test_log[TEST_LOG_LENGTH];
+static uint32_t test_logged;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Issues a long read on a fast channel, a short read on a slow one, a transmit
+* 	only burst on a third and a receive only read on a fourth in one call. The
+* 	three full duplex transfers must have shared the bus time, each receiving
+* 	its own channel's replies and releasing its select; the receive only one
+* 	must run after them. The same transfers made one at a time must take longer.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_transfer_multi
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, SPI_1, PCLK_DIV_4);
+	test_config_master(config_table, SPI_2, PCLK_DIV_32);
+	test_config_master(config_table, SPI_3, PCLK_DIV_8);
+	test_config_master(config_table, SPI_5, PCLK_DIV_8);
+	config_table[SPI_5].bidirectional_mode = UNIDIR_RXONLY;
+	spi_sim_reset();
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		spi_sim_set_responder((spi_channel_t)channel, test_responder);
+	}
+	spi_init(config_table);
+
+	static uint16_t tx[3][TEST_LONG];
+	static uint16_t rx[2][TEST_LONG + 1];
+	static uint16_t rxonly[5];
+	spi_channel_t channels[4] = {SPI_1, SPI_2, SPI_3, SPI_5};
+	gpio_pin_t pins[4] = {GPIO_A_4, GPIO_B_12, GPIO_A_15, GPIO_B_1};
+	uint32_t lengths[4] = {TEST_LONG, TEST_SHORT, TEST_LONG, 4};
+	spi_transfer_t transfers[4];
+	spi_transfer_t *requests[4];
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		spi_transfer_t transfer = {0};
+		transfer.channel = channels[i];
+		transfer.slave_pin = pins[i];
+		transfer.ss_polarity = SS_ACTIVE_LOW;
+		transfer.data_format = SPI_DATA_16BIT;
+		if (i < 3)
+		{
+			for (uint32_t frame = 0; frame < lengths[i]; frame++)
+			{
+				tx[i][frame] = (uint16_t)((i << 12) | frame);
+			}
+			transfer.tx_buffer = tx[i];
+			transfer.tx_length = lengths[i];
+		}
+		if (i != 2)
+		{
+			transfer.rx_buffer = (i < 2) ? rx[i] : rxonly;
+			transfer.rx_length = lengths[i];
+		}
+		transfers[i] = transfer;
+		requests[i] = &transfers[i];
+	}
+
+	for (uint32_t round = 0; round < 2; round++)
+	{
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			for (uint32_t frame = 0; frame <= lengths[i]; frame++)
+			{
+				rx[i][frame] = 0xDEAD;
+			}
+		}
+		rxonly[4] = 0xDEAD;
+		test_logged = 0;
+		uint32_t start = spi_sim_cycles();
+		spi_transfer_multi(requests, 4);
+		uint32_t multi_cycles = spi_sim_cycles() - start;
+
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			for (uint32_t frame = 0; frame < lengths[i]; frame++)
+			{
+				TEST_CHECK(rx[i][frame] == (uint16_t)(tx[i][frame] ^ (channels[i] << 8)));
+			}
+			TEST_CHECK(rx[i][lengths[i]] == 0xDEAD);
+		}
+		TEST_CHECK(rxonly[4] == 0xDEAD);
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			TEST_CHECK(spi_sim_pin(pins[i]) == GPIO_PIN_HIGH);
+			TEST_CHECK(spi_sim_pin_writes(pins[i]) == 2 * (round + 1));
+			TEST_CHECK(spi_error_get(channels[i]) == SPI_ERROR_NONE);
+		}
+		TEST_CHECK(transfers[0].tx_buffer == tx[0] && transfers[0].rx_length == TEST_LONG);
+
+		/* Each full duplex channel sends its first frame before any other finishes */
+		uint32_t first[NUM_SPI];
+		uint32_t last[NUM_SPI];
+		uint32_t seen[NUM_SPI] = {0};
+		for (uint32_t frame = 0; frame < test_logged; frame++)
+		{
+			spi_channel_t channel = test_log[frame];
+			first[channel] = (seen[channel] == 0) ? frame : first[channel];
+			last[channel] = frame;
+			seen[channel]++;
+		}
+		TEST_CHECK(seen[SPI_1] == TEST_LONG && seen[SPI_2] == TEST_SHORT && seen[SPI_3] == TEST_LONG);
+		TEST_CHECK(seen[SPI_5] >= 4);
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				TEST_CHECK(first[channels[i]] < last[channels[j]]);
+			}
+			TEST_CHECK(last[channels[i]] < first[SPI_5]);
+		}
+
+		if (round == 1)
+		{
+			start = spi_sim_cycles();
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				spi_transfer(&transfers[i]);
+			}
+			uint32_t serial_cycles = spi_sim_cycles() - start;
+			TEST_CHECK(multi_cycles < serial_cycles);
+			printf("test_spi_multi: %lu cycles for the call, %lu for the transfers one by one\n",
+					(unsigned long)multi_cycles, (unsigned long)serial_cycles);
+		}
+	}
+
+	printf("test_spi_multi: four channels interleaved and completed, passed\n");
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function which logs the channel of each frame and answers it with the
+* 	frame marked with its channel, so that replies crossing channels are caught.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device sending the frame
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	if (test_logged < TEST_LOG_LENGTH)
+	{
+		test_log[test_logged] = channel;
+		test_logged++;
+	}
+	return ((uint16_t)(frame ^ (channel << 8)));
+}
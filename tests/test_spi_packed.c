@@ -0,0 +1,287 @@
+/*******************************************************************************
+* Title                 :   Packed Byte Order Test
+* Filename              :   test_spi_packed.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_packed.c
+ *  @brief Checks that packed transfers put the bytes on the wire, and back into
+ *  	the receive buffer, in buffer order for both bit orders, on the polled and
+ *  	interrupt paths, with odd lengths finished by a single 8 bit frame.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+#include <string.h>
+
+/**
+ * Channel and select of the slave
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_PIN			GPIO_A_4
+
+/**
+ * Longest transfer run, in bytes
+ */
+#define TEST_MAX_BYTES		16U
+
+/**
+ * Left after the last byte received, which must not be written
+ */
+#define TEST_GUARD			0x5AU
+
+static uint16_t test_respond(spi_channel_t channel, uint16_t frame);
+static void test_run(spi_bit_format_t bit_format, uint32_t tx_length, uint32_t rx_length, uint8_t receive, uint8_t interrupt);
+
+/**
+ * Bytes in the order they went over the wire, and the frames they went in
+ */
+static uint8_t test_wire[TEST_MAX_BYTES];
+static uint32_t test_wire_count;
+static uint32_t test_narrow_count;
+static uint32_t test_narrow_at;
+
+/******************************************************************************
+* Function: test_respond()
+*//**
+* \b Description:
+*
+* 	Static function which takes a frame written to DR apart into the bytes that
+* 	go over the wire, first byte first, as the bit order and frame width set in
+* 	CR1 shift them. It logs the bytes and answers with a byte stream counting up
+* 	from 0xC0, put back together the same way.
+*
+* PRE-CONDITION: No more than TEST_MAX_BYTES bytes are sent between resets of
+* 					test_wire_count
+*
+* POST-CONDITION: The bytes have been appended to test_wire
+*
+* @param		channel the spi device
+* @param		frame the frame written to DR
+* @return 		uint16_t the reply frame
+*
+* \b Example:
+*	Called by the simulation for every frame
+*
+* @see test_run
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_respond(spi_channel_t channel, uint16_t frame)
+{
+	uint32_t CR1_state = spi_sim_regs[channel].cells[SPI_SIM_CR1];
+	uint8_t lsb_first = (CR1_state & SPI_CR1_LSBFIRST_Msk) != 0;
+
+	if ((CR1_state & SPI_CR1_DFF_Msk) == 0)
+	{
+		test_narrow_count++;
+		test_narrow_at = test_wire_count;
+		test_wire[test_wire_count] = (uint8_t)frame;
+		return ((uint16_t)(0xC0U + test_wire_count++));
+	}
+
+	uint8_t first = lsb_first ? (uint8_t)frame : (uint8_t)(frame >> 8);
+	uint8_t second = lsb_first ? (uint8_t)(frame >> 8) : (uint8_t)frame;
+	uint8_t reply_first = (uint8_t)(0xC0U + test_wire_count);
+	uint8_t reply_second = (uint8_t)(0xC1U + test_wire_count);
+	test_wire[test_wire_count++] = first;
+	test_wire[test_wire_count++] = second;
+	return (lsb_first ? (uint16_t)(reply_first | (reply_second << 8))
+					: (uint16_t)((reply_first << 8) | reply_second));
+}
+
+/******************************************************************************
+* Function: test_run()
+*//**
+* \b Description:
+*
+* 	Static function which runs one packed transfer and checks that the bytes
+* 	of the transmit buffer went out in order followed by dummy bytes, that the
+* 	replies landed in the receive buffer in order without touching the byte
+* 	after it, and that an odd length took a single 8 bit frame at the end.
+*
+* PRE-CONDITION: TEST_CHANNEL is initialised and answered by test_respond
+*
+* POST-CONDITION: The process has exited if a check failed
+*
+* @param		bit_format MSB or LSB first
+* @param		tx_length bytes taken from the transmit buffer
+* @param		rx_length bytes clocked, and received if receive is set
+* @param		receive non-zero to pass a receive buffer
+* @param		interrupt non-zero to run the transfer from the interrupt
+* @return 		void
+*
+* \b Example:
+* @code
+*	test_run(MSB_FIRST, 3, 3, 1, 0);
+* @endcode
+*
+* @see test_respond
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void test_run(spi_bit_format_t bit_format, uint32_t tx_length, uint32_t rx_length, uint8_t receive, uint8_t interrupt)
+{
+	uint16_t tx[TEST_MAX_BYTES / 2];
+	uint16_t rx[TEST_MAX_BYTES / 2 + 1];
+	uint8_t *tx_bytes = (uint8_t *)tx;
+	uint8_t *rx_bytes = (uint8_t *)rx;
+	for (uint32_t i = 0; i < TEST_MAX_BYTES; i++)
+	{
+		tx_bytes[i] = (uint8_t)(0x10U + i);
+	}
+	memset(rx, TEST_GUARD, sizeof(rx));
+
+	spi_transfer_t transfer = {0};
+	transfer.channel = TEST_CHANNEL;
+	transfer.slave_pin = TEST_PIN;
+	transfer.ss_polarity = SS_ACTIVE_LOW;
+	transfer.tx_buffer = tx;
+	transfer.tx_length = tx_length;
+	transfer.rx_buffer = receive ? rx : NULL;
+	transfer.rx_length = receive ? rx_length : 0;
+	transfer.data_format = SPI_DATA_8BIT_PACKED;
+	transfer.bit_format = bit_format;
+
+	test_wire_count = 0;
+	test_narrow_count = 0;
+	uint32_t frames = spi_sim_frames(TEST_CHANNEL);
+	if (interrupt)
+	{
+		spi_transfer_t completed;
+		TEST_CHECK(spi_transfer_submit(&transfer));
+		do
+		{
+			spi_sim_service(TEST_CHANNEL);
+		} while(!spi_transfer_reap(TEST_CHANNEL, &completed));
+	}
+	else
+	{
+		spi_transfer(&transfer);
+	}
+
+	TEST_CHECK(test_wire_count == rx_length);
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) - frames == (rx_length + 1) / 2);
+	TEST_CHECK(test_narrow_count == (rx_length & 1U));
+	TEST_CHECK(test_narrow_count == 0 || test_narrow_at == rx_length - 1);
+	for (uint32_t i = 0; i < rx_length; i++)
+	{
+		TEST_CHECK(test_wire[i] == ((i < tx_length) ? (uint8_t)(0x10U + i) : 0x00U));
+		TEST_CHECK(rx_bytes[i] == (receive ? (uint8_t)(0xC0U + i) : TEST_GUARD));
+	}
+	TEST_CHECK(rx_bytes[rx_length] == TEST_GUARD);
+	TEST_CHECK(spi_error_get(TEST_CHANNEL) == SPI_ERROR_NONE);
+	TEST_CHECK(spi_sim_pin(TEST_PIN) == GPIO_PIN_HIGH);
+}
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Runs even and odd packed transfers, with and without receive buffers and
+* 	with padding past the transmit buffer, MSB first and LSB first, polled and
+* 	from the interrupt. A plain 8 bit transfer after each
+* 	odd one checks the frame width was put back.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see test_run
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	const uint32_t lengths[][2] = {{1, 1}, {2, 2}, {3, 3}, {7, 7}, {8, 8}, {15, 15}, {3, 6}, {4, 7}, {1, 4}};
+	const spi_bit_format_t bit_formats[2] = {MSB_FIRST, LSB_FIRST};
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_4);
+	spi_sim_reset();
+	spi_init(config_table);
+	spi_sim_set_responder(TEST_CHANNEL, test_respond);
+
+	uint32_t runs = 0;
+	for (uint32_t b = 0; b < 2; b++)
+	{
+		for (uint8_t interrupt = 0; interrupt < 2; interrupt++)
+		{
+			for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+			{
+				test_run(bit_formats[b], lengths[i][0], lengths[i][1], 1, interrupt);
+				if (lengths[i][0] == lengths[i][1])
+				{
+					test_run(bit_formats[b], lengths[i][0], lengths[i][0], 0, interrupt);
+					runs++;
+				}
+				runs++;
+
+				uint16_t plain_tx[2] = {0x81, 0x42};
+				uint16_t plain_rx[2];
+				spi_transfer_t plain = {0};
+				plain.channel = TEST_CHANNEL;
+				plain.slave_pin = TEST_PIN;
+				plain.ss_polarity = SS_ACTIVE_LOW;
+				plain.tx_buffer = plain_tx;
+				plain.tx_length = 2;
+				plain.rx_buffer = plain_rx;
+				plain.rx_length = 2;
+				plain.data_format = SPI_DATA_8BIT;
+				plain.bit_format = bit_formats[b];
+				test_wire_count = 0;
+				test_narrow_count = 0;
+				spi_transfer(&plain);
+				TEST_CHECK(test_narrow_count == 2 && test_wire[0] == 0x81 && test_wire[1] == 0x42);
+				TEST_CHECK(plain_rx[0] == 0xC0 && plain_rx[1] == 0xC1);
+			}
+		}
+	}
+
+	printf("test_spi_packed: %u packed transfers in buffer order, passed\n", (unsigned)runs);
+	return (0);
+}
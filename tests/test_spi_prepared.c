@@ -0,0 +1,212 @@
+/*******************************************************************************
+* Title                 :   Prepared Transfer Test
+* Filename              :   test_spi_prepared.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_prepared.c
+ *  @brief Compares the register accesses and simulated cycles of a start of a
+ *  	prepared transfer with those of the same transfer made through
+ *  	spi_transfer, and checks both receive the same frames.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+
+/**
+ * Channel and select of the sensor being polled
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_SLAVE_PIN		GPIO_A_4
+
+/**
+ * Starts made each way, and the frames of the register read they make
+ */
+#define TEST_STARTS			100U
+#define TEST_RX_FRAMES		7U
+
+/**
+ * Counter the sensor answers each frame with
+ */
+static uint8_t test_next;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Makes TEST_STARTS register reads through spi_transfer and as many starts of
+* 	the same read prepared once, counting the accesses and cycles each way. A
+* 	transfer of another format is slipped in between prepared starts, which must
+* 	then still run with their own CR1. The prepared start must cost fewer
+* 	accesses and receive the same frames.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_transfer_prepare
+* @see spi_transfer_start_prepared
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_16);
+	spi_sim_reset();
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+	spi_init(config_table);
+
+	uint16_t address = 0xA8;
+	uint16_t rx[TEST_RX_FRAMES];
+	uint16_t expected[TEST_RX_FRAMES];
+	spi_transfer_t transfer = {0};
+	transfer.channel = TEST_CHANNEL;
+	transfer.slave_pin = TEST_SLAVE_PIN;
+	transfer.ss_polarity = SS_ACTIVE_LOW;
+	transfer.tx_buffer = &address;
+	transfer.tx_length = 1;
+	transfer.rx_buffer = rx;
+	transfer.rx_length = TEST_RX_FRAMES;
+	transfer.data_format = SPI_DATA_8BIT;
+	transfer.clock_polarity = ACTIVE_LOW;
+	transfer.clock_phase = SECOND_EDGE;
+	transfer.max_clock_hz = 10000000;
+
+	uint32_t accesses = spi_sim_accesses(TEST_CHANNEL);
+	uint32_t cycles = spi_sim_cycles();
+	for (uint32_t start = 0; start < TEST_STARTS; start++)
+	{
+		test_next = (uint8_t)start;
+		spi_transfer(&transfer);
+		if (start == 0)
+		{
+			for (uint32_t i = 0; i < TEST_RX_FRAMES; i++)
+			{
+				expected[i] = rx[i];
+			}
+		}
+	}
+	uint32_t transfer_accesses = spi_sim_accesses(TEST_CHANNEL) - accesses;
+	uint32_t transfer_cycles = spi_sim_cycles() - cycles;
+
+	spi_prepared_t prepared;
+	spi_transfer_prepare(&prepared, &transfer);
+	uint16_t other_tx[2] = {0x1234, 0x5678};
+	spi_transfer_t other = {0};
+	other.channel = TEST_CHANNEL;
+	other.slave_pin = GPIO_A_3;
+	other.ss_polarity = SS_ACTIVE_LOW;
+	other.tx_buffer = other_tx;
+	other.tx_length = 2;
+	other.data_format = SPI_DATA_16BIT;
+	other.bit_format = LSB_FIRST;
+
+	uint32_t prepared_accesses = 0;
+	uint32_t prepared_cycles = 0;
+	for (uint32_t start = 0; start < TEST_STARTS; start++)
+	{
+		if (start % 10U == 5U)
+		{
+			spi_transfer(&other);
+		}
+		for (uint32_t i = 0; i < TEST_RX_FRAMES; i++)
+		{
+			rx[i] = 0xDEAD;
+		}
+		test_next = 0;
+		accesses = spi_sim_accesses(TEST_CHANNEL);
+		cycles = spi_sim_cycles();
+		spi_transfer_start_prepared(&prepared);
+		prepared_accesses += spi_sim_accesses(TEST_CHANNEL) - accesses;
+		prepared_cycles += spi_sim_cycles() - cycles;
+		for (uint32_t i = 0; i < TEST_RX_FRAMES; i++)
+		{
+			TEST_CHECK(rx[i] == expected[i]);
+		}
+		TEST_CHECK((spi_sim_regs[TEST_CHANNEL].CR1 & ~SPI_CR1_SPE_Msk) == prepared.CR1_image);
+	}
+	TEST_CHECK(spi_sim_pin(TEST_SLAVE_PIN) == GPIO_PIN_HIGH);
+	TEST_CHECK(spi_sim_pin_writes(TEST_SLAVE_PIN) == 4 * TEST_STARTS);
+	TEST_CHECK(prepared_accesses < transfer_accesses);
+
+	printf("test_spi_prepared: per start of a %u frame read, spi_transfer %.1f accesses %.1f cycles,"
+			" prepared %.1f accesses %.1f cycles\n", TEST_RX_FRAMES,
+			(double)transfer_accesses / TEST_STARTS, (double)transfer_cycles / TEST_STARTS,
+			(double)prepared_accesses / TEST_STARTS, (double)prepared_cycles / TEST_STARTS);
+	printf("test_spi_prepared: %u prepared starts matched spi_transfer, passed\n", TEST_STARTS);
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function standing in for a sensor: each frame is answered with a
+* 	counter, restarted by the test before each read.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device sending the frame
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	(void)channel;
+	(void)frame;
+	return (test_next++);
+}
@@ -0,0 +1,277 @@
+/*******************************************************************************
+* Title                 :   Transfer Ring Stress Test
+* Filename              :   test_spi_queue.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+/** @file test_spi_queue.c
+ *  @brief Runs a submitting and reaping task against a simulated interrupt on a
+ *  	thread of its own, with the ring indices started just short of their wrap.
+ *  	Every transfer must complete exactly once and be reaped in submission order.
+ *  	The driver is included whole so that the indices can be preset.
+ */
+#define _XOPEN_SOURCE 700
+#define SPI_OS_ENABLE 1
+
+#include "../spi_stm32f411.c"
+#include "spi_sim.h"
+#include "test_common.h"
+#include <pthread.h>
+#include <sched.h>
+
+/**
+ * Channel and slave the transfers run on
+ */
+#define TEST_CHANNEL		SPI_2
+#define TEST_SLAVE_PIN		GPIO_B_12
+
+/**
+ * Transfers run through the ring, each sending two frames
+ */
+#define TEST_TRANSFERS		40000UL
+
+/**
+ * Transmit buffers cycled through by the submissions, more than the ring can hold
+ */
+#define TEST_BUFFERS		(SPI_QUEUE_LENGTH * 4U)
+
+/**
+ * Value the ring indices start at, so that they wrap early in the run
+ */
+#define TEST_START_INDEX	(0xFFFFFFFFUL - 5000UL)
+
+/**
+ * Transmit buffers, each loaded with the number of the submission using it
+ */
+static uint16_t test_frames[TEST_BUFFERS][2];
+
+/**
+ * Set to stop the interrupt thread
+ */
+static volatile uint8_t test_stop;
+
+/**
+ * Frames seen on the bus and the frames which were not the ones expected next
+ */
+static uint32_t test_frames_seen;
+static uint32_t test_frames_wrong;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+static void *test_isr_thread(void *argument);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Submits and reaps TEST_TRANSFERS transfers on a channel while a second
+* 	thread takes its interrupts, then checks that every transfer was sent once,
+* 	completed once and was reaped in order as the indices wrapped.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see test_isr_thread
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_16);
+
+	spi_sim_reset();
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+	spi_init(config_table);
+	spi_queue_t *queue = &spi_queues[TEST_CHANNEL];
+	queue->head = TEST_START_INDEX;
+	queue->done = TEST_START_INDEX;
+	queue->reaped = TEST_START_INDEX;
+
+	pthread_t isr;
+	spi_sim_set_background(1);
+	TEST_CHECK(pthread_create(&isr, NULL, test_isr_thread, NULL) == 0);
+
+	spi_transfer_t transfer = {0};
+	transfer.channel = TEST_CHANNEL;
+	transfer.slave_pin = TEST_SLAVE_PIN;
+	transfer.ss_polarity = SS_ACTIVE_LOW;
+	transfer.tx_length = 2;
+	transfer.data_format = SPI_DATA_16BIT;
+
+	uint32_t submitted = 0;
+	uint32_t reaped = 0;
+	while (reaped < TEST_TRANSFERS)
+	{
+		while (submitted < TEST_TRANSFERS)
+		{
+			uint16_t *frames = test_frames[submitted % TEST_BUFFERS];
+			frames[0] = (uint16_t)submitted;
+			frames[1] = (uint16_t)~submitted;
+			transfer.tx_buffer = frames;
+			if (!spi_transfer_submit(&transfer))
+			{
+				break;
+			}
+			submitted++;
+		}
+
+		spi_transfer_t completed;
+		while (spi_transfer_reap(TEST_CHANNEL, &completed))
+		{
+			TEST_CHECK(reaped < submitted);
+			TEST_CHECK(completed.tx_buffer == test_frames[reaped % TEST_BUFFERS] + 2);
+			TEST_CHECK(completed.tx_length == 0);
+			reaped++;
+		}
+		sched_yield();
+	}
+
+	test_stop = 1;
+	TEST_CHECK(pthread_join(isr, NULL) == 0);
+
+	TEST_CHECK(!spi_transfer_reap(TEST_CHANNEL, NULL));
+	TEST_CHECK(queue->head == (uint32_t)(TEST_START_INDEX + TEST_TRANSFERS));
+	TEST_CHECK(queue->done == queue->head && queue->reaped == queue->head && !queue->active);
+	TEST_CHECK(test_frames_seen == 2 * TEST_TRANSFERS && test_frames_wrong == 0);
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) == 2 * TEST_TRANSFERS);
+	TEST_CHECK(spi_sim_pin_writes(TEST_SLAVE_PIN) == 2 * TEST_TRANSFERS);
+
+	/* A transfer queued without a record leaves the submitted one to be reaped */
+	spi_sim_set_background(0);
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		uint16_t *frames = test_frames[(submitted + i) % TEST_BUFFERS];
+		frames[0] = (uint16_t)(submitted + i);
+		frames[1] = (uint16_t)~(submitted + i);
+	}
+	transfer.tx_buffer = test_frames[submitted % TEST_BUFFERS];
+	TEST_CHECK(spi_transfer_submit(&transfer));
+	spi_sim_service(TEST_CHANNEL);
+	transfer.tx_buffer = test_frames[(submitted + 1) % TEST_BUFFERS];
+	spi_transfer_it(&transfer);
+	spi_sim_service(TEST_CHANNEL);
+
+	spi_transfer_t completed;
+	TEST_CHECK(spi_transfer_reap(TEST_CHANNEL, &completed));
+	TEST_CHECK(completed.tx_buffer == test_frames[submitted % TEST_BUFFERS] + 2);
+	TEST_CHECK(!spi_transfer_reap(TEST_CHANNEL, NULL));
+	TEST_CHECK(queue->reaped == queue->head && test_frames_wrong == 0);
+	TEST_CHECK(spi_sim_pin(TEST_SLAVE_PIN) == GPIO_PIN_HIGH);
+
+	printf("test_spi_queue: %lu transfers across the index wrap, passed\n", TEST_TRANSFERS);
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function which checks every frame on the bus against the one expected
+* 	next, so that a transfer started twice or skipped is caught as well as one
+* 	completed twice. It echoes the frame back.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device sending the frame
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	(void)channel;
+	uint32_t submission = test_frames_seen / 2;
+	uint16_t expected = (test_frames_seen & 1U) ? (uint16_t)~submission : (uint16_t)submission;
+	if (frame != expected)
+	{
+		test_frames_wrong++;
+	}
+	test_frames_seen++;
+	return (frame);
+}
+
+/******************************************************************************
+* Function: test_isr_thread()
+*//**
+* \b Description:
+*
+* 	Static function standing in for the interrupt of the channel. It takes the
+* 	interrupts as they are asserted until the test is stopped.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		argument unused
+* @return 		void * NULL
+*
+* \b Example:
+*	Called by pthread_create
+*
+* @see spi_sim_service
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void *test_isr_thread(void *argument)
+{
+	(void)argument;
+	while (!test_stop)
+	{
+		spi_sim_service(TEST_CHANNEL);
+		sched_yield();
+	}
+	return (NULL);
+}
@@ -0,0 +1,270 @@
+/*******************************************************************************
+* Title                 :   Rate Fallback Test
+* Filename              :   test_spi_rate.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_rate.c
+ *  @brief Drives a device with a rate monitor through bursts of overruns which
+ *  	only happen above a given SCK, and checks that its clock steps down until
+ *  	they stop, probes back up after a clean run and returns to full speed once
+ *  	the noise is gone.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+
+/**
+ * Channel and select of the device
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_SLAVE_PIN		GPIO_A_4
+
+/**
+ * Settings of the monitor
+ */
+#define TEST_WINDOW			8U
+#define TEST_THRESHOLD		3U
+#define TEST_PROBE_AFTER	20U
+
+/**
+ * Set while the bus is noisy, and the fastest prescaler the noise spares
+ */
+static uint8_t test_noisy;
+static uint32_t test_noise_limit;
+
+/**
+ * Prescaler of the last frame sent
+ */
+static uint32_t test_baud_rate;
+
+static spi_transfer_t test_device;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+static uint32_t test_run(void);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Checks that errors spread wider than the window leave the clock alone and
+* 	that TEST_THRESHOLD errors within it take a step off. With the bus noisy
+* 	below PCLK_DIV_8 the device must settle there, try PCLK_DIV_4 again after
+* 	TEST_PROBE_AFTER clean transfers and fall back, then climb back to
+* 	PCLK_DIV_2 a step per clean run once the noise stops. A prepared start of
+* 	the device must follow the monitor as well.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_rate_monitor_init
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_64);
+	spi_sim_reset();
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+	spi_init(config_table);
+
+	spi_rate_monitor_t monitor;
+	spi_rate_monitor_init(&monitor, TEST_WINDOW, TEST_THRESHOLD, TEST_PROBE_AFTER);
+	test_device.channel = TEST_CHANNEL;
+	test_device.slave_pin = TEST_SLAVE_PIN;
+	test_device.ss_polarity = SS_ACTIVE_LOW;
+	test_device.data_format = SPI_DATA_8BIT;
+	test_device.max_clock_hz = spi_clock_get(TEST_CHANNEL, PCLK_DIV_2);
+	test_device.rate_monitor = &monitor;
+	test_noise_limit = PCLK_DIV_8;
+
+	/* One error in every four never puts TEST_THRESHOLD in the window */
+	for (uint32_t i = 0; i < 4 * TEST_WINDOW; i++)
+	{
+		test_noisy = (i % 4U == 0);
+		TEST_CHECK(test_run() == PCLK_DIV_2);
+	}
+	TEST_CHECK(monitor.derate == 0 && monitor.error_count == TEST_WINDOW);
+
+	/* One in every three does, once the window has been cleared of the above */
+	test_noisy = 0;
+	for (uint32_t i = 0; i < TEST_WINDOW; i++)
+	{
+		TEST_CHECK(test_run() == PCLK_DIV_2);
+	}
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		test_noisy = (i % 3U == 0);
+		TEST_CHECK(test_run() == PCLK_DIV_2);
+	}
+	test_noisy = 1;
+	TEST_CHECK(test_run() == PCLK_DIV_2);
+	TEST_CHECK(monitor.derate == 1);
+
+	/* Noise below PCLK_DIV_8: a step per TEST_THRESHOLD errors until it stops */
+	for (uint32_t i = 0; i < TEST_THRESHOLD; i++)
+	{
+		TEST_CHECK(test_run() == PCLK_DIV_4);
+	}
+	TEST_CHECK(monitor.derate == 2);
+	uint32_t errors = monitor.error_count;
+	for (uint32_t i = 0; i < TEST_PROBE_AFTER; i++)
+	{
+		TEST_CHECK(test_run() == PCLK_DIV_8);
+	}
+	TEST_CHECK(monitor.derate == 1 && monitor.error_count == errors);
+
+	/* The probe up fails and falls back */
+	for (uint32_t i = 0; i < TEST_THRESHOLD; i++)
+	{
+		TEST_CHECK(test_run() == PCLK_DIV_4);
+	}
+	TEST_CHECK(monitor.derate == 2);
+	uint16_t frame = 0x99;
+	spi_transfer_t transfer = test_device;
+	transfer.tx_buffer = &frame;
+	transfer.tx_length = 1;
+	spi_prepared_t prepared;
+	spi_transfer_prepare(&prepared, &transfer);
+	test_baud_rate = 0xFF;
+	spi_transfer_start_prepared(&prepared);
+	TEST_CHECK(test_baud_rate == PCLK_DIV_8);
+
+	/* Quiet again: back up a step per clean run, the prepared start being the first */
+	test_noisy = 0;
+	for (uint32_t step = PCLK_DIV_8; step > PCLK_DIV_2; step--)
+	{
+		for (uint32_t i = (step == PCLK_DIV_8) ? 1 : 0; i < TEST_PROBE_AFTER; i++)
+		{
+			TEST_CHECK(test_run() == step);
+		}
+	}
+	for (uint32_t i = 0; i < 2 * TEST_PROBE_AFTER; i++)
+	{
+		TEST_CHECK(test_run() == PCLK_DIV_2);
+	}
+	test_baud_rate = 0xFF;
+	spi_transfer_start_prepared(&prepared);
+	TEST_CHECK(test_baud_rate == PCLK_DIV_2);
+	TEST_CHECK(monitor.derate == 0 && monitor.error_count == TEST_WINDOW + 3 + 2 * TEST_THRESHOLD);
+
+	printf("test_spi_rate: stepped down to PCLK_DIV_8 under noise and back, passed\n");
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function which notes the prescaler a frame was sent at, reading CR1
+* 	past the access hooks, which the sim holds its lock across. While the bus is
+* 	noisy a frame sent faster than the noise limit raises an overrun.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device sending the frame
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	test_baud_rate = (spi_sim_regs[channel].cells[SPI_SIM_CR1] & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos;
+	if (test_noisy && test_baud_rate < test_noise_limit)
+	{
+		spi_sim_raise(channel, SPI_SR_OVR_Msk);
+	}
+	return (frame);
+}
+
+/******************************************************************************
+* Function: test_run()
+*//**
+* \b Description:
+*
+* 	Static function which exchanges two frames with the device through
+* 	spi_transfer.
+*
+* PRE-CONDITION: test_device has been filled in
+*
+* POST-CONDITION: The device's monitor has recorded the transfer
+*
+* @param		None
+* @return 		uint32_t the prescaler the frames were sent at
+*
+* \b Example:
+*	Called by main
+*
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t test_run(void)
+{
+	uint16_t frames[2] = {0x3C, 0xC3};
+	uint16_t replies[2];
+	spi_transfer_t transfer = test_device;
+	transfer.tx_buffer = frames;
+	transfer.tx_length = 2;
+	transfer.rx_buffer = replies;
+	transfer.rx_length = 2;
+	test_baud_rate = 0xFF;
+	spi_transfer(&transfer);
+	return (test_baud_rate);
+}
@@ -0,0 +1,192 @@
+/*******************************************************************************
+* Title                 :   Register Map Test
+* Filename              :   test_spi_regmap.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_regmap.c
+ *  @brief Drives spi_regmap and spi_fifo through the driver against the sensor
+ *  	model, attached to the simulated channel behind its select pin.
+ */
+#include "spi_sim.h"
+#include "test_common.h"
+#include "spi_regmap.h"
+#include "spi_fifo.h"
+
+/**
+ * Channel and select of the sensor
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_PIN			GPIO_A_4
+
+/**
+ * Register layout of the sensor
+ */
+#define TEST_REGISTERS		0x30U
+#define TEST_LEVEL_REGISTER	0x20U
+#define TEST_DATA_REGISTER	0x22U
+
+/**
+ * Samples pushed into the sensor FIFO, three little endian words each
+ */
+#define TEST_SAMPLES		10U
+#define TEST_SAMPLE_BYTES	6U
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Reads through the register cache, checking that cached registers cost no
+* 	transaction and that a block read matches the model. Writes are then held
+* 	back until spi_regmap_sync sends them as one burst. Last the FIFO is drained
+* 	with a single padded read of the data register and the decoded words
+* 	compared with what was pushed.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_sim_attach
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_4);
+	spi_sim_reset();
+	spi_init(config_table);
+
+	static uint8_t registers[TEST_REGISTERS];
+	static uint8_t fifo_storage[256];
+	for (uint32_t reg = 0; reg < TEST_REGISTERS; reg++)
+	{
+		registers[reg] = (uint8_t)(reg * 3U);
+	}
+	static spi_model_t sensor;
+	sensor.kind = MODEL_SENSOR;
+	sensor.device.sensor.registers = registers;
+	sensor.device.sensor.num_registers = TEST_REGISTERS;
+	sensor.device.sensor.read_mask = 0x80;
+	sensor.device.sensor.increment_mask = 0x40;
+	sensor.device.sensor.level_register = TEST_LEVEL_REGISTER;
+	sensor.device.sensor.data_register = TEST_DATA_REGISTER;
+	sensor.device.sensor.fifo = fifo_storage;
+	sensor.device.sensor.fifo_size = sizeof(fifo_storage);
+	spi_model_init(&sensor);
+	spi_sim_attach(TEST_CHANNEL, TEST_PIN, &sensor);
+
+	static uint8_t cache[TEST_REGISTERS];
+	static uint8_t flags[TEST_REGISTERS];
+	flags[TEST_LEVEL_REGISTER] = SPI_REGMAP_VOLATILE;
+	flags[TEST_LEVEL_REGISTER + 1] = SPI_REGMAP_VOLATILE;
+	flags[TEST_DATA_REGISTER] = SPI_REGMAP_VOLATILE;
+	spi_regmap_t map = {0};
+	map.bus.channel = TEST_CHANNEL;
+	map.bus.slave_pin = TEST_PIN;
+	map.bus.ss_polarity = SS_ACTIVE_LOW;
+	map.address_width = REGMAP_ADDR_8BIT;
+	map.read_mask = 0x80;
+	map.increment_mask = 0x40;
+	map.num_registers = TEST_REGISTERS;
+	map.cache = cache;
+	map.flags = flags;
+	spi_regmap_init(&map);
+
+	/* A register is read once, then served from the cache */
+	TEST_CHECK(spi_regmap_read(&map, 5) == 15);
+	TEST_CHECK(sensor.selections == 1 && sensor.frames == 2 && sensor.selected == 0);
+	TEST_CHECK(spi_regmap_read(&map, 5) == 15);
+	TEST_CHECK(sensor.selections == 1);
+
+	uint8_t block[TEST_LEVEL_REGISTER];
+	spi_regmap_read_block(&map, 0, block, sizeof(block));
+	TEST_CHECK(sensor.selections == 2 && sensor.frames == 2 + 1 + sizeof(block));
+	for (uint32_t reg = 0; reg < sizeof(block); reg++)
+	{
+		TEST_CHECK(block[reg] == registers[reg]);
+	}
+
+	/* Writes wait in the cache and go out as one burst */
+	spi_regmap_write(&map, 0x10, 0xA1);
+	spi_regmap_write(&map, 0x11, 0xA2);
+	spi_regmap_update_bits(&map, 0x12, 0x0F, 0x05);
+	spi_regmap_write(&map, 0x13, registers[0x13]);
+	TEST_CHECK(sensor.selections == 2 && registers[0x10] == 0x30);
+	spi_regmap_sync(&map);
+	TEST_CHECK(sensor.selections == 3);
+	TEST_CHECK(registers[0x10] == 0xA1 && registers[0x11] == 0xA2 && registers[0x12] == ((0x36 & 0xF0) | 0x05));
+	TEST_CHECK(spi_regmap_read(&map, 0x11) == 0xA2 && sensor.selections == 3);
+
+	/* The FIFO is drained by one read of its data register, padded past the address */
+	uint8_t samples[TEST_SAMPLES * TEST_SAMPLE_BYTES];
+	for (uint32_t i = 0; i < sizeof(samples); i++)
+	{
+		samples[i] = (uint8_t)(0x11U * i + 7U);
+	}
+	TEST_CHECK(spi_model_sensor_push(&sensor, samples, sizeof(samples)) == sizeof(samples));
+
+	static uint16_t buffer[SPI_REGMAP_ADDRESS_FRAMES + 16U * TEST_SAMPLE_BYTES];
+	spi_fifo_t fifo = {0};
+	fifo.map = &map;
+	fifo.level_register = TEST_LEVEL_REGISTER;
+	fifo.level_bytes = 2;
+	fifo.level_order = FIFO_LITTLE_ENDIAN;
+	fifo.level_mask = 0xFFFF;
+	fifo.level_unit = 1;
+	fifo.data_register = TEST_DATA_REGISTER;
+	fifo.sample_bytes = TEST_SAMPLE_BYTES;
+	fifo.sample_order = FIFO_LITTLE_ENDIAN;
+	fifo.buffer = buffer;
+	fifo.buffer_length = sizeof(buffer) / sizeof(buffer[0]);
+	spi_fifo_init(&fifo);
+
+	uint32_t frames_before = sensor.frames;
+	TEST_CHECK(spi_fifo_drain(&fifo) == TEST_SAMPLES * TEST_SAMPLE_BYTES / 2);
+	TEST_CHECK(sensor.frames - frames_before == (1 + 2) + (1 + sizeof(samples)));
+	TEST_CHECK(sensor.device.sensor.fifo_count == 0);
+	for (uint32_t i = 0; i < sizeof(samples) / 2; i++)
+	{
+		TEST_CHECK(buffer[i] == (uint16_t)((samples[2 * i + 1] << 8) | samples[2 * i]));
+	}
+	TEST_CHECK(spi_fifo_drain(&fifo) == 0);
+
+	printf("test_spi_regmap: cached, burst written and drained against the sensor model, passed\n");
+	return (0);
+}
@@ -0,0 +1,208 @@
+/*******************************************************************************
+* Title                 :   Periodic Schedule Test
+* Filename              :   test_spi_schedule.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+/** @file test_spi_schedule.c
+ *  @brief Releases a periodic slot on a channel a task also uses, checking that
+ *  	the jitter is measured from the real start of each transfer and that the
+ *  	task's completions are left alone.
+ */
+#include "spi_schedule.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+
+/**
+ * Channel the slot and the task share
+ */
+#define TEST_CHANNEL		SPI_3
+
+/**
+ * Core clock cycles per tick of the schedule
+ */
+#define TEST_TICK_CYCLES	1000UL
+
+/**
+ * Cycles by which the second transfer starts late
+ */
+#define TEST_LATENESS		436L
+
+/**
+ * Cycle count at which the first release of the second run starts
+ */
+#define TEST_BASE			0x10000UL
+
+static void test_service_at(uint32_t cycles);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Runs a slot with a period of two ticks. A task transfer completes on the
+* 	channel before the first release and must still be reaped afterwards. The
+* 	second transfer is made to start TEST_LATENESS cycles late, and a third that
+* 	never starts must be counted as missed when the slot is next due. The
+* 	slot is then run again with a release refused by a full interrupt queue,
+* 	whose stale stamp must not be taken for a start.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_schedule_tick
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_2);
+	spi_sim_reset();
+	spi_init(config_table);
+
+	static uint16_t command[2] = {0x8F, 0x00};
+	spi_transfer_t transfer = {0};
+	transfer.channel = TEST_CHANNEL;
+	transfer.slave_pin = GPIO_C_3;
+	transfer.ss_polarity = SS_ACTIVE_LOW;
+	transfer.tx_buffer = command;
+	transfer.tx_length = 2;
+	transfer.data_format = SPI_DATA_8BIT;
+
+	spi_schedule_slot_t slots[1] = {{.transfer = &transfer, .period = 2, .phase = 0}};
+	spi_schedule_t schedule = {.slots = slots, .num_slots = 1, .tick_cycles = TEST_TICK_CYCLES};
+	spi_schedule_init(&schedule);
+
+	spi_transfer_t task_transfer = transfer;
+	task_transfer.slave_pin = GPIO_A_4;
+	TEST_CHECK(spi_transfer_submit(&task_transfer));
+	spi_sim_service(TEST_CHANNEL);
+
+	spi_schedule_tick(&schedule);
+	TEST_CHECK(!slots[0].start.started);
+	test_service_at(0);
+	TEST_CHECK(slots[0].start.started && slots[0].releases == 1);
+
+	spi_transfer_t completed;
+	TEST_CHECK(spi_transfer_reap(TEST_CHANNEL, &completed));
+	TEST_CHECK(completed.slave_pin == GPIO_A_4 && completed.tx_length == 0);
+
+	spi_schedule_tick(&schedule);
+	spi_schedule_tick(&schedule);
+	test_service_at(2 * TEST_TICK_CYCLES + TEST_LATENESS);
+	TEST_CHECK(slots[0].releases == 2 && slots[0].jitter_max == INT32_MIN);
+
+	spi_schedule_tick(&schedule);
+	spi_schedule_tick(&schedule);
+	TEST_CHECK(slots[0].releases == 3 && slots[0].missed == 0);
+	TEST_CHECK(slots[0].jitter_min == TEST_LATENESS && slots[0].jitter_max == TEST_LATENESS);
+
+	spi_schedule_tick(&schedule);
+	spi_schedule_tick(&schedule);
+	TEST_CHECK(slots[0].releases == 3 && slots[0].missed == 1);
+
+	test_service_at(0);
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) == 8);
+	TEST_CHECK(spi_sim_pin_writes(GPIO_C_3) == 6 && spi_sim_pin(GPIO_C_3) == GPIO_PIN_HIGH);
+	TEST_CHECK(!spi_transfer_reap(TEST_CHANNEL, NULL));
+
+	/* A release refused by a full queue leaves the stamp it consumed behind, which must not be measured again */
+	spi_schedule_init(&schedule);
+	spi_schedule_tick(&schedule);
+	test_service_at(TEST_BASE);
+	spi_schedule_tick(&schedule);
+	spi_schedule_tick(&schedule);
+	test_service_at(TEST_BASE + 2 * TEST_TICK_CYCLES + TEST_LATENESS);
+	for (uint32_t i = 0; i < SPI_ISR_QUEUE_LENGTH; i++)
+	{
+		TEST_CHECK(spi_transfer_it_from_isr(&transfer, NULL));
+	}
+	spi_schedule_tick(&schedule);
+	spi_schedule_tick(&schedule);
+	TEST_CHECK(slots[0].releases == 2 && slots[0].missed == 1);
+	TEST_CHECK(slots[0].jitter_min == TEST_LATENESS && slots[0].jitter_max == TEST_LATENESS);
+
+	spi_sim_service(TEST_CHANNEL);
+	spi_schedule_tick(&schedule);
+	spi_schedule_tick(&schedule);
+	TEST_CHECK(slots[0].releases == 3 && slots[0].missed == 1);
+	TEST_CHECK(slots[0].jitter_min == TEST_LATENESS && slots[0].jitter_max == TEST_LATENESS);
+	test_service_at(TEST_BASE + 6 * TEST_TICK_CYCLES + 2 * TEST_LATENESS);
+	spi_schedule_tick(&schedule);
+	spi_schedule_tick(&schedule);
+	TEST_CHECK(slots[0].releases == 4 && slots[0].jitter_min == TEST_LATENESS && slots[0].jitter_max == TEST_LATENESS);
+
+	printf("test_spi_schedule: jitter of %ld cycles measured at the start, passed\n", TEST_LATENESS);
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_service_at()
+*//**
+* \b Description:
+*
+* 	Static function which sets the cycle counter so that the next transfer
+* 	started on the channel is stamped with the given count, plus the cycles
+* 	the handler always spends before it reads the counter, then takes the
+* 	channel's interrupts.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		cycles the cycle count the next start should read
+* @return 		void
+*
+* \b Example:
+*	Called by main
+*
+* @see spi_sim_service
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void test_service_at(uint32_t cycles)
+{
+	spi_sim_dwt.CYCCNT = cycles - 64U;
+	spi_sim_service(TEST_CHANNEL);
+}
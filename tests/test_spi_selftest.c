@@ -0,0 +1,311 @@
+/*******************************************************************************
+* Title                 :   Loopback Self-Test Test
+* Filename              :   test_spi_selftest.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_selftest.c
+ *  @brief Runs spi_selftest_run against an echoing slave, first clean and then
+ *  	with frames corrupted and an overrun raised, and checks the error counts
+ *  	it reports. A transfer another task submitted beforehand and reaps while the
+ *  	self-test runs must be left for that task.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "spi_selftest.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+#include <pthread.h>
+#include <sched.h>
+
+/**
+ * Channel and select of the loop
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_SLAVE_PIN		GPIO_A_4
+
+/**
+ * Frame of each transfer echoed with its lowest bit flipped, and frame of each
+ * polled transfer on which an overrun is raised
+ */
+#define TEST_BAD_FRAME		7U
+#define TEST_OVERRUN_FRAME	20U
+
+/**
+ * Transfers the self-test makes at each prescaler: both paths for both patterns
+ */
+#define TEST_TRANSFERS_PER_RATE	4U
+
+/**
+ * Set to make the responder inject its faults
+ */
+static volatile uint8_t test_faulty;
+
+/**
+ * Frames seen since the self-test began
+ */
+static uint32_t test_frames_seen;
+
+/**
+ * Set to stop the interrupt thread
+ */
+static volatile uint8_t test_stop;
+
+/**
+ * Transfer of the other task, and its final state once that task has reaped it
+ */
+static uint16_t test_other_tx[3] = {0x11, 0x22, 0x33};
+static spi_transfer_t test_other_done;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+static void *test_isr_thread(void *argument);
+static void *test_other_task(void *argument);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Leaves a transfer of another task completed but not reaped on the channel,
+* 	then runs the self-test at every prescaler over a clean echo, which must pass
+* 	with no errors. The other task reaps its transfer once the first prescaler
+* 	is done, and must find it still there. The self-test is run again with a
+* 	frame of every transfer corrupted and an overrun raised in every polled
+* 	transfer of the first pattern, which must be counted at every prescaler.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_selftest_run
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_2);
+	spi_sim_reset();
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+	spi_init(config_table);
+
+	pthread_t isr;
+	spi_sim_set_background(1);
+	TEST_CHECK(pthread_create(&isr, NULL, test_isr_thread, NULL) == 0);
+
+	spi_transfer_t other = {0};
+	other.channel = TEST_CHANNEL;
+	other.slave_pin = GPIO_A_3;
+	other.ss_polarity = SS_ACTIVE_LOW;
+	other.tx_buffer = test_other_tx;
+	other.tx_length = 3;
+	other.data_format = SPI_DATA_8BIT;
+	TEST_CHECK(spi_transfer_submit(&other));
+	while (spi_sim_pin_writes(GPIO_A_3) < 2)
+	{
+		sched_yield();
+	}
+	pthread_t other_task;
+	TEST_CHECK(pthread_create(&other_task, NULL, test_other_task, NULL) == 0);
+
+	spi_transfer_t loop = {0};
+	loop.channel = TEST_CHANNEL;
+	loop.slave_pin = TEST_SLAVE_PIN;
+	loop.ss_polarity = SS_ACTIVE_LOW;
+	loop.data_format = SPI_DATA_8BIT;
+	static spi_selftest_t test;
+	test.device = &loop;
+	test.core_clock_hz = 100000000UL;
+
+	test_frames_seen = 0;
+	TEST_CHECK(spi_selftest_run(&test));
+	for (uint32_t rate = 0; rate < SPI_SELFTEST_NUM_RATES; rate++)
+	{
+		const spi_selftest_result_t *result = &test.results[rate];
+		TEST_CHECK(result->clock_hz == spi_clock_get(TEST_CHANNEL, (spi_baud_rate_t)rate));
+		TEST_CHECK(result->frame_errors == 0 && result->bus_errors == 0);
+		TEST_CHECK(result->bytes_per_second[SELFTEST_POLLED] != 0 && result->bytes_per_second[SELFTEST_INTERRUPT] != 0);
+	}
+	TEST_CHECK(test_frames_seen == SPI_SELFTEST_NUM_RATES * TEST_TRANSFERS_PER_RATE * SPI_SELFTEST_FRAMES);
+
+	TEST_CHECK(pthread_join(other_task, NULL) == 0);
+	TEST_CHECK(test_other_done.tx_buffer == test_other_tx + 3 && test_other_done.tx_length == 0);
+	TEST_CHECK(!spi_transfer_reap(TEST_CHANNEL, NULL));
+
+	test_frames_seen = 0;
+	test_faulty = 1;
+	TEST_CHECK(!spi_selftest_run(&test));
+	for (uint32_t rate = 0; rate < SPI_SELFTEST_NUM_RATES; rate++)
+	{
+		TEST_CHECK(test.results[rate].frame_errors == TEST_TRANSFERS_PER_RATE);
+		TEST_CHECK(test.results[rate].bus_errors == 1);
+	}
+	TEST_CHECK(!spi_transfer_reap(TEST_CHANNEL, NULL));
+
+	test_stop = 1;
+	TEST_CHECK(pthread_join(isr, NULL) == 0);
+
+	printf("test_spi_selftest: PCLK_DIV_2 polled %lu B/s %lu cycles/B, interrupt %lu B/s %lu cycles/B\n",
+			(unsigned long)test.results[PCLK_DIV_2].bytes_per_second[SELFTEST_POLLED],
+			(unsigned long)test.results[PCLK_DIV_2].cycles_per_byte[SELFTEST_POLLED],
+			(unsigned long)test.results[PCLK_DIV_2].bytes_per_second[SELFTEST_INTERRUPT],
+			(unsigned long)test.results[PCLK_DIV_2].cycles_per_byte[SELFTEST_INTERRUPT]);
+	printf("test_spi_selftest: clean and faulty loops counted at %u prescalers, passed\n", SPI_SELFTEST_NUM_RATES);
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function echoing each frame back. When faults are injected it flips
+* 	the lowest bit of frame TEST_BAD_FRAME of every transfer, and raises an
+* 	overrun on frame TEST_OVERRUN_FRAME of the first transfer at each prescaler,
+* 	the polled one of the walking ones pattern.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		channel the spi device sending the frame
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	uint32_t transfer = test_frames_seen / SPI_SELFTEST_FRAMES;
+	uint32_t position = test_frames_seen % SPI_SELFTEST_FRAMES;
+	test_frames_seen++;
+	if (!test_faulty)
+	{
+		return (frame);
+	}
+	if (transfer % TEST_TRANSFERS_PER_RATE == 0 && position == TEST_OVERRUN_FRAME)
+	{
+		spi_sim_raise(channel, SPI_SR_OVR_Msk);
+	}
+	return ((position == TEST_BAD_FRAME) ? (uint16_t)(frame ^ 1U) : frame);
+}
+
+/******************************************************************************
+* Function: test_isr_thread()
+*//**
+* \b Description:
+*
+* 	Static function standing in for the interrupt of the channel. It takes the
+* 	interrupts as they are asserted until the test is stopped.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		argument unused
+* @return 		void * NULL
+*
+* \b Example:
+*	Called by pthread_create
+*
+* @see spi_sim_service
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void *test_isr_thread(void *argument)
+{
+	(void)argument;
+	while (!test_stop)
+	{
+		spi_sim_service(TEST_CHANNEL);
+		sched_yield();
+	}
+	return (NULL);
+}
+
+/******************************************************************************
+* Function: test_other_task()
+*//**
+* \b Description:
+*
+* 	Static function standing in for another task on the channel. It waits for
+* 	the self-test to finish its first prescaler, then reaps the transfer it
+* 	submitted.
+*
+* PRE-CONDITION: The other task's transfer has completed
+*
+* POST-CONDITION: test_other_done holds the reaped transfer
+*
+* @param		argument unused
+* @return 		void * NULL
+*
+* \b Example:
+*	Called by pthread_create
+*
+* @see spi_transfer_reap
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void *test_other_task(void *argument)
+{
+	(void)argument;
+	while (__atomic_load_n(&test_frames_seen, __ATOMIC_ACQUIRE) < TEST_TRANSFERS_PER_RATE * SPI_SELFTEST_FRAMES)
+	{
+		sched_yield();
+	}
+	TEST_CHECK(spi_transfer_reap(TEST_CHANNEL, &test_other_done));
+	return (NULL);
+}
@@ -0,0 +1,232 @@
+/*******************************************************************************
+* Title                 :   Sleeping Transfer Test
+* Filename              :   test_spi_sleep.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+/** @file test_spi_sleep.c
+ *  @brief Runs long padded reads through the sleep path of spi_transfer and checks
+ *  	they leave the same result behind as the polled path would.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+
+/**
+ * Channel and select of the device read
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_PIN			GPIO_A_4
+
+/**
+ * Bytes read, well above the sleep threshold and odd so a packed read ends on
+ * an 8 bit frame
+ */
+#define TEST_READ_LENGTH	301U
+
+/**
+ * Frame after which the responder latches an overrun
+ */
+#define TEST_OVERRUN_FRAME	100U
+
+/**
+ * Frames clocked out by the driver, in order, and whether to latch an overrun
+ */
+static uint16_t test_sent[2 * TEST_READ_LENGTH];
+static uint32_t test_count;
+static uint8_t test_overrun;
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Logs the frame sent and answers with the number of frames before it,
+* 	latching an overrun in SR at TEST_OVERRUN_FRAME when asked to.
+*
+* PRE-CONDITION: test_count has been cleared
+*
+* POST-CONDITION: The frame has been logged
+*
+* @param		channel the spi device
+* @param		frame the frame clocked out
+* @return 		uint16_t the reply
+*
+* \b Example:
+*	Called by spi_sim_service
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	TEST_CHECK(test_count < 2 * TEST_READ_LENGTH);
+	test_sent[test_count] = frame;
+	if (test_overrun && test_count == TEST_OVERRUN_FRAME)
+	{
+		spi_sim_raise(channel, SPI_SR_OVR_Msk);
+	}
+	return ((uint16_t)test_count++);
+}
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Reads TEST_READ_LENGTH bytes behind a two byte command with a sleep
+* 	threshold of 64, first as 8 bit frames and then packed. The command must be
+* 	followed by dummy frames until every byte has been clocked, each reply must
+* 	land in place, including the odd last byte of the packed read, and the
+* 	select must be released. A third read latches an overrun part way, which
+* 	must be reported by spi_error_get and counted by the rate monitor. Last, two
+* 	transfers are submitted ahead of a sleeping one and must still be reaped.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_2);
+	spi_sim_reset();
+	spi_init(config_table);
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+
+	static uint16_t command[2] = {0x03, 0xA0};
+	static uint16_t rx[TEST_READ_LENGTH];
+	spi_transfer_t read = {0};
+	read.channel = TEST_CHANNEL;
+	read.slave_pin = TEST_PIN;
+	read.ss_polarity = SS_ACTIVE_LOW;
+	read.tx_buffer = command;
+	read.tx_length = 2;
+	read.rx_buffer = rx;
+	read.rx_length = TEST_READ_LENGTH;
+	read.data_format = SPI_DATA_8BIT;
+	read.bit_format = MSB_FIRST;
+	read.sleep_threshold = 64;
+
+	spi_transfer(&read);
+	TEST_CHECK(test_count == TEST_READ_LENGTH);
+	TEST_CHECK(test_sent[0] == 0x03 && test_sent[1] == 0xA0);
+	for (uint32_t i = 2; i < TEST_READ_LENGTH; i++)
+	{
+		TEST_CHECK(test_sent[i] == 0);
+	}
+	for (uint32_t i = 0; i < TEST_READ_LENGTH; i++)
+	{
+		TEST_CHECK(rx[i] == (i & 0xFFU));
+	}
+	TEST_CHECK(spi_sim_pin(TEST_PIN) == GPIO_PIN_HIGH && spi_sim_pin_writes(TEST_PIN) == 2);
+	TEST_CHECK(spi_error_get(TEST_CHANNEL) == SPI_ERROR_NONE);
+
+	/* The same read packed: two bytes a frame, then the odd byte on its own */
+	static uint16_t packed_command = 0xA003;
+	static uint16_t packed_rx[(TEST_READ_LENGTH + 1) / 2];
+	uint8_t *bytes = (uint8_t *)packed_rx;
+	test_count = 0;
+	read.tx_buffer = &packed_command;
+	read.rx_buffer = packed_rx;
+	read.data_format = SPI_DATA_8BIT_PACKED;
+
+	spi_transfer(&read);
+	TEST_CHECK(test_count == (TEST_READ_LENGTH + 1) / 2);
+	TEST_CHECK(test_sent[0] == 0x03A0 && test_sent[TEST_READ_LENGTH / 2] == 0);
+	for (uint32_t i = 0; i < TEST_READ_LENGTH / 2; i++)
+	{
+		TEST_CHECK(bytes[2 * i] == (uint8_t)(i >> 8) && bytes[2 * i + 1] == (uint8_t)i);
+	}
+	TEST_CHECK(bytes[TEST_READ_LENGTH - 1] == (uint8_t)(TEST_READ_LENGTH / 2));
+	TEST_CHECK(spi_sim_pin(TEST_PIN) == GPIO_PIN_HIGH && spi_sim_pin_writes(TEST_PIN) == 4);
+
+	/* An overrun latched part way is collected at the end, as on the polled path */
+	spi_rate_monitor_t monitor;
+	spi_rate_monitor_init(&monitor, 8, 4, 16);
+	test_count = 0;
+	test_overrun = 1;
+	read.tx_buffer = command;
+	read.rx_buffer = rx;
+	read.data_format = SPI_DATA_8BIT;
+	read.rate_monitor = &monitor;
+
+	spi_transfer(&read);
+	TEST_CHECK(test_count == TEST_READ_LENGTH);
+	TEST_CHECK(spi_error_get(TEST_CHANNEL) == SPI_ERROR_OVERRUN);
+	TEST_CHECK(monitor.error_count == 1);
+
+	/* Completions of spi_transfer_submit outlive a sleeping transfer on the channel */
+	static uint16_t short_rx[2][4];
+	spi_transfer_t submitted = read;
+	submitted.rate_monitor = NULL;
+	submitted.rx_length = 4;
+	test_overrun = 0;
+	TEST_CHECK((spi_sim_regs[TEST_CHANNEL].SR & SPI_SR_OVR_Msk) == 0);
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		submitted.rx_buffer = short_rx[i];
+		TEST_CHECK(spi_transfer_submit(&submitted));
+	}
+	test_count = 0;
+	read.rate_monitor = NULL;
+	spi_transfer(&read);
+	TEST_CHECK(test_count == 2 * 4 + TEST_READ_LENGTH);
+
+	spi_transfer_t completed;
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		TEST_CHECK(spi_transfer_reap(TEST_CHANNEL, &completed));
+		TEST_CHECK(completed.rx_buffer == short_rx[i] + 4 && completed.rx_length == 0);
+		TEST_CHECK(short_rx[i][3] == 4 * i + 3);
+	}
+	TEST_CHECK(!spi_transfer_reap(TEST_CHANNEL, &completed));
+
+	printf("test_spi_sleep: %u byte padded reads slept through, passed\n", TEST_READ_LENGTH);
+	return (0);
+}
@@ -0,0 +1,378 @@
+/*******************************************************************************
+* Title                 :   Trace Test
+* Filename              :   test_spi_trace.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+
+/** @file test_spi_trace.c
+ *  @brief Records a polled and an interrupt transfer with the trace built in,
+ *  	checks the records, and feeds the dump through tools/spi_trace_vcd to
+ *  	check the VCD it writes against them.
+ */
+/* popen and pclose are POSIX rather than C99 */
+#define _POSIX_C_SOURCE 200809L
+#include "spi_interface.h"
+#include "spi_trace.h"
+#include "spi_sim.h"
+#include "test_common.h"
+#include "stm32f411xe.h"
+#include <string.h>
+
+/**
+ * Channel and select traced
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_PIN			GPIO_A_4
+
+/**
+ * Cycle count when the trace is started, and the core clock given to the tool
+ * (10 ns per cycle)
+ */
+#define TEST_BASE			5000UL
+#define TEST_CLOCK_HZ		100000000UL
+
+/**
+ * Signals of a channel in the VCD, in the tool's order
+ */
+#define TEST_VCD_SIGNALS	5U
+
+/**
+ * Frame during which the responder latches an overrun, 0 for none
+ */
+static uint32_t test_overrun_frame;
+static uint32_t test_count;
+
+/**
+ * Records dumped from the trace, and the changes expected and found in the VCD
+ */
+static spi_trace_record_t test_records[SPI_TRACE_LENGTH];
+static uint32_t test_expected[4 * SPI_TRACE_LENGTH][3];
+static uint32_t test_found[4 * SPI_TRACE_LENGTH][3];
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+static uint32_t test_expect(uint32_t count);
+static uint32_t test_parse(FILE *vcd);
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function which echoes each frame and latches an overrun in SR when
+* 	test_overrun_frame is reached.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: test_count has been incremented
+*
+* @param		channel the spi device
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim.c for every frame shifted
+*
+* @see spi_sim_set_responder
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	if (++test_count == test_overrun_frame)
+	{
+		spi_sim_raise(channel, SPI_SR_OVR_Msk);
+	}
+	return (frame);
+}
+
+/******************************************************************************
+* Function: test_expect()
+*//**
+* \b Description:
+*
+* 	Static function which works out, from the dumped records, the signal changes
+* 	the tool should write: one entry per change holding its time in ns, the
+* 	signal and the value.
+*
+* PRE-CONDITION: test_records holds count records of TEST_CHANNEL
+*
+* POST-CONDITION: test_expected holds the changes
+*
+* @param		count the records in test_records
+* @return 		uint32_t the number of changes
+*
+* \b Example:
+*	Called by main
+*
+* @see test_parse
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t test_expect(uint32_t count)
+{
+	uint32_t changes = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t time = (test_records[i].timestamp - test_records[0].timestamp) * (1000000000UL / TEST_CLOCK_HZ);
+		uint8_t event = test_records[i].event;
+		uint32_t signal = 0;
+		uint32_t value = 0;
+
+		if (event == TRACE_CS_ASSERT || event == TRACE_CS_RELEASE)
+		{
+			value = (event == TRACE_CS_ASSERT);
+		}
+		else if (event == TRACE_TRANSFER_START || event == TRACE_TRANSFER_END)
+		{
+			signal = 1;
+			value = (event == TRACE_TRANSFER_START);
+			if (event == TRACE_TRANSFER_START)
+			{
+				test_expected[changes][0] = time;
+				test_expected[changes][1] = signal;
+				test_expected[changes][2] = 1;
+				changes++;
+				signal = 3;
+				value = 0;
+			}
+		}
+		else if (event == TRACE_ISR_ENTRY || event == TRACE_ISR_EXIT)
+		{
+			signal = 2;
+			value = (event == TRACE_ISR_ENTRY);
+		}
+		else if (event == TRACE_ERROR)
+		{
+			signal = 3;
+			value = test_records[i].arg & 0x07U;
+		}
+		else
+		{
+			signal = 4;
+			value = test_records[i].arg;
+		}
+		test_expected[changes][0] = time;
+		test_expected[changes][1] = signal;
+		test_expected[changes][2] = value;
+		changes++;
+	}
+	return (changes);
+}
+
+/******************************************************************************
+* Function: test_parse()
+*//**
+* \b Description:
+*
+* 	Static function which reads the VCD written by the tool and collects every
+* 	value change made after the initial dump, with its time, signal and value.
+*
+* PRE-CONDITION: vcd is the tool's output
+*
+* POST-CONDITION: test_found holds the changes
+*
+* @param		vcd the stream to read
+* @return 		uint32_t the number of changes
+*
+* \b Example:
+*	Called by main
+*
+* @see test_expect
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint32_t test_parse(FILE *vcd)
+{
+	char line[64];
+	uint32_t changes = 0;
+	uint32_t time = 0;
+	uint8_t dumped = 0;
+
+	while (fgets(line, sizeof(line), vcd) != NULL)
+	{
+		uint32_t value = 0;
+		const char *id = NULL;
+		if (strcmp(line, "$end\n") == 0)
+		{
+			dumped = 1;
+			continue;
+		}
+		if (!dumped)
+		{
+			continue;
+		}
+		if (line[0] == '#')
+		{
+			time = (uint32_t)strtoul(line + 1, NULL, 10);
+			continue;
+		}
+		if (line[0] == 'b')
+		{
+			char *end;
+			value = (uint32_t)strtoul(line + 1, &end, 2);
+			id = end + 1;
+		}
+		else
+		{
+			value = (uint32_t)(line[0] - '0');
+			id = line + 1;
+		}
+		TEST_CHECK(changes < 4 * SPI_TRACE_LENGTH);
+		uint32_t index = (uint32_t)(*id - '!');
+		TEST_CHECK(index / TEST_VCD_SIGNALS == TEST_CHANNEL);
+		test_found[changes][0] = time;
+		test_found[changes][1] = index % TEST_VCD_SIGNALS;
+		test_found[changes][2] = value;
+		changes++;
+	}
+	return (changes);
+}
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Starts the trace with the cycle counter already running and checks it is not
+* 	reset. A polled transfer and a queued interrupt transfer which overruns are
+* 	recorded; the end of each must carry its own errors. The dump is then
+* 	written next to the test binary, converted by spi_trace_vcd, and every
+* 	change in the VCD compared with the records.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		argc the argument count
+* @param		argv argv[0] locates spi_trace_vcd, built alongside the test
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_trace_dump
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(int argc, char **argv)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_8);
+	spi_sim_reset();
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+	spi_sim_dwt.cycles = TEST_BASE;
+	spi_trace_init();
+	TEST_CHECK(spi_sim_cycles() >= TEST_BASE);
+	spi_init(config_table);
+
+	static uint16_t data[4] = {0x11, 0x22, 0x33, 0x44};
+	static uint16_t received[4];
+	spi_transfer_t transfer = {0};
+	transfer.channel = TEST_CHANNEL;
+	transfer.slave_pin = TEST_PIN;
+	transfer.ss_polarity = SS_ACTIVE_LOW;
+	transfer.tx_buffer = data;
+	transfer.tx_length = 4;
+	transfer.rx_buffer = received;
+	transfer.rx_length = 4;
+	transfer.data_format = SPI_DATA_8BIT;
+	spi_transfer(&transfer);
+
+	test_overrun_frame = test_count + 2;
+	TEST_CHECK(spi_transfer_submit(&transfer));
+	spi_sim_service(TEST_CHANNEL);
+	TEST_CHECK(spi_transfer_reap(TEST_CHANNEL, NULL));
+
+	uint32_t count = spi_trace_dump(test_records, SPI_TRACE_LENGTH);
+	TEST_CHECK(count > 10 && count < SPI_TRACE_LENGTH);
+	TEST_CHECK(test_records[0].timestamp < spi_sim_cycles() - TEST_BASE);
+	uint32_t ends = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		TEST_CHECK(test_records[i].channel == TEST_CHANNEL);
+		if (test_records[i].event == TRACE_TRANSFER_END)
+		{
+			TEST_CHECK(test_records[i].arg == ((ends == 0) ? SPI_ERROR_NONE : SPI_ERROR_OVERRUN));
+			ends++;
+		}
+	}
+	TEST_CHECK(ends == 2);
+
+	/* Round trip through the tool, which sits next to this binary */
+	TEST_CHECK(argc > 0);
+	char directory[200];
+	snprintf(directory, sizeof(directory), "%s", argv[0]);
+	char *slash = strrchr(directory, '/');
+	if (slash != NULL)
+	{
+		*slash = '\0';
+	}
+	else
+	{
+		snprintf(directory, sizeof(directory), ".");
+	}
+	char path[256];
+	snprintf(path, sizeof(path), "%s/test_spi_trace.bin", directory);
+	FILE *dump = fopen(path, "wb");
+	TEST_CHECK(dump != NULL && fwrite(test_records, sizeof(test_records[0]), count, dump) == count);
+	fclose(dump);
+
+	char command[600];
+	snprintf(command, sizeof(command), "%s/spi_trace_vcd %s %lu", directory, path, TEST_CLOCK_HZ);
+	FILE *vcd = popen(command, "r");
+	TEST_CHECK(vcd != NULL);
+	uint32_t found = test_parse(vcd);
+	TEST_CHECK(pclose(vcd) == 0);
+
+	uint32_t expected = test_expect(count);
+	TEST_CHECK(found == expected);
+	for (uint32_t i = 0; i < expected; i++)
+	{
+		TEST_CHECK(memcmp(test_found[i], test_expected[i], sizeof(test_expected[i])) == 0);
+	}
+
+	printf("test_spi_trace: %lu records round tripped through spi_trace_vcd, passed\n", (unsigned long)count);
+	return (0);
+}
@@ -0,0 +1,167 @@
+/*******************************************************************************
+* Title                 :   Resumable Transaction Test
+* Filename              :   test_spi_transaction.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+/** @file test_spi_transaction.c
+ *  @brief Runs a conversation while another user of the channel discards the
+ *  	completed transfers, which must not cost the conversation its completion.
+ */
+#include "spi_transaction.h"
+#include "spi_sim.h"
+#include "test_common.h"
+
+/**
+ * Channel and slave the conversation runs on
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_SLAVE_PIN		GPIO_A_4
+
+/**
+ * Polls given to the conversation before it is taken to have hung
+ */
+#define TEST_POLLS			16U
+
+/**
+ * The transfers of the conversation and the one queued alongside it
+ */
+static uint16_t test_command[2] = {0x06, 0x00};
+static uint16_t test_page[3] = {0x02, 0x10, 0x20};
+static uint16_t test_other[1] = {0x05};
+static spi_transfer_t test_first = {0};
+static spi_transfer_t test_second = {0};
+static spi_transfer_t test_interloper = {0};
+
+static spi_transaction_status_t test_conversation(spi_transaction_t *txn);
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Lets the first transfer of a conversation complete, then queues an unrelated
+* 	interrupt transfer on the channel, which discards every completion not yet
+* 	reaped. The conversation must still see its transfer complete and run to the
+* 	end.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_transaction_transfer
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_16);
+	spi_sim_reset();
+	spi_init(config_table);
+
+	test_first.channel = TEST_CHANNEL;
+	test_first.slave_pin = TEST_SLAVE_PIN;
+	test_first.ss_polarity = SS_ACTIVE_LOW;
+	test_first.data_format = SPI_DATA_8BIT;
+	test_second = test_first;
+	test_interloper = test_first;
+	test_first.tx_buffer = test_command;
+	test_first.tx_length = 2;
+	test_second.tx_buffer = test_page;
+	test_second.tx_length = 3;
+	test_interloper.tx_buffer = test_other;
+	test_interloper.tx_length = 1;
+
+	spi_transaction_t txn = {0};
+	spi_transaction_start(&txn, test_conversation, NULL);
+	TEST_CHECK(spi_transaction_poll(&txn) == TXN_RUNNING);
+	TEST_CHECK(spi_transaction_poll(&txn) == TXN_RUNNING);
+	spi_sim_service(TEST_CHANNEL);
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) == 2);
+
+	spi_transfer_t interloper;
+	spi_transfer_it_wait(&test_interloper, &interloper);
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) == 3);
+	TEST_CHECK(interloper.tx_length == 0 && test_interloper.tx_length == 1);
+
+	uint32_t polls = 0;
+	while (spi_transaction_poll(&txn) == TXN_RUNNING)
+	{
+		TEST_CHECK(++polls < TEST_POLLS);
+		spi_sim_service(TEST_CHANNEL);
+	}
+	TEST_CHECK(txn.status == TXN_DONE && txn.desc == SPI_DESC_NONE);
+	TEST_CHECK(spi_sim_frames(TEST_CHANNEL) == 6);
+	TEST_CHECK(spi_sim_pin_writes(TEST_SLAVE_PIN) == 6 && spi_sim_pin(TEST_SLAVE_PIN) == GPIO_PIN_HIGH);
+
+	printf("test_spi_transaction: completion survives a discard, passed\n");
+	return (0);
+}
+
+/******************************************************************************
+* Function: test_conversation()
+*//**
+* \b Description:
+*
+* 	Static step function sending two transfers one after the other.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: None
+*
+* @param		txn a pointer to the transaction object
+* @return 		spi_transaction_status_t the state of the conversation
+*
+* \b Example:
+*	Called by spi_transaction_poll
+*
+* @see spi_transaction_start
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static spi_transaction_status_t test_conversation(spi_transaction_t *txn)
+{
+	SPI_TXN_BEGIN(txn);
+	SPI_TXN_TRANSFER(txn, &test_first);
+	SPI_TXN_TRANSFER(txn, &test_second);
+	SPI_TXN_END(txn);
+}
@@ -0,0 +1,234 @@
+/*******************************************************************************
+* Title                 :   Urgent Preemption Test
+* Filename              :   test_spi_urgent.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   None
+* Target                :   None
+* Notes                 :   None
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+
+
+
+/** @file test_spi_urgent.c
+ *  @brief Pauses a preemptible interrupt transfer for an urgent descriptor and
+ *  	checks the pause closes the bus properly and the transfer resumes intact.
+ */
+#include "spi_interface.h"
+#include "spi_sim.h"
+#include "test_common.h"
+
+/**
+ * Channel and selects of the paused and the urgent slaves
+ */
+#define TEST_CHANNEL		SPI_1
+#define TEST_LONG_PIN		GPIO_A_4
+#define TEST_URGENT_PIN		GPIO_A_8
+
+/**
+ * Frames of each transfer, and the frame during which the urgent one is submitted
+ */
+#define TEST_LONG_FRAMES	32U
+#define TEST_URGENT_FRAMES	4U
+#define TEST_PAUSE_FRAME	10U
+
+/**
+ * Flags added to a logged frame for the selects which were low as it was shifted
+ */
+#define TEST_LONG_SELECTED		0x100U
+#define TEST_URGENT_SELECTED	0x200U
+
+/**
+ * Frames in the order they were shifted, and the urgent descriptor
+ */
+static uint16_t test_log[TEST_LONG_FRAMES + TEST_URGENT_FRAMES + 1U];
+static uint32_t test_count;
+static spi_desc_t test_urgent;
+
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame);
+
+/******************************************************************************
+* Function: test_responder()
+*//**
+* \b Description:
+*
+* 	Static function which logs each frame with the selects that were low, echoes
+* 	it back, and submits the urgent descriptor while TEST_PAUSE_FRAME is
+* 	shifted.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The frame has been logged
+*
+* @param		channel the spi device
+* @param		frame the frame sent
+* @return 		uint16_t the frame received
+*
+* \b Example:
+*	Called by spi_sim.c for every frame shifted
+*
+* @see spi_desc_submit_urgent
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static uint16_t test_responder(spi_channel_t channel, uint16_t frame)
+{
+	(void)channel;
+	TEST_CHECK(test_count < sizeof(test_log) / sizeof(test_log[0]));
+	uint16_t entry = frame;
+	if (spi_sim_pin(TEST_LONG_PIN) == GPIO_PIN_LOW)
+	{
+		entry |= TEST_LONG_SELECTED;
+	}
+	if (spi_sim_pin(TEST_URGENT_PIN) == GPIO_PIN_LOW)
+	{
+		entry |= TEST_URGENT_SELECTED;
+	}
+	test_log[test_count] = entry;
+	if (test_count == TEST_PAUSE_FRAME)
+	{
+		TEST_CHECK(spi_desc_submit_urgent(test_urgent));
+	}
+	test_count++;
+	return (frame);
+}
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Runs a preemptible transfer at PCLK_DIV_256, where BSY stays set for 128
+* 	cycles after RXNE, and submits an urgent descriptor part way through. The
+* 	urgent frames must run alone with their own select between two runs of the
+* 	paused transfer. The paused transfer must come back with every frame sent
+* 	and received once and in order. No frame may be cut short by SPE being
+* 	cleared early.
+*
+* PRE-CONDITION: None
+*
+* POST-CONDITION: The process exits with 0 if every check passed
+*
+* @param		None
+* @return 		int 0 on success
+*
+* \b Example:
+*	Run by make -C tests
+*
+* @see spi_desc_submit_urgent
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(void)
+{
+	spi_config_t config_table[NUM_SPI] = {{0}};
+	test_config_master(config_table, TEST_CHANNEL, PCLK_DIV_256);
+	spi_sim_reset();
+	spi_init(config_table);
+	spi_sim_set_responder(TEST_CHANNEL, test_responder);
+
+	static uint16_t long_tx[TEST_LONG_FRAMES];
+	static uint16_t long_rx[TEST_LONG_FRAMES];
+	for (uint32_t i = 0; i < TEST_LONG_FRAMES; i++)
+	{
+		long_tx[i] = (uint16_t)i;
+	}
+	spi_transfer_t paused = {0};
+	paused.channel = TEST_CHANNEL;
+	paused.slave_pin = TEST_LONG_PIN;
+	paused.ss_polarity = SS_ACTIVE_LOW;
+	paused.tx_buffer = long_tx;
+	paused.tx_length = TEST_LONG_FRAMES;
+	paused.rx_buffer = long_rx;
+	paused.rx_length = TEST_LONG_FRAMES;
+	paused.data_format = SPI_DATA_8BIT;
+	paused.preemptible = PREEMPT_ENABLE;
+
+	static uint16_t urgent_tx[TEST_URGENT_FRAMES] = {0xA0, 0xA1, 0xA2, 0xA3};
+	static uint16_t urgent_rx[TEST_URGENT_FRAMES];
+	static spi_transfer_t urgent = {0};
+	urgent.channel = TEST_CHANNEL;
+	urgent.slave_pin = TEST_URGENT_PIN;
+	urgent.ss_polarity = SS_ACTIVE_LOW;
+	urgent.tx_buffer = urgent_tx;
+	urgent.tx_length = TEST_URGENT_FRAMES;
+	urgent.rx_buffer = urgent_rx;
+	urgent.rx_length = TEST_URGENT_FRAMES;
+	urgent.data_format = SPI_DATA_8BIT;
+	test_urgent = spi_desc_create(&urgent);
+
+	TEST_CHECK(spi_transfer_submit(&paused));
+	spi_sim_service(TEST_CHANNEL);
+	TEST_CHECK(spi_desc_status(test_urgent) == SPI_DESC_DONE);
+	TEST_CHECK(test_count == TEST_LONG_FRAMES + TEST_URGENT_FRAMES);
+
+	/* The urgent frames run alone, after the pause frame and before the paused transfer resumes */
+	uint32_t first_urgent = 0;
+	while (first_urgent < test_count && (test_log[first_urgent] & TEST_URGENT_SELECTED) == 0)
+	{
+		first_urgent++;
+	}
+	TEST_CHECK(first_urgent > TEST_PAUSE_FRAME && first_urgent < TEST_LONG_FRAMES);
+	uint32_t next_long = 0;
+	for (uint32_t i = 0; i < test_count; i++)
+	{
+		if (i >= first_urgent && i < first_urgent + TEST_URGENT_FRAMES)
+		{
+			TEST_CHECK(test_log[i] == (TEST_URGENT_SELECTED | urgent_tx[i - first_urgent]));
+		}
+		else
+		{
+			TEST_CHECK(test_log[i] == (TEST_LONG_SELECTED | next_long));
+			next_long++;
+		}
+	}
+	for (uint32_t i = 0; i < TEST_URGENT_FRAMES; i++)
+	{
+		TEST_CHECK(urgent_rx[i] == urgent_tx[i]);
+	}
+
+	/* The paused transfer completes once, with everything it sent echoed back */
+	spi_transfer_t completed;
+	TEST_CHECK(spi_transfer_reap(TEST_CHANNEL, &completed));
+	TEST_CHECK(completed.tx_length == 0 && completed.rx_length == 0);
+	TEST_CHECK(!spi_transfer_reap(TEST_CHANNEL, NULL));
+	for (uint32_t i = 0; i < TEST_LONG_FRAMES; i++)
+	{
+		TEST_CHECK(long_rx[i] == long_tx[i]);
+	}
+
+	TEST_CHECK(spi_sim_pin_writes(TEST_LONG_PIN) == 4 && spi_sim_pin(TEST_LONG_PIN) == GPIO_PIN_HIGH);
+	TEST_CHECK(spi_sim_pin_writes(TEST_URGENT_PIN) == 2 && spi_sim_pin(TEST_URGENT_PIN) == GPIO_PIN_HIGH);
+	TEST_CHECK(spi_sim_aborts(TEST_CHANNEL) == 0);
+
+	printf("test_spi_urgent: paused after frame %lu and resumed, passed\n", (unsigned long)first_urgent);
+	return (0);
+}
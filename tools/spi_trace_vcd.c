@@ -0,0 +1,236 @@
+/*******************************************************************************
+* Title                 :   SPI Trace to VCD Converter
+* Filename              :   spi_trace_vcd.c
+* Author                :   Marko Galevski
+* Origin Date           :   18/10/2026
+* Version               :   1.0.0
+* Compiler              :   GCC
+* Target                :   Host
+* Notes                 :   cc -I.. -o spi_trace_vcd spi_trace_vcd.c
+*
+*
+*******************************************************************************/
+/****************************************************************************
+* Doxygen C Template
+* Copyright (c) 2013 - Jacob Beningo - All Rights Reserved
+*
+* Feel free to use this Doxygen Code Template at your own risk for your own
+* purposes.  The latest license and updates for this Doxygen C template can be
+* found at www.beningo.com or by contacting Jacob at jacob@beningo.com.
+*
+* For updates, free software, training and to stay up to date on the latest
+* embedded software techniques sign-up for Jacobs newsletter at
+* http://www.beningo.com/814-2/
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Template.
+*
+*****************************************************************************/
+
+/** @file spi_trace_vcd.c
+ *  @brief Host tool turning a dump of spi_trace_record_t into a Value Change
+ *  	Dump, which GTKWave and sigrok/PulseView open as a timeline. Each channel
+ *  	seen in the dump gets cs, xfer, isr, error and cr1 signals.
+ */
+#include "spi_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Contains the signals shown for every channel
+ */
+typedef enum
+{
+	VCD_CS,		/**<1 while the slave is selected */
+	VCD_XFER,	/**<1 while a transfer is in progress */
+	VCD_ISR,	/**<1 while spi_irq_handler runs */
+	VCD_ERROR,	/**<spi_error_t mask of the last transfer, cleared at the next start */
+	VCD_CR1,	/**<CR1 as configured for the last transfer */
+	NUM_VCD_SIGNALS
+}vcd_signal_t;
+
+/**
+ * Names and widths of the signals, indexed by vcd_signal_t
+ */
+static const char *vcd_names[NUM_VCD_SIGNALS] = {"cs", "xfer", "isr", "error", "cr1"};
+static const int vcd_widths[NUM_VCD_SIGNALS] = {1, 1, 1, 3, 16};
+
+/******************************************************************************
+* Function: vcd_value()
+*//**
+* \b Description:
+*
+* 	Writes a value change of one signal.
+*
+* PRE-CONDITION: The signal has been declared in the header
+*
+* POST-CONDITION: The value change has been written
+*
+* @param		out the vcd file
+* @param		channel the spi device the signal belongs to
+* @param		signal the signal of interest
+* @param		value the new value
+* @return 		void
+*
+* \b Example:
+*	Called by main for every record
+*
+* @see main
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+static void vcd_value(FILE *out, int channel, vcd_signal_t signal, unsigned value)
+{
+	char id = (char)('!' + channel * NUM_VCD_SIGNALS + signal);
+	if (vcd_widths[signal] == 1)
+	{
+		fprintf(out, "%u%c\n", value & 1U, id);
+		return;
+	}
+	fputc('b', out);
+	for (int bit = vcd_widths[signal] - 1; bit >= 0; bit--)
+	{
+		fputc(((value >> bit) & 1U) ? '1' : '0', out);
+	}
+	fprintf(out, " %c\n", id);
+}
+
+/******************************************************************************
+* Function: main()
+*//**
+* \b Description:
+*
+* 	Reads the dump, declares the signals of every channel present and writes
+* 	one value change per record. Timestamps are unwrapped across CYCCNT
+* 	overflows and converted to nanoseconds with the given core clock.
+*
+* PRE-CONDITION: The dump was written by a little endian target
+*
+* POST-CONDITION: The vcd has been written
+*
+* @param		argc the number of arguments
+* @param		argv dump file, core clock in Hz, optional output file
+* @return 		int 0 on success
+*
+* \b Example:
+* @code
+*	make -C tests build/spi_trace_vcd
+*	tests/build/spi_trace_vcd trace.bin 100000000 trace.vcd
+* @endcode
+*
+* @see spi_trace_dump
+* <br><b> - CHANGE HISTORY - </b>
+*
+* <table align="left" style="width:800px">
+* <tr><td> Date       </td><td> Software Version </td><td> Initials </td><td> Description </td></tr>
+* </table><br><br>
+* <hr>
+*******************************************************************************/
+int main(int argc, char **argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "usage: %s <dump.bin> <core_clock_hz> [out.vcd]\n", argv[0]);
+		return (1);
+	}
+	double ns_per_cycle = 1e9 / strtod(argv[2], NULL);
+
+	FILE *in = fopen(argv[1], "rb");
+	FILE *out = (argc > 3) ? fopen(argv[3], "w") : stdout;
+	if (in == NULL || out == NULL || ns_per_cycle <= 0)
+	{
+		fprintf(stderr, "cannot open files or bad clock\n");
+		return (1);
+	}
+
+	spi_trace_record_t record;
+	int present[NUM_SPI] = {0};
+	long count = 0;
+	while (fread(&record, sizeof(record), 1, in) == 1)
+	{
+		if (record.channel < NUM_SPI)
+		{
+			present[record.channel] = 1;
+		}
+		count++;
+	}
+
+	fprintf(out, "$timescale 1 ns $end\n$scope module spi $end\n");
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		if (!present[channel])
+		{
+			continue;
+		}
+		fprintf(out, "$scope module spi%d $end\n", channel + 1);
+		for (int signal = 0; signal < NUM_VCD_SIGNALS; signal++)
+		{
+			fprintf(out, "$var wire %d %c %s $end\n", vcd_widths[signal],
+					(char)('!' + channel * NUM_VCD_SIGNALS + signal), vcd_names[signal]);
+		}
+		fprintf(out, "$upscope $end\n");
+	}
+	fprintf(out, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+	for (int channel = 0; channel < NUM_SPI; channel++)
+	{
+		for (int signal = 0; present[channel] && signal < NUM_VCD_SIGNALS; signal++)
+		{
+			vcd_value(out, channel, (vcd_signal_t)signal, 0);
+		}
+	}
+	fprintf(out, "$end\n");
+
+	rewind(in);
+	uint64_t cycles = 0;
+	uint32_t previous = 0;
+	for (long i = 0; i < count && fread(&record, sizeof(record), 1, in) == 1; i++)
+	{
+		if (record.channel >= NUM_SPI)
+		{
+			continue;
+		}
+		if (i > 0)
+		{
+			cycles += (uint32_t)(record.timestamp - previous);
+		}
+		previous = record.timestamp;
+		fprintf(out, "#%llu\n", (unsigned long long)(cycles * ns_per_cycle));
+
+		if (record.event == TRACE_CS_ASSERT || record.event == TRACE_CS_RELEASE)
+		{
+			vcd_value(out, record.channel, VCD_CS, record.event == TRACE_CS_ASSERT);
+		}
+		else if (record.event == TRACE_TRANSFER_START)
+		{
+			vcd_value(out, record.channel, VCD_XFER, 1);
+			vcd_value(out, record.channel, VCD_ERROR, 0);
+		}
+		else if (record.event == TRACE_TRANSFER_END)
+		{
+			vcd_value(out, record.channel, VCD_XFER, 0);
+		}
+		else if (record.event == TRACE_ISR_ENTRY || record.event == TRACE_ISR_EXIT)
+		{
+			vcd_value(out, record.channel, VCD_ISR, record.event == TRACE_ISR_ENTRY);
+		}
+		else if (record.event == TRACE_ERROR)
+		{
+			vcd_value(out, record.channel, VCD_ERROR, record.arg);
+		}
+		else if (record.event == TRACE_CONFIGURE)
+		{
+			vcd_value(out, record.channel, VCD_CR1, record.arg);
+		}
+	}
+
+	fclose(in);
+	if (out != stdout)
+	{
+		fclose(out);
+	}
+	return (0);
+}